@@ -0,0 +1,526 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+// Replays a recording of the state recorder through controllers, without a robot.
+//
+// The samples of ~recording are fed, one per control cycle, through a controller manager over
+// ReplayRobotHW to each of ~controllers in turn, as fast as possible or at ~realtime_factor
+// times the recorded rate. The commands a controller writes are compared with those the robot
+// reports in the next sample (effort with tau_J_d, velocity with dq_d, position with q_d), and
+// the update() latency and replay throughput are reported. Running several controllers on one recording
+// gives a deterministic A/B comparison.
+//
+// The robot state does not respond to the commands, so the comparison is only meaningful for
+// the controller that was running when the recording was made (or one meant to behave like
+// it). With ~command_mode, the recorded desired values are published as the controllers'
+// commands (JointCommand from q_d, dq_d and tau_J_d, or the equilibrium pose from O_T_EE_d),
+// on a callback queue that is served right before every update. The dynamics model is
+// approximated, see ReplayModel. Controller parameters are read from ~controller_namespace
+// exactly as when spawned by the control node; see launch/controller_replay.launch.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <controller_manager/controller_manager.h>
+#include <controller_manager_msgs/SwitchController.h>
+#include <franka_core_msgs/JointCommand.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+
+#include <Eigen/Dense>
+
+#include <franka_interface/batch_kinematics.h>
+#include <franka_interface/state_recording.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/command_queue.h>
+
+#include "replay_robot_hw.h"
+
+namespace {
+
+using franka_interface::benchmark::ReplayRobotHW;
+
+constexpr size_t kJointCount = 7;
+
+/// Publishes the recorded desired values of a sample as the command of the controllers.
+class CommandPublisher {
+ public:
+  /// The topics are the ones the controllers of arm_id in controller_node_handle subscribe to.
+  bool init(ros::NodeHandle& node_handle,
+            const ros::NodeHandle& controller_node_handle,
+            const std::string& arm_id,
+            const std::string& mode,
+            const std::vector<std::string>& joint_names) {
+    joint_command_.names = joint_names;
+    if (mode == "position" || mode == "impedance") {
+      joint_command_.mode = mode == "position" ? franka_core_msgs::JointCommand::POSITION_MODE
+                                               : franka_core_msgs::JointCommand::IMPEDANCE_MODE;
+      joint_command_.position.resize(kJointCount);
+      joint_command_.velocity.resize(mode == "impedance" ? kJointCount : 0);
+    } else if (mode == "velocity") {
+      joint_command_.mode = franka_core_msgs::JointCommand::VELOCITY_MODE;
+      joint_command_.velocity.resize(kJointCount);
+    } else if (mode == "torque") {
+      joint_command_.mode = franka_core_msgs::JointCommand::TORQUE_MODE;
+      joint_command_.effort.resize(kJointCount);
+    } else if (mode != "pose" && mode != "none") {
+      return false;
+    }
+    mode_ = mode;
+    if (mode_ == "pose") {
+      publisher_ = node_handle.advertise<geometry_msgs::PoseStamped>(
+          franka_ros_controllers::armTopic(controller_node_handle, arm_id, "/equilibrium_pose"),
+          1);
+    } else if (mode_ != "none") {
+      publisher_ = node_handle.advertise<franka_core_msgs::JointCommand>(
+          franka_ros_controllers::armTopic(
+              controller_node_handle, arm_id,
+              "/franka_ros_interface/motion_controller/arm/joint_commands"),
+          1);
+    }
+    return true;
+  }
+
+  /// Waits until a controller has subscribed, so that the first command reaches it.
+  bool waitForSubscriber(double timeout) const {
+    if (mode_ == "none") {
+      return true;
+    }
+    ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(timeout);
+    while (publisher_.getNumSubscribers() == 0 && ros::WallTime::now() < deadline) {
+      ros::WallDuration(0.01).sleep();
+    }
+    return publisher_.getNumSubscribers() > 0;
+  }
+
+  // Subscribers in this node get the message queued on their callback queue within publish().
+  void publish(const ros::Time& time, const franka::RobotState& state) {
+    if (mode_ == "none") {
+      return;
+    }
+    if (mode_ == "pose") {
+      Eigen::Affine3d transform(Eigen::Matrix4d::Map(state.O_T_EE_d.data()));
+      Eigen::Quaterniond orientation(transform.linear());
+      pose_.header.stamp = time;
+      pose_.pose.position.x = transform.translation().x();
+      pose_.pose.position.y = transform.translation().y();
+      pose_.pose.position.z = transform.translation().z();
+      pose_.pose.orientation.x = orientation.x();
+      pose_.pose.orientation.y = orientation.y();
+      pose_.pose.orientation.z = orientation.z();
+      pose_.pose.orientation.w = orientation.w();
+      publisher_.publish(pose_);
+      return;
+    }
+    joint_command_.header.stamp = time;
+    if (!joint_command_.position.empty()) {
+      std::copy(state.q_d.begin(), state.q_d.end(), joint_command_.position.begin());
+    }
+    if (!joint_command_.velocity.empty()) {
+      std::copy(state.dq_d.begin(), state.dq_d.end(), joint_command_.velocity.begin());
+    }
+    if (!joint_command_.effort.empty()) {
+      std::copy(state.tau_J_d.begin(), state.tau_J_d.end(), joint_command_.effort.begin());
+    }
+    publisher_.publish(joint_command_);
+  }
+
+ private:
+  std::string mode_{"none"};
+  ros::Publisher publisher_;
+  franka_core_msgs::JointCommand joint_command_;
+  geometry_msgs::PoseStamped pose_;
+};
+
+/// Difference between the commands of a controller and the recorded ones.
+struct Error {
+  size_t samples{0};
+  std::array<double, kJointCount> sum_squares{};
+  std::array<double, kJointCount> max{};
+
+  void add(const std::array<double, kJointCount>& produced,
+           const std::array<double, kJointCount>& recorded) {
+    for (size_t i = 0; i < kJointCount; ++i) {
+      const double error = std::abs(produced[i] - recorded[i]);
+      sum_squares[i] += error * error;
+      max[i] = std::max(max[i], error);
+    }
+    ++samples;
+  }
+
+  double rms(size_t joint) const {
+    return samples == 0 ? 0.0 : std::sqrt(sum_squares[joint] / samples);
+  }
+
+  double rms() const {
+    double sum = 0.0;
+    for (double value : sum_squares) {
+      sum += value;
+    }
+    return samples == 0 ? 0.0 : std::sqrt(sum / (samples * kJointCount));
+  }
+
+  double maxAll() const { return *std::max_element(max.begin(), max.end()); }
+};
+
+bool written(const std::array<double, kJointCount>& command) {
+  return std::none_of(command.begin(), command.end(),
+                      [](double value) { return std::isnan(value); });
+}
+
+struct Result {
+  std::string name;
+  bool initialised{false};
+  std::string interface{"none"};  // command interface compared with the recording
+  Error error;
+  size_t cycles{0};
+  double p50_us{0.0};
+  double p99_us{0.0};
+  double max_us{0.0};
+  double cycles_per_second{0.0};
+  double realtime_factor{0.0};  // recorded duration / replay duration
+};
+
+double percentile(std::vector<double>& samples, double fraction) {
+  auto nth = samples.begin() + static_cast<std::ptrdiff_t>(fraction * (samples.size() - 1));
+  std::nth_element(samples.begin(), nth, samples.end());
+  return *nth;
+}
+
+/**
+ * Starts or stops controller while updating on the current robot state.
+ *
+ * ControllerManager::switchController() blocks until update() has carried out the switch, so it
+ * runs on another thread. Updating stops as soon as the controller is in the requested state,
+ * so that the controller sees the same number of cycles in every run: when starting, the
+ * update that starts it is its update for the current sample.
+ */
+bool switchController(controller_manager::ControllerManager& manager,
+                      const std::string& controller,
+                      bool start,
+                      const ros::Time& time,
+                      const ros::Duration& period) {
+  const std::vector<std::string> none;
+  const std::vector<std::string> controllers{controller};
+  std::future<bool> switched = std::async(std::launch::async, [&]() {
+    return manager.switchController(start ? controllers : none, start ? none : controllers,
+                                    controller_manager_msgs::SwitchController::Request::STRICT);
+  });
+  controller_interface::ControllerBase* base = manager.getControllerByName(controller);
+  while (base->isRunning() != start &&
+         switched.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+    manager.update(time, period);
+    std::this_thread::yield();
+  }
+  return switched.get() && base->isRunning() == start;
+}
+
+Result replay(const std::string& name,
+              controller_manager::ControllerManager& manager,
+              ReplayRobotHW& robot_hw,
+              CommandPublisher& commands,
+              ros::CallbackQueue& command_queue,
+              double realtime_factor) {
+  Result result;
+  result.name = name;
+  if (!manager.loadController(name)) {
+    ROS_ERROR_STREAM("controller_replay: Could not load " << name << ", skipping.");
+    return result;
+  }
+  if (!commands.waitForSubscriber(5.0)) {
+    ROS_WARN_STREAM("controller_replay: " << name << " does not subscribe to the commands");
+  }
+
+  const ros::Duration first_period(0.001);
+  Error effort_error, velocity_error, position_error;
+  // The robot reports the command of a cycle as the desired values of the next sample, so the
+  // commands of cycle i are compared with sample i + 1; those of the last cycle are dropped.
+  std::array<double, kJointCount> effort, velocity, position;
+  auto keep = [&]() {
+    effort = robot_hw.effortCommand();
+    velocity = robot_hw.velocityCommand();
+    position = robot_hw.positionCommand();
+  };
+  auto compare = [&]() {
+    const franka::RobotState& state = robot_hw.robotState();
+    if (written(effort)) {
+      effort_error.add(effort, state.tau_J_d);
+    }
+    if (written(velocity)) {
+      velocity_error.add(velocity, state.dq_d);
+    }
+    if (written(position)) {
+      position_error.add(position, state.q_d);
+    }
+  };
+
+  // The first sample is the cycle in which the controller starts.
+  robot_hw.read(0);
+  commands.publish(robot_hw.time(0), robot_hw.robotState());
+  command_queue.callAvailable();
+  if (!switchController(manager, name, true, robot_hw.time(0), first_period)) {
+    ROS_ERROR_STREAM("controller_replay: Could not start " << name << ", skipping.");
+    manager.unloadController(name);
+    return result;
+  }
+  result.initialised = true;
+  keep();
+
+  std::vector<double> update_us(robot_hw.size() - 1);
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 1; i < robot_hw.size() && ros::ok(); ++i) {
+    const ros::Time time = robot_hw.time(i);
+    robot_hw.read(i);
+    compare();
+    commands.publish(time, robot_hw.robotState());
+    command_queue.callAvailable();
+    auto before = std::chrono::steady_clock::now();
+    manager.update(time, time - robot_hw.time(i - 1));
+    auto after = std::chrono::steady_clock::now();
+    update_us[i - 1] = std::chrono::duration<double, std::micro>(after - before).count();
+    keep();
+    if (realtime_factor > 0.0) {
+      std::this_thread::sleep_until(
+          start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double>((time - robot_hw.time(0)).toSec() /
+                                                    realtime_factor)));
+    }
+  }
+  const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const size_t last = robot_hw.size() - 1;
+  if (!switchController(manager, name, false, robot_hw.time(last), first_period)) {
+    ROS_WARN_STREAM("controller_replay: Could not stop " << name);
+  }
+  manager.unloadController(name);
+
+  result.cycles = robot_hw.size();
+  if (effort_error.samples > 0) {
+    result.interface = "effort";
+    result.error = effort_error;
+  } else if (velocity_error.samples > 0) {
+    result.interface = "velocity";
+    result.error = velocity_error;
+  } else if (position_error.samples > 0) {
+    result.interface = "position";
+    result.error = position_error;
+  }
+  if (!update_us.empty()) {
+    result.max_us = *std::max_element(update_us.begin(), update_us.end());
+    result.p99_us = percentile(update_us, 0.99);
+    result.p50_us = percentile(update_us, 0.5);
+  }
+  if (elapsed > 0.0) {
+    result.cycles_per_second = update_us.size() / elapsed;
+    result.realtime_factor = (robot_hw.time(last) - robot_hw.time(0)).toSec() / elapsed;
+  }
+  return result;
+}
+
+bool readKinematics(const ros::NodeHandle& node_handle,
+                    franka_interface::KinematicParameters& parameters) {
+  const std::pair<const char*, std::array<double, 7>*> chains[] = {
+      {"/robot_config/kinematics/a", &parameters.a},
+      {"/robot_config/kinematics/d", &parameters.d},
+      {"/robot_config/kinematics/alpha", &parameters.alpha},
+  };
+  for (const auto& chain : chains) {
+    std::vector<double> values;
+    if (!node_handle.getParam(chain.first, values)) {
+      continue;
+    }
+    if (values.size() != kJointCount) {
+      ROS_ERROR_STREAM("controller_replay: " << chain.first << " must have 7 values");
+      return false;
+    }
+    std::copy(values.begin(), values.end(), chain.second->begin());
+  }
+  node_handle.param<double>("/robot_config/kinematics/flange", parameters.flange,
+                            parameters.flange);
+  return true;
+}
+
+bool writeReport(const std::string& path,
+                 const std::string& recording,
+                 const std::vector<Result>& results) {
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  auto list = [file](const char* key, const std::array<double, kJointCount>& values) {
+    std::fprintf(file, "    %s: [", key);
+    for (size_t i = 0; i < values.size(); ++i) {
+      std::fprintf(file, "%s%.9g", i == 0 ? "" : ", ", values[i]);
+    }
+    std::fprintf(file, "]\n");
+  };
+  std::fprintf(file, "recording: %s\ncontrollers:\n", recording.c_str());
+  for (const Result& r : results) {
+    std::fprintf(file, "  - name: %s\n    initialised: %s\n", r.name.c_str(),
+                 r.initialised ? "true" : "false");
+    if (!r.initialised) {
+      continue;
+    }
+    std::array<double, kJointCount> rms;
+    for (size_t i = 0; i < kJointCount; ++i) {
+      rms[i] = r.error.rms(i);
+    }
+    std::fprintf(file, "    interface: %s\n    cycles: %zu\n", r.interface.c_str(), r.cycles);
+    list("rms_error", rms);
+    list("max_error", r.error.max);
+    std::fprintf(file,
+                 "    update_p50_us: %.3f\n    update_p99_us: %.3f\n    update_max_us: %.3f\n"
+                 "    cycles_per_second: %.1f\n    realtime_factor: %.3f\n",
+                 r.p50_us, r.p99_us, r.max_us, r.cycles_per_second, r.realtime_factor);
+  }
+  return std::fclose(file) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "controller_replay");
+  ros::NodeHandle private_nh("~");
+
+  std::string recording_path;
+  if (!private_nh.getParam("recording", recording_path)) {
+    ROS_ERROR("controller_replay: Could not find parameter ~recording, aborting!");
+    return 1;
+  }
+  std::vector<std::string> controllers;
+  if (!private_nh.getParam("controllers", controllers) || controllers.empty()) {
+    ROS_ERROR("controller_replay: Invalid or no parameter ~controllers, aborting!");
+    return 1;
+  }
+  std::string arm_id;
+  if (!private_nh.getParam("/robot_config/arm_id", arm_id)) {
+    ROS_ERROR("controller_replay: Could not read parameter /robot_config/arm_id, aborting!");
+    return 1;
+  }
+  std::vector<std::string> joint_names;
+  if (!private_nh.getParam("/robot_config/joint_names", joint_names) ||
+      joint_names.size() != kJointCount) {
+    ROS_ERROR("controller_replay: Invalid or no /robot_config/joint_names, aborting!");
+    return 1;
+  }
+  franka_interface::KinematicParameters kinematics;
+  if (!readKinematics(private_nh, kinematics)) {
+    return 1;
+  }
+
+  std::string controller_namespace, command_mode, report_path;
+  double realtime_factor, max_rms_error, min_realtime_factor;
+  private_nh.param<std::string>("controller_namespace", controller_namespace,
+                                "/franka_ros_interface");
+  private_nh.param<std::string>("command_mode", command_mode, "none");
+  private_nh.param<std::string>("report", report_path, "");
+  // 0 replays as fast as possible
+  private_nh.param<double>("realtime_factor", realtime_factor, 0.0);
+  // Regression gate: a negative value disables the check.
+  private_nh.param<double>("max_rms_error", max_rms_error, -1.0);
+  private_nh.param<double>("min_realtime_factor", min_realtime_factor, -1.0);
+  if (realtime_factor < 0.0) {
+    ROS_ERROR("controller_replay: ~realtime_factor must not be negative, aborting!");
+    return 1;
+  }
+
+  franka_interface::StateRecording recording;
+  ReplayRobotHW robot_hw(arm_id, joint_names, kinematics);
+  std::string error;
+  if (!recording.open(recording_path, error) || !robot_hw.init(recording, error)) {
+    ROS_ERROR_STREAM("controller_replay: " << error << ", aborting!");
+    return 1;
+  }
+  if (recording.size() < 2) {
+    ROS_ERROR("controller_replay: The recording holds fewer than two samples, aborting!");
+    return 1;
+  }
+
+  // Commands are served only right before each update, so every run sees them in the same
+  // cycles. Publishers are created before the controllers subscribe, so that the connection is
+  // made within subscribe().
+  ros::CallbackQueue command_queue;
+  franka_ros_controllers::setCommandCallbackQueue(&command_queue);
+  ros::NodeHandle root_nh(controller_namespace);
+  CommandPublisher commands;
+  if (!commands.init(private_nh, root_nh, arm_id, command_mode, joint_names)) {
+    ROS_ERROR_STREAM("controller_replay: Invalid ~command_mode " << command_mode
+                     << ", expected none, position, velocity, impedance, torque or pose");
+    return 1;
+  }
+
+  // gains and dynamic_reconfigure callbacks of the controllers
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  controller_manager::ControllerManager manager(&robot_hw, root_nh);
+  std::vector<Result> results;
+  for (const std::string& controller : controllers) {
+    results.push_back(
+        replay(controller, manager, robot_hw, commands, command_queue, realtime_factor));
+  }
+  spinner.stop();
+
+  bool passed = true;
+  std::printf("\n%zu samples of %s (%.1f s), %s\n\n", recording.size(), recording_path.c_str(),
+              (robot_hw.time(recording.size() - 1) - robot_hw.time(0)).toSec(),
+              realtime_factor > 0.0 ? "throttled" : "as fast as possible");
+  std::printf("%-36s %-9s %12s %12s %10s %10s %10s %12s %10s\n", "controller", "interface",
+              "rms error", "max error", "p50 [us]", "p99 [us]", "max [us]", "cycles/s",
+              "x realtime");
+  for (const Result& r : results) {
+    if (!r.initialised) {
+      std::printf("%-36s %-9s\n", r.name.c_str(), "init failed");
+      passed = false;
+      continue;
+    }
+    const bool inaccurate =
+        max_rms_error >= 0.0 && r.interface != "none" && r.error.rms() > max_rms_error;
+    const bool too_slow = min_realtime_factor >= 0.0 && realtime_factor == 0.0 &&
+                          r.realtime_factor < min_realtime_factor;
+    std::printf("%-36s %-9s %12.6f %12.6f %10.2f %10.2f %10.2f %12.0f %10.1f%s\n",
+                r.name.c_str(), r.interface.c_str(), r.error.rms(), r.error.maxAll(), r.p50_us,
+                r.p99_us, r.max_us, r.cycles_per_second, r.realtime_factor,
+                inaccurate || too_slow ? "  FAILED" : "");
+    passed = passed && !inaccurate && !too_slow;
+  }
+  if (!report_path.empty() && !writeReport(report_path, recording_path, results)) {
+    ROS_ERROR_STREAM("controller_replay: Could not write " << report_path);
+    passed = false;
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,285 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include "replay_robot_hw.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include <Eigen/Dense>
+
+namespace franka_interface {
+namespace benchmark {
+
+namespace {
+
+constexpr size_t kJointCount = 7;
+
+// Recorded columns read into the robot state; indices into kColumns.
+enum ColumnIndex : size_t {
+  kRosTime,
+  kTime,
+  kQ,
+  kQD,
+  kDq,
+  kDqD,
+  kDdqD,
+  kTheta,
+  kDtheta,
+  kTauJ,
+  kTauJD,
+  kDtauJ,
+  kTauExtHatFiltered,
+  kOTEE,
+  kOTEED,
+  kOFExtHatK,
+  kKFExtHatK,
+  kControlCommandSuccessRate,
+};
+
+constexpr std::pair<const char*, size_t> kColumns[] = {
+    {"ros_time", 1},
+    {"time", 1},
+    {"q", 7},
+    {"q_d", 7},
+    {"dq", 7},
+    {"dq_d", 7},
+    {"ddq_d", 7},
+    {"theta", 7},
+    {"dtheta", 7},
+    {"tau_J", 7},
+    {"tau_J_d", 7},
+    {"dtau_J", 7},
+    {"tau_ext_hat_filtered", 7},
+    {"O_T_EE", 16},
+    {"O_T_EE_d", 16},
+    {"O_F_ext_hat_K", 6},
+    {"K_F_ext_hat_K", 6},
+    {"control_command_success_rate", 1},
+};
+
+template <size_t N>
+void copy(const double* values, std::array<double, N>& out) {
+  std::copy(values, values + N, out.begin());
+}
+
+// Modified DH: RotX(alpha) * TransX(a) * RotZ(q) * TransZ(d)
+Eigen::Matrix4d link(double a, double d, double alpha, double q) {
+  const double ca = std::cos(alpha), sa = std::sin(alpha);
+  const double cq = std::cos(q), sq = std::sin(q);
+  Eigen::Matrix4d transform;
+  transform << cq, -sq, 0.0, a,
+               sq * ca, cq * ca, -sa, -d * sa,
+               sq * sa, cq * sa, ca, d * ca,
+               0.0, 0.0, 0.0, 1.0;
+  return transform;
+}
+
+struct Chain {
+  std::array<Eigen::Matrix4d, kJointCount> joints;  // poses of the joint frames
+  Eigen::Matrix4d frame;                           // pose of the requested frame
+  size_t joint_count;                              // joints that move the requested frame
+};
+
+Chain chain(const KinematicParameters& parameters,
+            franka::Frame frame,
+            const franka::RobotState& state) {
+  Chain result;
+  Eigen::Matrix4d transform = Eigen::Matrix4d::Identity();
+  for (size_t i = 0; i < kJointCount; ++i) {
+    transform *= link(parameters.a[i], parameters.d[i], parameters.alpha[i], state.q[i]);
+    result.joints[i] = transform;
+  }
+  const size_t index = static_cast<size_t>(frame);
+  result.joint_count = std::min(index + 1, kJointCount);
+  if (index < kJointCount) {
+    result.frame = result.joints[index];
+    return result;
+  }
+  Eigen::Matrix4d flange = Eigen::Matrix4d::Identity();
+  flange(2, 3) = parameters.flange;
+  result.frame = result.joints.back() * flange;
+  if (frame == franka::Frame::kEndEffector || frame == franka::Frame::kStiffness) {
+    result.frame *= Eigen::Map<const Eigen::Matrix4d>(state.F_T_EE.data());
+  }
+  if (frame == franka::Frame::kStiffness) {
+    result.frame *= Eigen::Map<const Eigen::Matrix4d>(state.EE_T_K.data());
+  }
+  return result;
+}
+
+Eigen::Matrix<double, 6, 7> jacobian(const Chain& chain) {
+  Eigen::Matrix<double, 6, 7> result = Eigen::Matrix<double, 6, 7>::Zero();
+  const Eigen::Vector3d position = chain.frame.block<3, 1>(0, 3);
+  for (size_t j = 0; j < chain.joint_count; ++j) {
+    const Eigen::Vector3d axis = chain.joints[j].block<3, 1>(0, 2);
+    const Eigen::Vector3d origin = chain.joints[j].block<3, 1>(0, 3);
+    result.block<3, 1>(0, j) = axis.cross(position - origin);
+    result.block<3, 1>(3, j) = axis;
+  }
+  return result;
+}
+
+}  // anonymous namespace
+
+std::array<double, 49> ReplayModel::mass(const franka::RobotState& /* state */) const {
+  return {};
+}
+
+std::array<double, 7> ReplayModel::coriolis(const franka::RobotState& /* state */) const {
+  return {};
+}
+
+std::array<double, 7> ReplayModel::gravity(const franka::RobotState& state) const {
+  std::array<double, 7> result;
+  for (size_t i = 0; i < kJointCount; ++i) {
+    result[i] = state.tau_J[i] - state.tau_J_d[i] - state.tau_ext_hat_filtered[i];
+  }
+  return result;
+}
+
+std::array<double, 16> ReplayModel::pose(franka::Frame frame,
+                                         const franka::RobotState& state) const {
+  std::array<double, 16> result;
+  Eigen::Map<Eigen::Matrix4d>(result.data()) = chain(parameters_, frame, state).frame;
+  return result;
+}
+
+std::array<double, 42> ReplayModel::bodyJacobian(franka::Frame frame,
+                                                 const franka::RobotState& state) const {
+  const Chain frames = chain(parameters_, frame, state);
+  const Eigen::Matrix3d rotation_transposed = frames.frame.topLeftCorner<3, 3>().transpose();
+  const Eigen::Matrix<double, 6, 7> zero_jacobian = jacobian(frames);
+  std::array<double, 42> result;
+  Eigen::Map<Eigen::Matrix<double, 6, 7>> body_jacobian(result.data());
+  body_jacobian.topRows<3>() = rotation_transposed * zero_jacobian.topRows<3>();
+  body_jacobian.bottomRows<3>() = rotation_transposed * zero_jacobian.bottomRows<3>();
+  return result;
+}
+
+std::array<double, 42> ReplayModel::zeroJacobian(franka::Frame frame,
+                                                 const franka::RobotState& state) const {
+  std::array<double, 42> result;
+  Eigen::Map<Eigen::Matrix<double, 6, 7>>(result.data()) =
+      jacobian(chain(parameters_, frame, state));
+  return result;
+}
+
+ReplayRobotHW::ReplayRobotHW(const std::string& arm_id,
+                             const std::vector<std::string>& joint_names,
+                             const KinematicParameters& parameters)
+    : model_(parameters) {
+  for (size_t i = 0; i < joint_names.size() && i < kJointCount; ++i) {
+    hardware_interface::JointStateHandle joint_state_handle(
+        joint_names[i], &robot_state_.q[i], &robot_state_.dq[i], &robot_state_.tau_J[i]);
+    joint_state_interface_.registerHandle(joint_state_handle);
+    position_joint_interface_.registerHandle(
+        hardware_interface::JointHandle(joint_state_handle, &position_command_[i]));
+    velocity_joint_interface_.registerHandle(
+        hardware_interface::JointHandle(joint_state_handle, &velocity_command_[i]));
+    effort_joint_interface_.registerHandle(
+        hardware_interface::JointHandle(joint_state_handle, &effort_command_[i]));
+  }
+
+  franka_hw::FrankaStateHandle franka_state_handle(arm_id + "_robot", robot_state_);
+  franka_state_interface_.registerHandle(franka_state_handle);
+  franka_pose_cartesian_interface_.registerHandle(franka_hw::FrankaCartesianPoseHandle(
+      franka_state_handle, pose_command_, elbow_command_));
+  model_approximation_interface_.registerModel(arm_id, model_);
+
+  registerInterface(&joint_state_interface_);
+  registerInterface(&position_joint_interface_);
+  registerInterface(&velocity_joint_interface_);
+  registerInterface(&effort_joint_interface_);
+  registerInterface(&franka_state_interface_);
+  registerInterface(&franka_pose_cartesian_interface_);
+  registerInterface(&franka_model_interface_);
+  registerInterface(&model_approximation_interface_);
+}
+
+bool ReplayRobotHW::init(const StateRecording& recording, std::string& error) {
+  columns_.clear();
+  size_ = recording.size();
+  if (size_ == 0) {
+    error = "The recording holds no samples";
+    return false;
+  }
+  for (const auto& expected : kColumns) {
+    size_t width = 0;
+    const double* values = recording.column(expected.first, width);
+    if (values == nullptr || width != expected.second) {
+      error = std::string("The recording has no column ") + expected.first + " of width " +
+              std::to_string(expected.second);
+      return false;
+    }
+    columns_.push_back(Column{expected.first, width, values});
+  }
+
+  // O_T_EE = O_T_F * F_T_EE, with O_T_F from the kinematic chain
+  robot_state_.F_T_EE = {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  robot_state_.EE_T_K = robot_state_.F_T_EE;
+  read(0);
+  const std::array<double, 16> O_T_F = model_.pose(franka::Frame::kFlange, robot_state_);
+  Eigen::Map<Eigen::Matrix4d>(robot_state_.F_T_EE.data()) =
+      Eigen::Map<const Eigen::Matrix4d>(O_T_F.data()).inverse() *
+      Eigen::Map<const Eigen::Matrix4d>(robot_state_.O_T_EE.data());
+  return true;
+}
+
+ros::Time ReplayRobotHW::time(size_t sample) const {
+  return ros::Time(values(kRosTime, sample)[0]);
+}
+
+void ReplayRobotHW::read(size_t sample) {
+  robot_state_.time =
+      franka::Duration(static_cast<uint64_t>(std::llround(values(kTime, sample)[0] * 1000.0)));
+  copy(values(kQ, sample), robot_state_.q);
+  copy(values(kQD, sample), robot_state_.q_d);
+  copy(values(kDq, sample), robot_state_.dq);
+  copy(values(kDqD, sample), robot_state_.dq_d);
+  copy(values(kDdqD, sample), robot_state_.ddq_d);
+  copy(values(kTheta, sample), robot_state_.theta);
+  copy(values(kDtheta, sample), robot_state_.dtheta);
+  copy(values(kTauJ, sample), robot_state_.tau_J);
+  copy(values(kTauJD, sample), robot_state_.tau_J_d);
+  copy(values(kDtauJ, sample), robot_state_.dtau_J);
+  copy(values(kTauExtHatFiltered, sample), robot_state_.tau_ext_hat_filtered);
+  copy(values(kOTEE, sample), robot_state_.O_T_EE);
+  copy(values(kOTEED, sample), robot_state_.O_T_EE_d);
+  copy(values(kOFExtHatK, sample), robot_state_.O_F_ext_hat_K);
+  copy(values(kKFExtHatK, sample), robot_state_.K_F_ext_hat_K);
+  robot_state_.control_command_success_rate = values(kControlCommandSuccessRate, sample)[0];
+  robot_state_.robot_mode = franka::RobotMode::kMove;
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  position_command_.fill(nan);
+  velocity_command_.fill(nan);
+  effort_command_.fill(nan);
+}
+
+}  // namespace benchmark
+}  // namespace franka_interface
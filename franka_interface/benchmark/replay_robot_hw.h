@@ -0,0 +1,150 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <franka/robot_state.h>
+#include <franka_hw/franka_cartesian_command_interface.h>
+#include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <hardware_interface/robot_hw.h>
+#include <ros/time.h>
+
+#include <franka_interface/batch_kinematics.h>
+#include <franka_interface/state_recording.h>
+#include <franka_ros_controllers/model_approximation.h>
+
+namespace franka_interface {
+namespace benchmark {
+
+/**
+ * Model of the arm for robot states read from a recording.
+ *
+ * Poses and Jacobians are those of the kinematic chain (/robot_config/kinematics) with the
+ * F_T_EE and EE_T_K of the state. The recording holds no inertial parameters, so gravity is
+ * estimated from the recorded torques, tau_J - tau_J_d - tau_ext_hat_filtered (i.e. whatever
+ * the robot did not attribute to the command or to external forces), and the Coriolis and mass
+ * terms are zero.
+ */
+class ReplayModel : public franka_ros_controllers::ModelApproximation {
+ public:
+  explicit ReplayModel(const KinematicParameters& parameters) : parameters_(parameters) {}
+
+  std::array<double, 49> mass(const franka::RobotState& state) const override;
+  std::array<double, 7> coriolis(const franka::RobotState& state) const override;
+  std::array<double, 7> gravity(const franka::RobotState& state) const override;
+  std::array<double, 16> pose(franka::Frame frame,
+                              const franka::RobotState& state) const override;
+  std::array<double, 42> bodyJacobian(franka::Frame frame,
+                                      const franka::RobotState& state) const override;
+  std::array<double, 42> zeroJacobian(franka::Frame frame,
+                                      const franka::RobotState& state) const override;
+
+ private:
+  KinematicParameters parameters_;
+};
+
+/**
+ * RobotHW over a recording of StateRecorder, for running controllers without a robot.
+ *
+ * Exposes the joint state and position / velocity / effort command interfaces, the franka_hw
+ * state and Cartesian pose interfaces and a ReplayModel as the model of the arm (the
+ * FrankaModelInterface is registered empty, for the interface checks of the controllers).
+ * read() moves the robot state to a sample of the recording; the commands of the controller
+ * do not act on it.
+ */
+class ReplayRobotHW : public hardware_interface::RobotHW {
+ public:
+  ReplayRobotHW(const std::string& arm_id,
+                const std::vector<std::string>& joint_names,
+                const KinematicParameters& parameters);
+
+  /**
+   * Takes the samples of recording, which has to outlive this object. The end-effector frame
+   * F_T_EE is recovered from O_T_EE of the first sample; EE_T_K is the identity.
+   *
+   * @param[out] error Reason of the failure.
+   * @return False if the recording is empty or lacks a column.
+   */
+  bool init(const StateRecording& recording, std::string& error);
+
+  size_t size() const { return size_; }
+
+  /// Recorded ROS time of a sample.
+  ros::Time time(size_t sample) const;
+
+  /**
+   * Loads a sample into the robot state and sets all commands to NaN, so that after the next
+   * update the commands tell which interface the running controller wrote.
+   */
+  void read(size_t sample);
+
+  const franka::RobotState& robotState() const { return robot_state_; }
+  const std::array<double, 7>& positionCommand() const { return position_command_; }
+  const std::array<double, 7>& velocityCommand() const { return velocity_command_; }
+  const std::array<double, 7>& effortCommand() const { return effort_command_; }
+
+ private:
+  struct Column {
+    const char* name;
+    size_t width;
+    const double* values;
+  };
+
+  ReplayModel model_;
+  franka::RobotState robot_state_;
+  size_t size_{0};
+  std::vector<Column> columns_;
+
+  std::array<double, 7> position_command_{};
+  std::array<double, 7> velocity_command_{};
+  std::array<double, 7> effort_command_{};
+  std::array<double, 16> pose_command_{};
+  std::array<double, 2> elbow_command_{};
+
+  hardware_interface::JointStateInterface joint_state_interface_;
+  hardware_interface::PositionJointInterface position_joint_interface_;
+  hardware_interface::VelocityJointInterface velocity_joint_interface_;
+  hardware_interface::EffortJointInterface effort_joint_interface_;
+  franka_hw::FrankaStateInterface franka_state_interface_;
+  franka_hw::FrankaPoseCartesianInterface franka_pose_cartesian_interface_;
+  franka_hw::FrankaModelInterface franka_model_interface_;
+  franka_ros_controllers::ModelApproximationInterface model_approximation_interface_;
+
+  const double* values(size_t column, size_t sample) const {
+    return columns_[column].values + sample * columns_[column].width;
+  }
+};
+
+}  // namespace benchmark
+}  // namespace franka_interface
@@ -0,0 +1,221 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+// Per-tick cost of CustomFrankaStateController::update().
+//
+// The state controller is initialised against a RobotHW that exposes the franka_hw state and
+// model interfaces over a single robot state, and update() is then called back to back with a
+// 1 ms period. Its topics are subscribed to from this node first, so every output stream is
+// due on every cycle. The latency distribution and the number of heap allocations made by
+// update() are reported, as by controller_benchmark of franka_ros_controllers.
+//
+// libfranka can only evaluate the dynamics model after loading it from a robot, so the node
+// connects to ~robot_ip once, reads one state and loads the model. No motion is commanded and
+// franka_control must not be running at the same time. Controller parameters are read from
+// ~controller_namespace/custom_franka_state_controller; see launch/state_controller_benchmark.launch.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <franka/exception.h>
+#include <franka/model.h>
+#include <franka/robot.h>
+#include <franka/robot_state.h>
+#include <franka_core_msgs/EndPointState.h>
+#include <franka_core_msgs/RobotState.h>
+#include <franka_core_msgs/RobotStateCompact.h>
+#include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
+#include <hardware_interface/robot_hw.h>
+#include <ros/ros.h>
+#include <sensor_msgs/JointState.h>
+
+#include <franka_interface/robot_state_controller.h>
+
+#include "allocation_counter.h"
+
+namespace {
+
+using franka_ros_controllers::benchmark::ScopedAllocationCounter;
+
+class BenchmarkRobotHW : public hardware_interface::RobotHW {
+ public:
+  BenchmarkRobotHW(const std::string& arm_id,
+                   franka::Model& model,
+                   const franka::RobotState& robot_state)
+      : robot_state_(robot_state) {
+    franka_state_interface_.registerHandle(
+        franka_hw::FrankaStateHandle(arm_id + "_robot", robot_state_));
+    franka_model_interface_.registerHandle(
+        franka_hw::FrankaModelHandle(arm_id + "_model", model, robot_state_));
+    registerInterface(&franka_state_interface_);
+    registerInterface(&franka_model_interface_);
+  }
+
+  /// Advances the robot state time as a read from the robot would, so that cached model
+  /// quantities are evaluated again on every update.
+  void tick() { robot_state_.time = robot_state_.time + franka::Duration(1); }
+
+ private:
+  franka::RobotState robot_state_;
+  franka_hw::FrankaStateInterface franka_state_interface_;
+  franka_hw::FrankaModelInterface franka_model_interface_;
+};
+
+double percentile(std::vector<double>& samples, double fraction) {
+  auto nth = samples.begin() + static_cast<std::ptrdiff_t>(fraction * (samples.size() - 1));
+  std::nth_element(samples.begin(), nth, samples.end());
+  return *nth;
+}
+
+template <typename Message>
+ros::Subscriber subscribe(ros::NodeHandle& node_handle, const std::string& topic) {
+  return node_handle.subscribe<Message>(topic, 1, [](const typename Message::ConstPtr&) {});
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "state_controller_benchmark");
+  ros::NodeHandle private_nh("~");
+
+  std::string robot_ip;
+  if (!private_nh.getParam("robot_ip", robot_ip)) {
+    ROS_ERROR("state_controller_benchmark: Could not find parameter ~robot_ip, aborting!");
+    return 1;
+  }
+  std::string controller_namespace;
+  int iterations, warmup_iterations;
+  double max_p999_us, max_allocations_per_call;
+  private_nh.param<std::string>("controller_namespace", controller_namespace,
+                                "/franka_ros_interface");
+  private_nh.param<int>("iterations", iterations, 1000000);
+  private_nh.param<int>("warmup_iterations", warmup_iterations, 10000);
+  // Regression gate: a negative value disables the check.
+  private_nh.param<double>("max_p99_9_us", max_p999_us, -1.0);
+  private_nh.param<double>("max_allocations_per_call", max_allocations_per_call, -1.0);
+  if (iterations <= 0 || warmup_iterations < 0) {
+    ROS_ERROR("state_controller_benchmark: ~iterations must be positive, aborting!");
+    return 1;
+  }
+
+  ros::NodeHandle root_nh(controller_namespace);
+  ros::NodeHandle controller_nh(controller_namespace + "/custom_franka_state_controller");
+  std::string arm_id;
+  if (!controller_nh.getParam("arm_id", arm_id)) {
+    ROS_ERROR_STREAM("state_controller_benchmark: Could not read parameter "
+                     << controller_nh.getNamespace() << "/arm_id, aborting!");
+    return 1;
+  }
+
+  std::unique_ptr<franka::Robot> robot;
+  std::unique_ptr<franka::Model> model;
+  franka::RobotState robot_state;
+  try {
+    robot.reset(new franka::Robot(robot_ip));
+    robot_state = robot->readOnce();
+    model.reset(new franka::Model(robot->loadModel()));
+  } catch (const franka::Exception& ex) {
+    ROS_ERROR_STREAM("state_controller_benchmark: Could not load the model from "
+                     << robot_ip << ": " << ex.what());
+    return 1;
+  }
+
+  BenchmarkRobotHW robot_hw(arm_id, *model, robot_state);
+  franka_interface::CustomFrankaStateController controller;
+  if (!controller.init(&robot_hw, root_nh, controller_nh)) {
+    ROS_ERROR("state_controller_benchmark: Could not initialise the state controller, aborting!");
+    return 1;
+  }
+
+  // Subscribe to every stream, so update() fills and publishes all of them.
+  ros::AsyncSpinner spinner(2);
+  spinner.start();
+  std::vector<ros::Subscriber> subscribers{
+      subscribe<franka_core_msgs::RobotState>(controller_nh, "robot_state"),
+      subscribe<franka_core_msgs::RobotStateCompact>(controller_nh, "robot_state_compact"),
+      subscribe<sensor_msgs::JointState>(controller_nh, "joint_states"),
+      subscribe<sensor_msgs::JointState>(controller_nh, "joint_states_desired"),
+      subscribe<franka_core_msgs::EndPointState>(controller_nh, "tip_state"),
+  };
+  ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(5.0);
+  while (ros::ok() && ros::WallTime::now() < deadline &&
+         !std::all_of(subscribers.begin(), subscribers.end(),
+                      [](const ros::Subscriber& s) { return s.getNumPublishers() > 0; })) {
+    ros::WallDuration(0.01).sleep();
+  }
+  // let the connection callbacks of the controller run
+  ros::WallDuration(0.5).sleep();
+
+  const ros::Duration period(0.001);
+  ros::Time time = ros::Time::now();
+  controller.starting(time);
+  for (int i = 0; i < warmup_iterations; ++i) {
+    time += period;
+    robot_hw.tick();
+    controller.update(time, period);
+  }
+
+  std::vector<double> samples(iterations);
+  uint64_t allocations = 0;
+  {
+    ScopedAllocationCounter allocation_counter;
+    for (int i = 0; i < iterations; ++i) {
+      time += period;
+      robot_hw.tick();
+      auto start = std::chrono::steady_clock::now();
+      controller.update(time, period);
+      auto stop = std::chrono::steady_clock::now();
+      samples[i] = std::chrono::duration<double, std::micro>(stop - start).count();
+    }
+    allocations = allocation_counter.count();
+  }
+  controller.stopping(time);
+  spinner.stop();
+
+  const double allocations_per_call = static_cast<double>(allocations) / iterations;
+  const double max_us = *std::max_element(samples.begin(), samples.end());
+  const double p999_us = percentile(samples, 0.999);
+  const double p99_us = percentile(samples, 0.99);
+  const double p50_us = percentile(samples, 0.5);
+  const bool too_slow = max_p999_us >= 0.0 && p999_us > max_p999_us;
+  const bool allocates =
+      max_allocations_per_call >= 0.0 && allocations_per_call > max_allocations_per_call;
+
+  std::printf("\n%d update() calls after %d warm-up calls, all streams subscribed\n\n",
+              iterations, warmup_iterations);
+  std::printf("%-36s %10s %10s %10s %10s %12s\n", "controller", "p50 [us]", "p99 [us]",
+              "p99.9 [us]", "max [us]", "allocs/call");
+  std::printf("%-36s %10.2f %10.2f %10.2f %10.2f %12.3f%s\n", "custom_franka_state_controller",
+              p50_us, p99_us, p999_us, max_us, allocations_per_call,
+              too_slow || allocates ? "  FAILED" : "");
+  return too_slow || allocates ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#ifndef _FRANKA_INTERFACE____BATCH_KINEMATICS_H_
+#define _FRANKA_INTERFACE____BATCH_KINEMATICS_H_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+
+namespace franka_interface {
+
+  class WorkerPool;
+
+  /**
+   * Kinematic chain of the arm in modified (Craig) Denavit-Hartenberg convention, as listed
+   * under /robot_config/kinematics. The defaults are the values of the Panda.
+   */
+  struct KinematicParameters {
+    std::array<double, 7> a{{0.0, 0.0, 0.0, 0.0825, -0.0825, 0.0, 0.088}};
+    std::array<double, 7> d{{0.333, 0.0, 0.316, 0.0, 0.384, 0.0, 0.0}};
+    std::array<double, 7> alpha{{0.0, -M_PI_2, M_PI_2, M_PI_2, -M_PI_2, M_PI_2, M_PI_2}};
+    double flange{0.107};  // link 7 to flange, along z
+  };
+
+  /**
+   * Forward kinematics and zero Jacobians for many joint configurations at once.
+   *
+   * Configurations are processed in blocks of kLanes, with every quantity of a block stored
+   * as a structure of arrays so that the per-joint updates compile to SIMD instructions. The
+   * blocks are shared between a pool of worker threads and the calling thread.
+   *
+   * Results are for the end-effector frame, i.e. the flange followed by F_T_EE, and match
+   * O_T_EE and O_Jac_EE of franka_core_msgs/RobotState for the same F_T_EE.
+   */
+  class BatchKinematics
+  {
+  public:
+    static constexpr size_t kLanes = 8;
+
+  /**
+   * @param[in] parameters Kinematic chain of the arm.
+   * @param[in] threads Number of threads evaluating a batch, including the caller; 0 uses
+   * one per CPU.
+   */
+    explicit BatchKinematics(const KinematicParameters& parameters = KinematicParameters(),
+                             size_t threads = 0);
+    ~BatchKinematics();
+
+  /**
+   * Sets the transformation from the flange to the end-effector frame (column-major,
+   * like franka::RobotState::F_T_EE). Identity by default.
+   */
+    void setEEFrame(const std::array<double, 16>& F_T_EE);
+
+  /**
+   * Evaluates a batch. Thread-safe; concurrent calls are serialised.
+   *
+   * @param[in] q count x 7 joint positions, row-major.
+   * @param[in] count Number of configurations.
+   * @param[out] poses count x 4 x 4 end-effector poses in the base frame, row-major. May
+   * be nullptr.
+   * @param[out] jacobians count x 6 x 7 zero Jacobians (linear rows first), row-major. May
+   * be nullptr.
+   */
+    void evaluate(const double* q, size_t count, double* poses, double* jacobians);
+
+    size_t threads() const;
+
+  private:
+    KinematicParameters parameters_;
+    std::array<double, 16> F_T_EE_;
+    std::unique_ptr<WorkerPool> pool_;
+    std::mutex mutex_;
+
+    void evaluateBlock(const double* q, size_t count, double* poses, double* jacobians) const;
+
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____BATCH_KINEMATICS_H_
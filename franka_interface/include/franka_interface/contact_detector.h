@@ -0,0 +1,119 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#ifndef _FRANKA_INTERFACE____CONTACT_DETECTOR_H_
+#define _FRANKA_INTERFACE____CONTACT_DETECTOR_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <franka/robot_state.h>
+#include <franka_core_msgs/ContactEvent.h>
+#include <ros/ros.h>
+
+
+namespace franka_interface {
+  /**
+   * Contact and collision predicates evaluated on the robot state of every control cycle:
+   * the norm of the estimated external force, per-joint thresholds on tau_ext_hat_filtered and
+   * the contact / collision flags of the robot. Force and torque predicates clear with
+   * hysteresis, once the value drops below release_ratio times the threshold.
+   *
+   * A change of the active predicates is kept as a pending event until fillEvent() takes it,
+   * so an event is not lost when its message cannot be sent in the same cycle.
+   *
+   * Configured by the /robot_config/contact_events parameters.
+   */
+  class ContactDetector
+  {
+  public:
+  /**
+   * Reads the parameters.
+   *
+   * @param[in] node_handle Any node handle; the parameters are read by absolute name.
+   * @param[out] error Reason of the failure.
+   * @return False if the parameters are invalid.
+   */
+    bool init(ros::NodeHandle& node_handle, std::string& error);
+
+    bool isEnabled() const { return enabled_; }
+
+  /**
+   * Evaluates the predicates for one control cycle. Real-time safe.
+   *
+   * @return True if the set of active predicates changed, and in the first cycle.
+   */
+    bool update(const ros::Time& time, const franka::RobotState& robot_state);
+
+  /**
+   * @return franka_core_msgs::ContactEvent::SOURCE_* bits active in the last cycle.
+   */
+    uint8_t sources() const { return active_.sources; }
+
+    bool hasPendingEvent() const { return pending_; }
+
+  /**
+   * Writes the pending event into message and clears it. Real-time safe.
+   */
+    void fillEvent(franka_core_msgs::ContactEvent& message);
+
+  private:
+    struct Predicates {
+      uint8_t sources = 0;
+      uint8_t joint_torque = 0;
+      uint8_t joint_contact = 0;
+      uint8_t joint_collision = 0;
+      uint8_t cartesian_contact = 0;
+      uint8_t cartesian_collision = 0;
+
+      bool operator!=(const Predicates& other) const {
+        return sources != other.sources || joint_torque != other.joint_torque ||
+               joint_contact != other.joint_contact || joint_collision != other.joint_collision ||
+               cartesian_contact != other.cartesian_contact ||
+               cartesian_collision != other.cartesian_collision;
+      }
+    };
+
+    bool enabled_ = false;
+    double force_threshold_ = 0.0;  // 0 disables the force predicate
+    std::array<double, 7> joint_torque_thresholds_{};  // 0 disables the joint
+    double release_ratio_ = 1.0;
+    uint8_t flag_sources_ = 0;  // robot flags to watch, SOURCE_* bits
+
+    Predicates active_;
+    bool first_cycle_ = true;
+
+    // latest change not yet taken by fillEvent()
+    bool pending_ = false;
+    ros::Time pending_stamp_;
+    double pending_time_ = 0.0;
+    uint8_t pending_onsets_ = 0;
+    double external_force_ = 0.0;
+    std::array<double, 7> tau_ext_hat_filtered_{};
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____CONTACT_DETECTOR_H_
@@ -0,0 +1,135 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#ifndef _FRANKA_INTERFACE____CONTROL_LOOP_MONITOR_H_
+#define _FRANKA_INTERFACE____CONTROL_LOOP_MONITOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+
+#include <ros/ros.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/cycle_histogram.h>
+
+
+namespace franka_interface {
+  /**
+   * Instrumentation of the 1 kHz control loop in custom_franka_control_node.
+   *
+   * The control callback records, for every cycle, how long controller_manager::update()
+   * and enforceLimits() took, how far the cycle start deviated from the nominal period and
+   * libfranka's control_command_success_rate, into lock-free histograms. A ros::Timer running
+   * on the spinner threads turns them into windowed statistics and publishes them to
+   * /diagnostics, together with an optional breakdown per controller (see
+   * franka_ros_controllers::ControllerTiming).
+   */
+  class ControlLoopMonitor
+  {
+  public:
+    ControlLoopMonitor();
+
+  /**
+   * Reads the /robot_config/cycle_statistics parameters and starts publishing. Must be
+   * called before any controller is loaded for the per-controller breakdown to apply.
+   *
+   * @param[in] nh Node handle used for the parameters, the timer and the publisher.
+   * @param[in] hardware_id Reported as the hardware_id of the diagnostics.
+   */
+    void init(ros::NodeHandle& nh, const std::string& hardware_id);
+
+  /**
+   * Marks the start of a new motion; the gap since the previous cycle is not counted as
+   * jitter. Records the duration of its first cycle, which runs starting() of the controllers
+   * just switched to, separately from the other cycles. Real-time safe; call from the control
+   * callback once the first cycle is done.
+   *
+   * @param[in] cycle_start Time at which the control callback was entered.
+   */
+    void startMotion(const std::chrono::steady_clock::time_point& cycle_start);
+
+  /**
+   * Records one control cycle. Real-time safe; call from the control callback only.
+   *
+   * @param[in] cycle_start Time at which the control callback was entered.
+   * @param[in] period Period reported by libfranka (multiple of 1 ms).
+   * @param[in] control_command_success_rate From the current franka::RobotState.
+   */
+    void recordCycle(const std::chrono::steady_clock::time_point& cycle_start,
+                     const ros::Duration& period,
+                     double control_command_success_rate);
+
+  private:
+    // microseconds, 1 us bins up to 2 ms
+    using TimeHistogram = franka_ros_controllers::CycleHistogram<2000>;
+    // percent of lost commands, 0.1 % bins
+    using LossHistogram = franka_ros_controllers::CycleHistogram<1000>;
+
+    bool enabled_;
+    std::string hardware_id_;
+    double update_duration_warning_us_;
+
+    TimeHistogram update_duration_;
+    TimeHistogram first_cycle_duration_;
+    TimeHistogram period_jitter_;
+    LossHistogram command_loss_;
+    std::atomic<uint64_t> missed_cycles_;
+
+    // accessed by the control callback only
+    bool have_last_cycle_;
+    std::chrono::steady_clock::time_point last_cycle_start_;
+
+    // accessed by the publishing timer only
+    TimeHistogram::Snapshot last_update_duration_;
+    TimeHistogram::Snapshot last_first_cycle_duration_;
+    TimeHistogram::Snapshot last_period_jitter_;
+    LossHistogram::Snapshot last_command_loss_;
+    uint64_t last_missed_cycles_;
+    std::map<std::string, franka_ros_controllers::ControllerTiming::Histogram::Snapshot>
+        last_controller_durations_;
+
+    ros::Publisher diagnostics_pub_;
+    ros::Timer publish_timer_;
+
+  /**
+   * Publishes the statistics collected since the previous call.
+   */
+    void publishDiagnostics(const ros::TimerEvent& e);
+
+  /**
+   * Appends p50/p99/p99.9/max of a window to a status message.
+   */
+    template <typename Histogram>
+    static void addPercentiles(diagnostic_msgs::DiagnosticStatus& status,
+                               const std::string& prefix,
+                               const Histogram& histogram,
+                               const typename Histogram::Snapshot& window);
+
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____CONTROL_LOOP_MONITOR_H_
@@ -28,14 +28,22 @@
 #ifndef _FRANKA_INTERFACE____MOTION_CONTROLLER_INTERFACE_H_
 #define _FRANKA_INTERFACE____MOTION_CONTROLLER_INTERFACE_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <ros/ros.h>
 #include <controller_manager/controller_manager.h>
 
 #include <std_msgs/Float64.h>
-#include <realtime_tools/realtime_box.h>
 #include <franka_core_msgs/JointCommand.h>
+#include <franka_core_msgs/JointCommandBatch.h>
+#include <franka_ros_controllers/contact_signal.h>
 
 
 namespace franka_interface {
@@ -51,18 +59,27 @@ namespace franka_interface {
     void init(ros::NodeHandle& nh,
          boost::shared_ptr<controller_manager::ControllerManager> controller_manager);
 
+  /**
+   * Stops the switching and contact reaction threads.
+   */
+    ~MotionControllerInterface();
+
   private:
-    // mutex for re-entrant calls to modeCommandCallback
+    // protects the controller bookkeeping below; never held while switching
     std::mutex mtx_;
     int current_mode_;
 
-    realtime_tools::RealtimeBox< std::shared_ptr<const ros::Duration > > box_timeout_length_;
-    realtime_tools::RealtimeBox< std::shared_ptr<const ros::Time > > box_cmd_timeout_;
+    // Command watchdog state, shared lock-free between the command callback and the timer
+    std::atomic<int64_t> command_timeout_ns_;
+    // stamp of the last command, 0 while disarmed (no command since the last timeout)
+    std::atomic<int64_t> last_command_time_ns_;
+    std::atomic<int> requested_mode_;   // mode of requested_controller_name_
 
     ros::Timer cmd_timeout_timer_;
 
     ros::Subscriber joint_command_timeout_sub_;
     ros::Subscriber joint_command_sub_;
+    ros::Subscriber joint_command_batch_sub_;
     boost::shared_ptr<controller_manager::ControllerManager> controller_manager_;
 
     std::string position_controller_name_;
@@ -80,6 +97,29 @@ namespace franka_interface {
     std::vector<std::string> all_controllers_;
 
     std::map<std::string,int> controller_name_to_mode_map_;
+    std::map<int,std::string> mode_to_controller_name_map_;
+
+    // Switch plans, computed once in init(): for every controller it may start, the
+    // controllers that have to be stopped if they are running.
+    std::map<std::string, std::vector<std::string> > stop_candidates_;
+    std::vector<std::string> start_list_;
+    std::vector<std::string> stop_list_;
+
+    // Controller switches run on switch_thread_ so that command callbacks never wait for the
+    // control loop. Only the latest request is kept.
+    std::thread switch_thread_;
+    std::condition_variable switch_cv_;
+    std::string requested_controller_name_;  // latest target, pending or done
+    std::string pending_controller_name_;    // target not yet picked up by switch_thread_
+    bool shutdown_ = false;
+    bool warm_standby_ = false;
+
+    // Contact reaction (robot_config/contact_events/reaction): on a contact onset reported by
+    // the state controller, contact_thread_ requests contact_controller_name_, and other
+    // controllers are not requested until the contact has cleared.
+    std::thread contact_thread_;
+    std::string contact_controller_name_;  // empty if the interface does not react to contacts
+    bool contact_hold_ = false;
   protected:
   /**
    * Callback function to set time out to switch back to position mode. When using torque
@@ -100,17 +140,65 @@ namespace franka_interface {
     void jointCommandCallback(const franka_core_msgs::JointCommandConstPtr& msg);
 
   /**
-   * Switch controller depending on the mode specified.
+   * Same as jointCommandCallback() for a batch of waypoints: starts the controller for the
+   * mode of the batch and feeds the command timeout.
+   *
+   * @param[in] msg JointCommandBatchConstPtr instance containing the waypoints.
+   */
+    void jointCommandBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg);
+
+  /**
+   * Requests the controller for control_mode if needed and records the command time for the
+   * command timeout.
+   */
+    void handleCommand(int control_mode);
+
+  /**
+   * Request the controller for the mode specified. Returns immediately; the switch is carried
+   * out by the switching thread.
    *
    * @param[in] control_mode integer value representing the type of controller to use
+   * @return false if the mode is unknown.
    */
     bool switchControllers(int control_mode);
 
   /**
-   * Switch controller to the initially defined default controller.
+   * Request a switch to the initially defined default controller.
    */
     bool switchToDefaultController();
 
+  /**
+   * Queue a switch to the named controller unless it is already active or requested. With
+   * force the switch is queued even then, as requested_controller_name_ is stale once the
+   * controllers were switched outside the interface; switchToController() only starts and
+   * stops what is needed. Must be called with mtx_ held.
+   */
+    void requestController(const std::string& controller_name, bool force = false);
+
+  /**
+   * Body of switch_thread_: loads the controllers if warm standby is enabled, then performs
+   * requested switches one at a time.
+   */
+    void switchLoop();
+
+  /**
+   * Start the named controller, stopping only those controllers of its plan that are
+   * running. Called from switch_thread_ only.
+   */
+    bool switchToController(const std::string& controller_name);
+
+  /**
+   * Body of contact_thread_: waits for contact changes of the arm and requests
+   * contact_controller_name_ on every onset.
+   */
+    void contactLoop(franka_ros_controllers::ContactSignal* signal);
+
+  /**
+   * Load every controller the interface may switch to that is not loaded yet, so that
+   * switching only has to start it.
+   */
+    void loadStandbyControllers();
+
    /**
    * Check if the command timeout has been violated.
    *
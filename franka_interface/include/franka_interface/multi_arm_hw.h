@@ -0,0 +1,109 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#ifndef _FRANKA_INTERFACE____MULTI_ARM_HW_H_
+#define _FRANKA_INTERFACE____MULTI_ARM_HW_H_
+
+#include <array>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <controller_interface/controller_base.h>
+#include <controller_manager/controller_manager.h>
+#include <franka_hw/franka_hw.h>
+#include <hardware_interface/controller_info.h>
+#include <hardware_interface/robot_hw.h>
+
+
+namespace franka_interface {
+  /**
+   * Hardware of several arms behind one controller manager.
+   *
+   * The interfaces of all FrankaHW instances are combined, so a controller sees the handles of
+   * every arm ("<arm_id>_robot", "<arm_id>_model", the joints of each arm) and a bimanual
+   * controller can read both states in the same update. Controller switches are forwarded to
+   * each arm with only the resources that belong to it, so every FrankaHW selects its own
+   * libfranka control mode.
+   *
+   * The running controllers of each arm are tracked across switches, so that only the
+   * controllers of an arm that starts a new motion are restarted (restartControllers()) instead
+   * of all controllers of the controller manager.
+   */
+  class MultiArmHW : public hardware_interface::RobotHW
+  {
+  public:
+  /**
+   * Adds the interfaces of an arm. hw has to outlive this object; arms must not share joint
+   * names or arm_id.
+   */
+    void addArm(franka_hw::FrankaHW* hw, const std::string& arm_id,
+                const std::array<std::string, 7>& joint_names);
+
+  /**
+   * Sets the controller manager serving this hardware, used to look up the controllers being
+   * started. Must be called before the first controller switch.
+   */
+    void setControllerManager(controller_manager::ControllerManager* manager);
+
+  /**
+   * Stops and starts again the running controllers that claim resources of an arm, as
+   * ControllerManager::update() does for all controllers when reset_controllers is set. To be
+   * called from the control loop before update(). Real-time safe.
+   *
+   * @param[in] arm Index of the arm in the order of addArm() calls.
+   */
+    void restartControllers(size_t arm, const ros::Time& time);
+
+    bool checkForConflict(const std::list<hardware_interface::ControllerInfo>& info) const override;
+    bool prepareSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                       const std::list<hardware_interface::ControllerInfo>& stop_list) override;
+    void doSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                  const std::list<hardware_interface::ControllerInfo>& stop_list) override;
+
+  private:
+    struct Arm
+    {
+      franka_hw::FrankaHW* hw;
+      std::set<std::string> resources;  // joint names and the "<arm_id>_robot" handle
+      // running controllers claiming resources of the arm; changed only in doSwitch()
+      std::map<std::string, controller_interface::ControllerBase*> running;
+      // controllers to be started by the pending switch, looked up in prepareSwitch()
+      std::map<std::string, controller_interface::ControllerBase*> starting;
+    };
+
+  /**
+   * The controllers of list that claim resources of arm, with only those resources.
+   */
+    static std::list<hardware_interface::ControllerInfo> filter(
+        const std::list<hardware_interface::ControllerInfo>& list, const Arm& arm);
+
+    std::vector<Arm> arms_;
+    controller_manager::ControllerManager* manager_{nullptr};
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____MULTI_ARM_HW_H_
@@ -0,0 +1,109 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#ifndef _FRANKA_INTERFACE____MULTI_ARM_SCHEDULER_H_
+#define _FRANKA_INTERFACE____MULTI_ARM_SCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <ros/ros.h>
+
+
+namespace franka_interface {
+  /**
+   * Lock-step scheduling of the control threads of several arms that share one controller
+   * manager.
+   *
+   * Every arm thread calls tick() once per robot cycle, after its FrankaHW has read the new
+   * state and before it sends the command. The last thread to arrive runs the update (the
+   * controller manager) for all arms while the others wait, so controllers see the states of
+   * all arms from the same cycle and every arm's state and commands are only touched by one
+   * thread at a time. The waiting time counts against the cycle budget of the arms that
+   * arrive first, so the arms should be connected to the same host and their threads pinned
+   * to separate CPUs.
+   *
+   * If the other arms do not arrive within sync_timeout, the waiting arm skips the cycle: the
+   * update does not run and the arm sends its previous command again. The update never runs
+   * over an arm whose thread is not waiting, as that thread may be reading its state. Callers
+   * bound the number of consecutive skipped cycles, as arms whose cycles are offset by more
+   * than sync_timeout never meet.
+   */
+  class MultiArmScheduler
+  {
+  public:
+  /**
+   * @param[in] now Time of the cycle (ros::Time::now() when the last arm arrived).
+   * @param[in] period Longest period reported by the arms since their previous cycle.
+   * @param[in] starting For every arm, true if it starts a new motion in this cycle; only its
+   * controllers are to be reset, the other arms keep running theirs.
+   */
+    using Update = std::function<void(const ros::Time& now, const ros::Duration& period,
+                                      const std::vector<bool>& starting)>;
+
+  /**
+   * @param[in] arm_count Number of threads calling tick() every cycle, one per arm.
+   * @param[in] update Run once per cycle by one of the arm threads.
+   * @param[in] sync_timeout Time a thread waits for the other arms before it skips the cycle,
+   * e.g. if an arm lost its connection.
+   */
+    MultiArmScheduler(size_t arm_count, Update update, std::chrono::microseconds sync_timeout);
+
+  /**
+   * Waits until all arms have reached this cycle and returns after the update ran, or leaves
+   * the cycle once sync_timeout passed. Real-time safe apart from the blocking wait.
+   *
+   * @param[in] arm Index of the calling arm, below arm_count.
+   * @param[in] period Period since the previous cycle of the calling arm.
+   * @param[in] start_motion True if the calling arm starts a new motion.
+   * @return false if the cycle was skipped; a motion start is then applied in the next
+   * completed cycle.
+   */
+    bool tick(size_t arm, const ros::Duration& period, bool start_motion);
+
+  private:
+    const size_t arm_count_;
+    const Update update_;
+    const std::chrono::microseconds sync_timeout_;
+
+    std::mutex mutex_;
+    std::condition_variable cycle_done_;
+    uint64_t cycle_;   // number of completed cycles
+    size_t arrived_;   // arms waiting in the current cycle
+    ros::Duration period_;
+    std::vector<bool> starting_;  // per arm, for the current cycle
+
+  /**
+   * Runs the update and starts the next cycle; the mutex must be held.
+   */
+    void completeCycle();
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____MULTI_ARM_SCHEDULER_H_
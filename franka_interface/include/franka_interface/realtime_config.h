@@ -0,0 +1,95 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#ifndef _FRANKA_INTERFACE____REALTIME_CONFIG_H_
+#define _FRANKA_INTERFACE____REALTIME_CONFIG_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <ros/ros.h>
+
+
+namespace franka_interface {
+  /**
+   * Threading and memory configuration of custom_franka_control_node, read from
+   * /robot_config/realtime.
+   *
+   * Threads inherit the CPU affinity and scheduling policy of the thread that creates them,
+   * so the node applies a setting to the main thread right before spawning the threads it is
+   * meant for (spinners), and pins the main thread itself to the control CPUs last, just before
+   * entering the control loop. libfranka raises the control thread to SCHED_FIFO itself.
+   */
+  struct RealtimeConfig
+  {
+    std::vector<int> control_cpus;       // control loop (main) thread; empty: unchanged
+    std::vector<int> non_realtime_cpus;  // spinners and their threads; empty: current affinity
+    bool lock_memory = true;             // mlockall(MCL_CURRENT | MCL_FUTURE)
+    int prefault_stack_size = 512 * 1024;  // bytes of control thread stack touched up front
+    int spinner_threads = 4;
+
+    bool command_queue = true;           // serve command topics from their own queue
+    int command_spinner_threads = 2;
+    int command_spinner_priority = 0;    // SCHED_FIFO priority; 0 keeps SCHED_OTHER
+    std::vector<int> command_spinner_cpus;  // empty: non_realtime_cpus
+
+  /**
+   * Reads the configuration; parameters that are not set keep their defaults.
+   *
+   * @return false if a value is out of range.
+   */
+    bool load(ros::NodeHandle& nh);
+  };
+
+  /**
+   * Restricts the calling thread to the given CPUs. Does nothing for an empty list.
+   *
+   * @return false (after logging a warning) if the affinity could not be set.
+   */
+  bool setCurrentThreadAffinity(const std::vector<int>& cpus);
+
+  /**
+   * Sets the scheduling policy of the calling thread: SCHED_FIFO with the given priority, or
+   * SCHED_OTHER for priority 0.
+   *
+   * @return false (after logging a warning) if not permitted.
+   */
+  bool setCurrentThreadPriority(int priority);
+
+  /**
+   * Locks all current and future pages of the process into RAM, so that the control loop never
+   * takes a major page fault.
+   *
+   * @return false (after logging a warning) if not permitted, e.g. because of RLIMIT_MEMLOCK.
+   */
+  bool lockProcessMemory();
+
+  /**
+   * Touches the given amount of the calling thread's stack so that its pages are mapped (and,
+   * after lockProcessMemory(), locked) before the control loop starts.
+   */
+  void prefaultStack(size_t bytes);
+}
+#endif // #ifndef _FRANKA_INTERFACE____REALTIME_CONFIG_H_
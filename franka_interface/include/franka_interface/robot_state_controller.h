@@ -29,20 +29,30 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <controller_interface/multi_interface_controller.h>
 #include <franka_hw/franka_state_interface.h>
 #include <franka_hw/franka_model_interface.h>
-#include <franka_hw/trigger_rate.h>
+#include <franka_ros_controllers/cached_model_handle.h>
+#include <franka_ros_controllers/contact_signal.h>
+#include <franka_ros_controllers/shm_transport.h>
+#include <franka_interface/contact_detector.h>
+#include <franka_interface/state_recorder.h>
+#include <franka_interface/static_transform_broadcaster.h>
+#include <franka_core_msgs/ContactEvent.h>
 #include <franka_core_msgs/RobotState.h>
+#include <franka_core_msgs/RobotStateCompact.h>
+#include <franka_core_msgs/RobotStateErrors.h>
 #include <franka_core_msgs/EndPointState.h>
 #include <geometry_msgs/WrenchStamped.h>
 #include <realtime_tools/realtime_publisher.h>
 #include <sensor_msgs/JointState.h>
-#include <tf2_msgs/TFMessage.h>
 #include <controller_manager/controller_manager.h>
 #include <Eigen/Dense>
 
@@ -80,25 +90,101 @@ class CustomFrankaStateController
   void update(const ros::Time& time, const ros::Duration& period) override;
 
  private:
+  /**
+   * Publishing schedule of one output stream. A stream is only due while at least one
+   * subscriber is connected, so unused topics cost no RT-thread time.
+   */
+  struct OutputStream {
+    // Publish every decimation-th update(), i.e. at control rate / decimation; 0 never
+    // publishes. A cycle count instead of a wall-clock trigger, so that a stream at the control
+    // rate is published on every cycle.
+    uint32_t decimation{1};
+    uint32_t cycle{0};
+    std::atomic<int> subscribers{0};  // updated from roscpp connect/disconnect callbacks
+    std::atomic<uint64_t> connections{0};  // total number of subscriber connections so far
+    std::vector<ros::Publisher> monitors;
+
+    bool due() {
+      if (decimation == 0) {
+        return false;
+      }
+      // counts every cycle, so the phase does not depend on when subscribers come and go
+      if (++cycle < decimation) {
+        return false;
+      }
+      cycle = 0;
+      return subscribers.load(std::memory_order_relaxed) > 0;
+    }
+  };
+
+  template <typename Message>
+  void monitorSubscribers(ros::NodeHandle& node_handle,
+                          const std::string& topic,
+                          OutputStream& stream);
+
+  void updateModel(bool kinematics, bool dynamics);
   void publishFrankaState(const ros::Time& time);
+  void publishFrankaStateCompact(const ros::Time& time);
+  void publishErrorsOnChange(const franka::RobotState& robot_state,
+                             uint64_t current_errors,
+                             uint64_t last_motion_errors);
+  void publishContactEventOnChange(const ros::Time& time, const franka::RobotState& robot_state);
   void publishJointStates(const ros::Time& time);
-  void publishTransforms(const ros::Time& time);
+  void publishTransformsOnChange(const ros::Time& time, const franka::RobotState& robot_state);
   void publishEndPointState(const ros::Time& time);
+  void writeSharedMemoryState(const franka::RobotState& robot_state);
 
   std::string arm_id_;
 
   franka_hw::FrankaStateInterface* franka_state_interface_{};
   std::unique_ptr<franka_hw::FrankaStateHandle> franka_state_handle_{};
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  franka_ros_controllers::CachedFrankaModelHandle* model_handle_{nullptr};  // shared with the controllers
 
-  realtime_tools::RealtimePublisher<tf2_msgs::TFMessage> publisher_transforms_;
+  StaticTransformBroadcaster* static_transforms_{nullptr};  // of the process, for all arms
+  size_t ee_frame_{0};  // frame indices in static_transforms_
+  size_t k_frame_{0};
   realtime_tools::RealtimePublisher<franka_core_msgs::RobotState> publisher_franka_state_;
+  realtime_tools::RealtimePublisher<franka_core_msgs::RobotStateCompact>
+      publisher_franka_state_compact_;
+  realtime_tools::RealtimePublisher<franka_core_msgs::RobotStateErrors> publisher_errors_;
+  realtime_tools::RealtimePublisher<franka_core_msgs::ContactEvent> publisher_contact_events_;
   realtime_tools::RealtimePublisher<sensor_msgs::JointState> publisher_joint_states_;
   realtime_tools::RealtimePublisher<sensor_msgs::JointState> publisher_joint_states_desired_;
   realtime_tools::RealtimePublisher<franka_core_msgs::EndPointState> publisher_tip_state_;
-  franka_hw::TriggerRate trigger_publish_;
-  franka::RobotState robot_state_;
+  OutputStream franka_state_stream_;
+  OutputStream franka_state_compact_stream_;
+  OutputStream joint_states_stream_;
+  OutputStream tip_state_stream_;
+  const franka::RobotState* robot_state_{nullptr};  // state of the handle, set in init()
+
+  // Model quantities of the current cycle, only computed when a due stream needs them.
+  std::array<double, 42> O_Jac_EE_{};
+  std::array<double, 6> O_dP_EE_{};
+  std::array<double, 7> coriolis_{};
+  std::array<double, 7> gravity_{};
+  std::array<double, 49> mass_matrix_{};
+
+  uint8_t compact_groups_{0};  // franka_core_msgs::RobotStateCompact::GROUP_* selected for publishing
+  uint64_t compact_errors_connections_{0};  // connection count when errors were last sent
+
+  // link8 -> EE and EE -> K only change through the set_EE_frame / set_K_frame services, so they
+  // are latched on /tf_static and republished when the robot reports new values.
+  std::array<double, 16> published_F_T_EE_{};
+  std::array<double, 16> published_EE_T_K_{};
+
+  bool errors_published_{false};
+  uint64_t published_current_errors_{0};
+  uint64_t published_last_motion_errors_{0};
+  uint64_t compact_current_errors_{0};
+  uint64_t compact_last_motion_errors_{0};
   uint64_t sequence_number_ = 0;
+  franka_ros_controllers::shm::Transport shm_transport_;
+  franka_ros_controllers::shm::StateSample shm_state_{};
+  uint64_t shm_sequence_number_ = 0;
+  StateRecorder state_recorder_;
+  ContactDetector contact_detector_;
+  // set if the motion controller interface reacts to contacts, see contact_events/reaction
+  franka_ros_controllers::ContactSignal* contact_signal_{nullptr};
   std::vector<std::string> joint_names_;
 };
 
@@ -0,0 +1,151 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#ifndef _FRANKA_INTERFACE____STATE_RECORDER_H_
+#define _FRANKA_INTERFACE____STATE_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <franka/robot_state.h>
+#include <ros/ros.h>
+#include <std_srvs/Trigger.h>
+
+
+namespace franka_interface {
+  /**
+   * Records every control cycle of the robot state into a binary file.
+   *
+   * The RT thread copies each sample into a preallocated single-producer single-consumer ring;
+   * a writer thread drains it and appends it to the file in column-oriented chunks (see
+   * franka_interface.state_recording for the file layout and a NumPy reader). In flight mode
+   * only the last flight_duration seconds are kept in memory and written to a new file when
+   * the robot reports an error (reflex, limit violation, ...) or when the dump_state_recording
+   * service is called.
+   *
+   * Configured by the /robot_config/state_recorder parameters.
+   */
+  class StateRecorder
+  {
+  public:
+    /**
+     * Number of doubles per sample; the columns are listed in state_recorder.cpp.
+     */
+    static constexpr size_t kSampleWidth = 128;
+
+    StateRecorder();
+    ~StateRecorder();
+
+  /**
+   * Reads the parameters and, if the recorder is enabled, opens the output file (continuous
+   * mode), advertises the dump service and starts the writer thread.
+   *
+   * @param[in] node_handle Node handle in the controller namespace.
+   * @param[in] arm_id Arm whose state is recorded; in a multi-arm node it is part of the file
+   * names, so that the arms do not write to the same files.
+   * @param[out] error Reason of the failure.
+   * @return False if the recorder is enabled but could not be started.
+   */
+    bool init(ros::NodeHandle& node_handle, const std::string& arm_id, std::string& error);
+
+    bool isEnabled() const { return enabled_; }
+
+  /**
+   * Queues one sample. Real-time safe; call from the controller's update() only. Samples are
+   * dropped (and counted) while the ring is full.
+   *
+   * @param[in] time ROS time of the control cycle.
+   * @param[in] robot_state Current robot state; tau_J_d is the torque commanded by the active
+   * controller.
+   * @param[in] robot_mode franka_core_msgs::RobotState::ROBOT_MODE_*.
+   * @param[in] current_errors Bit mask of robot_state.current_errors.
+   * @param[in] last_motion_errors Bit mask of robot_state.last_motion_errors.
+   */
+    void record(const ros::Time& time,
+                const franka::RobotState& robot_state,
+                uint8_t robot_mode,
+                uint64_t current_errors,
+                uint64_t last_motion_errors);
+
+  private:
+    bool enabled_;
+    bool flight_mode_;
+    std::string directory_;
+    std::string state_prefix_;   // file name prefixes, "state" and "flight" with the arm_id
+    std::string flight_prefix_;  // in a multi-arm node
+    size_t chunk_samples_;
+
+    // SPSC ring, written by record() and drained by the writer thread
+    std::vector<double> ring_;
+    size_t ring_mask_;
+    std::atomic<uint64_t> ring_head_;
+    std::atomic<uint64_t> ring_tail_;
+    std::atomic<uint64_t> dropped_samples_;
+    uint64_t sequence_;  // RT thread only
+
+    // accessed by the writer thread only
+    FILE* file_;
+    std::string path_;
+    std::vector<double> chunk_rows_;
+    std::vector<double> chunk_columns_;
+    size_t chunk_count_;
+    uint64_t file_samples_;
+    std::vector<double> history_;  // flight mode, history_samples_ rows
+    size_t history_samples_;
+    size_t history_next_;
+    size_t history_count_;
+    size_t post_trigger_samples_;
+    int64_t dump_countdown_;  // samples left before a pending dump, -1 if none
+    bool had_errors_;
+
+    std::atomic<bool> dump_requested_;
+    std::atomic<bool> running_;
+    std::thread writer_thread_;
+    ros::ServiceServer dump_service_;
+
+    void writerLoop();
+    void drain();
+    void addToHistory(const double* sample);
+    void dumpHistory();
+    /**
+     * Creates a recording file and writes the file and column headers.
+     */
+    bool openFile(const std::string& prefix, std::string& error);
+    void closeFile();
+    void appendToChunk(const double* sample);
+    /**
+     * Writes the buffered samples as one column-oriented chunk.
+     */
+    void writeChunk();
+    bool dumpCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____STATE_RECORDER_H_
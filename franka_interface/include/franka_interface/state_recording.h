@@ -0,0 +1,77 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#ifndef _FRANKA_INTERFACE____STATE_RECORDING_H_
+#define _FRANKA_INTERFACE____STATE_RECORDING_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace franka_interface {
+  /**
+   * Reads a recording written by StateRecorder, the C++ counterpart of
+   * franka_interface.state_recording. The whole file is loaded, with every column
+   * concatenated over the chunks. A last chunk that was only partly written is ignored.
+   */
+  class StateRecording
+  {
+  public:
+  /**
+   * @param[in] path Recording file.
+   * @param[out] error Reason of the failure.
+   * @return False if the file could not be read or is not a recording.
+   */
+    bool open(const std::string& path, std::string& error);
+
+    size_t size() const { return samples_; }
+
+    bool isFlight() const { return flight_; }
+
+  /**
+   * @return Column names in file order.
+   */
+    std::vector<std::string> names() const;
+
+  /**
+   * @param[in] name Column name, as in state_recorder.cpp.
+   * @param[out] width Number of values per sample.
+   * @return size() * width values, sample-major, or nullptr if there is no such column.
+   */
+    const double* column(const std::string& name, size_t& width) const;
+
+  private:
+    size_t samples_{0};
+    bool flight_{false};
+    std::vector<std::pair<std::string, size_t>> columns_;  // name, width
+    std::map<std::string, std::vector<double>> data_;
+
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____STATE_RECORDING_H_
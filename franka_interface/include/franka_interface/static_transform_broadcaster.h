@@ -0,0 +1,97 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#ifndef _FRANKA_INTERFACE____STATIC_TRANSFORM_BROADCASTER_H_
+#define _FRANKA_INTERFACE____STATIC_TRANSFORM_BROADCASTER_H_
+
+#include <cstddef>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <realtime_tools/realtime_publisher.h>
+#include <ros/ros.h>
+#include <tf2_msgs/TFMessage.h>
+
+
+namespace franka_interface {
+  /**
+   * The latched /tf_static publisher of the process, shared by the state controllers of all
+   * arms.
+   *
+   * A latched topic keeps only the last message a process sent on it, so with a publisher per
+   * controller a multi-arm node would latch the frames of one arm only. All frames are kept in
+   * one message instead: a controller sets its frames when it is initialised, and the control
+   * loop updates them in place with the trylock() / unlockAndPublish() protocol of
+   * realtime_tools::RealtimePublisher, which sends the frames of every arm again.
+   */
+  class StaticTransformBroadcaster
+  {
+  public:
+  /**
+   * The broadcaster of this process, created on first use and kept for the life of the
+   * process. Not real-time safe.
+   *
+   * @param[in] node_handle Any node handle; /tf_static is advertised by absolute name.
+   */
+    static StaticTransformBroadcaster& get(ros::NodeHandle& node_handle);
+
+    StaticTransformBroadcaster(const StaticTransformBroadcaster&) = delete;
+    StaticTransformBroadcaster& operator=(const StaticTransformBroadcaster&) = delete;
+
+  /**
+   * Sets the frame transform.child_frame_id, replacing it if it was set before (e.g. by a
+   * controller that is loaded again), and publishes all frames. Not real-time safe.
+   *
+   * @return Index of the frame for frame().
+   */
+    size_t setFrame(const geometry_msgs::TransformStamped& transform);
+
+  /**
+   * Takes the message for an update from the control loop. Real-time safe.
+   *
+   * @return False if the previous message is still being sent; try again on the next cycle.
+   */
+    bool trylock() { return publisher_.trylock(); }
+
+  /**
+   * A frame by the index setFrame() returned, between a successful trylock() and
+   * unlockAndPublish(). Real-time safe.
+   */
+    geometry_msgs::TransformStamped& frame(size_t index) {
+      return publisher_.msg_.transforms[index];
+    }
+
+  /**
+   * Publishes all frames and releases the message. Real-time safe.
+   */
+    void unlockAndPublish() { publisher_.unlockAndPublish(); }
+
+  private:
+    explicit StaticTransformBroadcaster(ros::NodeHandle& node_handle);
+
+    realtime_tools::RealtimePublisher<tf2_msgs::TFMessage> publisher_;
+  };
+}
+#endif // #ifndef _FRANKA_INTERFACE____STATIC_TRANSFORM_BROADCASTER_H_
@@ -0,0 +1,192 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_interface/batch_kinematics.h>
+
+#include <algorithm>
+
+#include "worker_pool.h"
+
+namespace franka_interface {
+
+namespace {
+
+constexpr size_t kLanes = BatchKinematics::kLanes;
+constexpr size_t kBlocksPerTask = 16;
+
+// One value per configuration of a block.
+using Lanes = double[kLanes];
+
+// Frame of a block: rotation columns x, y, z and origin, each component as lanes.
+struct Frames {
+  alignas(64) Lanes r[3][3];  // r[column][row]
+  alignas(64) Lanes p[3];
+};
+
+}  // anonymous namespace
+
+BatchKinematics::BatchKinematics(const KinematicParameters& parameters, size_t threads)
+    : parameters_(parameters),
+      F_T_EE_{{1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0}} {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  pool_ = std::make_unique<WorkerPool>(threads);
+}
+
+BatchKinematics::~BatchKinematics() = default;
+
+void BatchKinematics::setEEFrame(const std::array<double, 16>& F_T_EE) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  F_T_EE_ = F_T_EE;
+}
+
+size_t BatchKinematics::threads() const {
+  return pool_->size();
+}
+
+void BatchKinematics::evaluate(const double* q, size_t count, double* poses, double* jacobians) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t blocks = (count + kLanes - 1) / kLanes;
+  pool_->run(blocks, kBlocksPerTask, [&](size_t begin, size_t end) {
+    for (size_t block = begin; block < end; ++block) {
+      size_t first = block * kLanes;
+      evaluateBlock(q + first * 7, std::min(kLanes, count - first),
+                    poses == nullptr ? nullptr : poses + first * 16,
+                    jacobians == nullptr ? nullptr : jacobians + first * 42);
+    }
+  });
+}
+
+void BatchKinematics::evaluateBlock(const double* q,
+                                    size_t count,
+                                    double* poses,
+                                    double* jacobians) const {
+  // cos/sin of the joint angles, unused lanes of the last block at q = 0
+  alignas(64) Lanes cos_q[7];
+  alignas(64) Lanes sin_q[7];
+  for (size_t joint = 0; joint < 7; ++joint) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      double angle = lane < count ? q[lane * 7 + joint] : 0.0;
+      cos_q[joint][lane] = std::cos(angle);
+      sin_q[joint][lane] = std::sin(angle);
+    }
+  }
+
+  Frames frame;
+  for (size_t column = 0; column < 3; ++column) {
+    for (size_t row = 0; row < 3; ++row) {
+      std::fill(frame.r[column][row], frame.r[column][row] + kLanes,
+                column == row ? 1.0 : 0.0);
+    }
+  }
+  for (size_t row = 0; row < 3; ++row) {
+    std::fill(frame.p[row], frame.p[row] + kLanes, 0.0);
+  }
+
+  // joint axes and origins, for the Jacobian
+  alignas(64) Lanes axis[7][3];
+  alignas(64) Lanes origin[7][3];
+
+  for (size_t joint = 0; joint < 7; ++joint) {
+    // T = T * RotX(alpha) * TransX(a) * RotZ(q) * TransZ(d)
+    const double a = parameters_.a[joint];
+    const double d = parameters_.d[joint];
+    const double cos_alpha = std::cos(parameters_.alpha[joint]);
+    const double sin_alpha = std::sin(parameters_.alpha[joint]);
+    for (size_t row = 0; row < 3; ++row) {
+      double* x = frame.r[0][row];
+      double* y = frame.r[1][row];
+      double* z = frame.r[2][row];
+      double* p = frame.p[row];
+      const double* c = cos_q[joint];
+      const double* s = sin_q[joint];
+      for (size_t lane = 0; lane < kLanes; ++lane) {
+        double y_alpha = cos_alpha * y[lane] + sin_alpha * z[lane];
+        double z_alpha = cos_alpha * z[lane] - sin_alpha * y[lane];
+        double x_q = c[lane] * x[lane] + s[lane] * y_alpha;
+        double y_q = c[lane] * y_alpha - s[lane] * x[lane];
+        p[lane] += a * x[lane] + d * z_alpha;
+        x[lane] = x_q;
+        y[lane] = y_q;
+        z[lane] = z_alpha;
+      }
+      std::copy(z, z + kLanes, axis[joint][row]);
+      std::copy(p, p + kLanes, origin[joint][row]);
+    }
+  }
+
+  // flange, then F_T_EE
+  Frames end_effector;
+  for (size_t row = 0; row < 3; ++row) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      double p = frame.p[row][lane] + parameters_.flange * frame.r[2][row][lane];
+      for (size_t column = 0; column < 3; ++column) {
+        end_effector.r[column][row][lane] = frame.r[0][row][lane] * F_T_EE_[column * 4] +
+                                            frame.r[1][row][lane] * F_T_EE_[column * 4 + 1] +
+                                            frame.r[2][row][lane] * F_T_EE_[column * 4 + 2];
+      }
+      end_effector.p[row][lane] = p + frame.r[0][row][lane] * F_T_EE_[12] +
+                                  frame.r[1][row][lane] * F_T_EE_[13] +
+                                  frame.r[2][row][lane] * F_T_EE_[14];
+    }
+  }
+
+  for (size_t lane = 0; lane < count; ++lane) {
+    if (poses != nullptr) {
+      double* pose = poses + lane * 16;
+      for (size_t row = 0; row < 3; ++row) {
+        for (size_t column = 0; column < 3; ++column) {
+          pose[row * 4 + column] = end_effector.r[column][row][lane];
+        }
+        pose[row * 4 + 3] = end_effector.p[row][lane];
+      }
+      pose[12] = 0.0;
+      pose[13] = 0.0;
+      pose[14] = 0.0;
+      pose[15] = 1.0;
+    }
+    if (jacobians != nullptr) {
+      // linear: axis x (p_EE - origin), angular: axis
+      double* jacobian = jacobians + lane * 42;
+      for (size_t joint = 0; joint < 7; ++joint) {
+        double zx = axis[joint][0][lane];
+        double zy = axis[joint][1][lane];
+        double zz = axis[joint][2][lane];
+        double dx = end_effector.p[0][lane] - origin[joint][0][lane];
+        double dy = end_effector.p[1][lane] - origin[joint][1][lane];
+        double dz = end_effector.p[2][lane] - origin[joint][2][lane];
+        jacobian[0 * 7 + joint] = zy * dz - zz * dy;
+        jacobian[1 * 7 + joint] = zz * dx - zx * dz;
+        jacobian[2 * 7 + joint] = zx * dy - zy * dx;
+        jacobian[3 * 7 + joint] = zx;
+        jacobian[4 * 7 + joint] = zy;
+        jacobian[5 * 7 + joint] = zz;
+      }
+    }
+  }
+}
+
+}  // namespace franka_interface
@@ -0,0 +1,79 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+// C interface of BatchKinematics for franka_interface.batch_kinematics (loaded with ctypes),
+// so that NumPy arrays are passed as pointers and filled in place.
+
+#include <algorithm>
+
+#include <franka_interface/batch_kinematics.h>
+
+extern "C" {
+
+// a, d, alpha: 7 values each; threads: 0 for one per CPU.
+void* franka_batch_kinematics_create(const double* a,
+                                     const double* d,
+                                     const double* alpha,
+                                     double flange,
+                                     int threads) {
+  franka_interface::KinematicParameters parameters;
+  std::copy(a, a + 7, parameters.a.begin());
+  std::copy(d, d + 7, parameters.d.begin());
+  std::copy(alpha, alpha + 7, parameters.alpha.begin());
+  parameters.flange = flange;
+  try {
+    return new franka_interface::BatchKinematics(parameters,
+                                                 static_cast<size_t>(std::max(threads, 0)));
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+}
+
+void franka_batch_kinematics_destroy(void* kinematics) {
+  delete static_cast<franka_interface::BatchKinematics*>(kinematics);
+}
+
+// F_T_EE: 16 values, column-major.
+void franka_batch_kinematics_set_ee_frame(void* kinematics, const double* F_T_EE) {
+  std::array<double, 16> transform;
+  std::copy(F_T_EE, F_T_EE + 16, transform.begin());
+  static_cast<franka_interface::BatchKinematics*>(kinematics)->setEEFrame(transform);
+}
+
+int franka_batch_kinematics_threads(void* kinematics) {
+  return static_cast<int>(static_cast<franka_interface::BatchKinematics*>(kinematics)->threads());
+}
+
+// See BatchKinematics::evaluate(); poses and jacobians may be NULL.
+void franka_batch_kinematics_evaluate(void* kinematics,
+                                      const double* q,
+                                      size_t count,
+                                      double* poses,
+                                      double* jacobians) {
+  static_cast<franka_interface::BatchKinematics*>(kinematics)->evaluate(q, count, poses,
+                                                                        jacobians);
+}
+
+}  // extern "C"
@@ -0,0 +1,193 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_interface/contact_detector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace franka_interface {
+
+namespace {
+
+typedef franka_core_msgs::ContactEvent ContactEvent;
+
+template <size_t N>
+uint8_t flagsToMask(const std::array<double, N>& flags) {
+  uint8_t mask = 0;
+  for (size_t i = 0; i < N; ++i) {
+    if (flags[i] != 0.0) {
+      mask |= static_cast<uint8_t>(1u << i);
+    }
+  }
+  return mask;
+}
+
+// A threshold predicate becomes active above threshold and stays active down to
+// release_ratio * threshold.
+bool exceeds(double value, double threshold, double release_ratio, bool active) {
+  return active ? value >= release_ratio * threshold : value > threshold;
+}
+
+}  // anonymous namespace
+
+bool ContactDetector::init(ros::NodeHandle& node_handle, std::string& error) {
+  std::vector<double> joint_torque_thresholds;
+  std::vector<std::string> robot_flags{"joint_collision", "cartesian_collision"};
+  node_handle.param<bool>("/robot_config/contact_events/enabled", enabled_, true);
+  node_handle.param<double>("/robot_config/contact_events/force_threshold", force_threshold_,
+                            0.0);
+  node_handle.param("/robot_config/contact_events/joint_torque_thresholds",
+                    joint_torque_thresholds, joint_torque_thresholds);
+  node_handle.param<double>("/robot_config/contact_events/release_ratio", release_ratio_, 0.8);
+  node_handle.param("/robot_config/contact_events/robot_flags", robot_flags, robot_flags);
+  if (!enabled_) {
+    return true;
+  }
+
+  if (force_threshold_ < 0.0) {
+    error = "contact_events/force_threshold must not be negative";
+    return false;
+  }
+  if (!joint_torque_thresholds.empty() &&
+      joint_torque_thresholds.size() != joint_torque_thresholds_.size()) {
+    error = "contact_events/joint_torque_thresholds needs one value per joint";
+    return false;
+  }
+  joint_torque_thresholds_.fill(0.0);
+  for (size_t i = 0; i < joint_torque_thresholds.size(); ++i) {
+    if (joint_torque_thresholds[i] < 0.0) {
+      error = "contact_events/joint_torque_thresholds must not be negative";
+      return false;
+    }
+    joint_torque_thresholds_[i] = joint_torque_thresholds[i];
+  }
+  if (release_ratio_ <= 0.0 || release_ratio_ > 1.0) {
+    error = "contact_events/release_ratio must be in (0, 1]";
+    return false;
+  }
+  flag_sources_ = 0;
+  for (const std::string& flag : robot_flags) {
+    if (flag == "joint_contact") {
+      flag_sources_ |= ContactEvent::SOURCE_JOINT_CONTACT;
+    } else if (flag == "joint_collision") {
+      flag_sources_ |= ContactEvent::SOURCE_JOINT_COLLISION;
+    } else if (flag == "cartesian_contact") {
+      flag_sources_ |= ContactEvent::SOURCE_CARTESIAN_CONTACT;
+    } else if (flag == "cartesian_collision") {
+      flag_sources_ |= ContactEvent::SOURCE_CARTESIAN_COLLISION;
+    } else {
+      error = "Unknown contact_events/robot_flags entry " + flag +
+              ". Valid flags are joint_contact, joint_collision, cartesian_contact and "
+              "cartesian_collision.";
+      return false;
+    }
+  }
+  active_ = Predicates();
+  first_cycle_ = true;
+  pending_ = false;
+  return true;
+}
+
+bool ContactDetector::update(const ros::Time& time, const franka::RobotState& robot_state) {
+  Predicates predicates;
+
+  const std::array<double, 6>& wrench = robot_state.O_F_ext_hat_K;
+  const double external_force =
+      std::sqrt(wrench[0] * wrench[0] + wrench[1] * wrench[1] + wrench[2] * wrench[2]);
+  if (force_threshold_ > 0.0 &&
+      exceeds(external_force, force_threshold_, release_ratio_,
+              active_.sources & ContactEvent::SOURCE_EXTERNAL_FORCE)) {
+    predicates.sources |= ContactEvent::SOURCE_EXTERNAL_FORCE;
+  }
+
+  for (size_t i = 0; i < joint_torque_thresholds_.size(); ++i) {
+    const uint8_t bit = static_cast<uint8_t>(1u << i);
+    if (joint_torque_thresholds_[i] > 0.0 &&
+        exceeds(std::abs(robot_state.tau_ext_hat_filtered[i]), joint_torque_thresholds_[i],
+                release_ratio_, active_.joint_torque & bit)) {
+      predicates.joint_torque |= bit;
+    }
+  }
+  if (predicates.joint_torque != 0) {
+    predicates.sources |= ContactEvent::SOURCE_JOINT_TORQUE;
+  }
+
+  if (flag_sources_ & ContactEvent::SOURCE_JOINT_CONTACT) {
+    predicates.joint_contact = flagsToMask(robot_state.joint_contact);
+  }
+  if (flag_sources_ & ContactEvent::SOURCE_JOINT_COLLISION) {
+    predicates.joint_collision = flagsToMask(robot_state.joint_collision);
+  }
+  if (flag_sources_ & ContactEvent::SOURCE_CARTESIAN_CONTACT) {
+    predicates.cartesian_contact = flagsToMask(robot_state.cartesian_contact);
+  }
+  if (flag_sources_ & ContactEvent::SOURCE_CARTESIAN_COLLISION) {
+    predicates.cartesian_collision = flagsToMask(robot_state.cartesian_collision);
+  }
+  predicates.sources |= (predicates.joint_contact ? ContactEvent::SOURCE_JOINT_CONTACT : 0) |
+                        (predicates.joint_collision ? ContactEvent::SOURCE_JOINT_COLLISION : 0) |
+                        (predicates.cartesian_contact ? ContactEvent::SOURCE_CARTESIAN_CONTACT : 0) |
+                        (predicates.cartesian_collision ? ContactEvent::SOURCE_CARTESIAN_COLLISION
+                                                        : 0);
+
+  // the first cycle is always reported, so that the latched topic carries the current state
+  if (!first_cycle_ && !(predicates != active_)) {
+    return false;
+  }
+  first_cycle_ = false;
+  // Several changes before the event is sent: keep the stamp of the first one and report
+  // every predicate that became active in between.
+  if (!pending_) {
+    pending_ = true;
+    pending_stamp_ = time;
+    pending_time_ = robot_state.time.toSec();
+    pending_onsets_ = 0;
+  }
+  pending_onsets_ |= predicates.sources & ~active_.sources;
+  external_force_ = external_force;
+  tau_ext_hat_filtered_ = robot_state.tau_ext_hat_filtered;
+  active_ = predicates;
+  return true;
+}
+
+void ContactDetector::fillEvent(franka_core_msgs::ContactEvent& message) {
+  message.header.stamp = pending_stamp_;
+  message.time = pending_time_;
+  message.sources = active_.sources;
+  message.onsets = pending_onsets_;
+  message.joint_torque_mask = active_.joint_torque;
+  message.joint_contact_mask = active_.joint_contact;
+  message.joint_collision_mask = active_.joint_collision;
+  message.cartesian_contact_mask = active_.cartesian_contact;
+  message.cartesian_collision_mask = active_.cartesian_collision;
+  message.external_force = external_force_;
+  std::copy(tau_ext_hat_filtered_.begin(), tau_ext_hat_filtered_.end(),
+            message.tau_ext_hat_filtered.begin());
+  pending_ = false;
+}
+
+}  // namespace franka_interface
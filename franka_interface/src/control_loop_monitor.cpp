@@ -0,0 +1,230 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#include <franka_interface/control_loop_monitor.h>
+
+#include <cmath>
+#include <sstream>
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <diagnostic_msgs/KeyValue.h>
+
+namespace franka_interface {
+
+namespace {
+
+constexpr double kNominalPeriodUs = 1000.0;
+
+void addValue(diagnostic_msgs::DiagnosticStatus& status, const std::string& key, double value) {
+  diagnostic_msgs::KeyValue key_value;
+  key_value.key = key;
+  std::ostringstream stream;
+  stream << value;
+  key_value.value = stream.str();
+  status.values.push_back(key_value);
+}
+
+}  // anonymous namespace
+
+ControlLoopMonitor::ControlLoopMonitor()
+    : enabled_(false),
+      update_duration_warning_us_(500.0),
+      update_duration_(1.0),
+      first_cycle_duration_(1.0),
+      period_jitter_(1.0),
+      command_loss_(0.1),
+      missed_cycles_(0),
+      have_last_cycle_(false),
+      last_missed_cycles_(0) {}
+
+void ControlLoopMonitor::init(ros::NodeHandle& nh, const std::string& hardware_id) {
+  hardware_id_ = hardware_id;
+
+  bool per_controller;
+  double publish_rate;
+  nh.param<bool>("/robot_config/cycle_statistics/enabled", enabled_, true);
+  nh.param<bool>("/robot_config/cycle_statistics/per_controller", per_controller, false);
+  nh.param<double>("/robot_config/cycle_statistics/publish_rate", publish_rate, 1.0);
+  nh.param<double>("/robot_config/cycle_statistics/update_duration_warning",
+                   update_duration_warning_us_, 500.0);
+  if (!enabled_) {
+    return;
+  }
+  if (publish_rate <= 0.0) {
+    ROS_WARN("ControlLoopMonitor: Invalid cycle_statistics/publish_rate, using 1 Hz");
+    publish_rate = 1.0;
+  }
+
+  franka_ros_controllers::ControllerTiming::instance().setEnabled(per_controller);
+
+  update_duration_.read(last_update_duration_);
+  first_cycle_duration_.read(last_first_cycle_duration_);
+  period_jitter_.read(last_period_jitter_);
+  command_loss_.read(last_command_loss_);
+
+  diagnostics_pub_ = nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+  publish_timer_ = nh.createTimer(ros::Duration(1.0 / publish_rate),
+                                  &ControlLoopMonitor::publishDiagnostics, this);
+}
+
+void ControlLoopMonitor::startMotion(const std::chrono::steady_clock::time_point& cycle_start) {
+  have_last_cycle_ = false;
+  if (!enabled_) {
+    return;
+  }
+  first_cycle_duration_.record(std::chrono::duration<double, std::micro>(
+                                   std::chrono::steady_clock::now() - cycle_start)
+                                   .count());
+}
+
+void ControlLoopMonitor::recordCycle(const std::chrono::steady_clock::time_point& cycle_start,
+                                     const ros::Duration& period,
+                                     double control_command_success_rate) {
+  if (!enabled_) {
+    return;
+  }
+  const std::chrono::steady_clock::time_point cycle_end = std::chrono::steady_clock::now();
+  update_duration_.record(std::chrono::duration<double, std::micro>(cycle_end - cycle_start).count());
+
+  if (have_last_cycle_) {
+    const double interval_us =
+        std::chrono::duration<double, std::micro>(cycle_start - last_cycle_start_).count();
+    period_jitter_.record(std::abs(interval_us - kNominalPeriodUs));
+  }
+  last_cycle_start_ = cycle_start;
+  have_last_cycle_ = true;
+
+  // libfranka reports a multiple of the nominal period when packets were lost in between.
+  const int64_t cycles = std::llround(period.toSec() * 1e6 / kNominalPeriodUs);
+  if (cycles > 1) {
+    missed_cycles_.fetch_add(static_cast<uint64_t>(cycles - 1), std::memory_order_relaxed);
+  }
+  command_loss_.record(100.0 * (1.0 - control_command_success_rate));
+}
+
+template <typename Histogram>
+void ControlLoopMonitor::addPercentiles(diagnostic_msgs::DiagnosticStatus& status,
+                                        const std::string& prefix,
+                                        const Histogram& histogram,
+                                        const typename Histogram::Snapshot& window) {
+  addValue(status, prefix + " p50", histogram.percentile(window, 0.5));
+  addValue(status, prefix + " p99", histogram.percentile(window, 0.99));
+  addValue(status, prefix + " p99.9", histogram.percentile(window, 0.999));
+  addValue(status, prefix + " max", histogram.windowMax(window));
+}
+
+void ControlLoopMonitor::publishDiagnostics(const ros::TimerEvent& e) {
+  diagnostic_msgs::DiagnosticArray array;
+  array.header.stamp = ros::Time::now();
+
+  TimeHistogram::Snapshot now, window;
+  update_duration_.read(now);
+  TimeHistogram::difference(now, last_update_duration_, window);
+  last_update_duration_ = now;
+
+  diagnostic_msgs::DiagnosticStatus loop;
+  loop.name = "franka_control: control loop";
+  loop.hardware_id = hardware_id_;
+  addValue(loop, "cycles", window.total);
+  const double worst_update_us = update_duration_.windowMax(window);
+  addPercentiles(loop, "update duration [us]", update_duration_, window);
+
+  TimeHistogram::Snapshot first_cycle_window;
+  first_cycle_duration_.read(now);
+  TimeHistogram::difference(now, last_first_cycle_duration_, first_cycle_window);
+  last_first_cycle_duration_ = now;
+  addValue(loop, "motions started", first_cycle_window.total);
+  const double worst_first_cycle_us = first_cycle_duration_.windowMax(first_cycle_window);
+  if (first_cycle_window.total > 0) {
+    addValue(loop, "first cycle duration max [us]", worst_first_cycle_us);
+    if (worst_first_cycle_us > update_duration_warning_us_) {
+      ROS_WARN("ControlLoopMonitor: First control cycle after a controller switch took %.0f us",
+               worst_first_cycle_us);
+    }
+  }
+
+  period_jitter_.read(now);
+  TimeHistogram::difference(now, last_period_jitter_, window);
+  last_period_jitter_ = now;
+  addPercentiles(loop, "period jitter [us]", period_jitter_, window);
+
+  const uint64_t missed_cycles = missed_cycles_.load(std::memory_order_relaxed);
+  const uint64_t missed_in_window = missed_cycles - last_missed_cycles_;
+  last_missed_cycles_ = missed_cycles;
+  addValue(loop, "missed cycles", missed_in_window);
+  addValue(loop, "missed cycles total", missed_cycles);
+
+  LossHistogram::Snapshot loss_now, loss_window;
+  command_loss_.read(loss_now);
+  LossHistogram::difference(loss_now, last_command_loss_, loss_window);
+  last_command_loss_ = loss_now;
+  if (loss_window.total > 0) {
+    addValue(loop, "control command success rate mean [%]",
+             100.0 - loss_window.sum / loss_window.total);
+    addValue(loop, "control command success rate p0.1 [%]",
+             100.0 - command_loss_.percentile(loss_window, 0.999));
+  }
+
+  const bool slow_first_cycle =
+      first_cycle_window.total > 0 && worst_first_cycle_us > update_duration_warning_us_;
+  if (window.total == 0 && !slow_first_cycle) {
+    loop.level = diagnostic_msgs::DiagnosticStatus::OK;
+    loop.message = "No motion running";
+  } else if (missed_in_window > 0 || slow_first_cycle ||
+             worst_update_us > update_duration_warning_us_) {
+    loop.level = diagnostic_msgs::DiagnosticStatus::WARN;
+    loop.message = missed_in_window > 0 ? "Cycles were missed"
+                   : slow_first_cycle   ? "Slow first cycle after a controller switch"
+                                        : "Slow controller update";
+  } else {
+    loop.level = diagnostic_msgs::DiagnosticStatus::OK;
+    loop.message = "OK";
+  }
+  array.status.push_back(loop);
+
+  using franka_ros_controllers::ControllerTiming;
+  ControllerTiming::instance().forEach(
+      [&](const std::string& name, const ControllerTiming::Histogram& histogram) {
+        ControllerTiming::Histogram::Snapshot controller_now, controller_window;
+        histogram.read(controller_now);
+        ControllerTiming::Histogram::Snapshot& last = last_controller_durations_[name];
+        ControllerTiming::Histogram::difference(controller_now, last, controller_window);
+        last = controller_now;
+
+        diagnostic_msgs::DiagnosticStatus status;
+        status.name = "franka_control: controller " + name;
+        status.hardware_id = hardware_id_;
+        status.level = diagnostic_msgs::DiagnosticStatus::OK;
+        status.message = controller_window.total > 0 ? "Running" : "Not running";
+        addValue(status, "cycles", controller_window.total);
+        addPercentiles(status, "update duration [us]", histogram, controller_window);
+        array.status.push_back(status);
+      });
+
+  diagnostics_pub_.publish(array);
+}
+
+}  // namespace franka_interface
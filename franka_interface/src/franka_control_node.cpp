@@ -29,17 +29,33 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <actionlib/server/simple_action_server.h>
 #include <controller_manager/controller_manager.h>
 #include <franka/exception.h>
 #include <franka/robot.h>
 #include <franka_hw/franka_hw.h>
+#include <franka_hw/franka_state_interface.h>
+#include <ros/callback_queue.h>
 #include <ros/ros.h>
 
+#include <franka_interface/control_loop_monitor.h>
 #include <franka_interface/motion_controller_interface.h>
+#include <franka_interface/multi_arm_hw.h>
+#include <franka_interface/multi_arm_scheduler.h>
+#include <franka_interface/realtime_config.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/command_queue.h>
 
 #include <franka_control/ErrorRecoveryAction.h>
 #include <franka_control/services.h>
@@ -57,20 +73,359 @@ class ServiceContainer {
   std::vector<ros::ServiceServer> services_;
 };
 
+/**
+ * Durations of the startup phases of the node, reported in one line once it is ready to
+ * control the robot.
+ */
+class StartupTimer {
+ public:
+  /// Ends the current phase, which started with the previous call (or construction).
+  void phase(const std::string& name) {
+    const auto now = std::chrono::steady_clock::now();
+    phases_ << " " << name << ": " << std::fixed << std::setprecision(3)
+            << std::chrono::duration<double>(now - last_).count() << " s,";
+    last_ = now;
+  }
+
+  void report() const {
+    ROS_INFO("Startup took %.3f s (%s)",
+             std::chrono::duration<double>(last_ - start_).count(),
+             phases_.str().substr(1, phases_.str().size() - 2).c_str());
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_{std::chrono::steady_clock::now()};
+  std::chrono::steady_clock::time_point last_{start_};
+  std::ostringstream phases_;
+};
+
+void setDefaultCollisionBehavior(franka::Robot& robot) {
+  robot.setCollisionBehavior(
+      {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
+      {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
+      {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}},
+      {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}});
+}
+
+/**
+ * Advertises the services that configure robot under ns, e.g.
+ * "/franka_ros_interface/franka_control".
+ */
+void advertiseRobotServices(ServiceContainer& services, ros::NodeHandle& node_handle,
+                            franka::Robot& robot, const std::string& ns) {
+  services
+      .advertiseService<franka_control::SetJointImpedance>(
+          node_handle, ns + "/set_joint_impedance",
+          [&robot](auto&& req, auto&& res) {
+            return franka_control::setJointImpedance(robot, req, res);
+          })
+      .advertiseService<franka_control::SetCartesianImpedance>(
+          node_handle, ns + "/set_cartesian_impedance",
+          [&robot](auto&& req, auto&& res) {
+            return franka_control::setCartesianImpedance(robot, req, res);
+          })
+      .advertiseService<franka_control::SetEEFrame>(
+          node_handle, ns + "/set_EE_frame",
+          [&robot](auto&& req, auto&& res) { return franka_control::setEEFrame(robot, req, res); })
+      .advertiseService<franka_control::SetKFrame>(
+          node_handle, ns + "/set_K_frame",
+          [&robot](auto&& req, auto&& res) { return franka_control::setKFrame(robot, req, res); })
+      .advertiseService<franka_control::SetForceTorqueCollisionBehavior>(
+          node_handle, ns + "/set_force_torque_collision_behavior",
+          [&robot](auto&& req, auto&& res) {
+            return franka_control::setForceTorqueCollisionBehavior(robot, req, res);
+          })
+      .advertiseService<franka_control::SetFullCollisionBehavior>(
+          node_handle, ns + "/set_full_collision_behavior",
+          [&robot](auto&& req, auto&& res) {
+            return franka_control::setFullCollisionBehavior(robot, req, res);
+          })
+      .advertiseService<franka_control::SetLoad>(
+          node_handle, ns + "/set_load",
+          [&robot](auto&& req, auto&& res) { return franka_control::setLoad(robot, req, res); });
+}
+
+/**
+ * Starts the spinner threads of the global queue and, if enabled, of the command queue with the
+ * CPUs and priority given in realtime_config. Leaves the calling thread on the non-realtime CPUs.
+ */
+void startSpinners(const franka_interface::RealtimeConfig& realtime_config,
+                   ros::AsyncSpinner& spinner, ros::AsyncSpinner& command_spinner) {
+  spinner.start();
+  if (realtime_config.command_queue) {
+    // The spinner threads take over the main thread's affinity and policy when started
+    franka_interface::setCurrentThreadAffinity(realtime_config.command_spinner_cpus);
+    franka_interface::setCurrentThreadPriority(realtime_config.command_spinner_priority);
+    command_spinner.start();
+    franka_interface::setCurrentThreadPriority(0);
+    franka_interface::setCurrentThreadAffinity(realtime_config.non_realtime_cpus);
+  }
+}
+
+/**
+ * An arm of a multi-arm node, with everything its control thread needs.
+ */
+struct Arm {
+  std::string arm_id;
+  std::array<std::string, 7> joint_names;
+  std::vector<int> control_cpus;
+
+  std::unique_ptr<franka::Robot> robot;
+  std::unique_ptr<franka::Model> model;
+  std::unique_ptr<franka_hw::FrankaHW> hw;
+  std::unique_ptr<actionlib::SimpleActionServer<franka_control::ErrorRecoveryAction>>
+      recovery_action_server;
+  ServiceContainer services;
+  franka_interface::ControlLoopMonitor control_loop_monitor;
+  std::atomic_bool has_error{false};
+  // set by the control thread, reported by the timer of runMultiArm()
+  std::atomic<uint64_t> skipped_cycles{0};
+  std::atomic_bool sync_lost{false};
+};
+
+/**
+ * Control thread of an arm in a multi-arm node: same loop as the single-arm node, but the
+ * controller manager update is left to the scheduler, which runs it once per cycle for all arms.
+ * After more than max_skipped_cycles cycles in a row without the other arms the motion is stopped
+ * and the arm waits for error recovery.
+ */
+void runArm(Arm& arm, size_t index, franka_interface::MultiArmScheduler& scheduler,
+            int max_skipped_cycles, size_t prefault_stack_size) {
+  franka_interface::setCurrentThreadAffinity(arm.control_cpus);
+  franka_interface::prefaultStack(prefault_stack_size);
+  franka_hw::FrankaStateHandle franka_state_handle =
+      arm.hw->get<franka_hw::FrankaStateInterface>()->getHandle(arm.arm_id + "_robot");
+
+  while (ros::ok()) {
+    ros::Time last_time = ros::Time::now();
+
+    // Wait until controller has been activated or error has been recovered
+    while (!arm.hw->controllerActive() || arm.has_error) {
+      arm.hw->update(arm.robot->readOnce());
+
+      ros::Time now = ros::Time::now();
+      scheduler.tick(index, now - last_time, false);
+      last_time = now;
+
+      if (!ros::ok()) {
+        return;
+      }
+    }
+
+    int consecutive_skips = 0;
+    try {
+      arm.hw->control(*arm.robot, [&](const ros::Time&, const ros::Duration& period) {
+        const auto cycle_start = std::chrono::steady_clock::now();
+        const bool start_motion = period.toSec() == 0.0;
+        if (scheduler.tick(index, period, start_motion)) {
+          consecutive_skips = 0;
+        } else {
+          arm.skipped_cycles.fetch_add(1, std::memory_order_relaxed);
+          // The arms' cycles keep missing each other (e.g. their phase offset exceeds
+          // sync_timeout), so no controller runs: stop instead of holding the command forever.
+          if (++consecutive_skips > max_skipped_cycles) {
+            arm.sync_lost = true;
+            arm.has_error = true;
+            return false;
+          }
+        }
+        if (start_motion) {
+          // The controllers of this arm were restarted by the scheduler update
+          arm.hw->reset();
+          arm.control_loop_monitor.startMotion(cycle_start);
+        } else {
+          arm.hw->enforceLimits(period);
+          arm.control_loop_monitor.recordCycle(
+              cycle_start, period, franka_state_handle.getRobotState().control_command_success_rate);
+        }
+        return ros::ok();
+      });
+    } catch (const franka::ControlException& e) {
+      ROS_ERROR("%s: %s", arm.arm_id.c_str(), e.what());
+      arm.has_error = true;
+    }
+  }
+}
+
+/**
+ * Runs all arms listed in /robot_config/multi_arm/arm_ids from this process: one FrankaHW and
+ * control thread per arm, and one controller manager for all of them. The services of an arm
+ * are advertised under /<arm_id>/franka_ros_interface/franka_control.
+ */
+int runMultiArm(ros::NodeHandle& public_node_handle, ros::NodeHandle& node_handle,
+                const std::vector<std::string>& arm_ids, const urdf::Model& urdf_model,
+                std::future<bool>& urdf_loaded, StartupTimer& startup_timer,
+                const franka_interface::RealtimeConfig& realtime_config,
+                const std::function<bool()>& get_rate_limiting,
+                const std::function<double()>& get_cutoff_frequency,
+                const std::function<franka::ControllerMode()>& get_internal_controller) {
+  double sync_timeout;
+  node_handle.param<double>("/robot_config/multi_arm/sync_timeout", sync_timeout, 0.3);
+  // in ms; the wait must leave the arm time to send its command within the 1 ms cycle
+  if (sync_timeout <= 0.0 || sync_timeout >= 1.0) {
+    ROS_ERROR("Invalid /robot_config/multi_arm/sync_timeout parameter provided");
+    return 1;
+  }
+  int max_skipped_cycles;
+  node_handle.param<int>("/robot_config/multi_arm/max_skipped_cycles", max_skipped_cycles, 10);
+  if (max_skipped_cycles < 0) {
+    ROS_ERROR("Invalid /robot_config/multi_arm/max_skipped_cycles parameter provided");
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<Arm>> arms;
+  std::vector<std::future<void>> connections;
+  for (const std::string& arm_id : arm_ids) {
+    const std::string prefix = "/robot_config/multi_arm/" + arm_id + "/";
+    std::unique_ptr<Arm> arm(new Arm);
+    arm->arm_id = arm_id;
+
+    std::vector<std::string> joint_names_vector;
+    if (!node_handle.getParam(prefix + "joint_names", joint_names_vector) ||
+        joint_names_vector.size() != 7) {
+      ROS_ERROR("Invalid or no joint_names parameters provided for arm %s", arm_id.c_str());
+      return 1;
+    }
+    std::copy(joint_names_vector.cbegin(), joint_names_vector.cend(), arm->joint_names.begin());
+
+    std::string robot_ip;
+    if (!node_handle.getParam(prefix + "robot_ip", robot_ip)) {
+      ROS_ERROR("Invalid or no robot_ip parameter provided for arm %s", arm_id.c_str());
+      return 1;
+    }
+    node_handle.param<std::vector<int>>(prefix + "control_cpus", arm->control_cpus,
+                                        realtime_config.control_cpus);
+    if (arm->control_cpus.empty()) {
+      arm->control_cpus = realtime_config.non_realtime_cpus;
+    }
+
+    // Connecting and loading the model take most of the startup time; the arms do it in parallel
+    Arm* arm_ptr = arm.get();
+    connections.push_back(std::async(std::launch::async, [arm_ptr, robot_ip]() {
+      arm_ptr->robot.reset(new franka::Robot(robot_ip));
+      setDefaultCollisionBehavior(*arm_ptr->robot);
+      arm_ptr->model.reset(new franka::Model(arm_ptr->robot->loadModel()));
+    }));
+    arms.push_back(std::move(arm));
+  }
+  for (std::future<void>& connection : connections) {
+    connection.get();
+  }
+  startup_timer.phase("connect");
+  if (!urdf_loaded.get()) {
+    ROS_ERROR("Could not initialize URDF model from robot_description");
+    return 1;
+  }
+  startup_timer.phase("robot_description");
+
+  franka_interface::MultiArmHW multi_arm_hw;
+  for (auto& arm : arms) {
+    const std::string& arm_id = arm->arm_id;
+    const std::string ns = "/" + arm_id + "/franka_ros_interface/franka_control";
+    advertiseRobotServices(arm->services, node_handle, *arm->robot, ns);
+    Arm* arm_ptr = arm.get();
+    arm->recovery_action_server.reset(
+        new actionlib::SimpleActionServer<franka_control::ErrorRecoveryAction>(
+            node_handle, ns + "/error_recovery",
+            [arm_ptr](const franka_control::ErrorRecoveryGoalConstPtr&) {
+              try {
+                arm_ptr->robot->automaticErrorRecovery();
+                arm_ptr->has_error = false;
+                arm_ptr->recovery_action_server->setSucceeded();
+                ROS_INFO("%s: Recovered from error", arm_ptr->arm_id.c_str());
+              } catch (const franka::Exception& ex) {
+                arm_ptr->recovery_action_server->setAborted(
+                    franka_control::ErrorRecoveryResult(), ex.what());
+              }
+            },
+            false));
+
+    arm->hw.reset(new franka_hw::FrankaHW(arm->joint_names, arm_id, urdf_model, *arm->model,
+                                          get_rate_limiting, get_cutoff_frequency,
+                                          get_internal_controller));
+    // Initialize robot state before loading any controller
+    arm->hw->update(arm->robot->readOnce());
+    arm->control_loop_monitor.init(node_handle, arm_id);
+    multi_arm_hw.addArm(arm->hw.get(), arm_id, arm->joint_names);
+  }
+  startup_timer.phase("hardware");
+
+  ros::CallbackQueue command_queue;
+  if (realtime_config.command_queue) {
+    franka_ros_controllers::setCommandCallbackQueue(&command_queue);
+  }
+
+  // The motion controller interface (command timeout, mode switching by topic) serves a single
+  // arm; controllers are switched through the controller manager services here.
+  controller_manager::ControllerManager control_manager(&multi_arm_hw, public_node_handle);
+  multi_arm_hw.setControllerManager(&control_manager);
+  franka_interface::MultiArmScheduler scheduler(
+      arms.size(),
+      [&](const ros::Time& now, const ros::Duration& period, const std::vector<bool>& starting) {
+        // A new motion of one arm must not restart the controllers of the others, which are in
+        // the middle of theirs, so reset_controllers of update() stays false.
+        for (size_t i = 0; i < starting.size(); ++i) {
+          if (starting[i]) {
+            multi_arm_hw.restartControllers(i, now);
+          }
+        }
+        control_manager.update(now, period, false);
+      },
+      std::chrono::microseconds(static_cast<int64_t>(sync_timeout * 1000.0)));
+  startup_timer.phase("controller_manager");
+  startup_timer.report();
+
+  for (auto& arm : arms) {
+    arm->recovery_action_server->start();
+  }
+
+  // The control threads only count skipped cycles; they are logged here, off the control CPUs
+  std::vector<uint64_t> reported_skips(arms.size(), 0);
+  ros::WallTimer sync_report_timer = node_handle.createWallTimer(
+      ros::WallDuration(1.0), [&](const ros::WallTimerEvent&) {
+        for (size_t i = 0; i < arms.size(); ++i) {
+          const uint64_t skips = arms[i]->skipped_cycles.load(std::memory_order_relaxed);
+          if (skips != reported_skips[i]) {
+            ROS_WARN("%s: %lu control cycles skipped waiting for the other arms",
+                     arms[i]->arm_id.c_str(),
+                     static_cast<unsigned long>(skips - reported_skips[i]));
+            reported_skips[i] = skips;
+          }
+          if (arms[i]->sync_lost.exchange(false)) {
+            ROS_ERROR("%s: Stopped the motion after more than %d consecutive skipped cycles, "
+                      "recover with the error_recovery action",
+                      arms[i]->arm_id.c_str(), max_skipped_cycles);
+          }
+        }
+      });
+
+  ros::AsyncSpinner spinner(realtime_config.spinner_threads);
+  ros::AsyncSpinner command_spinner(realtime_config.command_spinner_threads, &command_queue);
+  startSpinners(realtime_config, spinner, command_spinner);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < arms.size(); ++i) {
+    threads.emplace_back(runArm, std::ref(*arms[i]), i, std::ref(scheduler), max_skipped_cycles,
+                         static_cast<size_t>(realtime_config.prefault_stack_size));
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return 0;
+}
+
 int main(int argc, char** argv) {
   ros::init(argc, argv, "custom_franka_control_node");
   ros::NodeHandle public_node_handle;
   ros::NodeHandle node_handle("~");
+  StartupTimer startup_timer;
 
-  std::vector<std::string> joint_names_vector;
-  if (!node_handle.getParam("/robot_config/joint_names", joint_names_vector) || joint_names_vector.size() != 7) {
-    ROS_ERROR("Invalid or no joint_names parameters provided");
+  // Fetched once for all controllers loaded into this node
+  if (!franka_ros_controllers::RobotConfig::load(node_handle)) {
+    ROS_ERROR("No /robot_config parameters provided");
     return 1;
   }
 
-  std::array<std::string, 7> joint_names;
-  std::copy(joint_names_vector.cbegin(), joint_names_vector.cend(), joint_names.begin());
-
   bool rate_limiting;
   if (!node_handle.getParamCached("/robot_config/rate_limiting", rate_limiting)) {
     ROS_ERROR("Invalid or no rate_limiting parameter provided");
@@ -89,12 +444,66 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  franka_interface::RealtimeConfig realtime_config;
+  if (!realtime_config.load(node_handle)) {
+    ROS_ERROR("Invalid /robot_config/realtime parameters provided");
+    return 1;
+  }
+  // Every thread started from here on inherits this affinity; the main thread moves to the
+  // control CPUs only once it enters the control loop.
+  franka_interface::setCurrentThreadAffinity(realtime_config.non_realtime_cpus);
+  if (realtime_config.lock_memory) {
+    franka_interface::lockProcessMemory();
+  }
+
+  // Parsed while the robot connects and sends its model; needed only once FrankaHW is created
   urdf::Model urdf_model;
-  if (!urdf_model.initParamWithNodeHandle("robot_description", public_node_handle)) {
-    ROS_ERROR("Could not initialize URDF model from robot_description");
+  std::future<bool> urdf_loaded = std::async(std::launch::async, [&]() {
+    return urdf_model.initParamWithNodeHandle("robot_description", public_node_handle);
+  });
+
+  auto get_rate_limiting = [&]() {
+    node_handle.getParamCached("rate_limiting", rate_limiting);
+    return rate_limiting;
+  };
+  auto get_internal_controller = [&]() {
+    node_handle.getParamCached("internal_controller", internal_controller);
+
+    franka::ControllerMode controller_mode;
+    if (internal_controller == "joint_impedance") {
+      controller_mode = franka::ControllerMode::kJointImpedance;
+    } else if (internal_controller == "cartesian_impedance") {
+      controller_mode = franka::ControllerMode::kCartesianImpedance;
+    } else {
+      ROS_WARN("Invalid internal_controller parameter provided, falling back to joint impedance");
+      controller_mode = franka::ControllerMode::kJointImpedance;
+    }
+
+    return controller_mode;
+  };
+  auto get_cutoff_frequency = [&]() {
+    node_handle.getParamCached("cutoff_frequency", cutoff_frequency);
+    return cutoff_frequency;
+  };
+
+  std::vector<std::string> arm_ids;
+  node_handle.getParam("/robot_config/multi_arm/arm_ids", arm_ids);
+  startup_timer.phase("robot_config");
+  if (!arm_ids.empty()) {
+    return runMultiArm(public_node_handle, node_handle, arm_ids, urdf_model, urdf_loaded,
+                       startup_timer, realtime_config, get_rate_limiting, get_cutoff_frequency,
+                       get_internal_controller);
+  }
+
+  std::vector<std::string> joint_names_vector;
+  if (!node_handle.getParam("/robot_config/joint_names", joint_names_vector) || joint_names_vector.size() != 7) {
+    ROS_ERROR("Invalid or no joint_names parameters provided");
     return 1;
   }
 
+  std::array<std::string, 7> joint_names;
+  std::copy(joint_names_vector.cbegin(), joint_names_vector.cend(), joint_names.begin());
+
   std::string robot_ip;
   if (!node_handle.getParam("robot_ip", robot_ip)) {
     ROS_ERROR("Invalid or no robot_ip parameter provided");
@@ -106,48 +515,17 @@ int main(int argc, char** argv) {
     ROS_ERROR("Invalid or no arm_id parameter provided");
     return 1;
   }
+
   franka::Robot robot(robot_ip);
+  startup_timer.phase("connect");
 
-  // Set default collision behavior
-  robot.setCollisionBehavior(
-      {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
-      {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
-      {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}},
-      {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}});
+  setDefaultCollisionBehavior(robot);
+  startup_timer.phase("collision_behavior");
 
   std::atomic_bool has_error(false);
 
   ServiceContainer services;
-  services
-      .advertiseService<franka_control::SetJointImpedance>(
-          node_handle, "/franka_ros_interface/franka_control/set_joint_impedance",
-          [&robot](auto&& req, auto&& res) {
-            return franka_control::setJointImpedance(robot, req, res);
-          })
-      .advertiseService<franka_control::SetCartesianImpedance>(
-          node_handle, "/franka_ros_interface/franka_control/set_cartesian_impedance",
-          [&robot](auto&& req, auto&& res) {
-            return franka_control::setCartesianImpedance(robot, req, res);
-          })
-      .advertiseService<franka_control::SetEEFrame>(
-          node_handle, "/franka_ros_interface/franka_control/set_EE_frame",
-          [&robot](auto&& req, auto&& res) { return franka_control::setEEFrame(robot, req, res); })
-      .advertiseService<franka_control::SetKFrame>(
-          node_handle, "/franka_ros_interface/franka_control/set_K_frame",
-          [&robot](auto&& req, auto&& res) { return franka_control::setKFrame(robot, req, res); })
-      .advertiseService<franka_control::SetForceTorqueCollisionBehavior>(
-          node_handle, "/franka_ros_interface/franka_control/set_force_torque_collision_behavior",
-          [&robot](auto&& req, auto&& res) {
-            return franka_control::setForceTorqueCollisionBehavior(robot, req, res);
-          })
-      .advertiseService<franka_control::SetFullCollisionBehavior>(
-          node_handle, "/franka_ros_interface/franka_control/set_full_collision_behavior",
-          [&robot](auto&& req, auto&& res) {
-            return franka_control::setFullCollisionBehavior(robot, req, res);
-          })
-      .advertiseService<franka_control::SetLoad>(
-          node_handle, "/franka_ros_interface/franka_control/set_load",
-          [&robot](auto&& req, auto&& res) { return franka_control::setLoad(robot, req, res); });
+  advertiseRobotServices(services, node_handle, robot, "/franka_ros_interface/franka_control");
 
   actionlib::SimpleActionServer<franka_control::ErrorRecoveryAction> recovery_action_server(
       node_handle, "/franka_ros_interface/franka_control/error_recovery",
@@ -164,34 +542,32 @@ int main(int argc, char** argv) {
       false);
 
   franka::Model model = robot.loadModel();
-  auto get_rate_limiting = [&]() {
-    node_handle.getParamCached("rate_limiting", rate_limiting);
-    return rate_limiting;
-  };
-  auto get_internal_controller = [&]() {
-    node_handle.getParamCached("internal_controller", internal_controller);
-
-    franka::ControllerMode controller_mode;
-    if (internal_controller == "joint_impedance") {
-      controller_mode = franka::ControllerMode::kJointImpedance;
-    } else if (internal_controller == "cartesian_impedance") {
-      controller_mode = franka::ControllerMode::kCartesianImpedance;
-    } else {
-      ROS_WARN("Invalid internal_controller parameter provided, falling back to joint impedance");
-      controller_mode = franka::ControllerMode::kJointImpedance;
-    }
+  startup_timer.phase("load_model");
+  if (!urdf_loaded.get()) {
+    ROS_ERROR("Could not initialize URDF model from robot_description");
+    return 1;
+  }
+  startup_timer.phase("robot_description");
 
-    return controller_mode;
-  };
-  auto get_cutoff_frequency = [&]() {
-    node_handle.getParamCached("cutoff_frequency", cutoff_frequency);
-    return cutoff_frequency;
-  };
   franka_hw::FrankaHW franka_control(joint_names, arm_id, urdf_model, model, get_rate_limiting,
                                      get_cutoff_frequency, get_internal_controller);
 
   // Initialize robot state before loading any controller
   franka_control.update(robot.readOnce());
+  startup_timer.phase("hardware");
+
+  // Set up before the controller manager so that controllers see the per-controller timing flag
+  franka_interface::ControlLoopMonitor control_loop_monitor;
+  control_loop_monitor.init(node_handle, arm_id);
+  franka_hw::FrankaStateHandle franka_state_handle =
+      franka_control.get<franka_hw::FrankaStateInterface>()->getHandle(arm_id + "_robot");
+
+  // Command topics get their own queue so that bursts of gain, stiffness or
+  // dynamic_reconfigure callbacks cannot delay them. Must be set before controllers are loaded.
+  ros::CallbackQueue command_queue;
+  if (realtime_config.command_queue) {
+    franka_ros_controllers::setCommandCallbackQueue(&command_queue);
+  }
 
   boost::shared_ptr<controller_manager::ControllerManager> control_manager;
 
@@ -199,12 +575,20 @@ int main(int argc, char** argv) {
 
   franka_interface::MotionControllerInterface motion_controller_interface_;
   motion_controller_interface_.init(public_node_handle, control_manager);
+  startup_timer.phase("controller_manager");
+  startup_timer.report();
 
   recovery_action_server.start();
 
   // Start background threads for message handling
-  ros::AsyncSpinner spinner(4);
-  spinner.start();
+  ros::AsyncSpinner spinner(realtime_config.spinner_threads);
+  ros::AsyncSpinner command_spinner(realtime_config.command_spinner_threads, &command_queue);
+  startSpinners(realtime_config, spinner, command_spinner);
+
+  franka_interface::setCurrentThreadAffinity(realtime_config.control_cpus.empty()
+                                                 ? realtime_config.non_realtime_cpus
+                                                 : realtime_config.control_cpus);
+  franka_interface::prefaultStack(realtime_config.prefault_stack_size);
 
   while (ros::ok()) {
     ros::Time last_time = ros::Time::now();
@@ -225,13 +609,17 @@ int main(int argc, char** argv) {
     try {
       // Run control loop. Will exit if the controller is switched.
       franka_control.control(robot, [&](const ros::Time& now, const ros::Duration& period) {
+        const auto cycle_start = std::chrono::steady_clock::now();
         if (period.toSec() == 0.0) {
           // Reset controllers before starting a motion
           control_manager->update(now, period, true);
           franka_control.reset();
+          control_loop_monitor.startMotion(cycle_start);
         } else {
           control_manager->update(now, period);
           franka_control.enforceLimits(period);
+          control_loop_monitor.recordCycle(
+              cycle_start, period, franka_state_handle.getRobotState().control_command_success_rate);
         }
         return ros::ok();
       });
@@ -33,13 +33,17 @@
 
 import enum
 import rospy
+import threading
+import actionlib
 import warnings
 import quaternion
 import numpy as np
-from copy import deepcopy
+from rospy.numpy_msg import numpy_msg
 from rospy_message_converter import message_converter
+from actionlib_msgs.msg import GoalStatus
 
-from franka_core_msgs.msg import JointCommand, RobotState, EndPointState, CartImpedanceStiffness, JointImpedanceStiffness, TorqueCmd, JICmd
+from franka_core_msgs.msg import JointCommand, JointCommandBatch, RobotState, RobotStateCompact, RobotStateErrors, ContactEvent, EndPointState, CartImpedanceStiffness, JointImpedanceStiffness, TorqueCmd, JICmd
+from franka_core_msgs.msg import JointImpedanceTrajectory, JointImpedanceTrajectoryPoint, CartImpedanceTrajectory, CartImpedanceTrajectoryPoint
 from sensor_msgs.msg import JointState
 from std_msgs.msg import Float64
 from geometry_msgs.msg import PoseStamped, Wrench
@@ -48,6 +52,7 @@ import franka_interface
 import franka_control
 import franka_dataflow
 from robot_params import RobotParams
+from franka_interface.batch_kinematics import BatchKinematics
 
 from franka_tools import FrankaFramesInterface, FrankaControllerManagerInterface, JointTrajectoryActionClient, CollisionBehaviourInterface
 
@@ -74,6 +79,33 @@ class TipState():
     def effort_in_K_frame(self):
         return self._effort_in_K_frame
 
+
+class StateSnapshot(object):
+    """
+    Latest robot state as read-only NumPy arrays, returned by
+    :py:meth:`ArmInterface.state_snapshot`. The arrays are views into the received
+    messages, so taking a snapshot copies nothing and a snapshot is never modified by
+    later messages; use ``np.array(...)`` for a writable copy.
+
+    Joint quantities are ordered as :py:meth:`ArmInterface.joint_names`; matrices are
+    row-major NumPy matrices (O_T_EE (4,4), O_Jac_EE (6,7), mass_matrix (7,7)).
+    Wrenches are [fx, fy, fz, tx, ty, tz]. Fields not received yet are None.
+    """
+
+    __slots__ = ('stamp', 'q', 'dq', 'tau', 'q_d', 'dq_d', 'O_T_EE', 'O_dP_EE', 'O_Jac_EE',
+                 'mass_matrix', 'gravity', 'coriolis', 'O_F_ext_hat_K', 'K_F_ext_hat_K')
+
+    def __init__(self, **fields):
+        for name in self.__slots__:
+            setattr(self, name, fields.get(name))
+
+
+def _wrench_to_array(wrench):
+    array = np.array([wrench.force.x, wrench.force.y, wrench.force.z,
+                      wrench.torque.x, wrench.torque.y, wrench.torque.z])
+    array.flags.writeable = False
+    return array
+
     
     
     
@@ -96,6 +128,24 @@ class ArmInterface(object):
         when using this mode, it is possible for a blocking Subscriber to
         prevent the joint_command functions from exiting. Unless you need exact
         JointCommand timing, default to Asynchronous Publishing (False).
+
+    :type compact_state: bool
+    :param compact_state: subscribe to the lean robot_state_compact topic
+        (franka_core_msgs/RobotStateCompact) instead of robot_state. Only the
+        field groups published by the state controller are updated; errors are
+        only received when they change.
+
+    :type state_decimation: int
+    :param state_decimation: only process every n-th message of the state topics
+        (joint_states, robot_state, tip_state) to save CPU when the state is not
+        needed at the full publishing rate. State callbacks registered with
+        :py:meth:`add_state_callback` are decimated further on top of this.
+
+    :type command_connection_timeout: float
+    :param command_connection_timeout: seconds a command helper (set_*, execute_*) waits
+        for the controller to subscribe to its topic before publishing, so that the
+        first commands after startup are not dropped (see
+        :py:meth:`wait_for_command_subscribers`).
     """
 
     # Containers
@@ -116,7 +166,8 @@ class ArmInterface(object):
         ROBOT_MODE_USER_STOPPED                 = 5
         ROBOT_MODE_AUTOMATIC_ERROR_RECOVERY     = 6
 
-    def __init__(self, synchronous_pub=False):
+    def __init__(self, synchronous_pub=False, compact_state=False, state_decimation=1,
+                 command_connection_timeout=1.0):
         """
 
         """
@@ -137,18 +188,35 @@ class ArmInterface(object):
 
         self._joint_names = joint_names
         self.name = self._params.get_robot_name()
-        self._joint_angle = dict()
-        self._joint_velocity = dict()
-        self._joint_effort = dict()
-        self._cartesian_pose = dict()
-        self._cartesian_velocity = dict()
-        self._cartesian_effort = dict()
-        self._stiffness_frame_effort = dict()
+        # State messages are deserialised with rospy.numpy_msg: the callbacks only keep
+        # references to the (read-only) arrays of the latest messages, and dicts, quaternions
+        # etc. are only built when an accessor asks for them.
+        self._joint_index = dict((name, i) for i, name in enumerate(self._joint_names))
+        self._joint_state_names = None
+        self._joint_state_order = None  # index array if joint_states is in another order
+        self._joint_state_stamp = None
+        self._q = None
+        self._dq = None
+        self._tau = None
+        self._endpoint = None  # (latest tip_state message, dict of quantities derived from it)
+        self._O_dP_EE = None
+        self._joint_inertia = None
+        self._gravity = None
+        self._coriolis = None
+        self.q_d = None
+        self.dq_d = None
         self._errors = dict()
+        self._errors_mask = 0
         self._collision_state = False
-        self._tip_states = None
         self._jacobian = None
+        self._batch_kinematics = None
         self._cartesian_contact = None
+        self._contact_event = None  # latest ContactEvent, None until the first one arrives
+        self._contact_onset = threading.Event()  # set by every contact onset
+
+        self._state_decimation = max(1, int(state_decimation))
+        self._state_message_counts = {'joint_states': 0, 'robot_state': 0, 'tip_state': 0}
+        self._state_callbacks = []
 
         self._robot_mode = False
 
@@ -176,6 +244,11 @@ class ArmInterface(object):
                 JointCommand,
                 tcp_nodelay=True,
                 queue_size=queue_size)
+            self._joint_command_batch_publisher = rospy.Publisher(
+                self._ns +'/motion_controller/arm/joint_command_batch',
+                JointCommandBatch,
+                tcp_nodelay=True,
+                queue_size=queue_size)
 
         self._pub_joint_cmd_timeout = rospy.Publisher(
             self._ns +'/motion_controller/arm/joint_command_timeout',
@@ -183,52 +256,91 @@ class ArmInterface(object):
             latch=True,
             queue_size=10)
 
-        self._robot_state_subscriber = rospy.Subscriber(
-            self._ns + '/custom_franka_state_controller/robot_state',
-            RobotState,
-            self._on_robot_state,
+        if compact_state:
+            self._robot_state_subscriber = rospy.Subscriber(
+                self._ns + '/custom_franka_state_controller/robot_state_compact',
+                numpy_msg(RobotStateCompact),
+                self._on_robot_state_compact,
+                queue_size=1,
+                tcp_nodelay=True)
+        else:
+            self._robot_state_subscriber = rospy.Subscriber(
+                self._ns + '/custom_franka_state_controller/robot_state',
+                numpy_msg(RobotState),
+                self._on_robot_state,
+                queue_size=1,
+                tcp_nodelay=True)
+
+        self._robot_errors_subscriber = rospy.Subscriber(
+            self._ns + '/custom_franka_state_controller/robot_errors',
+            RobotStateErrors,
+            self._on_robot_errors,
             queue_size=1,
             tcp_nodelay=True)
 
+        self._contact_event_subscriber = rospy.Subscriber(
+            self._ns + '/custom_franka_state_controller/contact_events',
+            ContactEvent,
+            self._on_contact_event,
+            queue_size=10,
+            tcp_nodelay=True)
+
         joint_state_topic = self._ns + '/custom_franka_state_controller/joint_states'
         self._joint_state_sub = rospy.Subscriber(
             joint_state_topic,
-            JointState,
+            numpy_msg(JointState),
             self._on_joint_states,
             queue_size=1,
             tcp_nodelay=True)
 
         self._cartesian_state_sub = rospy.Subscriber(
             self._ns + '/custom_franka_state_controller/tip_state',
-            EndPointState,
+            numpy_msg(EndPointState),
             self._on_endpoint_state,
             queue_size=1,
             tcp_nodelay=True)
 
         # Cartesian Impedance Controller Publishers
-        self._cartesian_impedance_pose_publisher = rospy.Publisher("equilibrium_pose", PoseStamped, queue_size=10)
-        self._cartesian_stiffness_publisher = rospy.Publisher("impedance_stiffness", CartImpedanceStiffness, queue_size=10)
+        self._cartesian_impedance_pose_publisher = rospy.Publisher("equilibrium_pose", PoseStamped, queue_size=10, tcp_nodelay=True)
+        self._cartesian_stiffness_publisher = rospy.Publisher("impedance_stiffness", CartImpedanceStiffness, queue_size=10, tcp_nodelay=True)
+        self._cartesian_impedance_trajectory_publisher = rospy.Publisher("equilibrium_pose_trajectory", CartImpedanceTrajectory, queue_size=100, tcp_nodelay=True)
 
         # Force Control Publisher
-        self._force_controller_publisher = rospy.Publisher("wrench_target", Wrench, queue_size=10)
+        self._force_controller_publisher = rospy.Publisher("wrench_target", Wrench, queue_size=10, tcp_nodelay=True)
 
         # Torque Control Publisher
-        self._torque_controller_publisher = rospy.Publisher("torque_target", TorqueCmd, queue_size=20)
+        self._torque_controller_publisher = rospy.Publisher("torque_target", TorqueCmd, queue_size=20, tcp_nodelay=True)
 
         # Joint Impedance Controller Publishers
-        self._joint_impedance_publisher = rospy.Publisher("joint_impedance_position_velocity", JICmd, queue_size=20)
-        self._joint_stiffness_publisher = rospy.Publisher("joint_impedance_stiffness", JointImpedanceStiffness, queue_size=10) 
+        self._joint_impedance_publisher = rospy.Publisher("joint_impedance_position_velocity", JICmd, queue_size=20, tcp_nodelay=True)
+        self._joint_stiffness_publisher = rospy.Publisher("joint_impedance_stiffness", JointImpedanceStiffness, queue_size=10, tcp_nodelay=True) 
+        self._joint_impedance_trajectory_publisher = rospy.Publisher("joint_impedance_trajectory", JointImpedanceTrajectory, queue_size=100, tcp_nodelay=True)
+
+        # Command topics by (resolved) name, for the subscriber readiness checks
+        self._command_connection_timeout = command_connection_timeout
+        self._command_publishers = dict((pub.resolved_name, pub) for pub in [
+            self._joint_command_publisher, self._joint_command_batch_publisher,
+            self._cartesian_impedance_pose_publisher, self._cartesian_stiffness_publisher,
+            self._cartesian_impedance_trajectory_publisher, self._force_controller_publisher,
+            self._torque_controller_publisher, self._joint_impedance_publisher,
+            self._joint_stiffness_publisher, self._joint_impedance_trajectory_publisher])
+
+        # Created once and kept connected; the trajectory client is created on first use,
+        # as its action server only runs while the trajectory controller is loaded.
+        self._error_recovery_client = actionlib.SimpleActionClient(
+            self._ns + '/franka_control/error_recovery', franka_control.msg.ErrorRecoveryAction)
+        self._trajectory_client = None
 
         rospy.on_shutdown(self._clean_shutdown)
 
         err_msg = ("%s arm init failed to get current joint_states "
                    "from %s") % (self.name.capitalize(), joint_state_topic)
-        franka_dataflow.wait_for(lambda: len(self._joint_angle.keys()) > 0,
+        franka_dataflow.wait_for(lambda: self._q is not None,
                                  timeout_msg=err_msg, timeout=5.0)
 
         err_msg = ("%s arm, init failed to get current tip_state "
                    "from %s") % (self.name.capitalize(), self._ns + 'tip_state')
-        franka_dataflow.wait_for(lambda: len(self._cartesian_pose.keys()) > 0,
+        franka_dataflow.wait_for(lambda: self._endpoint is not None,
                                  timeout_msg=err_msg, timeout=5.0)
 
         err_msg = ("%s arm, init failed to get current robot_state "
@@ -256,6 +368,7 @@ class ArmInterface(object):
         self._cartesian_state_sub.unregister()
         self._pub_joint_cmd_timeout.unregister()
         self._robot_state_subscriber.unregister()
+        self._robot_errors_subscriber.unregister()
         self._joint_command_publisher.unregister()
         self._cartesian_impedance_pose_publisher.unregister()
         self._cartesian_stiffness_publisher.unregister()
@@ -263,6 +376,9 @@ class ArmInterface(object):
         self._torque_controller_publisher.unregister()
         self._joint_impedance_publisher.unregister()
         self._joint_stiffness_publisher.unregister()
+        self._joint_command_batch_publisher.unregister()
+        self._cartesian_impedance_trajectory_publisher.unregister()
+        self._joint_impedance_trajectory_publisher.unregister()
 
     def get_robot_params(self):
         """
@@ -289,25 +405,43 @@ class ArmInterface(object):
         """
         return self._joint_names
 
+    def _skip_state_message(self, topic):
+        count = self._state_message_counts[topic]
+        self._state_message_counts[topic] = count + 1
+        return count % self._state_decimation != 0
+
     def _on_joint_states(self, msg):
 
-        for idx, name in enumerate(msg.name):
-            if name in self._joint_names:
-                self._joint_angle[name] = msg.position[idx]
-                self._joint_velocity[name] = msg.velocity[idx]
-                self._joint_effort[name] = msg.effort[idx]
+        if self._skip_state_message('joint_states'):
+            return
+
+        if msg.name != self._joint_state_names:
+            names = list(msg.name)
+            if names == self._joint_names:
+                self._joint_state_order = None
+            else:
+                self._joint_state_order = np.array([names.index(name) for name in self._joint_names])
+            self._joint_state_names = msg.name
+
+        order = self._joint_state_order
+        if order is None:
+            self._q, self._dq, self._tau = msg.position, msg.velocity, msg.effort
+        else:
+            self._q, self._dq, self._tau = msg.position[order], msg.velocity[order], msg.effort[order]
+        self._joint_state_stamp = msg.header.stamp
 
     def _on_robot_state(self, msg):
 
+        if self._skip_state_message('robot_state'):
+            return
+
         self._robot_mode = self.RobotMode(msg.robot_mode)
 
         self._robot_mode_ok = (self._robot_mode.value != self.RobotMode.ROBOT_MODE_REFLEX) and (self._robot_mode.value != self.RobotMode.ROBOT_MODE_USER_STOPPED)
 
-        self._jacobian = np.asarray(msg.O_Jac_EE).reshape(6,7,order = 'F')
+        self._jacobian = msg.O_Jac_EE.reshape(6,7,order = 'F')
 
-        self._cartesian_velocity = {
-                'linear': np.asarray([msg.O_dP_EE[0], msg.O_dP_EE[1], msg.O_dP_EE[2]]),
-                'angular': np.asarray([msg.O_dP_EE[3], msg.O_dP_EE[4], msg.O_dP_EE[5]]) }
+        self._O_dP_EE = msg.O_dP_EE
 
         self._cartesian_contact = msg.cartesian_contact
         self._cartesian_collision = msg.cartesian_collision
@@ -317,34 +451,90 @@ class ArmInterface(object):
         if self._frames_interface:
             self._frames_interface._update_frame_data(msg.F_T_EE, msg.EE_T_K)
 
-        self._joint_inertia = np.asarray(msg.mass_matrix).reshape(7,7,order='F')
+        self._joint_inertia = msg.mass_matrix.reshape(7,7,order='F')
 
         self.q_d = msg.q_d
         self.dq_d = msg.dq_d
 
-        self._gravity = np.asarray(msg.gravity)
-        self._coriolis = np.asarray(msg.coriolis)
+        self._gravity = msg.gravity
+        self._coriolis = msg.coriolis
 
+        self._errors_mask = msg.current_errors_mask
+
+        self._run_state_callbacks()
+
+    def _on_robot_errors(self, msg):
+
+        # latched and only published when the errors change
         self._errors = message_converter.convert_ros_message_to_dictionary(msg.current_errors)
+        self._errors_mask = msg.current_errors_mask
+
+    def _on_contact_event(self, msg):
+
+        # latched and only published when the contact predicates change
+        self._contact_event = msg
+        if msg.onsets:
+            self._contact_onset.set()
+
+    def _on_robot_state_compact(self, msg):
 
-    def coriolis_comp(self):
+        if self._skip_state_message('robot_state'):
+            return
+
+        self._robot_mode = self.RobotMode(msg.robot_mode)
+
+        self._robot_mode_ok = (self._robot_mode.value != self.RobotMode.ROBOT_MODE_REFLEX) and (self._robot_mode.value != self.RobotMode.ROBOT_MODE_USER_STOPPED)
+
+        if msg.kinematics:
+            kinematics = msg.kinematics[0]
+            self._jacobian = kinematics.O_Jac_EE.reshape(6,7,order = 'F')
+
+            self._O_dP_EE = kinematics.O_dP_EE
+
+            self._cartesian_contact = kinematics.cartesian_contact
+            self._cartesian_collision = kinematics.cartesian_collision
+
+            self._joint_contact = kinematics.joint_contact
+            self._joint_collision = kinematics.joint_collision
+            if self._frames_interface:
+                self._frames_interface._update_frame_data(kinematics.F_T_EE, kinematics.EE_T_K)
+
+            self.q_d = kinematics.q_d
+            self.dq_d = kinematics.dq_d
+
+        if msg.dynamics:
+            dynamics = msg.dynamics[0]
+            self._joint_inertia = dynamics.mass_matrix.reshape(7,7,order='F')
+            self._gravity = dynamics.gravity
+            self._coriolis = dynamics.coriolis
+
+        if msg.errors:
+            self._on_robot_errors(msg.errors[0])
+
+        self._run_state_callbacks()
+
+    def coriolis_comp(self, copy=True):
         """
         Return coriolis compensation torques. Useful for compensating coriolis when
         performing direct torque control of the robot.
 
+        :type copy: bool
+        :param copy: if False, return a read-only view of the latest message instead of a copy
         :rtype: np.ndarray
         :return: 7D joint torques compensating for coriolis.
         """
-        return self._coriolis
+        return np.array(self._coriolis) if copy else self._coriolis
         
-    def gravity_comp(self):
+    def gravity_comp(self, copy=True):
         """
         Return gravity compensation torques.
 
+        :type copy: bool
+        :param copy: if False, return a read-only view of the latest message instead of a copy
         :rtype: np.ndarray
         :return: 7D joint torques compensating for gravity.
         """
-        return self._gravity
+        return np.array(self._gravity) if copy else self._gravity
 
     def get_robot_status(self):
         """
@@ -371,7 +561,7 @@ class ArmInterface(object):
         :rtype: bool
         :return: True if the arm has error, False otherwise.
         """
-        return not all([e == False for e in self._errors.values()])
+        return self._errors_mask != 0
 
     def what_errors(self):
         """
@@ -385,35 +575,81 @@ class ArmInterface(object):
 
     def _on_endpoint_state(self, msg):
 
-        cart_pose_trans_mat = np.asarray(msg.O_T_EE).reshape(4,4,order='F')
-
-        self._cartesian_pose = {
-            'position': cart_pose_trans_mat[:3,3],
-            'orientation': quaternion.from_rotation_matrix(cart_pose_trans_mat[:3,:3]) }
-
-        self._cartesian_effort = {
-            'force': np.asarray([ msg.O_F_ext_hat_K.wrench.force.x,
-                                  msg.O_F_ext_hat_K.wrench.force.y,
-                                  msg.O_F_ext_hat_K.wrench.force.z]),
-
-            'torque': np.asarray([ msg.O_F_ext_hat_K.wrench.torque.x,
-                                   msg.O_F_ext_hat_K.wrench.torque.y,
-                                   msg.O_F_ext_hat_K.wrench.torque.z])
-        }
-
-        self._stiffness_frame_effort = {
-            'force': np.asarray([ msg.K_F_ext_hat_K.wrench.force.x,
-                                  msg.K_F_ext_hat_K.wrench.force.y,
-                                  msg.K_F_ext_hat_K.wrench.force.z]),
-
-            'torque': np.asarray([ msg.K_F_ext_hat_K.wrench.torque.x,
-                                   msg.K_F_ext_hat_K.wrench.torque.y,
-                                   msg.K_F_ext_hat_K.wrench.torque.z])
-        }
-
-        self._tip_states = TipState(msg.header.stamp, deepcopy(self._cartesian_pose), deepcopy(self._cartesian_velocity), deepcopy(self._cartesian_effort), deepcopy(self._stiffness_frame_effort))
-
-
+        if self._skip_state_message('tip_state'):
+            return
+
+        # quantities derived from the message are cached next to it by _endpoint_quantity()
+        self._endpoint = (msg, {})
+
+    def _endpoint_quantity(self, key):
+        msg, cache = self._endpoint
+        if key not in cache:
+            if key == 'O_T_EE':
+                cache[key] = msg.O_T_EE.reshape(4,4,order='F')
+            elif key == 'pose':
+                cart_pose_trans_mat = self._endpoint_quantity('O_T_EE')
+                cache[key] = {
+                    'position': cart_pose_trans_mat[:3,3],
+                    'orientation': quaternion.from_rotation_matrix(cart_pose_trans_mat[:3,:3]) }
+            elif key == 'O_F_ext_hat_K':
+                cache[key] = _wrench_to_array(msg.O_F_ext_hat_K.wrench)
+            elif key == 'K_F_ext_hat_K':
+                cache[key] = _wrench_to_array(msg.K_F_ext_hat_K.wrench)
+        return cache[key]
+
+    def state_snapshot(self):
+        """
+        Return the latest robot state as read-only NumPy arrays without copying
+        (see :py:class:`StateSnapshot`).
+
+        :rtype: StateSnapshot
+        """
+        has_endpoint = self._endpoint is not None
+        return StateSnapshot(
+            stamp=self._joint_state_stamp, q=self._q, dq=self._dq, tau=self._tau,
+            q_d=self.q_d, dq_d=self.dq_d, O_dP_EE=self._O_dP_EE, O_Jac_EE=self._jacobian,
+            mass_matrix=self._joint_inertia, gravity=self._gravity, coriolis=self._coriolis,
+            O_T_EE=self._endpoint_quantity('O_T_EE') if has_endpoint else None,
+            O_F_ext_hat_K=self._endpoint_quantity('O_F_ext_hat_K') if has_endpoint else None,
+            K_F_ext_hat_K=self._endpoint_quantity('K_F_ext_hat_K') if has_endpoint else None)
+
+    def add_state_callback(self, callback, decimation=1):
+        """
+        Call a function with a :py:class:`StateSnapshot` of the robot state on every
+        ``decimation``-th robot_state message that is processed (see the
+        ``state_decimation`` argument of the constructor). Callbacks run in the
+        subscriber thread and should return quickly.
+
+        :type callback: callable
+        :param callback: function taking a :py:class:`StateSnapshot`
+        :type decimation: int
+        :param decimation: call on every n-th message
+        :rtype: object
+        :return: handle for :py:meth:`remove_state_callback`
+        """
+        handle = [callback, max(1, int(decimation)), 0]
+        # copy-on-write, so the subscriber thread can iterate without a lock
+        self._state_callbacks = self._state_callbacks + [handle]
+        return handle
+
+    def remove_state_callback(self, handle):
+        """
+        :param handle: value returned by :py:meth:`add_state_callback`
+        """
+        self._state_callbacks = [h for h in self._state_callbacks if h is not handle]
+
+    def _run_state_callbacks(self):
+        callbacks = self._state_callbacks
+        if not callbacks:
+            return
+        snapshot = None
+        for handle in callbacks:
+            handle[2] += 1
+            if handle[2] >= handle[1]:
+                handle[2] = 0
+                if snapshot is None:
+                    snapshot = self.state_snapshot()
+                handle[0](snapshot)
 
     def joint_angle(self, joint):
         """
@@ -424,7 +660,7 @@ class ArmInterface(object):
         :rtype: float
         :return: angle in radians of individual joint
         """
-        return self._joint_angle[joint]
+        return float(self._q[self._joint_index[joint]])
 
     def joint_angles(self):
         """
@@ -433,7 +669,7 @@ class ArmInterface(object):
         :rtype: dict({str:float})
         :return: unordered dict of joint name Keys to angle (rad) Values
         """
-        return deepcopy(self._joint_angle)
+        return dict(zip(self._joint_names, self._q.tolist()))
 
     def joint_ordered_angles(self):
         """
@@ -442,7 +678,7 @@ class ArmInterface(object):
         :rtype: [float]
         :return: joint angles (rad) orded by joint_names from proximal to distal (i.e. shoulder to wrist).
         """
-        return [self._joint_angle[name] for name in self._joint_names]
+        return self._q.tolist()
 
     def joint_velocity(self, joint):
         """
@@ -453,7 +689,7 @@ class ArmInterface(object):
         :rtype: float
         :return: velocity in radians/s of individual joint
         """
-        return self._joint_velocity[joint]
+        return float(self._dq[self._joint_index[joint]])
 
     def joint_velocities(self):
         """
@@ -462,7 +698,7 @@ class ArmInterface(object):
         :rtype: dict({str:float})
         :return: unordered dict of joint name Keys to velocity (rad/s) Values
         """
-        return deepcopy(self._joint_velocity)
+        return dict(zip(self._joint_names, self._dq.tolist()))
 
     def joint_effort(self, joint):
         """
@@ -473,7 +709,7 @@ class ArmInterface(object):
         :rtype: float
         :return: effort in Nm of individual joint
         """
-        return self._joint_effort[joint]
+        return float(self._tau[self._joint_index[joint]])
 
     def joint_efforts(self):
         """
@@ -482,7 +718,7 @@ class ArmInterface(object):
         :rtype: dict({str:float})
         :return: unordered dict of joint name Keys to effort (Nm) Values
         """
-        return deepcopy(self._joint_effort)
+        return dict(zip(self._joint_names, self._tau.tolist()))
 
     def endpoint_pose(self):
         """
@@ -495,7 +731,8 @@ class ArmInterface(object):
           - 'orientation': quaternion x,y,z,w in quaternion format
 
         """
-        return deepcopy(self._cartesian_pose)
+        pose = self._endpoint_quantity('pose')
+        return {'position': np.array(pose['position']), 'orientation': pose['orientation']}
 
     def endpoint_velocity(self):
         """
@@ -507,7 +744,7 @@ class ArmInterface(object):
           - 'linear': np.array of x, y, z
           - 'angular': np.array of x, y, z (angular velocity along the axes)
         """
-        return deepcopy(self._cartesian_velocity)
+        return {'linear': np.array(self._O_dP_EE[:3]), 'angular': np.array(self._O_dP_EE[3:])}
 
     def endpoint_effort(self):
         """
@@ -519,7 +756,8 @@ class ArmInterface(object):
           - 'force': Cartesian force on x,y,z axes in np.ndarray format
           - 'torque': Torque around x,y,z axes in np.ndarray format
         """
-        return deepcopy(self._cartesian_effort)
+        wrench = self._endpoint_quantity('O_F_ext_hat_K')
+        return {'force': np.array(wrench[:3]), 'torque': np.array(wrench[3:])}
 
     def exit_control_mode(self, timeout=0.2):
         """
@@ -541,22 +779,103 @@ class ArmInterface(object):
         :rtype: TipState object
         :return: pose, velocity, effort, effort_in_K_frame
         """
-        return deepcopy(self._tip_states)
+        msg, _ = self._endpoint
+        K_wrench = self._endpoint_quantity('K_F_ext_hat_K')
+        return TipState(msg.header.stamp, self.endpoint_pose(), self.endpoint_velocity(), self.endpoint_effort(),
+                        {'force': np.array(K_wrench[:3]), 'torque': np.array(K_wrench[3:])})
         
-    def joint_inertia_matrix(self):
+    def joint_inertia_matrix(self, copy=True):
         """
         
+        :type copy: bool
+        :param copy: if False, return a read-only view of the latest message instead of a copy
         :return: joint inertia matrix (7,7)
         :rtype: np.ndarray [7x7]
         """
-        return deepcopy(self._joint_inertia)
+        return np.array(self._joint_inertia) if copy else self._joint_inertia
 
-    def zero_jacobian(self):
+    def zero_jacobian(self, copy=True):
         """
+        :type copy: bool
+        :param copy: if False, return a read-only view of the latest message instead of a copy
         :return: end-effector jacobian (6,7)
         :rtype: np.ndarray [6x7]
         """
-        return deepcopy(self._jacobian)        
+        return np.array(self._jacobian) if copy else self._jacobian
+
+    def forward_kinematics_batch(self, qs):
+        """
+        End-effector poses for many joint configurations at once (C++ library, see
+        :py:class:`franka_interface.batch_kinematics.BatchKinematics`), using the
+        current EE frame.
+
+        :param qs: joint positions ordered as :py:meth:`joint_names`, shape (N, 7)
+        :type qs: np.ndarray
+        :return: poses in the base frame, shape (N, 4, 4)
+        :rtype: np.ndarray
+        """
+        return self._get_batch_kinematics().forward_kinematics(qs)
+
+    def zero_jacobian_batch(self, qs):
+        """
+        End-effector zero Jacobians for many joint configurations at once, using the
+        current EE frame (see :py:meth:`forward_kinematics_batch`).
+
+        :param qs: joint positions ordered as :py:meth:`joint_names`, shape (N, 7)
+        :type qs: np.ndarray
+        :return: jacobians, shape (N, 6, 7)
+        :rtype: np.ndarray
+        """
+        return self._get_batch_kinematics().zero_jacobians(qs)
+
+    def _get_batch_kinematics(self):
+        if self._batch_kinematics is None:
+            self._batch_kinematics = BatchKinematics(self._params.get_kinematic_parameters())
+        EE_frame = self._frames_interface.get_EE_frame()
+        if EE_frame is not None:
+            self._batch_kinematics.set_EE_frame(EE_frame)
+        return self._batch_kinematics
+
+    def wait_for_command_subscribers(self, topics=None, timeout=5.0):
+        """
+        Wait until the controllers are subscribed to the command topics, so that
+        commands published afterwards are not dropped. The command helpers (set_*,
+        execute_*) already wait up to command_connection_timeout on each topic they use.
+
+        :type topics: [str]
+        :param topics: resolved topic names; all command topics of the arm interface if
+            None (topics of inactive controllers may never get a subscriber)
+        :type timeout: float
+        :param timeout: seconds to wait in total
+        :rtype: bool
+        :return: True if every topic has a subscriber
+        """
+        if topics is None:
+            publishers = list(self._command_publishers.values())
+        else:
+            publishers = [self._command_publishers[topic] for topic in topics]
+        return franka_dataflow.wait_for(
+            lambda: all(pub.get_num_connections() > 0 for pub in publishers),
+            timeout=timeout, raise_on_error=False, rate=1000,
+            timeout_msg="ArmInterface: Timed out waiting for subscribers of %s" %
+                        ", ".join(pub.resolved_name for pub in publishers
+                                  if pub.get_num_connections() == 0))
+
+    def _publish_command(self, publisher, msg):
+        # Right after startup or a controller switch the subscriber may not be connected yet,
+        # and rospy would silently drop the message.
+        if publisher.get_num_connections() == 0:
+            franka_dataflow.wait_for(lambda: publisher.get_num_connections() > 0,
+                                     timeout=self._command_connection_timeout,
+                                     raise_on_error=False, rate=1000,
+                                     timeout_msg="ArmInterface: No subscriber on %s, command may be lost" %
+                                                 publisher.resolved_name)
+        publisher.publish(msg)
+
+    def _get_trajectory_client(self):
+        if self._trajectory_client is None:
+            self._trajectory_client = JointTrajectoryActionClient(joint_names = self.joint_names())
+        return self._trajectory_client
 
     def set_command_timeout(self, timeout):
         """
@@ -598,7 +917,7 @@ class ArmInterface(object):
         self._command_msg.position = [positions[j] for j in self._joint_names]
         self._command_msg.mode = JointCommand.POSITION_MODE
         self._command_msg.header.stamp = rospy.Time.now()
-        self._joint_command_publisher.publish(self._command_msg)
+        self._publish_command(self._joint_command_publisher, self._command_msg)
 
     def set_joint_velocities(self, velocities):
         """
@@ -611,7 +930,7 @@ class ArmInterface(object):
         self._command_msg.velocity = [velocities[j] for j in self._joint_names]
         self._command_msg.mode = JointCommand.VELOCITY_MODE
         self._command_msg.header.stamp = rospy.Time.now()
-        self._joint_command_publisher.publish(self._command_msg)
+        self._publish_command(self._joint_command_publisher, self._command_msg)
 
     def set_joint_torques(self, torques):
         """
@@ -624,7 +943,7 @@ class ArmInterface(object):
         self._command_msg.effort = [torques[j] for j in self._joint_names]
         self._command_msg.mode = JointCommand.TORQUE_MODE
         self._command_msg.header.stamp = rospy.Time.now()
-        self._joint_command_publisher.publish(self._command_msg)
+        self._publish_command(self._joint_command_publisher, self._command_msg)
 
     def set_joint_positions_velocities(self, positions, velocities):
         """
@@ -644,15 +963,69 @@ class ArmInterface(object):
         self._command_msg.velocity = velocities
         self._command_msg.mode = JointCommand.IMPEDANCE_MODE
         self._command_msg.header.stamp = rospy.Time.now()
-        self._joint_command_publisher.publish(self._command_msg)
+        self._publish_command(self._joint_command_publisher, self._command_msg)
+
+    def set_joint_command_batch(self, mode, times, positions=None, velocities=None, efforts=None, start_time=None):
+        """
+        Sends several future commands for the active controller in one message, e.g. the
+        horizon of a model predictive controller. Each waypoint is applied at start_time + times[k]
+        and held until the next one; a new batch replaces the waypoints not yet applied.
+
+        :type mode: int
+        :param mode: command mode, e.g. JointCommand.POSITION_MODE
+        :type times: [float]
+        :param times: time (s) of each waypoint relative to start_time, non-decreasing
+        :type positions: [[float]]
+        :param positions: joint positions of each waypoint, ordered as self.joint_names()
+        :type velocities: [[float]]
+        :param velocities: joint velocities of each waypoint, ordered as self.joint_names()
+        :type efforts: [[float]]
+        :param efforts: joint torques of each waypoint, ordered as self.joint_names()
+        :type start_time: rospy.Time
+        :param start_time: time of the first waypoint (default: now)
+        """
+        msg = JointCommandBatch()
+        msg.header.stamp = rospy.Time.now() if start_time is None else start_time
+        msg.mode = mode
+        msg.names = self._joint_names
+        msg.time_from_start = list(times)
+        if positions is not None:
+            msg.position = np.asarray(positions, dtype=float).ravel().tolist()
+        if velocities is not None:
+            msg.velocity = np.asarray(velocities, dtype=float).ravel().tolist()
+        if efforts is not None:
+            msg.effort = np.asarray(efforts, dtype=float).ravel().tolist()
+        self._publish_command(self._joint_command_batch_publisher, msg)
 
 
     def has_collided(self):
         """
         Returns true if either joint collision or cartesian collision is detected. 
         Collision thresholds can be set using instance of :py:class:`franka_tools.CollisionBehaviourInterface`.
+
+        The contact_events stream of the state controller reports a collision as soon as the
+        control loop sees it; the flags of the last robot state are checked as well.
         """
+        if self._contact_event is not None and self._contact_event.sources & (
+                ContactEvent.SOURCE_JOINT_COLLISION | ContactEvent.SOURCE_CARTESIAN_COLLISION):
+            return True
         return any(self._joint_collision) or any(self._cartesian_collision)
+
+    def in_contact(self):
+        """
+        Returns true while any of the contact predicates of robot_config/contact_events
+        (external force, joint torques, contact and collision flags of the robot) is active.
+
+        :rtype: bool
+        """
+        return self._contact_event is not None and self._contact_event.sources != 0
+
+    def contact_event(self):
+        """
+        :rtype: franka_core_msgs.msg.ContactEvent
+        :return: the latest change of the contact predicates, or None if there was none
+        """
+        return self._contact_event
         
 
     def switchToController(self, controller_name):
@@ -682,7 +1055,7 @@ class ArmInterface(object):
 
     def genf(self, joint, angle):
         def joint_diff():
-            return abs(angle - self._joint_angle[joint])
+            return abs(angle - self.joint_angle(joint))
         return joint_diff
 
     def move_to_joint_positions(self, positions, timeout=10.0,
@@ -709,15 +1082,15 @@ class ArmInterface(object):
             self.switchToController(self._ctrl_manager.joint_trajectory_controller)
        
         min_traj_dur = 0.5
-        traj_client = JointTrajectoryActionClient(joint_names = self.joint_names())
+        traj_client = self._get_trajectory_client()
         traj_client.clear()
 
         dur = []
         for j in range(len(self._joint_names)):
-            dur.append(max(abs(positions[self._joint_names[j]] - self._joint_angle[self._joint_names[j]]) / self._joint_limits.velocity[j], min_traj_dur))
+            dur.append(max(abs(positions[self._joint_names[j]] - self._q[j]) / self._joint_limits.velocity[j], min_traj_dur))
         traj_client.add_point(positions = [positions[n] for n in self._joint_names], time = max(dur)/self._speed_ratio)
 
-        diffs = [self.genf(j, a) for j, a in positions.items() if j in self._joint_angle]
+        diffs = [self.genf(j, a) for j, a in positions.items() if j in self._joint_index]
 
         traj_client.start() # send the trajectory action request
         fail_msg = "ArmInterface: {0} limb failed to reach commanded joint positions.".format(
@@ -771,7 +1144,7 @@ class ArmInterface(object):
             self.switchToController(self._ctrl_manager.joint_trajectory_controller)
         
         min_traj_dur = 0.5
-        traj_client = JointTrajectoryActionClient(joint_names = self.joint_names())
+        traj_client = self._get_trajectory_client()
         traj_client.clear()
 
         time_so_far = 0
@@ -780,12 +1153,12 @@ class ArmInterface(object):
             q = position_path[i]
             dur = []
             for j in range(len(self._joint_names)):
-                dur.append(max(abs(q[self._joint_names[j]] - self._joint_angle[self._joint_names[j]]) / self._joint_limits.velocity[j], min_traj_dur))
+                dur.append(max(abs(q[self._joint_names[j]] - self._q[j]) / self._joint_limits.velocity[j], min_traj_dur))
 
             time_so_far += max(dur)/self._speed_ratio
             traj_client.add_point(positions = [q[n] for n in self._joint_names], time = time_so_far, velocities=[0.005 for n in self._joint_names])
 
-        diffs = [self.genf(j, a) for j, a in (position_path[-1]).items() if j in self._joint_angle] # Measures diff to last waypoint
+        diffs = [self.genf(j, a) for j, a in (position_path[-1]).items() if j in self._joint_index] # Measures diff to last waypoint
 
         fail_msg = "ArmInterface: {0} limb failed to reach commanded joint positions.".format(
                                                       self.name.capitalize())
@@ -832,33 +1205,37 @@ class ArmInterface(object):
             self.switchToController(self._ctrl_manager.joint_trajectory_controller)
         
         min_traj_dur = 0.5
-        traj_client = JointTrajectoryActionClient(joint_names = self.joint_names())
+        traj_client = self._get_trajectory_client()
         traj_client.clear()
 
         speed_ratio = 0.05 # Move slower when approaching contact
         dur = []
         for j in range(len(self._joint_names)):
-            dur.append(max(abs(positions[self._joint_names[j]] - self._joint_angle[self._joint_names[j]]) / self._joint_limits.velocity[j], min_traj_dur))
+            dur.append(max(abs(positions[self._joint_names[j]] - self._q[j]) / self._joint_limits.velocity[j], min_traj_dur))
         traj_client.add_point(positions = [positions[n] for n in self._joint_names], time = max(dur)/speed_ratio, velocities=[0.002 for n in self._joint_names])
 
-        diffs = [self.genf(j, a) for j, a in positions.items() if j in self._joint_angle]
+        diffs = [self.genf(j, a) for j, a in positions.items() if j in self._joint_index]
         fail_msg = "ArmInterface: {0} limb failed to reach commanded joint positions.".format(
                                                       self.name.capitalize()) 
  
+        self._contact_onset.clear()
         traj_client.start() # send the trajectory action request
 
-        franka_dataflow.wait_for(
-            test=lambda: self.has_collided() or \
-                         (all(diff() < threshold for diff in diffs)),
-            timeout=timeout,
-            timeout_msg="Move to touch complete.",
-            rate=100,
-            raise_on_error=False
-            )
+        # Contact onsets arrive as events and wake this thread immediately; with
+        # contact_events/reaction set, the control node has already stopped the trajectory
+        # controller by then. Reaching the target and the collision flag are checked in between.
+        end_time = rospy.get_time() + timeout
+        while not self._contact_onset.wait(0.01):
+            if rospy.is_shutdown() or self.has_collided() or \
+                    all(diff() < threshold for diff in diffs):
+                break
+            if rospy.get_time() >= end_time:
+                rospy.loginfo("Move to touch complete.")
+                break
 
         rospy.sleep(0.5)
 
-        if not self.has_collided():
+        if not (self._contact_onset.is_set() or self.has_collided()):
             rospy.logerr('Move To Touch did not end in making contact') 
         else:
 
@@ -870,12 +1247,31 @@ class ArmInterface(object):
 
         rospy.loginfo("ArmInterface: Trajectory controlling complete")
 
-    def resetErrors(self):
-        rospy.sleep(0.5)
-        pub = rospy.Publisher('/franka_ros_interface/franka_control/error_recovery/goal', franka_control.msg.ErrorRecoveryActionGoal, queue_size=10)
-        rospy.sleep(0.5)
-        pub.publish(franka_control.msg.ErrorRecoveryActionGoal())
+    def resetErrors(self, timeout=5.0):
+        """
+        Recover from robot errors (e.g. collision reflexes) through the error_recovery
+        action of franka_control. The action client is kept connected, so this is cheap
+        when there is no error.
+
+        :type timeout: float
+        :param timeout: seconds to wait for the recovery
+        :rtype: bool
+        :return: True if the recovery succeeded within the timeout
+        """
+        # normally connected long before, as the client is created with the interface
+        if not self._error_recovery_client.wait_for_server(rospy.Duration(min(timeout, 1.0))):
+            rospy.logwarn("ArmInterface: Error recovery action server is not available")
+            return False
+        self._error_recovery_client.send_goal(franka_control.msg.ErrorRecoveryGoal())
+        if not self._error_recovery_client.wait_for_result(rospy.Duration(timeout)):
+            rospy.logwarn("ArmInterface: Error recovery did not finish within %.1f s" % timeout)
+            return False
+        state = self._error_recovery_client.get_state()
+        if state != GoalStatus.SUCCEEDED:
+            rospy.logwarn("ArmInterface: Error recovery failed (goal status %d)" % state)
+            return False
         rospy.loginfo("Collision Reflex was reset")
+        return True
 
     def move_from_touch(self, positions, timeout=10.0, threshold=0.00085):
         """
@@ -898,15 +1294,15 @@ class ArmInterface(object):
             self.switchToController(self._ctrl_manager.joint_trajectory_controller)
         
         min_traj_dur = 0.5
-        traj_client = JointTrajectoryActionClient(joint_names = self.joint_names())
+        traj_client = self._get_trajectory_client()
         traj_client.clear()
 
         dur = []
         for j in range(len(self._joint_names)):
-            dur.append(max(abs(positions[self._joint_names[j]] - self._joint_angle[self._joint_names[j]]) / self._joint_limits.velocity[j], min_traj_dur))
+            dur.append(max(abs(positions[self._joint_names[j]] - self._q[j]) / self._joint_limits.velocity[j], min_traj_dur))
         traj_client.add_point(positions = [positions[n] for n in self._joint_names], time = max(dur)/self._speed_ratio)
 
-        diffs = [self.genf(j, a) for j, a in positions.items() if j in self._joint_angle]
+        diffs = [self.genf(j, a) for j, a in positions.items() if j in self._joint_index]
         fail_msg = "ArmInterface: {0} limb failed to reach commanded joint positions.".format(
                                                       self.name.capitalize()) 
  
@@ -928,14 +1324,7 @@ class ArmInterface(object):
             self.switchToController(self._ctrl_manager.cartesian_impedance_controller)
 
         if stiffness is not None:
-            stiffness_gains = CartImpedanceStiffness()
-            stiffness_gains.x = stiffness[0]
-            stiffness_gains.y = stiffness[1]
-            stiffness_gains.z = stiffness[2]
-            stiffness_gains.xrot = stiffness[3]
-            stiffness_gains.yrot = stiffness[4]
-            stiffness_gains.zrot = stiffness[5]
-            self._cartesian_stiffness_publisher.publish(stiffness_gains)
+            self._publish_cart_stiffness(stiffness)
 
         marker_pose = PoseStamped()
         marker_pose.pose.position.x = pose['position'][0]
@@ -945,13 +1334,23 @@ class ArmInterface(object):
         marker_pose.pose.orientation.y = pose['orientation'].y
         marker_pose.pose.orientation.z = pose['orientation'].z
         marker_pose.pose.orientation.w = pose['orientation'].w
-        self._cartesian_impedance_pose_publisher.publish(marker_pose)
+        self._publish_command(self._cartesian_impedance_pose_publisher, marker_pose)
 
         # Do not return until motion complete
         rospy.sleep(0.1)
         while sum(map(abs, self.convertToList(self.joint_velocities()))) > 1e-2:
             rospy.sleep(0.1)
 
+    def _publish_cart_stiffness(self, stiffness):
+        stiffness_gains = CartImpedanceStiffness()
+        stiffness_gains.x = stiffness[0]
+        stiffness_gains.y = stiffness[1]
+        stiffness_gains.z = stiffness[2]
+        stiffness_gains.xrot = stiffness[3]
+        stiffness_gains.yrot = stiffness[4]
+        stiffness_gains.zrot = stiffness[5]
+        self._publish_command(self._cartesian_stiffness_publisher, stiffness_gains)
+
 
     def set_joint_impedance_config(self, q, stiffness=None):
         #Need q converted to list
@@ -961,12 +1360,12 @@ class ArmInterface(object):
         if stiffness is not None:
             stiffness_gains = JointImpedanceStiffness()
             stiffness_gains = stiffness
-            self._joint_stiffness_publisher.publish(stiffness_gains)
+            self._publish_command(self._joint_stiffness_publisher, stiffness_gains)
 
         marker_pose = JICmd()
         marker_pose.position = q
         marker_pose.velocity = [0.005]*7
-        self._joint_impedance_publisher.publish(marker_pose)
+        self._publish_command(self._joint_impedance_publisher, marker_pose)
 
         # Do not return until motion complete
         rospy.sleep(0.1)
@@ -982,24 +1381,149 @@ class ArmInterface(object):
 
         torque = TorqueCmd()
         torque.torque = tau
-        self._torque_controller_publisher.publish(torque)
+        self._publish_command(self._torque_controller_publisher, torque)
+
+    def execute_cart_impedance_traj(self, poses, stiffness=None, times=None):
+        """
+        Moves the equilibrium pose of the cartesian impedance controller through the given poses.
 
-    def execute_cart_impedance_traj(self, poses, stiffness=None):
+        @type poses: [dict]
+        @param poses: poses with 'position' and 'orientation' (quaternion) keys
+        @type stiffness: [float]
+        @param stiffness: optional cartesian stiffness (x, y, z, xrot, yrot, zrot)
+        @type times: [float]
+        @param times: optional time (s) from the start at which each pose is reached. If
+            given, the whole trajectory is sent ahead and interpolated by the controller;
+            otherwise each pose is commanded in turn, waiting for the robot to stop in between.
+        """
         if self._ctrl_manager.current_controller != self._ctrl_manager.cartesian_impedance_controller: 
             self.switchToController(self._ctrl_manager.cartesian_impedance_controller)
 
+        if times is not None:
+            if stiffness is not None:
+                self._publish_cart_stiffness(stiffness)
+            self.resetErrors()
+            self.send_cart_impedance_trajectory(poses, times)
+            rospy.sleep(times[-1])
+            return
+
         for i in xrange(len(poses)):
             self.set_cart_impedance_pose(poses[i], stiffness)
             if i == 0: self.resetErrors()
 
-    def execute_joint_impedance_traj(self, qs, stiffness=None):
+    def execute_joint_impedance_traj(self, qs, stiffness=None, times=None):
+        """
+        Moves the equilibrium configuration of the joint impedance controller through the given
+        joint positions.
+
+        @type qs: [[float]]
+        @param qs: joint positions
+        @type stiffness: [float]
+        @param stiffness: optional joint stiffness
+        @type times: [float]
+        @param times: optional time (s) from the start at which each configuration is reached.
+            If given, the whole trajectory is sent ahead and interpolated by the controller;
+            otherwise each configuration is commanded in turn, waiting for the robot to stop
+            in between.
+        """
         if self._ctrl_manager.current_controller != self._ctrl_manager.joint_impedance_controller:
             self.switchToController(self._ctrl_manager.joint_impedance_controller)
 
+        if times is not None:
+            if stiffness is not None:
+                self._publish_command(self._joint_stiffness_publisher, stiffness)
+            self.resetErrors()
+            self.send_joint_impedance_trajectory(qs, times)
+            rospy.sleep(times[-1])
+            return
+
         for i in xrange(len(qs)):
             self.set_joint_impedance_config(qs[i], stiffness)
             if i == 0: self.resetErrors()
 
+    def send_joint_impedance_trajectory(self, qs, times, velocities=None, accelerations=None,
+                                        interpolation='cubic', append=False, chunk_size=200):
+        """
+        (Non-blocking) Sends a time-stamped trajectory to the joint impedance controller, which
+        queues it and interpolates between the points in its control loop. Long trajectories
+        are sent in chunks; later chunks are appended to the first one.
+
+        @type qs: [[float]]
+        @param qs: joint positions of the points
+        @type times: [float]
+        @param times: time (s) at which each point is reached, from the start of the
+            trajectory (or from the last queued point if append is True)
+        @type velocities: [[float]]
+        @param velocities: optional joint velocities at the points (default zero)
+        @type accelerations: [[float]]
+        @param accelerations: optional joint accelerations at the points, used by quintic
+            interpolation (default zero)
+        @type interpolation: str
+        @param interpolation: 'cubic' or 'quintic'
+        @type append: bool
+        @param append: continue the queued trajectory instead of replacing it
+        @type chunk_size: int
+        @param chunk_size: points per message (the controller accepts at most 1024)
+        """
+        assert len(qs) == len(times), "ArmInterface: Need one time per trajectory point"
+        assert interpolation in ('cubic', 'quintic'), "ArmInterface: Unknown interpolation {}".format(interpolation)
+
+        chunk_start = 0.
+        for begin in xrange(0, len(qs), chunk_size):
+            msg = JointImpedanceTrajectory()
+            msg.interpolation = JointImpedanceTrajectory.INTERPOLATION_QUINTIC if interpolation == 'quintic' \
+                else JointImpedanceTrajectory.INTERPOLATION_CUBIC
+            msg.append = append or begin > 0
+            for i in xrange(begin, min(begin + chunk_size, len(qs))):
+                point = JointImpedanceTrajectoryPoint()
+                point.position = list(qs[i])
+                if velocities is not None:
+                    point.velocity = list(velocities[i])
+                if accelerations is not None:
+                    point.acceleration = list(accelerations[i])
+                point.time_from_start = rospy.Duration(times[i] - chunk_start)
+                msg.points.append(point)
+            chunk_start = times[min(begin + chunk_size, len(qs)) - 1]
+            self._publish_command(self._joint_impedance_trajectory_publisher, msg)
+
+    def send_cart_impedance_trajectory(self, poses, times, append=False, chunk_size=200):
+        """
+        (Non-blocking) Sends a time-stamped trajectory of equilibrium poses to the cartesian
+        impedance controller, which queues it and interpolates between the poses (linearly in
+        position, SLERP in orientation) in its control loop. Long trajectories are sent in
+        chunks; later chunks are appended to the first one. The controller rejects a chunk whose
+        consecutive poses are further apart than its trajectory_velocity_limits allow.
+
+        @type poses: [dict]
+        @param poses: poses with 'position' and 'orientation' (quaternion) keys
+        @type times: [float]
+        @param times: time (s) at which each pose is reached, from the start of the trajectory
+            (or from the last queued pose if append is True)
+        @type append: bool
+        @param append: continue the queued trajectory instead of replacing it
+        @type chunk_size: int
+        @param chunk_size: poses per message (the controller accepts at most 1024)
+        """
+        assert len(poses) == len(times), "ArmInterface: Need one time per trajectory point"
+
+        chunk_start = 0.
+        for begin in xrange(0, len(poses), chunk_size):
+            msg = CartImpedanceTrajectory()
+            msg.append = append or begin > 0
+            for i in xrange(begin, min(begin + chunk_size, len(poses))):
+                point = CartImpedanceTrajectoryPoint()
+                point.pose.position.x = poses[i]['position'][0]
+                point.pose.position.y = poses[i]['position'][1]
+                point.pose.position.z = poses[i]['position'][2]
+                point.pose.orientation.x = poses[i]['orientation'].x
+                point.pose.orientation.y = poses[i]['orientation'].y
+                point.pose.orientation.z = poses[i]['orientation'].z
+                point.pose.orientation.w = poses[i]['orientation'].w
+                point.time_from_start = rospy.Duration(times[i] - chunk_start)
+                msg.points.append(point)
+            chunk_start = times[min(begin + chunk_size, len(poses)) - 1]
+            self._publish_command(self._cartesian_impedance_trajectory_publisher, msg)
+
     def exert_force(self, target_wrench):
         if self._ctrl_manager.current_controller != self._ctrl_manager.force_controller: 
             self.switchToController(self._ctrl_manager.force_controller)
@@ -1011,7 +1535,7 @@ class ArmInterface(object):
         wrench.torque.x = target_wrench[3]
         wrench.torque.y = target_wrench[4] 
         wrench.torque.z = target_wrench[5]
-        self._force_controller_publisher.publish(wrench)
+        self._publish_command(self._force_controller_publisher, wrench)
 
     def pause_controllers_and_do(self, func, *args, **kwargs):
         """
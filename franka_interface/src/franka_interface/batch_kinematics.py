@@ -0,0 +1,177 @@
+# /***************************************************************************
+
+# 
+# @package: franka_interface
+# @metapackage: franka_ros_interface
+# @author: Saif Sidhik <sxs1412@bham.ac.uk>
+# 
+
+# **************************************************************************/
+
+# /***************************************************************************
+# Copyright (c) 2019-2020, Saif Sidhik
+ 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#     http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# **************************************************************************/
+
+"""
+ @info: 
+       Python bindings of the C++ batch kinematics library of franka_interface
+       (franka_interface/batch_kinematics.h). Evaluates forward kinematics and zero
+       Jacobians of many joint configurations in one call; results are written by the
+       library directly into the returned NumPy arrays.
+
+       Requires libfranka_batch_kinematics.so on the library path (source the catkin
+       workspace).
+
+"""
+
+import ctypes
+
+import numpy as np
+
+_DOUBLES = np.ctypeslib.ndpointer(dtype=np.float64, flags='C_CONTIGUOUS')
+
+# Panda, modified (Craig) Denavit-Hartenberg; overridden by /robot_config/kinematics
+DEFAULT_PARAMETERS = {
+    'a': [0.0, 0.0, 0.0, 0.0825, -0.0825, 0.0, 0.088],
+    'd': [0.333, 0.0, 0.316, 0.0, 0.384, 0.0, 0.0],
+    'alpha': [0.0, -np.pi / 2, np.pi / 2, np.pi / 2, -np.pi / 2, np.pi / 2, np.pi / 2],
+    'flange': 0.107,
+    'threads': 0,
+}
+
+
+def _load_library():
+    library = ctypes.CDLL('libfranka_batch_kinematics.so')
+    library.franka_batch_kinematics_create.restype = ctypes.c_void_p
+    library.franka_batch_kinematics_create.argtypes = [_DOUBLES, _DOUBLES, _DOUBLES,
+                                                       ctypes.c_double, ctypes.c_int]
+    library.franka_batch_kinematics_destroy.restype = None
+    library.franka_batch_kinematics_destroy.argtypes = [ctypes.c_void_p]
+    library.franka_batch_kinematics_set_ee_frame.restype = None
+    library.franka_batch_kinematics_set_ee_frame.argtypes = [ctypes.c_void_p, _DOUBLES]
+    library.franka_batch_kinematics_threads.restype = ctypes.c_int
+    library.franka_batch_kinematics_threads.argtypes = [ctypes.c_void_p]
+    library.franka_batch_kinematics_evaluate.restype = None
+    library.franka_batch_kinematics_evaluate.argtypes = [ctypes.c_void_p, _DOUBLES,
+                                                         ctypes.c_size_t, ctypes.c_void_p,
+                                                         ctypes.c_void_p]
+    return library
+
+
+class BatchKinematics(object):
+    """
+    Forward kinematics and zero Jacobians of the end-effector frame for batches of
+    joint configurations, matching O_T_EE and O_Jac_EE of the robot state for the
+    same EE frame.
+
+        >>> kinematics = BatchKinematics(F_T_EE=arm.get_frames_interface().get_EE_frame())
+        >>> poses, jacobians = kinematics.evaluate(qs)   # qs: (N, 7)
+
+    :param parameters: kinematic chain as in /robot_config/kinematics (keys a, d,
+        alpha, flange, threads); missing keys use DEFAULT_PARAMETERS
+    :type parameters: dict
+    :param F_T_EE: flange to end-effector transformation (16 values,
+        column-major as in franka_core_msgs/RobotState); identity if None
+    :type F_T_EE: [float]
+    """
+
+    _library = None
+
+    def __init__(self, parameters=None, F_T_EE=None):
+
+        if BatchKinematics._library is None:
+            BatchKinematics._library = _load_library()
+
+        params = dict(DEFAULT_PARAMETERS)
+        params.update(parameters or {})
+        self._handle = self._library.franka_batch_kinematics_create(
+            np.ascontiguousarray(params['a'], dtype=np.float64),
+            np.ascontiguousarray(params['d'], dtype=np.float64),
+            np.ascontiguousarray(params['alpha'], dtype=np.float64),
+            float(params['flange']), int(params['threads']))
+        if not self._handle:
+            raise RuntimeError("BatchKinematics: Could not create the kinematics library instance")
+
+        if F_T_EE is not None:
+            self.set_EE_frame(F_T_EE)
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self._library.franka_batch_kinematics_destroy(self._handle)
+            self._handle = None
+
+    def set_EE_frame(self, F_T_EE):
+        """
+        :param F_T_EE: flange to end-effector transformation (16 values, column-major)
+        :type F_T_EE: [float]
+        """
+        F_T_EE = np.ascontiguousarray(F_T_EE, dtype=np.float64).reshape(16)
+        self._library.franka_batch_kinematics_set_ee_frame(self._handle, F_T_EE)
+
+    def threads(self):
+        """
+        :return: number of threads used for a batch
+        :rtype: int
+        """
+        return self._library.franka_batch_kinematics_threads(self._handle)
+
+    def evaluate(self, qs, poses=True, jacobians=True):
+        """
+        :param qs: joint positions, shape (N, 7) (or (7,) for a single configuration)
+        :type qs: np.ndarray
+        :param poses: compute the end-effector poses
+        :type poses: bool
+        :param jacobians: compute the zero Jacobians
+        :type jacobians: bool
+        :return: poses (N, 4, 4) and jacobians (N, 6, 7; linear rows first), None for
+            the quantities not requested
+        :rtype: (np.ndarray, np.ndarray)
+        """
+        qs = np.ascontiguousarray(qs, dtype=np.float64)
+        if qs.ndim not in (1, 2) or qs.shape[-1] != 7:
+            raise ValueError("BatchKinematics: Expected joint positions of shape (N, 7)")
+        single = qs.ndim == 1
+        qs = qs.reshape(-1, 7)
+        count = qs.shape[0]
+
+        out_poses = np.empty((count, 4, 4)) if poses else None
+        out_jacobians = np.empty((count, 6, 7)) if jacobians else None
+        self._library.franka_batch_kinematics_evaluate(
+            self._handle, qs, count,
+            None if out_poses is None else out_poses.ctypes.data,
+            None if out_jacobians is None else out_jacobians.ctypes.data)
+
+        if single:
+            return (None if out_poses is None else out_poses[0],
+                    None if out_jacobians is None else out_jacobians[0])
+        return out_poses, out_jacobians
+
+    def forward_kinematics(self, qs):
+        """
+        :param qs: joint positions, shape (N, 7)
+        :type qs: np.ndarray
+        :return: end-effector poses in the base frame, shape (N, 4, 4)
+        :rtype: np.ndarray
+        """
+        return self.evaluate(qs, jacobians=False)[0]
+
+    def zero_jacobians(self, qs):
+        """
+        :param qs: joint positions, shape (N, 7)
+        :type qs: np.ndarray
+        :return: end-effector zero Jacobians, shape (N, 6, 7)
+        :rtype: np.ndarray
+        """
+        return self.evaluate(qs, poses=False)[1]
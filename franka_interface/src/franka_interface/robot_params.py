@@ -222,6 +222,22 @@ class RobotParams(object):
 
         return lims
 
+    def get_kinematic_parameters(self):
+        """
+        Get the kinematic chain of the arm from ROS parameter server
+        (/robot_config/kinematics), as used by franka_interface.batch_kinematics.
+
+        :return: modified DH parameters (keys a, d, alpha, flange, threads), or None if
+            not defined
+        :rtype: dict
+        """
+        try:
+            return rospy.get_param("/robot_config/kinematics")
+        except KeyError:
+            return None
+        except (socket.error, socket.gaierror):
+            _log_networking_error()
+
 
 
 if __name__ == '__main__':
@@ -0,0 +1,185 @@
+# /***************************************************************************
+
+# 
+# @package: franka_interface
+# @metapackage: franka_ros_interface
+# @author: Saif Sidhik <sxs1412@bham.ac.uk>
+# 
+
+# **************************************************************************/
+
+# /***************************************************************************
+# Copyright (c) 2019-2020, Saif Sidhik
+ 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#     http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# **************************************************************************/
+
+"""
+ @info: 
+       Client for the optional shared-memory transport of franka_ros_interface
+       (franka_ros_controllers/shm_transport.h). Lets a process on the same host read
+       the robot state written every control cycle and send joint commands to the
+       effort controllers without going through ROS topics.
+
+       Enable it with the /robot_config/shm_transport/enabled parameter.
+
+"""
+
+import mmap
+import os
+import struct
+import time
+
+import numpy as np
+
+_MAGIC = 0x4d485346
+_VERSION = 1
+
+# Segment header: magic, version, size, state_ring_size, state_offset, state_stride,
+# command_offset, reserved; followed (at offset 64) by the 64 bit state head counter.
+_HEADER = struct.Struct('<8I')
+_STATE_HEAD_OFFSET = 64
+_WORD = struct.Struct('<Q')
+
+_STATE_FIELDS = [('sequence', 1), ('robot_mode', 1), ('time', 1),
+                 ('q', 7), ('dq', 7), ('q_d', 7), ('dq_d', 7),
+                 ('tau_J', 7), ('tau_J_d', 7), ('dtau_J', 7), ('tau_ext_hat_filtered', 7),
+                 ('O_T_EE', 16), ('O_F_ext_hat_K', 6), ('K_F_ext_hat_K', 6)]
+_STATE = struct.Struct('<QQ' + 'd' * sum(n for _, n in _STATE_FIELDS[2:]))
+_COMMAND = struct.Struct('<QQ' + 'd' * 21)
+
+
+class ShmClient(object):
+    """
+    Maps the shared-memory segment created by the robot side (CustomFrankaStateController).
+    Only one ShmClient per segment should send commands at a time.
+
+    :param name: segment name, as set in /robot_config/shm_transport/name
+    :type name: str
+    :param arm_id: arm of a multi-arm control node, whose segment is <name>_<arm_id>; None for
+        a single-arm node
+    :type arm_id: str
+    """
+
+    def __init__(self, name="franka_ros_interface", arm_id=None):
+        if arm_id:
+            name = name + "_" + arm_id
+
+        fd = os.open("/dev/shm/" + name, os.O_RDWR)
+        try:
+            self._buffer = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ | mmap.PROT_WRITE)
+        finally:
+            os.close(fd)
+
+        (magic, version, size, self._ring_size, self._state_offset, self._state_stride,
+         self._command_offset, _) = _HEADER.unpack_from(self._buffer, 0)
+        if magic != _MAGIC or version != _VERSION or size != len(self._buffer):
+            self._buffer.close()
+            raise IOError("Shared-memory segment /dev/shm/%s has an incompatible layout" % name)
+
+        self._command_sequence = 0
+
+    def close(self):
+        self._buffer.close()
+
+    # sequence counters are 8 byte aligned, so these are single loads/stores on x86-64
+    def _load(self, offset):
+        return _WORD.unpack_from(self._buffer, offset)[0]
+
+    def _store(self, offset, value):
+        _WORD.pack_into(self._buffer, offset, value)
+
+    def state_count(self):
+        """
+        :return: number of state samples written by the robot side so far
+        :rtype: int
+        """
+        return self._load(_STATE_HEAD_OFFSET)
+
+    def latest_state(self, retries=8):
+        """
+        Copy of the most recent robot state sample.
+
+        :return: dict of field name to value (float, int or numpy array), or None if no
+            consistent sample could be read
+        :rtype: dict
+        """
+        for _ in range(retries):
+            head = self._load(_STATE_HEAD_OFFSET)
+            if head == 0:
+                return None
+            slot = self._state_offset + ((head - 1) % self._ring_size) * self._state_stride
+            before = self._load(slot)
+            if before & 1:
+                continue
+            raw = _STATE.unpack_from(self._buffer, slot + 8)
+            if self._load(slot) == before:
+                return self._to_dict(raw)
+        return None
+
+    def wait_for_state(self, last_sequence=None, timeout=1.0, poll_period=0.0001):
+        """
+        Busy-waits until a sample newer than last_sequence is available.
+
+        :return: state dict, or None on timeout
+        """
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            state = self.latest_state()
+            if state is not None and (last_sequence is None or state['sequence'] != last_sequence):
+                return state
+            time.sleep(poll_period)
+        return None
+
+    def send_command(self, mode, position=None, velocity=None, effort=None):
+        """
+        Writes a joint command, interpreted like franka_core_msgs/JointCommand by the
+        effort controllers (TORQUE_MODE: effort_joint_torque_controller, IMPEDANCE_MODE:
+        effort_joint_impedance_controller).
+
+        Like the topic path, commands have to be resent at least every
+        /controllers_config/command_timeout seconds; once the controller stops seeing new
+        commands it falls back to zero torque (TORQUE_MODE) or to holding its position
+        (IMPEDANCE_MODE).
+
+        :param mode: franka_core_msgs.msg.JointCommand.*_MODE
+        :param position: 7 joint positions (rad)
+        :param velocity: 7 joint velocities (rad/s)
+        :param effort: 7 joint torques (Nm)
+        """
+        fields = []
+        for values in (position, velocity, effort):
+            values = np.zeros(7) if values is None else np.asarray(values, dtype=float)
+            if values.shape != (7,):
+                raise ValueError("ShmClient: Commands have to be of size 7")
+            fields.extend(values.tolist())
+
+        self._command_sequence += 1
+        payload = _COMMAND.pack(self._command_sequence, int(mode), *fields)
+
+        sequence = self._load(self._command_offset)
+        self._store(self._command_offset, sequence + 1)
+        self._buffer[self._command_offset + 8:self._command_offset + 8 + _COMMAND.size] = payload
+        self._store(self._command_offset, sequence + 2)
+
+    @staticmethod
+    def _to_dict(raw):
+        state = {}
+        i = 0
+        for name, count in _STATE_FIELDS:
+            if count == 1:
+                state[name] = raw[i]
+            else:
+                state[name] = np.array(raw[i:i + count])
+            i += count
+        return state
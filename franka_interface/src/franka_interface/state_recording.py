@@ -0,0 +1,154 @@
+# /***************************************************************************
+
+# 
+# @package: franka_interface
+# @metapackage: franka_ros_interface
+# @author: Saif Sidhik <sxs1412@bham.ac.uk>
+# 
+
+# **************************************************************************/
+
+# /***************************************************************************
+# Copyright (c) 2019-2020, Saif Sidhik
+ 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#     http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# **************************************************************************/
+
+"""
+ @info: 
+       Reader for the binary robot state recordings written by the state recorder of
+       CustomFrankaStateController (franka_interface/state_recorder.h). The file is
+       memory-mapped, so columns of long recordings are only read when they are used.
+
+       Enable the recorder with the /robot_config/state_recorder parameters.
+
+       File layout (little-endian, all blocks 8-byte aligned):
+         header (64 bytes): magic 'FRANKREC', uint32 version, column_count, chunk_samples,
+                            flight, float64 start_time, 32 reserved bytes
+         column_count column headers (48 bytes): char name[40], uint32 width, uint32 reserved
+         chunks: 'CHNK', uint32 sample_count, uint64 first_sample, followed for every
+                 column by sample_count * width float64 values
+
+"""
+
+import struct
+
+import numpy as np
+
+_MAGIC = b'FRANKREC'
+_VERSION = 1
+_HEADER = struct.Struct('<8sIIIId32x')
+_COLUMN = struct.Struct('<40sII')
+_CHUNK = struct.Struct('<4sIQ')
+_CHUNK_TAG = b'CHNK'
+
+
+class StateRecording(object):
+    """
+    Memory-maps a recording written by the state recorder.
+
+        >>> recording = StateRecording('/tmp/flight_20200101_120000_000.bin')
+        >>> q = recording['q']            # (N, 7) array
+        >>> t = recording['ros_time']     # (N,) array
+
+    Error columns (current_errors, last_motion_errors) hold the bit masks of
+    franka_core_msgs/RobotStateErrors; gaps in the 'sequence' column are samples that
+    the recorder had to drop. A last chunk that was only partially written (e.g. because
+    the driver crashed) is ignored.
+
+    :param path: recording file
+    :type path: str
+    """
+
+    def __init__(self, path):
+
+        self._data = np.memmap(path, dtype=np.uint8, mode='r')
+
+        (magic, version, column_count, self.chunk_samples, flight,
+         self.start_time) = _HEADER.unpack_from(self._data, 0)
+        if magic != _MAGIC:
+            raise ValueError("%s is not a robot state recording" % path)
+        if version != _VERSION:
+            raise ValueError("Unsupported recording version %d" % version)
+        self.flight = bool(flight)
+
+        self.columns = []
+        offset = _HEADER.size
+        for _ in range(column_count):
+            name, width, _ = _COLUMN.unpack_from(self._data, offset)
+            self.columns.append((name.split(b'\0', 1)[0].decode(), width))
+            offset += _COLUMN.size
+        self._widths = dict(self.columns)
+        self._sample_width = sum(width for _, width in self.columns)
+
+        # (data offset, sample count) of every complete chunk
+        self._chunks = []
+        while offset + _CHUNK.size <= len(self._data):
+            tag, count, _ = _CHUNK.unpack_from(self._data, offset)
+            end = offset + _CHUNK.size + count * self._sample_width * 8
+            if tag != _CHUNK_TAG or end > len(self._data):
+                break
+            self._chunks.append((offset + _CHUNK.size, count))
+            offset = end
+
+        self._cache = {}
+
+    def __len__(self):
+        return sum(count for _, count in self._chunks)
+
+    def __contains__(self, name):
+        return name in self._widths
+
+    def __getitem__(self, name):
+        """
+        :return: all samples of a column, shape (N,) for scalars and (N, width) otherwise
+        :rtype: np.ndarray
+        """
+        if name not in self._cache:
+            parts = [chunk[name] for chunk in self.chunks()]
+            width = self._widths[name]
+            if parts:
+                self._cache[name] = np.concatenate(parts)
+            else:
+                self._cache[name] = np.empty((0,) if width == 1 else (0, width))
+        return self._cache[name]
+
+    def names(self):
+        """
+        :return: column names in file order
+        :rtype: [str]
+        """
+        return [name for name, _ in self.columns]
+
+    def chunks(self):
+        """
+        Iterates over the chunks without copying.
+
+        :return: generator of dicts mapping column names to read-only views into the file
+        :rtype: generator
+        """
+        for offset, count in self._chunks:
+            chunk = {}
+            for name, width in self.columns:
+                values = np.ndarray((count, width), dtype='<f8', buffer=self._data,
+                                    offset=offset)
+                chunk[name] = values[:, 0] if width == 1 else values
+                offset += count * width * 8
+            yield chunk
+
+    def load(self):
+        """
+        :return: all columns as arrays
+        :rtype: dict
+        """
+        return dict((name, self[name]) for name in self.names())
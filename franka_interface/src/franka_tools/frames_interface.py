@@ -84,8 +84,11 @@ class FrankaFramesInterface(object):
     def _assert_frame_validity(self, frame):
 
         if isinstance(frame, np.ndarray):
-            if frame.shape[0] == frame.shape[1] == 4:
+            if frame.shape == (4, 4):
                 frame = frame.flatten('F').tolist()
+            elif frame.shape == (16,):
+                # flattened column major, e.g. from the robot state
+                frame = frame.tolist()
             else:
                 raise ValueError("Invalid shape for transformation matrix numpy array")
         else:
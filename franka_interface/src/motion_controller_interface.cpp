@@ -28,6 +28,7 @@
 
 #include <franka_interface/motion_controller_interface.h>
 #include <controller_manager_msgs/SwitchController.h>
+#include <franka_ros_controllers/command_queue.h>
 
 namespace franka_interface {
 
@@ -99,167 +100,308 @@ void MotionControllerInterface::init(ros::NodeHandle& nh,
   controller_name_to_mode_map_[joint_impedance_controller_name_] = -1;
   controller_name_to_mode_map_[trajectory_controller_name_] = -1;
 
+  current_mode_ = controller_name_to_mode_map_[current_controller_name_];
+
+  mode_to_controller_name_map_[franka_core_msgs::JointCommand::POSITION_MODE] = position_controller_name_;
+  mode_to_controller_name_map_[franka_core_msgs::JointCommand::IMPEDANCE_MODE] = impedance_controller_name_;
+  mode_to_controller_name_map_[franka_core_msgs::JointCommand::TORQUE_MODE] = torque_controller_name_;
+  mode_to_controller_name_map_[franka_core_msgs::JointCommand::VELOCITY_MODE] = velocity_controller_name_;
+
+  stop_candidates_.clear();
+  for (size_t i = 0; i < all_controllers_.size(); ++i) {
+    std::vector<std::string>& stop = stop_candidates_[all_controllers_[i]];
+    for (size_t j = 0; j < all_controllers_.size(); ++j) {
+      if (all_controllers_[j] != all_controllers_[i])
+        stop.push_back(all_controllers_[j]);
+    }
+  }
+  start_list_.reserve(1);
+  stop_list_.reserve(all_controllers_.size());
+  requested_controller_name_ = current_controller_name_;
+
+  nh.param<bool>("/controllers_config/warm_standby", warm_standby_, false);
+
+  bool contact_events_enabled;
+  std::string contact_reaction;
+  nh.param<bool>("/robot_config/contact_events/enabled", contact_events_enabled, true);
+  nh.param<std::string>("/robot_config/contact_events/reaction", contact_reaction, "none");
+  contact_controller_name_.clear();
+  if (contact_reaction == "hold") {
+    contact_controller_name_ = position_controller_name_;
+  } else if (contact_reaction == "switch") {
+    nh.param<std::string>("/robot_config/contact_events/reaction_controller",
+                          contact_controller_name_, position_controller_name_);
+  } else if (contact_reaction != "none") {
+    ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Unknown contact_events/reaction "
+                            << contact_reaction << ". Valid reactions are none, hold and switch.");
+  }
+  if (!contact_controller_name_.empty() && !contact_events_enabled) {
+    ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "contact_events/reaction "
+                            << contact_reaction << " needs contact_events/enabled");
+    contact_controller_name_.clear();
+  }
+  if (!contact_controller_name_.empty() &&
+      stop_candidates_.find(contact_controller_name_) == stop_candidates_.end()) {
+    ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Contact reaction controller "
+                            << contact_controller_name_
+                            << " is not managed by the motion controller interface");
+    contact_controller_name_.clear();
+  }
+
   if (! default_defined){
     ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Default controller not present in the provided controllers!");
   }
 
   controller_manager_ = controller_manager;
-  joint_command_sub_ = nh.subscribe("/franka_ros_interface/motion_controller/arm/joint_commands", 1,
+  joint_command_sub_ = franka_ros_controllers::commandNodeHandle(nh).subscribe("/franka_ros_interface/motion_controller/arm/joint_commands", 1,
                        &MotionControllerInterface::jointCommandCallback, this);
+  joint_command_batch_sub_ = franka_ros_controllers::commandNodeHandle(nh).subscribe(
+                       "/franka_ros_interface/motion_controller/arm/joint_command_batch", 1,
+                       &MotionControllerInterface::jointCommandBatchCallback, this);
 
   // Command Timeout
   joint_command_timeout_sub_ = nh.subscribe("/franka_ros_interface/motion_controller/arm/joint_command_timeout", 1,
                        &MotionControllerInterface::jointCommandTimeoutCallback, this);
   double command_timeout_default;
   nh.param<double>("/controllers_config/command_timeout", command_timeout_default, 0.2);
-  auto p_cmd_timeout_length = std::make_shared<ros::Duration>(std::min(1.0,
-                                std::max(0.0, command_timeout_default)));
-  box_timeout_length_.set(p_cmd_timeout_length);
+  command_timeout_ns_.store(
+      ros::Duration(std::min(1.0, std::max(0.0, command_timeout_default))).toNSec());
+  last_command_time_ns_.store(0);
+  requested_mode_.store(current_mode_);
+
+  // The watchdog granularity is 1 / rate; at most the control rate makes sense.
+  double command_timeout_check_rate;
+  nh.param<double>("/controllers_config/command_timeout_check_rate", command_timeout_check_rate, 100.0);
+  command_timeout_check_rate = std::min(1000.0, std::max(1.0, command_timeout_check_rate));
 
   ROS_INFO_STREAM("MotionControllerInterface Initialised");
 
-  // Update at 100Hz
-  cmd_timeout_timer_ = nh.createTimer(100, &MotionControllerInterface::commandTimeoutCheck, this);
+  switch_thread_ = std::thread(&MotionControllerInterface::switchLoop, this);
+  if (!contact_controller_name_.empty()) {
+    std::string arm_id;
+    nh.param<std::string>("/robot_config/arm_id", arm_id, "panda");
+    ROS_INFO_STREAM("MotionControllerInterface: Switching to " << contact_controller_name_
+                    << " on contact");
+    contact_thread_ = std::thread(&MotionControllerInterface::contactLoop, this,
+                                  &franka_ros_controllers::ContactSignal::forArm(arm_id));
+  }
+
+  cmd_timeout_timer_ = nh.createTimer(ros::Rate(command_timeout_check_rate),
+                                      &MotionControllerInterface::commandTimeoutCheck, this);
+}
+
+MotionControllerInterface::~MotionControllerInterface() {
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    shutdown_ = true;
+  }
+  switch_cv_.notify_all();
+  if (switch_thread_.joinable()) {
+    switch_thread_.join();
+  }
+  if (contact_thread_.joinable()) {
+    contact_thread_.join();
+  }
 }
 
 void MotionControllerInterface::commandTimeoutCheck(const ros::TimerEvent& e) {
-  // lock out other thread(s) which are getting called back via ros.
-  std::lock_guard<std::mutex> guard(mtx_);
   // Check Command Timeout
-  std::shared_ptr<const ros::Duration>  p_timeout_length;
-  box_timeout_length_.get(p_timeout_length);
-  std::shared_ptr<const ros::Time>  p_cmd_msg_time;
-  box_cmd_timeout_.get(p_cmd_msg_time);
-  bool command_timeout = (p_cmd_msg_time && p_timeout_length &&
-      ((ros::Time::now() - *p_cmd_msg_time.get()) > (*p_timeout_length.get())));
-  if(command_timeout && (current_controller_name_ != default_controller_name_)) {
+  int64_t last_command_ns = last_command_time_ns_.load(std::memory_order_acquire);
+  if (last_command_ns == 0) {
+    return;
+  }
+  const int64_t elapsed_ns = static_cast<int64_t>(ros::Time::now().toNSec()) - last_command_ns;
+  if (elapsed_ns <= command_timeout_ns_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // Disarm until the next command, so that a timeout is handled once. Fails if a command
+  // arrived since the stamp was read, which then counts as in time.
+  if (!last_command_time_ns_.compare_exchange_strong(last_command_ns, 0,
+                                                     std::memory_order_acq_rel)) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mtx_);
+  if (requested_controller_name_ != default_controller_name_) {
     // Timeout violated, force robot back to Default Controller Mode
-
     ROS_WARN_STREAM("MotionControllerInterface: Command timeout violated: Switching to Default control mode." << default_controller_name_);
     switchToDefaultController();
   }
 }
 
 bool MotionControllerInterface::switchToDefaultController() {
-
-  std::vector<std::string> start_controllers; 
-  std::vector<std::string> stop_controllers;
-
-  for (size_t i = 0; i < all_controllers_.size(); ++i) {
-
-    if (all_controllers_[i] == default_controller_name_)
-      start_controllers.push_back(all_controllers_[i]);
-    else stop_controllers.push_back(all_controllers_[i]);
-  }
-  if (!controller_manager_->switchController(start_controllers, stop_controllers,
-                              controller_manager_msgs::SwitchController::Request::BEST_EFFORT))
-    {
-      ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Failed to switch controllers");
-      return false;
-    }
-    current_controller_name_ = start_controllers[0];
-    current_mode_ = controller_name_to_mode_map_[current_controller_name_];
-    ROS_INFO_STREAM("MotionControllerInterface: Controller " << start_controllers[0]
-                            << " started; Controllers " << stop_controllers[0] <<
-                            ", " << stop_controllers[1] <<
-                            ", " << stop_controllers[2] <<
-                            ", " << stop_controllers[3] <<
-                            ", " << stop_controllers[4] <<
-                            ", " << stop_controllers[5] << " stopped.");
+  requestController(default_controller_name_);
   return true;
 }
 
 
 void MotionControllerInterface::jointCommandTimeoutCallback(const std_msgs::Float64 msg) {
   ROS_INFO_STREAM("MotionControllerInterface: Joint command timeout: " << msg.data);
-  auto p_cmd_timeout_length = std::make_shared<ros::Duration>(
-                                std::min(1.0, std::max(0.0, double(msg.data))));
-  box_timeout_length_.set(p_cmd_timeout_length);
+  command_timeout_ns_.store(ros::Duration(std::min(1.0, std::max(0.0, double(msg.data)))).toNSec());
 }
 
 bool MotionControllerInterface::switchControllers(int control_mode) {
-  std::vector<std::string> start_controllers;
-  std::vector<std::string> stop_controllers;
+  std::map<int, std::string>::const_iterator it = mode_to_controller_name_map_.find(control_mode);
+  if (it == mode_to_controller_name_map_.end()) {
+    ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Unknown JointCommand mode "
+                            << control_mode << ". Ignoring command.");
+    return false;
+  }
+  requestController(it->second);
+  return true;
+}
 
-  if(current_mode_ != control_mode)
-  {
-    switch (control_mode)
-    {
-      case franka_core_msgs::JointCommand::POSITION_MODE:
-        start_controllers.push_back(position_controller_name_);
-        stop_controllers.push_back(impedance_controller_name_);
-        stop_controllers.push_back(torque_controller_name_);
-        stop_controllers.push_back(velocity_controller_name_);
-        stop_controllers.push_back(trajectory_controller_name_);
-        stop_controllers.push_back(force_controller_name_);
-        stop_controllers.push_back(ntorque_controller_name_);
-        stop_controllers.push_back(cartesian_impedance_controller_name_);
-        stop_controllers.push_back(joint_impedance_controller_name_);
-        break;
-      case franka_core_msgs::JointCommand::IMPEDANCE_MODE:
-        start_controllers.push_back(impedance_controller_name_);
-        stop_controllers.push_back(position_controller_name_);
-        stop_controllers.push_back(torque_controller_name_);
-        stop_controllers.push_back(velocity_controller_name_);
-        stop_controllers.push_back(trajectory_controller_name_);
-        stop_controllers.push_back(force_controller_name_);
-        stop_controllers.push_back(ntorque_controller_name_);
-        stop_controllers.push_back(cartesian_impedance_controller_name_);
-        stop_controllers.push_back(joint_impedance_controller_name_);
-        break;
-      case franka_core_msgs::JointCommand::TORQUE_MODE:
-        start_controllers.push_back(torque_controller_name_);
-        stop_controllers.push_back(position_controller_name_);
-        stop_controllers.push_back(impedance_controller_name_);
-        stop_controllers.push_back(velocity_controller_name_);
-        stop_controllers.push_back(trajectory_controller_name_);
-        stop_controllers.push_back(force_controller_name_);
-        stop_controllers.push_back(ntorque_controller_name_);
-        stop_controllers.push_back(cartesian_impedance_controller_name_);
-        stop_controllers.push_back(joint_impedance_controller_name_);
-        break;
-      case franka_core_msgs::JointCommand::VELOCITY_MODE:
-        start_controllers.push_back(velocity_controller_name_);
-        stop_controllers.push_back(position_controller_name_);
-        stop_controllers.push_back(impedance_controller_name_);
-        stop_controllers.push_back(torque_controller_name_);
-        stop_controllers.push_back(trajectory_controller_name_);
-        stop_controllers.push_back(force_controller_name_);
-        stop_controllers.push_back(ntorque_controller_name_);
-        stop_controllers.push_back(cartesian_impedance_controller_name_);
-        stop_controllers.push_back(joint_impedance_controller_name_);
-        break;        
-      default:
-        ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Unknown JointCommand mode "
-                                << control_mode << ". Ignoring command.");
-        return false;
+void MotionControllerInterface::requestController(const std::string& controller_name,
+                                                  bool force) {
+  if (!force && controller_name == requested_controller_name_) {
+    return;
+  }
+  if (contact_hold_ && controller_name != contact_controller_name_) {
+    ROS_WARN_STREAM_THROTTLE_NAMED(1.0, "MotionControllerInterface", "Not switching to "
+                                   << controller_name << " while the arm is in contact");
+    return;
+  }
+  requested_controller_name_ = controller_name;
+  requested_mode_.store(controller_name_to_mode_map_[controller_name]);
+  pending_controller_name_ = controller_name;
+  switch_cv_.notify_one();
+}
+
+void MotionControllerInterface::switchLoop() {
+  if (warm_standby_) {
+    loadStandbyControllers();
+  }
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (!shutdown_) {
+    switch_cv_.wait(lock, [this] { return shutdown_ || !pending_controller_name_.empty(); });
+    if (shutdown_) {
+      break;
     }
-    if (!controller_manager_->switchController(start_controllers, stop_controllers,
-                              controller_manager_msgs::SwitchController::Request::BEST_EFFORT))
-    {
-      ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Failed to switch controllers");
-      return false;
+    std::string controller_name;
+    controller_name.swap(pending_controller_name_);
+
+    lock.unlock();
+    bool switched = switchToController(controller_name);
+    lock.lock();
+
+    if (switched) {
+      current_controller_name_ = controller_name;
+      current_mode_ = controller_name_to_mode_map_[controller_name];
+    } else if (pending_controller_name_.empty()) {
+      // let the next command for this mode try again
+      requested_controller_name_ = current_controller_name_;
+      requested_mode_.store(current_mode_);
     }
-    current_mode_ = control_mode;
-    current_controller_name_ = start_controllers[0];
-    ROS_INFO_STREAM("MotionControllerInterface: Controller " << start_controllers[0]
-                            << " started; Controllers " << stop_controllers[0] <<
-                            ", " << stop_controllers[1] <<
-                            ", " << stop_controllers[2] <<
-                            ", " << stop_controllers[3] <<
-                            ", " << stop_controllers[4] <<
-                            ", " << stop_controllers[5] << " stopped.");
   }
+}
+
+void MotionControllerInterface::contactLoop(franka_ros_controllers::ContactSignal* signal) {
+  uint64_t handled_onsets = 0;
+  while (true) {
+    uint8_t sources = 0;
+    uint64_t onsets = 0;
+    // the timeout only bounds how long shutdown waits for this thread
+    bool changed = signal->wait(0.1, sources, onsets);
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (shutdown_) {
+      break;
+    }
+    if (!changed) {
+      continue;
+    }
+    // every onset is handled, even a contact that cleared again before this thread woke up
+    if (onsets != handled_onsets) {
+      handled_onsets = onsets;
+      contact_hold_ = true;
+      ROS_WARN_STREAM("MotionControllerInterface: Contact detected (sources " << int(sources)
+                      << "): Switching to " << contact_controller_name_);
+      // The reaction must not depend on what was requested last: the held controller may have
+      // been stopped through the controller manager since.
+      requestController(contact_controller_name_, true);
+    }
+    if (sources == 0 && contact_hold_) {
+      contact_hold_ = false;
+      ROS_INFO_STREAM("MotionControllerInterface: Contact cleared");
+    }
+  }
+}
+
+bool MotionControllerInterface::switchToController(const std::string& controller_name) {
+  std::map<std::string, std::vector<std::string> >::const_iterator plan =
+      stop_candidates_.find(controller_name);
+  if (plan == stop_candidates_.end()) {
+    ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Controller " << controller_name
+                            << " is not managed by the motion controller interface");
+    return false;
+  }
+  controller_interface::ControllerBase* target = controller_manager_->getControllerByName(controller_name);
+  if (!target) {
+    ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Controller " << controller_name
+                            << " is not loaded");
+    return false;
+  }
+
+  start_list_.clear();
+  stop_list_.clear();
+  if (!target->isRunning())
+    start_list_.push_back(controller_name);
+  for (size_t i = 0; i < plan->second.size(); ++i) {
+    controller_interface::ControllerBase* controller =
+        controller_manager_->getControllerByName(plan->second[i]);
+    if (controller && controller->isRunning())
+      stop_list_.push_back(plan->second[i]);
+  }
+  if (start_list_.empty() && stop_list_.empty())
+    return true;
+
+  ros::WallTime start_time = ros::WallTime::now();
+  if (!controller_manager_->switchController(start_list_, stop_list_,
+                              controller_manager_msgs::SwitchController::Request::BEST_EFFORT))
+  {
+    ROS_ERROR_STREAM_NAMED("MotionControllerInterface", "Failed to switch controllers");
+    return false;
+  }
+
+  std::string stopped;
+  for (size_t i = 0; i < stop_list_.size(); ++i)
+    stopped += (i == 0 ? "" : ", ") + stop_list_[i];
+  ROS_INFO_STREAM("MotionControllerInterface: Controller " << controller_name << " started"
+                  << (stopped.empty() ? "" : "; Controllers " + stopped + " stopped")
+                  << " (" << (ros::WallTime::now() - start_time).toSec() * 1000.0 << " ms).");
   return true;
 }
 
+void MotionControllerInterface::loadStandbyControllers() {
+  for (size_t i = 0; i < all_controllers_.size(); ++i) {
+    if (controller_manager_->getControllerByName(all_controllers_[i]))
+      continue;
+    if (!controller_manager_->loadController(all_controllers_[i]))
+      ROS_WARN_STREAM_NAMED("MotionControllerInterface", "Could not load " << all_controllers_[i]
+                            << " for warm standby; it has to be loaded before switching to it");
+  }
+}
+
 void MotionControllerInterface::jointCommandCallback(const franka_core_msgs::JointCommandConstPtr& msg) {
-  // lock out other thread(s) which are getting called back via ros.
-  std::lock_guard<std::mutex> guard(mtx_);
-  if(switchControllers(msg->mode)) {
-    auto p_cmd_msg_time = std::make_shared<ros::Time>(ros::Time::now());
-    box_cmd_timeout_.set(p_cmd_msg_time);
+  handleCommand(msg->mode);
+}
+
+void MotionControllerInterface::jointCommandBatchCallback(
+    const franka_core_msgs::JointCommandBatchConstPtr& msg) {
+  handleCommand(msg->mode);
+}
+
+void MotionControllerInterface::handleCommand(int control_mode) {
+  // Common case: the mode is already the requested one, so only the watchdog is fed.
+  // The lock is taken only to request a different controller.
+  if (control_mode != requested_mode_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (!switchControllers(control_mode)) {
+      return;
+    }
   }
+  // also (re-)arms the watchdog
+  last_command_time_ns_.store(static_cast<int64_t>(ros::Time::now().toNSec()),
+                              std::memory_order_release);
 }
 
 }
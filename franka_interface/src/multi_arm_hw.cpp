@@ -0,0 +1,129 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_interface/multi_arm_hw.h>
+
+namespace franka_interface {
+
+void MultiArmHW::addArm(franka_hw::FrankaHW* hw, const std::string& arm_id,
+                        const std::array<std::string, 7>& joint_names) {
+  Arm arm;
+  arm.hw = hw;
+  arm.resources.insert(joint_names.begin(), joint_names.end());
+  arm.resources.insert(arm_id + "_robot");
+  arms_.push_back(arm);
+  registerInterfaceManager(hw);
+}
+
+void MultiArmHW::setControllerManager(controller_manager::ControllerManager* manager) {
+  manager_ = manager;
+}
+
+void MultiArmHW::restartControllers(size_t arm, const ros::Time& time) {
+  for (const auto& controller : arms_[arm].running) {
+    if (controller.second->isRunning()) {
+      controller.second->stopRequest(time);
+      controller.second->startRequest(time);
+    }
+  }
+}
+
+bool MultiArmHW::checkForConflict(
+    const std::list<hardware_interface::ControllerInfo>& info) const {
+  for (const Arm& arm : arms_) {
+    if (arm.hw->checkForConflict(filter(info, arm))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MultiArmHW::prepareSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                               const std::list<hardware_interface::ControllerInfo>& stop_list) {
+  for (Arm& arm : arms_) {
+    const auto arm_start_list = filter(start_list, arm);
+    const auto arm_stop_list = filter(stop_list, arm);
+    // Called by ControllerManager::switchController() with the controller lock held, so the
+    // lookup is safe here; doSwitch() runs in the control loop, which must not take that lock.
+    arm.starting.clear();
+    if (manager_ != nullptr) {
+      for (const hardware_interface::ControllerInfo& info : arm_start_list) {
+        arm.starting[info.name] = manager_->getControllerByName(info.name);
+      }
+    }
+    // an arm not involved in the switch keeps running its motion undisturbed
+    if ((!arm_start_list.empty() || !arm_stop_list.empty()) &&
+        !arm.hw->prepareSwitch(arm_start_list, arm_stop_list)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MultiArmHW::doSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                          const std::list<hardware_interface::ControllerInfo>& stop_list) {
+  for (Arm& arm : arms_) {
+    const auto arm_start_list = filter(start_list, arm);
+    const auto arm_stop_list = filter(stop_list, arm);
+    if (!arm_start_list.empty() || !arm_stop_list.empty()) {
+      arm.hw->doSwitch(arm_start_list, arm_stop_list);
+    }
+    for (const hardware_interface::ControllerInfo& info : arm_stop_list) {
+      arm.running.erase(info.name);
+    }
+    for (const auto& controller : arm.starting) {
+      if (controller.second != nullptr) {
+        arm.running[controller.first] = controller.second;
+      }
+    }
+    arm.starting.clear();
+  }
+}
+
+std::list<hardware_interface::ControllerInfo> MultiArmHW::filter(
+    const std::list<hardware_interface::ControllerInfo>& list, const Arm& arm) {
+  std::list<hardware_interface::ControllerInfo> filtered;
+  for (const hardware_interface::ControllerInfo& info : list) {
+    hardware_interface::ControllerInfo arm_info = info;
+    arm_info.claimed_resources.clear();
+    for (const hardware_interface::InterfaceResources& claimed : info.claimed_resources) {
+      hardware_interface::InterfaceResources arm_claimed(claimed.hardware_interface, {});
+      for (const std::string& resource : claimed.resources) {
+        if (arm.resources.count(resource) != 0) {
+          arm_claimed.resources.insert(resource);
+        }
+      }
+      if (!arm_claimed.resources.empty()) {
+        arm_info.claimed_resources.push_back(arm_claimed);
+      }
+    }
+    if (!arm_info.claimed_resources.empty()) {
+      filtered.push_back(arm_info);
+    }
+  }
+  return filtered;
+}
+
+}  // namespace franka_interface
@@ -0,0 +1,71 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_interface/multi_arm_scheduler.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace franka_interface {
+
+MultiArmScheduler::MultiArmScheduler(size_t arm_count, Update update,
+                                     std::chrono::microseconds sync_timeout)
+    : arm_count_(arm_count),
+      update_(std::move(update)),
+      sync_timeout_(sync_timeout),
+      cycle_(0),
+      arrived_(0),
+      period_(0.0),
+      starting_(arm_count, false) {}
+
+bool MultiArmScheduler::tick(size_t arm, const ros::Duration& period, bool start_motion) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  period_ = std::max(period_, period);
+  starting_[arm] = starting_[arm] || start_motion;
+  if (++arrived_ == arm_count_) {
+    completeCycle();
+    return true;
+  }
+
+  const uint64_t cycle = cycle_;
+  if (cycle_done_.wait_for(lock, sync_timeout_, [&] { return cycle_ != cycle; })) {
+    return true;
+  }
+  // Leave the cycle without running the update: the missing arms may be touching their state.
+  // A motion start stays recorded for the cycle that does complete.
+  --arrived_;
+  return false;
+}
+
+void MultiArmScheduler::completeCycle() {
+  update_(ros::Time::now(), period_, starting_);
+  ++cycle_;
+  arrived_ = 0;
+  period_ = ros::Duration(0.0);
+  std::fill(starting_.begin(), starting_.end(), false);
+  cycle_done_.notify_all();
+}
+
+}  // namespace franka_interface
@@ -0,0 +1,143 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#include <franka_interface/realtime_config.h>
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace franka_interface {
+
+bool RealtimeConfig::load(ros::NodeHandle& nh) {
+  nh.param<std::vector<int>>("/robot_config/realtime/control_cpus", control_cpus, control_cpus);
+  nh.param<std::vector<int>>("/robot_config/realtime/non_realtime_cpus", non_realtime_cpus,
+                             non_realtime_cpus);
+  nh.param<bool>("/robot_config/realtime/lock_memory", lock_memory, lock_memory);
+  nh.param<int>("/robot_config/realtime/prefault_stack_size", prefault_stack_size,
+                prefault_stack_size);
+  nh.param<int>("/robot_config/realtime/spinner_threads", spinner_threads, spinner_threads);
+  nh.param<bool>("/robot_config/realtime/command_queue/enabled", command_queue, command_queue);
+  nh.param<int>("/robot_config/realtime/command_queue/threads", command_spinner_threads,
+                command_spinner_threads);
+  nh.param<int>("/robot_config/realtime/command_queue/priority", command_spinner_priority,
+                command_spinner_priority);
+  nh.param<std::vector<int>>("/robot_config/realtime/command_queue/cpus", command_spinner_cpus,
+                             command_spinner_cpus);
+  if (non_realtime_cpus.empty()) {
+    // keep whatever the process was started with (e.g. by taskset), but as an explicit list so
+    // that it can be restored after configuring the command spinner
+    cpu_set_t cpu_set;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpu_set)) {
+          non_realtime_cpus.push_back(cpu);
+        }
+      }
+    }
+  }
+  if (command_spinner_cpus.empty()) {
+    command_spinner_cpus = non_realtime_cpus;
+  }
+
+  if (spinner_threads < 1 || command_spinner_threads < 1 || prefault_stack_size < 0) {
+    ROS_ERROR("RealtimeConfig: spinner thread counts must be positive and prefault_stack_size "
+              "must not be negative");
+    return false;
+  }
+  const int max_priority = sched_get_priority_max(SCHED_FIFO);
+  if (command_spinner_priority < 0 || command_spinner_priority >= max_priority) {
+    // libfranka runs the control loop at the maximum priority
+    ROS_ERROR("RealtimeConfig: command_queue/priority must be in [0, %d)", max_priority);
+    return false;
+  }
+  const long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+  for (const std::vector<int>* cpus : {&control_cpus, &non_realtime_cpus, &command_spinner_cpus}) {
+    for (int cpu : *cpus) {
+      if (cpu < 0 || cpu >= cpu_count || cpu >= CPU_SETSIZE) {
+        ROS_ERROR("RealtimeConfig: CPU %d does not exist", cpu);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool setCurrentThreadAffinity(const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return true;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (error != 0) {
+    ROS_WARN("Could not set CPU affinity: %s", std::strerror(error));
+    return false;
+  }
+  return true;
+}
+
+bool setCurrentThreadPriority(int priority) {
+  sched_param param{};
+  param.sched_priority = priority;
+  const int error =
+      pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+  if (error != 0) {
+    ROS_WARN("Could not set thread priority %d: %s", priority, std::strerror(error));
+    return false;
+  }
+  return true;
+}
+
+bool lockProcessMemory() {
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    ROS_WARN("Could not lock memory (mlockall): %s. Check the memlock limit of the user.",
+             std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void prefaultStack(size_t bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(bytes));
+  const long page_size = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < bytes; i += static_cast<size_t>(page_size)) {
+    stack[i] = 0;
+  }
+}
+
+}  // namespace franka_interface
@@ -28,14 +28,17 @@
 
 #include <franka_interface/robot_state_controller.h>
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <tuple>
 
 #include <franka/errors.h>
 #include <franka_hw/franka_cartesian_command_interface.h>
 #include <franka_msgs/Errors.h>
+#include <franka_ros_controllers/arm_config.h>
 #include <hardware_interface/hardware_interface.h>
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
@@ -44,6 +47,8 @@
 
 namespace {
 
+constexpr size_t kJointCount = std::tuple_size<decltype(franka::RobotState::q)>::value;
+
 tf::Transform convertArrayToTf(const std::array<double, 16>& transform) {
   tf::Matrix3x3 rotation(transform[0], transform[4], transform[8], transform[1], transform[5],
                          transform[9], transform[2], transform[6], transform[10]);
@@ -51,6 +56,11 @@ tf::Transform convertArrayToTf(const std::array<double, 16>& transform) {
   return tf::Transform(rotation, translation);
 }
 
+void convertArrayToTransformMsg(const std::array<double, 16>& transform,
+                                geometry_msgs::Transform& message) {
+  tf::transformTFToMsg(convertArrayToTf(transform), message);
+}
+
 franka_msgs::Errors errorsToMessage(const franka::Errors& error) {
   franka_msgs::Errors message;
   message.joint_position_limits_violation =
@@ -157,6 +167,73 @@ franka_msgs::Errors errorsToMessage(const franka::Errors& error) {
   return message;
 }
 
+// Packs the errors into a bit mask, bit i being the i-th field of franka_msgs/Errors.
+uint64_t errorsToBits(const franka::Errors& error) {
+  const bool flags[] = {
+      error.joint_position_limits_violation,
+      error.cartesian_position_limits_violation,
+      error.self_collision_avoidance_violation,
+      error.joint_velocity_violation,
+      error.cartesian_velocity_violation,
+      error.force_control_safety_violation,
+      error.joint_reflex,
+      error.cartesian_reflex,
+      error.max_goal_pose_deviation_violation,
+      error.max_path_pose_deviation_violation,
+      error.cartesian_velocity_profile_safety_violation,
+      error.joint_position_motion_generator_start_pose_invalid,
+      error.joint_motion_generator_position_limits_violation,
+      error.joint_motion_generator_velocity_limits_violation,
+      error.joint_motion_generator_velocity_discontinuity,
+      error.joint_motion_generator_acceleration_discontinuity,
+      error.cartesian_position_motion_generator_start_pose_invalid,
+      error.cartesian_motion_generator_elbow_limit_violation,
+      error.cartesian_motion_generator_velocity_limits_violation,
+      error.cartesian_motion_generator_velocity_discontinuity,
+      error.cartesian_motion_generator_acceleration_discontinuity,
+      error.cartesian_motion_generator_elbow_sign_inconsistent,
+      error.cartesian_motion_generator_start_elbow_invalid,
+      error.cartesian_motion_generator_joint_position_limits_violation,
+      error.cartesian_motion_generator_joint_velocity_limits_violation,
+      error.cartesian_motion_generator_joint_velocity_discontinuity,
+      error.cartesian_motion_generator_joint_acceleration_discontinuity,
+      error.cartesian_position_motion_generator_invalid_frame,
+      error.force_controller_desired_force_tolerance_violation,
+      error.controller_torque_discontinuity,
+      error.start_elbow_sign_inconsistent,
+      error.communication_constraints_violation,
+      error.power_limit_violation,
+      error.joint_p2p_insufficient_torque_for_planning,
+      error.tau_j_range_violation,
+      error.instability_detected
+  };
+  uint64_t bits = 0;
+  for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i) {
+    bits |= static_cast<uint64_t>(flags[i]) << i;
+  }
+  return bits;
+}
+
+uint8_t robotModeToMessage(franka::RobotMode mode) {
+  switch (mode) {
+    case franka::RobotMode::kIdle:
+      return franka_core_msgs::RobotState::ROBOT_MODE_IDLE;
+    case franka::RobotMode::kMove:
+      return franka_core_msgs::RobotState::ROBOT_MODE_MOVE;
+    case franka::RobotMode::kGuiding:
+      return franka_core_msgs::RobotState::ROBOT_MODE_GUIDING;
+    case franka::RobotMode::kReflex:
+      return franka_core_msgs::RobotState::ROBOT_MODE_REFLEX;
+    case franka::RobotMode::kUserStopped:
+      return franka_core_msgs::RobotState::ROBOT_MODE_USER_STOPPED;
+    case franka::RobotMode::kAutomaticErrorRecovery:
+      return franka_core_msgs::RobotState::ROBOT_MODE_AUTOMATIC_ERROR_RECOVERY;
+    case franka::RobotMode::kOther:
+    default:
+      return franka_core_msgs::RobotState::ROBOT_MODE_OTHER;
+  }
+}
+
 }  // anonymous namespace
 
 namespace franka_interface {
@@ -173,15 +250,35 @@ bool CustomFrankaStateController::init(hardware_interface::RobotHW* robot_hardwa
     ROS_ERROR("CustomFrankaStateController: Could not get parameter arm_id");
     return false;
   }
+  // libfranka runs update() at a fixed rate, so streams are decimated by cycle count
+  double control_rate(1000.0);
+  controller_node_handle.param<double>("control_rate", control_rate, control_rate);
+  if (!(control_rate > 0.0)) {
+    ROS_ERROR("CustomFrankaStateController: Invalid control_rate parameter provided");
+    return false;
+  }
   double publish_rate(500.0);
   if (!controller_node_handle.getParam("publish_rate", publish_rate)) {
     ROS_INFO_STREAM("CustomFrankaStateController: Did not find publish_rate. Using default "
                     << publish_rate << " [Hz].");
   }
-  trigger_publish_ = franka_hw::TriggerRate(publish_rate);
+  // Per-stream rates; streams without an entry in publish_rates use publish_rate.
+  auto stream_rate = [&](const std::string& stream) {
+    double rate = publish_rate;
+    controller_node_handle.param<double>("publish_rates/" + stream, rate, publish_rate);
+    uint32_t decimation =
+        rate <= 0.0 ? 0 : static_cast<uint32_t>(std::max(1.0, std::round(control_rate / rate)));
+    ROS_INFO_STREAM("CustomFrankaStateController: Publishing " << stream << " at "
+                    << (decimation == 0 ? 0.0 : control_rate / decimation) << " [Hz].");
+    return decimation;
+  };
+  franka_state_stream_.decimation = stream_rate("robot_state");
+  franka_state_compact_stream_.decimation = stream_rate("robot_state_compact");
+  joint_states_stream_.decimation = stream_rate("joint_states");
+  tip_state_stream_.decimation = stream_rate("tip_state");
 
   if (!controller_node_handle.getParam("joint_names", joint_names_) ||
-      joint_names_.size() != robot_state_.q.size()) {
+      joint_names_.size() != kJointCount) {
     ROS_ERROR(
         "CustomFrankaStateController: Invalid or no joint_names parameters provided, aborting "
         "controller init!");
@@ -191,6 +288,7 @@ bool CustomFrankaStateController::init(hardware_interface::RobotHW* robot_hardwa
   try {
     franka_state_handle_ = std::make_unique<franka_hw::FrankaStateHandle>(
         franka_state_interface_->getHandle(arm_id_ + "_robot"));
+    robot_state_ = &franka_state_handle_->getRobotState();
   } catch (const hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM("CustomFrankaStateController: Exception getting franka state handle: " << ex.what());
     return false;
@@ -203,8 +301,7 @@ bool CustomFrankaStateController::init(hardware_interface::RobotHW* robot_hardwa
     return false;
   }
   try {
-    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
-        model_interface->getHandle(arm_id_ + "_model"));
+    model_handle_ = franka_ros_controllers::CachedFrankaModelHandle::acquire(robot_hardware, arm_id_);
   } catch (hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM(
         "CustomFrankaStateController: Exception getting model handle from interface: "
@@ -212,50 +309,130 @@ bool CustomFrankaStateController::init(hardware_interface::RobotHW* robot_hardwa
     return false;
   }
 
-  publisher_transforms_.init(root_node_handle, "/tf", 1);
+  bool shm_enabled = false;
+  root_node_handle.param<bool>("/robot_config/shm_transport/enabled", shm_enabled, false);
+  if (shm_enabled) {
+    std::string shm_name;
+    std::string shm_error;
+    root_node_handle.param<std::string>("/robot_config/shm_transport/name", shm_name,
+                                        "franka_ros_interface");
+    shm_name = franka_ros_controllers::armResourceName(root_node_handle, arm_id_, shm_name);
+    if (!shm_transport_.open(shm_name, true, shm_error)) {
+      ROS_ERROR_STREAM("CustomFrankaStateController: Could not open shared-memory transport: "
+                       << shm_error);
+      return false;
+    }
+    ROS_INFO_STREAM("CustomFrankaStateController: Writing robot state to shared memory /"
+                    << shm_name);
+  }
+
+  std::string recorder_error;
+  if (!state_recorder_.init(controller_node_handle, arm_id_, recorder_error)) {
+    ROS_ERROR_STREAM("CustomFrankaStateController: Could not start the state recorder: "
+                     << recorder_error);
+    return false;
+  }
+
+  std::string contact_error;
+  if (!contact_detector_.init(controller_node_handle, contact_error)) {
+    ROS_ERROR_STREAM("CustomFrankaStateController: Invalid contact_events parameters: "
+                     << contact_error);
+    return false;
+  }
+  if (contact_detector_.isEnabled()) {
+    std::string reaction;
+    root_node_handle.param<std::string>("/robot_config/contact_events/reaction", reaction, "none");
+    if (reaction != "none") {
+      contact_signal_ = &franka_ros_controllers::ContactSignal::forArm(arm_id_);
+    }
+  }
+
   publisher_franka_state_.init(controller_node_handle, "robot_state", 1);
+  publisher_franka_state_compact_.init(controller_node_handle, "robot_state_compact", 1);
+  publisher_errors_.init(controller_node_handle, "robot_errors", 1, true);
+  if (contact_detector_.isEnabled()) {
+    publisher_contact_events_.init(controller_node_handle, "contact_events", 1, true);
+  }
   publisher_joint_states_.init(controller_node_handle, "joint_states", 1);
   publisher_joint_states_desired_.init(controller_node_handle, "joint_states_desired", 1);
   publisher_tip_state_.init(controller_node_handle, "tip_state", 1);
 
+  monitorSubscribers<franka_core_msgs::RobotState>(controller_node_handle, "robot_state",
+                                                   franka_state_stream_);
+  monitorSubscribers<franka_core_msgs::RobotStateCompact>(
+      controller_node_handle, "robot_state_compact", franka_state_compact_stream_);
+  monitorSubscribers<sensor_msgs::JointState>(controller_node_handle, "joint_states",
+                                              joint_states_stream_);
+  monitorSubscribers<sensor_msgs::JointState>(controller_node_handle, "joint_states_desired",
+                                              joint_states_stream_);
+  monitorSubscribers<franka_core_msgs::EndPointState>(controller_node_handle, "tip_state",
+                                                      tip_state_stream_);
+
+  // Joint names, frame IDs and array sizes are fixed here; update() only writes numeric fields,
+  // so the RT thread never constructs, assigns or resizes a string or vector.
   {
     std::lock_guard<realtime_tools::RealtimePublisher<sensor_msgs::JointState> > lock(
         publisher_joint_states_);
-    publisher_joint_states_.msg_.name.resize(joint_names_.size());
-    publisher_joint_states_.msg_.position.resize(robot_state_.q.size());
-    publisher_joint_states_.msg_.velocity.resize(robot_state_.dq.size());
-    publisher_joint_states_.msg_.effort.resize(robot_state_.tau_J.size());
+    publisher_joint_states_.msg_.name = joint_names_;
+    publisher_joint_states_.msg_.position.resize(kJointCount);
+    publisher_joint_states_.msg_.velocity.resize(kJointCount);
+    publisher_joint_states_.msg_.effort.resize(kJointCount);
   }
   {
     std::lock_guard<realtime_tools::RealtimePublisher<sensor_msgs::JointState> > lock(
         publisher_joint_states_desired_);
-    publisher_joint_states_desired_.msg_.name.resize(joint_names_.size());
-    publisher_joint_states_desired_.msg_.position.resize(robot_state_.q_d.size());
-    publisher_joint_states_desired_.msg_.velocity.resize(robot_state_.dq_d.size());
-    publisher_joint_states_desired_.msg_.effort.resize(robot_state_.tau_J_d.size());
+    publisher_joint_states_desired_.msg_.name = joint_names_;
+    publisher_joint_states_desired_.msg_.position.resize(kJointCount);
+    publisher_joint_states_desired_.msg_.velocity.resize(kJointCount);
+    publisher_joint_states_desired_.msg_.effort.resize(kJointCount);
+  }
+  std::vector<std::string> compact_groups{"kinematics", "dynamics", "errors"};
+  controller_node_handle.param("robot_state_compact_groups", compact_groups, compact_groups);
+  for (const std::string& group : compact_groups) {
+    if (group == "kinematics") {
+      compact_groups_ |= franka_core_msgs::RobotStateCompact::GROUP_KINEMATICS;
+    } else if (group == "dynamics") {
+      compact_groups_ |= franka_core_msgs::RobotStateCompact::GROUP_DYNAMICS;
+    } else if (group == "errors") {
+      compact_groups_ |= franka_core_msgs::RobotStateCompact::GROUP_ERRORS;
+    } else {
+      ROS_ERROR_STREAM("CustomFrankaStateController: Unknown robot_state_compact_groups entry "
+                       << group << ". Valid groups are kinematics, dynamics and errors.");
+      return false;
+    }
   }
   {
-    std::lock_guard<realtime_tools::RealtimePublisher<tf2_msgs::TFMessage> > lock(
-        publisher_transforms_);
-    publisher_transforms_.msg_.transforms.resize(2);
-    tf::Quaternion quaternion(0.0, 0.0, 0.0, 1.0);
-    tf::Vector3 translation(0.0, 0.0, 0.05);
-    tf::Transform transform(quaternion, translation);
-    tf::StampedTransform stamped_transform(transform, ros::Time::now(), arm_id_ + "_link8",
-                                           arm_id_ + "_EE");
-    geometry_msgs::TransformStamped transform_message;
-    transformStampedTFToMsg(stamped_transform, transform_message);
-    publisher_transforms_.msg_.transforms[0] = transform_message;
-    translation = tf::Vector3(0.0, 0.0, 0.0);
-    transform = tf::Transform(quaternion, translation);
-    stamped_transform =
-        tf::StampedTransform(transform, ros::Time::now(), arm_id_ + "_EE", arm_id_ + "_K");
-    transformStampedTFToMsg(stamped_transform, transform_message);
-    publisher_transforms_.msg_.transforms[1] = transform_message;
+    // Groups are sent as zero- or one-element arrays; size them here so that publishing
+    // never allocates.
+    std::lock_guard<realtime_tools::RealtimePublisher<franka_core_msgs::RobotStateCompact> >
+        lock(publisher_franka_state_compact_);
+    publisher_franka_state_compact_.msg_.kinematics.resize(
+        (compact_groups_ & franka_core_msgs::RobotStateCompact::GROUP_KINEMATICS) ? 1 : 0);
+    publisher_franka_state_compact_.msg_.dynamics.resize(
+        (compact_groups_ & franka_core_msgs::RobotStateCompact::GROUP_DYNAMICS) ? 1 : 0);
+    publisher_franka_state_compact_.msg_.errors.reserve(1);
+  }
+  {
+    // One latched message for the frames of all arms in this process; it is sent with the
+    // frames of this arm right away, as the state has been read before controllers are loaded.
+    static_transforms_ = &StaticTransformBroadcaster::get(root_node_handle);
+    geometry_msgs::TransformStamped transform;
+    transform.header.stamp = ros::Time::now();
+    transform.header.frame_id = arm_id_ + "_link8";
+    transform.child_frame_id = arm_id_ + "_EE";
+    convertArrayToTransformMsg(robot_state_->F_T_EE, transform.transform);
+    ee_frame_ = static_transforms_->setFrame(transform);
+    transform.header.frame_id = arm_id_ + "_EE";
+    transform.child_frame_id = arm_id_ + "_K";
+    convertArrayToTransformMsg(robot_state_->EE_T_K, transform.transform);
+    k_frame_ = static_transforms_->setFrame(transform);
+    published_F_T_EE_ = robot_state_->F_T_EE;
+    published_EE_T_K_ = robot_state_->EE_T_K;
   }
   {
     std::lock_guard<realtime_tools::RealtimePublisher<franka_core_msgs::EndPointState> > lock(
         publisher_tip_state_);
+    publisher_tip_state_.msg_.header.frame_id = arm_id_ + "_link0";
     publisher_tip_state_.msg_.O_F_ext_hat_K.header.frame_id = arm_id_ + "_link0";
     publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.x = 0.0;
     publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.y = 0.0;
@@ -276,101 +453,160 @@ bool CustomFrankaStateController::init(hardware_interface::RobotHW* robot_hardwa
 }
 
 void CustomFrankaStateController::update(const ros::Time& time, const ros::Duration& /* period */) {
-  if (trigger_publish_()) {
-    robot_state_ = franka_state_handle_->getRobotState();
+  const franka::RobotState& robot_state = franka_state_handle_->getRobotState();
+  if (shm_transport_.isOpen()) {
+    writeSharedMemoryState(robot_state);
+  }
+  uint64_t current_errors = errorsToBits(robot_state.current_errors);
+  uint64_t last_motion_errors = errorsToBits(robot_state.last_motion_errors);
+  if (state_recorder_.isEnabled()) {
+    state_recorder_.record(time, robot_state, robotModeToMessage(robot_state.robot_mode),
+                           current_errors, last_motion_errors);
+  }
+  publishErrorsOnChange(robot_state, current_errors, last_motion_errors);
+  if (contact_detector_.isEnabled()) {
+    publishContactEventOnChange(time, robot_state);
+  }
+  publishTransformsOnChange(time, robot_state);
+  bool publish_franka_state = franka_state_stream_.due();
+  bool publish_compact = franka_state_compact_stream_.due();
+  bool publish_tip_state = tip_state_stream_.due();
+  bool publish_joint_states = joint_states_stream_.due();
+  if (!(publish_franka_state || publish_compact || publish_tip_state || publish_joint_states)) {
+    return;
+  }
+
+  updateModel(publish_franka_state ||
+                  (publish_compact &&
+                   (compact_groups_ & franka_core_msgs::RobotStateCompact::GROUP_KINEMATICS)),
+              publish_franka_state ||
+                  (publish_compact &&
+                   (compact_groups_ & franka_core_msgs::RobotStateCompact::GROUP_DYNAMICS)));
+  if (publish_franka_state) {
     publishFrankaState(time);
-    publishTransforms(time);
+  }
+  if (publish_compact) {
+    publishFrankaStateCompact(time);
+  }
+  if (publish_tip_state) {
     publishEndPointState(time);
+  }
+  if (publish_joint_states) {
     publishJointStates(time);
-    sequence_number_++;
   }
+  sequence_number_++;
 }
 
-void CustomFrankaStateController::publishFrankaState(const ros::Time& time) {
+template <typename Message>
+void CustomFrankaStateController::monitorSubscribers(ros::NodeHandle& node_handle,
+                                                     const std::string& topic,
+                                                     OutputStream& stream) {
+  // Advertising an already advertised topic again shares its publication, so the callbacks
+  // see the subscribers of the realtime publisher without touching it from the RT thread.
+  std::atomic<int>* subscribers = &stream.subscribers;
+  std::atomic<uint64_t>* connections = &stream.connections;
+  stream.monitors.push_back(node_handle.advertise<Message>(
+      topic, 1,
+      [subscribers, connections](const ros::SingleSubscriberPublisher&) {
+        connections->fetch_add(1);
+        subscribers->fetch_add(1);
+      },
+      [subscribers](const ros::SingleSubscriberPublisher&) { subscribers->fetch_sub(1); }));
+}
 
-    std::array<double, 7> coriolis = model_handle_->getCoriolis();
-    std::array<double, 7> gravity = model_handle_->getGravity();
+void CustomFrankaStateController::updateModel(bool kinematics, bool dynamics) {
+  if (kinematics) {
+    O_Jac_EE_ = model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
+    Eigen::Map<const Eigen::Matrix<double, 6, 7>> jacobian(O_Jac_EE_.data());
+    Eigen::Map<const Eigen::Matrix<double, 7, 1>> dq(robot_state_->dq.data());
+    Eigen::Map<Eigen::Matrix<double, 6, 1>>(O_dP_EE_.data()) = jacobian * dq;
+  }
+  if (dynamics) {
+    coriolis_ = model_handle_->getCoriolis();
+    gravity_ = model_handle_->getGravity();
+    mass_matrix_ = model_handle_->getMass();
+  }
+}
 
-    std::array<double, 49> mass_matrix = model_handle_->getMass();
-    std::array<double, 42> O_Jac_EE = model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
-    Eigen::Map<Eigen::Matrix<double, 6, 7>> jacobian(O_Jac_EE.data());
-    Eigen::Map<Eigen::Matrix<double, 7, 1>> dq(robot_state_.dq.data());
+void CustomFrankaStateController::publishFrankaState(const ros::Time& time) {
 
-//  jacobian * dq
-    Eigen::Matrix<double, 6, 1> ee_vel = jacobian * dq;
+    const std::array<double, 7>& coriolis = coriolis_;
+    const std::array<double, 7>& gravity = gravity_;
+    const std::array<double, 49>& mass_matrix = mass_matrix_;
+    const std::array<double, 42>& O_Jac_EE = O_Jac_EE_;
 
     if (publisher_franka_state_.trylock()) {
         static_assert(
-                sizeof(robot_state_.cartesian_collision) == sizeof(robot_state_.cartesian_contact),
+                sizeof(robot_state_->cartesian_collision) == sizeof(robot_state_->cartesian_contact),
                 "Robot state Cartesian members do not have same size");
         static_assert(
-                sizeof(robot_state_.cartesian_collision) == sizeof(robot_state_.O_dP_EE_c),
+                sizeof(robot_state_->cartesian_collision) == sizeof(robot_state_->O_dP_EE_c),
                 "Robot state Cartesian members do not have same size");
         static_assert(
-                sizeof(robot_state_.cartesian_collision) == sizeof(robot_state_.O_dP_EE_d),
+                sizeof(robot_state_->cartesian_collision) == sizeof(robot_state_->O_dP_EE_d),
                 "Robot state Cartesian members do not have same size");
         static_assert(
-                sizeof(robot_state_.cartesian_collision) == sizeof(robot_state_.O_ddP_EE_c),
+                sizeof(robot_state_->cartesian_collision) == sizeof(robot_state_->O_ddP_EE_c),
                 "Robot state Cartesian members do not have same size");
-        for (size_t i = 0; i < robot_state_.cartesian_collision.size(); i++) {
-            publisher_franka_state_.msg_.cartesian_collision[i] = robot_state_.cartesian_collision[i];
-            publisher_franka_state_.msg_.cartesian_contact[i] = robot_state_.cartesian_contact[i];
-            publisher_franka_state_.msg_.O_dP_EE[i] = ee_vel(i,0);
+        for (size_t i = 0; i < robot_state_->cartesian_collision.size(); i++) {
+            publisher_franka_state_.msg_.cartesian_collision[i] = robot_state_->cartesian_collision[i];
+            publisher_franka_state_.msg_.cartesian_contact[i] = robot_state_->cartesian_contact[i];
+            publisher_franka_state_.msg_.O_dP_EE[i] = O_dP_EE_[i];
         }
 
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.q_d),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->q_d),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.dq_d),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->dq_d),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.dtau_J),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->dtau_J),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.tau_J_d),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->tau_J_d),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.joint_collision),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->joint_collision),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.joint_contact),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->joint_contact),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.tau_ext_hat_filtered),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->tau_ext_hat_filtered),
                   "Robot state joint members do not have same size");
-      for (size_t i = 0; i < robot_state_.q.size(); i++) {
-          publisher_franka_state_.msg_.q_d[i] = robot_state_.q_d[i];
-          publisher_franka_state_.msg_.dq_d[i] = robot_state_.dq_d[i];
-          publisher_franka_state_.msg_.dtau_J[i] = robot_state_.dtau_J[i];
-          publisher_franka_state_.msg_.tau_J_d[i] = robot_state_.tau_J_d[i];
-          publisher_franka_state_.msg_.joint_collision[i] = robot_state_.joint_collision[i];
-          publisher_franka_state_.msg_.joint_contact[i] = robot_state_.joint_contact[i];
-          publisher_franka_state_.msg_.tau_ext_hat_filtered[i] = robot_state_.tau_ext_hat_filtered[i];
+      for (size_t i = 0; i < robot_state_->q.size(); i++) {
+          publisher_franka_state_.msg_.q_d[i] = robot_state_->q_d[i];
+          publisher_franka_state_.msg_.dq_d[i] = robot_state_->dq_d[i];
+          publisher_franka_state_.msg_.dtau_J[i] = robot_state_->dtau_J[i];
+          publisher_franka_state_.msg_.tau_J_d[i] = robot_state_->tau_J_d[i];
+          publisher_franka_state_.msg_.joint_collision[i] = robot_state_->joint_collision[i];
+          publisher_franka_state_.msg_.joint_contact[i] = robot_state_->joint_contact[i];
+          publisher_franka_state_.msg_.tau_ext_hat_filtered[i] = robot_state_->tau_ext_hat_filtered[i];
           publisher_franka_state_.msg_.gravity[i] = gravity[i];
           publisher_franka_state_.msg_.coriolis[i] = coriolis[i];
       }
 
-    static_assert(sizeof(robot_state_.O_T_EE) == sizeof(robot_state_.F_T_EE),
+    static_assert(sizeof(robot_state_->O_T_EE) == sizeof(robot_state_->F_T_EE),
                   "Robot state transforms do not have same size");
-    static_assert(sizeof(robot_state_.O_T_EE) == sizeof(robot_state_.EE_T_K),
+    static_assert(sizeof(robot_state_->O_T_EE) == sizeof(robot_state_->EE_T_K),
                   "Robot state transforms do not have same size");
-    static_assert(sizeof(robot_state_.O_T_EE) == sizeof(robot_state_.O_T_EE_d),
+    static_assert(sizeof(robot_state_->O_T_EE) == sizeof(robot_state_->O_T_EE_d),
                   "Robot state transforms do not have same size");
 
 
-      for (size_t i = 0; i < robot_state_.O_T_EE.size(); i++) {
-          publisher_franka_state_.msg_.F_T_EE[i] = robot_state_.F_T_EE[i];
-          publisher_franka_state_.msg_.EE_T_K[i] = robot_state_.EE_T_K[i];
-          publisher_franka_state_.msg_.O_T_EE_d[i] = robot_state_.O_T_EE_d[i];
+      for (size_t i = 0; i < robot_state_->O_T_EE.size(); i++) {
+          publisher_franka_state_.msg_.F_T_EE[i] = robot_state_->F_T_EE[i];
+          publisher_franka_state_.msg_.EE_T_K[i] = robot_state_->EE_T_K[i];
+          publisher_franka_state_.msg_.O_T_EE_d[i] = robot_state_->O_T_EE_d[i];
       }
-      publisher_franka_state_.msg_.m_ee = robot_state_.m_ee;
-      publisher_franka_state_.msg_.m_load = robot_state_.m_load;
-      publisher_franka_state_.msg_.m_total = robot_state_.m_total;
-
-      for (size_t i = 0; i < robot_state_.I_load.size(); i++) {
-          publisher_franka_state_.msg_.I_ee[i] = robot_state_.I_ee[i];
-          publisher_franka_state_.msg_.I_load[i] = robot_state_.I_load[i];
-          publisher_franka_state_.msg_.I_total[i] = robot_state_.I_total[i];
+      publisher_franka_state_.msg_.m_ee = robot_state_->m_ee;
+      publisher_franka_state_.msg_.m_load = robot_state_->m_load;
+      publisher_franka_state_.msg_.m_total = robot_state_->m_total;
+
+      for (size_t i = 0; i < robot_state_->I_load.size(); i++) {
+          publisher_franka_state_.msg_.I_ee[i] = robot_state_->I_ee[i];
+          publisher_franka_state_.msg_.I_load[i] = robot_state_->I_load[i];
+          publisher_franka_state_.msg_.I_total[i] = robot_state_->I_total[i];
       }
 
-      for (size_t i = 0; i < robot_state_.F_x_Cload.size(); i++) {
-          publisher_franka_state_.msg_.F_x_Cee[i] = robot_state_.F_x_Cee[i];
-          publisher_franka_state_.msg_.F_x_Cload[i] = robot_state_.F_x_Cload[i];
-          publisher_franka_state_.msg_.F_x_Ctotal[i] = robot_state_.F_x_Ctotal[i];
+      for (size_t i = 0; i < robot_state_->F_x_Cload.size(); i++) {
+          publisher_franka_state_.msg_.F_x_Cee[i] = robot_state_->F_x_Cee[i];
+          publisher_franka_state_.msg_.F_x_Cload[i] = robot_state_->F_x_Cload[i];
+          publisher_franka_state_.msg_.F_x_Ctotal[i] = robot_state_->F_x_Ctotal[i];
       }
 
       for (size_t i = 0; i < mass_matrix.size(); i++) {
@@ -381,42 +617,12 @@ void CustomFrankaStateController::publishFrankaState(const ros::Time& time) {
           publisher_franka_state_.msg_.O_Jac_EE[i] = O_Jac_EE[i];
       }
 
-      publisher_franka_state_.msg_.time = robot_state_.time.toSec();
-      publisher_franka_state_.msg_.current_errors = errorsToMessage(robot_state_.current_errors);
-      publisher_franka_state_.msg_.last_motion_errors =
-        errorsToMessage(robot_state_.last_motion_errors);
-
-      switch (robot_state_.robot_mode) {
-          case franka::RobotMode::kOther:
-              publisher_franka_state_.msg_.robot_mode = franka_core_msgs::RobotState::ROBOT_MODE_OTHER;
-              break;
-
-          case franka::RobotMode::kIdle:
-              publisher_franka_state_.msg_.robot_mode = franka_core_msgs::RobotState::ROBOT_MODE_IDLE;
-              break;
-
-          case franka::RobotMode::kMove:
-              publisher_franka_state_.msg_.robot_mode = franka_core_msgs::RobotState::ROBOT_MODE_MOVE;
-              break;
-
-          case franka::RobotMode::kGuiding:
-              publisher_franka_state_.msg_.robot_mode = franka_core_msgs::RobotState::ROBOT_MODE_GUIDING;
-              break;
-
-          case franka::RobotMode::kReflex:
-              publisher_franka_state_.msg_.robot_mode = franka_core_msgs::RobotState::ROBOT_MODE_REFLEX;
-              break;
-
-          case franka::RobotMode::kUserStopped:
-              publisher_franka_state_.msg_.robot_mode =
-            franka_core_msgs::RobotState::ROBOT_MODE_USER_STOPPED;
-              break;
-
-          case franka::RobotMode::kAutomaticErrorRecovery:
-              publisher_franka_state_.msg_.robot_mode =
-            franka_core_msgs::RobotState::ROBOT_MODE_AUTOMATIC_ERROR_RECOVERY;
-              break;
-      }
+      publisher_franka_state_.msg_.time = robot_state_->time.toSec();
+      publisher_franka_state_.msg_.current_errors_mask = errorsToBits(robot_state_->current_errors);
+      publisher_franka_state_.msg_.last_motion_errors_mask =
+        errorsToBits(robot_state_->last_motion_errors);
+
+      publisher_franka_state_.msg_.robot_mode = robotModeToMessage(robot_state_->robot_mode);
 
       publisher_franka_state_.msg_.header.seq = sequence_number_;
       publisher_franka_state_.msg_.header.stamp = time;
@@ -424,32 +630,130 @@ void CustomFrankaStateController::publishFrankaState(const ros::Time& time) {
   }
 }
 
+void CustomFrankaStateController::publishFrankaStateCompact(const ros::Time& time) {
+  if (!publisher_franka_state_compact_.trylock()) {
+    return;
+  }
+  franka_core_msgs::RobotStateCompact& msg = publisher_franka_state_compact_.msg_;
+  msg.groups = compact_groups_ & ~franka_core_msgs::RobotStateCompact::GROUP_ERRORS;
+
+  if (!msg.kinematics.empty()) {
+    franka_core_msgs::RobotStateKinematics& kinematics = msg.kinematics[0];
+    std::copy(O_dP_EE_.begin(), O_dP_EE_.end(), kinematics.O_dP_EE.begin());
+    std::copy(robot_state_->q_d.begin(), robot_state_->q_d.end(), kinematics.q_d.begin());
+    std::copy(robot_state_->dq_d.begin(), robot_state_->dq_d.end(), kinematics.dq_d.begin());
+    std::copy(O_Jac_EE_.begin(), O_Jac_EE_.end(), kinematics.O_Jac_EE.begin());
+    std::copy(robot_state_->O_T_EE_d.begin(), robot_state_->O_T_EE_d.end(),
+              kinematics.O_T_EE_d.begin());
+    std::copy(robot_state_->F_T_EE.begin(), robot_state_->F_T_EE.end(), kinematics.F_T_EE.begin());
+    std::copy(robot_state_->EE_T_K.begin(), robot_state_->EE_T_K.end(), kinematics.EE_T_K.begin());
+    std::copy(robot_state_->cartesian_collision.begin(), robot_state_->cartesian_collision.end(),
+              kinematics.cartesian_collision.begin());
+    std::copy(robot_state_->cartesian_contact.begin(), robot_state_->cartesian_contact.end(),
+              kinematics.cartesian_contact.begin());
+    std::copy(robot_state_->joint_collision.begin(), robot_state_->joint_collision.end(),
+              kinematics.joint_collision.begin());
+    std::copy(robot_state_->joint_contact.begin(), robot_state_->joint_contact.end(),
+              kinematics.joint_contact.begin());
+  }
+
+  if (!msg.dynamics.empty()) {
+    franka_core_msgs::RobotStateDynamics& dynamics = msg.dynamics[0];
+    std::copy(robot_state_->tau_J_d.begin(), robot_state_->tau_J_d.end(), dynamics.tau_J_d.begin());
+    std::copy(robot_state_->dtau_J.begin(), robot_state_->dtau_J.end(), dynamics.dtau_J.begin());
+    std::copy(robot_state_->tau_ext_hat_filtered.begin(), robot_state_->tau_ext_hat_filtered.end(),
+              dynamics.tau_ext_hat_filtered.begin());
+    std::copy(gravity_.begin(), gravity_.end(), dynamics.gravity.begin());
+    std::copy(coriolis_.begin(), coriolis_.end(), dynamics.coriolis.begin());
+    std::copy(mass_matrix_.begin(), mass_matrix_.end(), dynamics.mass_matrix.begin());
+  }
+
+  msg.errors.clear();
+  if (compact_groups_ & franka_core_msgs::RobotStateCompact::GROUP_ERRORS) {
+    uint64_t current_errors = errorsToBits(robot_state_->current_errors);
+    uint64_t last_motion_errors = errorsToBits(robot_state_->last_motion_errors);
+    // Also resend when somebody (re)connected, so late subscribers learn the current errors.
+    uint64_t connections =
+        franka_state_compact_stream_.connections.load(std::memory_order_relaxed);
+    if (connections != compact_errors_connections_ || current_errors != compact_current_errors_ ||
+        last_motion_errors != compact_last_motion_errors_) {
+      msg.errors.resize(1);
+      msg.errors[0].current_errors_mask = current_errors;
+      msg.errors[0].last_motion_errors_mask = last_motion_errors;
+      msg.errors[0].current_errors = errorsToMessage(robot_state_->current_errors);
+      msg.errors[0].last_motion_errors = errorsToMessage(robot_state_->last_motion_errors);
+      msg.groups |= franka_core_msgs::RobotStateCompact::GROUP_ERRORS;
+      compact_current_errors_ = current_errors;
+      compact_last_motion_errors_ = last_motion_errors;
+      compact_errors_connections_ = connections;
+    }
+  }
+
+  msg.time = robot_state_->time.toSec();
+  msg.robot_mode = robotModeToMessage(robot_state_->robot_mode);
+  msg.header.seq = sequence_number_;
+  msg.header.stamp = time;
+  publisher_franka_state_compact_.unlockAndPublish();
+}
+
+void CustomFrankaStateController::publishErrorsOnChange(const franka::RobotState& robot_state,
+                                                        uint64_t current_errors,
+                                                        uint64_t last_motion_errors) {
+  if (errors_published_ && current_errors == published_current_errors_ &&
+      last_motion_errors == published_last_motion_errors_) {
+    return;
+  }
+  // If the previous message is still being sent, try again on the next cycle.
+  if (publisher_errors_.trylock()) {
+    publisher_errors_.msg_.current_errors_mask = current_errors;
+    publisher_errors_.msg_.last_motion_errors_mask = last_motion_errors;
+    publisher_errors_.msg_.current_errors = errorsToMessage(robot_state.current_errors);
+    publisher_errors_.msg_.last_motion_errors = errorsToMessage(robot_state.last_motion_errors);
+    publisher_errors_.unlockAndPublish();
+    published_current_errors_ = current_errors;
+    published_last_motion_errors_ = last_motion_errors;
+    errors_published_ = true;
+  }
+}
+
+void CustomFrankaStateController::publishContactEventOnChange(
+    const ros::Time& time, const franka::RobotState& robot_state) {
+  // The predicates are evaluated at the control rate, independent of the stream rates.
+  if (contact_detector_.update(time, robot_state) && contact_signal_ != nullptr) {
+    contact_signal_->raise(contact_detector_.sources());
+  }
+  // If the previous message is still being sent, the event stays pending for the next cycle.
+  if (contact_detector_.hasPendingEvent() && publisher_contact_events_.trylock()) {
+    contact_detector_.fillEvent(publisher_contact_events_.msg_);
+    publisher_contact_events_.msg_.header.seq = sequence_number_;
+    publisher_contact_events_.unlockAndPublish();
+  }
+}
+
 void CustomFrankaStateController::publishJointStates(const ros::Time& time) {
   if (publisher_joint_states_.trylock()) {
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.dq),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->dq),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q) == sizeof(robot_state_.tau_J),
+    static_assert(sizeof(robot_state_->q) == sizeof(robot_state_->tau_J),
                   "Robot state joint members do not have same size");
-    for (size_t i = 0; i < robot_state_.q.size(); i++) {
-      publisher_joint_states_.msg_.name[i] = joint_names_[i];
-      publisher_joint_states_.msg_.position[i] = robot_state_.q[i];
-      publisher_joint_states_.msg_.velocity[i] = robot_state_.dq[i];
-      publisher_joint_states_.msg_.effort[i] = robot_state_.tau_J[i];
+    for (size_t i = 0; i < robot_state_->q.size(); i++) {
+      publisher_joint_states_.msg_.position[i] = robot_state_->q[i];
+      publisher_joint_states_.msg_.velocity[i] = robot_state_->dq[i];
+      publisher_joint_states_.msg_.effort[i] = robot_state_->tau_J[i];
     }
     publisher_joint_states_.msg_.header.stamp = time;
     publisher_joint_states_.msg_.header.seq = sequence_number_;
     publisher_joint_states_.unlockAndPublish();
   }
   if (publisher_joint_states_desired_.trylock()) {
-    static_assert(sizeof(robot_state_.q_d) == sizeof(robot_state_.dq_d),
+    static_assert(sizeof(robot_state_->q_d) == sizeof(robot_state_->dq_d),
                   "Robot state joint members do not have same size");
-    static_assert(sizeof(robot_state_.q_d) == sizeof(robot_state_.tau_J_d),
+    static_assert(sizeof(robot_state_->q_d) == sizeof(robot_state_->tau_J_d),
                   "Robot state joint members do not have same size");
-    for (size_t i = 0; i < robot_state_.q_d.size(); i++) {
-      publisher_joint_states_desired_.msg_.name[i] = joint_names_[i];
-      publisher_joint_states_desired_.msg_.position[i] = robot_state_.q_d[i];
-      publisher_joint_states_desired_.msg_.velocity[i] = robot_state_.dq_d[i];
-      publisher_joint_states_desired_.msg_.effort[i] = robot_state_.tau_J_d[i];
+    for (size_t i = 0; i < robot_state_->q_d.size(); i++) {
+      publisher_joint_states_desired_.msg_.position[i] = robot_state_->q_d[i];
+      publisher_joint_states_desired_.msg_.velocity[i] = robot_state_->dq_d[i];
+      publisher_joint_states_desired_.msg_.effort[i] = robot_state_->tau_J_d[i];
     }
     publisher_joint_states_desired_.msg_.header.stamp = time;
     publisher_joint_states_desired_.msg_.header.seq = sequence_number_;
@@ -457,50 +761,52 @@ void CustomFrankaStateController::publishJointStates(const ros::Time& time) {
   }
 }
 
-void CustomFrankaStateController::publishTransforms(const ros::Time& time) {
-  if (publisher_transforms_.trylock()) {
-    tf::StampedTransform stamped_transform(convertArrayToTf(robot_state_.F_T_EE), time,
-                                           arm_id_ + "_link8", arm_id_ + "_EE");
-    geometry_msgs::TransformStamped transform_message;
-    transformStampedTFToMsg(stamped_transform, transform_message);
-    publisher_transforms_.msg_.transforms[0] = transform_message;
-    stamped_transform = tf::StampedTransform(convertArrayToTf(robot_state_.EE_T_K), time,
-                                             arm_id_ + "_EE", arm_id_ + "_K");
-    transformStampedTFToMsg(stamped_transform, transform_message);
-    publisher_transforms_.msg_.transforms[1] = transform_message;
-    publisher_transforms_.unlockAndPublish();
+void CustomFrankaStateController::publishTransformsOnChange(const ros::Time& time,
+                                                            const franka::RobotState& robot_state) {
+  if (robot_state.F_T_EE == published_F_T_EE_ && robot_state.EE_T_K == published_EE_T_K_) {
+    return;
+  }
+  // The frame IDs were set in init(); only the stamp and the transforms change. If the previous
+  // message is still being sent, try again on the next cycle.
+  if (static_transforms_->trylock()) {
+    geometry_msgs::TransformStamped& ee_frame = static_transforms_->frame(ee_frame_);
+    ee_frame.header.stamp = time;
+    convertArrayToTransformMsg(robot_state.F_T_EE, ee_frame.transform);
+    geometry_msgs::TransformStamped& k_frame = static_transforms_->frame(k_frame_);
+    k_frame.header.stamp = time;
+    convertArrayToTransformMsg(robot_state.EE_T_K, k_frame.transform);
+    static_transforms_->unlockAndPublish();
+    published_F_T_EE_ = robot_state.F_T_EE;
+    published_EE_T_K_ = robot_state.EE_T_K;
   }
 }
 
 void CustomFrankaStateController::publishEndPointState(const ros::Time& time) {
   if (publisher_tip_state_.trylock()) {
-    for (size_t i = 0; i < robot_state_.O_T_EE.size(); i++) {
-      publisher_tip_state_.msg_.O_T_EE[i] = robot_state_.O_T_EE[i];
+    for (size_t i = 0; i < robot_state_->O_T_EE.size(); i++) {
+      publisher_tip_state_.msg_.O_T_EE[i] = robot_state_->O_T_EE[i];
     }
-//    for (size_t i = 0; i < robot_state_.O_dP_EE_c.size(); i++) {
-//      publisher_tip_state_.msg_.O_dP_EE_c[i] = robot_state_.O_dP_EE_c[i];
-//      publisher_tip_state_.msg_.O_dP_EE_d[i] = robot_state_.O_dP_EE_d[i];
-//      publisher_tip_state_.msg_.O_ddP_EE_c[i] = robot_state_.O_ddP_EE_c[i];
+//    for (size_t i = 0; i < robot_state_->O_dP_EE_c.size(); i++) {
+//      publisher_tip_state_.msg_.O_dP_EE_c[i] = robot_state_->O_dP_EE_c[i];
+//      publisher_tip_state_.msg_.O_dP_EE_d[i] = robot_state_->O_dP_EE_d[i];
+//      publisher_tip_state_.msg_.O_ddP_EE_c[i] = robot_state_->O_ddP_EE_c[i];
 //    }
-    publisher_tip_state_.msg_.O_F_ext_hat_K.header.frame_id = arm_id_ + "_link0";
     publisher_tip_state_.msg_.O_F_ext_hat_K.header.stamp = time;
-    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.x = robot_state_.O_F_ext_hat_K[0];
-    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.y = robot_state_.O_F_ext_hat_K[1];
-    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.z = robot_state_.O_F_ext_hat_K[2];
-    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.torque.x = robot_state_.O_F_ext_hat_K[3];
-    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.torque.y = robot_state_.O_F_ext_hat_K[4];
-    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.torque.z = robot_state_.O_F_ext_hat_K[5];
+    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.x = robot_state_->O_F_ext_hat_K[0];
+    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.y = robot_state_->O_F_ext_hat_K[1];
+    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.force.z = robot_state_->O_F_ext_hat_K[2];
+    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.torque.x = robot_state_->O_F_ext_hat_K[3];
+    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.torque.y = robot_state_->O_F_ext_hat_K[4];
+    publisher_tip_state_.msg_.O_F_ext_hat_K.wrench.torque.z = robot_state_->O_F_ext_hat_K[5];
 
-    publisher_tip_state_.msg_.K_F_ext_hat_K.header.frame_id = arm_id_ + "_K";
     publisher_tip_state_.msg_.K_F_ext_hat_K.header.stamp = time;
-    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.force.x = robot_state_.K_F_ext_hat_K[0];
-    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.force.y = robot_state_.K_F_ext_hat_K[1];
-    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.force.z = robot_state_.K_F_ext_hat_K[2];
-    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.torque.x = robot_state_.K_F_ext_hat_K[3];
-    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.torque.y = robot_state_.K_F_ext_hat_K[4];
-    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.torque.z = robot_state_.K_F_ext_hat_K[5];
+    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.force.x = robot_state_->K_F_ext_hat_K[0];
+    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.force.y = robot_state_->K_F_ext_hat_K[1];
+    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.force.z = robot_state_->K_F_ext_hat_K[2];
+    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.torque.x = robot_state_->K_F_ext_hat_K[3];
+    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.torque.y = robot_state_->K_F_ext_hat_K[4];
+    publisher_tip_state_.msg_.K_F_ext_hat_K.wrench.torque.z = robot_state_->K_F_ext_hat_K[5];
 
-    publisher_tip_state_.msg_.header.frame_id = arm_id_ + "_link0";
     publisher_tip_state_.msg_.header.seq = sequence_number_;
     publisher_tip_state_.msg_.header.stamp = time;
 
@@ -508,6 +814,27 @@ void CustomFrankaStateController::publishEndPointState(const ros::Time& time) {
   }
 }
 
+void CustomFrankaStateController::writeSharedMemoryState(const franka::RobotState& robot_state) {
+  shm_state_.sequence = shm_sequence_number_++;
+  shm_state_.robot_mode = robotModeToMessage(robot_state.robot_mode);
+  shm_state_.time = robot_state.time.toSec();
+  std::copy(robot_state.q.begin(), robot_state.q.end(), shm_state_.q);
+  std::copy(robot_state.dq.begin(), robot_state.dq.end(), shm_state_.dq);
+  std::copy(robot_state.q_d.begin(), robot_state.q_d.end(), shm_state_.q_d);
+  std::copy(robot_state.dq_d.begin(), robot_state.dq_d.end(), shm_state_.dq_d);
+  std::copy(robot_state.tau_J.begin(), robot_state.tau_J.end(), shm_state_.tau_J);
+  std::copy(robot_state.tau_J_d.begin(), robot_state.tau_J_d.end(), shm_state_.tau_J_d);
+  std::copy(robot_state.dtau_J.begin(), robot_state.dtau_J.end(), shm_state_.dtau_J);
+  std::copy(robot_state.tau_ext_hat_filtered.begin(), robot_state.tau_ext_hat_filtered.end(),
+            shm_state_.tau_ext_hat_filtered);
+  std::copy(robot_state.O_T_EE.begin(), robot_state.O_T_EE.end(), shm_state_.O_T_EE);
+  std::copy(robot_state.O_F_ext_hat_K.begin(), robot_state.O_F_ext_hat_K.end(),
+            shm_state_.O_F_ext_hat_K);
+  std::copy(robot_state.K_F_ext_hat_K.begin(), robot_state.K_F_ext_hat_K.end(),
+            shm_state_.K_F_ext_hat_K);
+  shm_transport_.writeState(shm_state_);
+}
+
 }  // namespace franka_interface
 
 PLUGINLIB_EXPORT_CLASS(franka_interface::CustomFrankaStateController, controller_interface::ControllerBase)
@@ -0,0 +1,396 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_interface/state_recorder.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+#include <franka_ros_controllers/arm_config.h>
+
+#include "state_recording_format.h"
+
+namespace franka_interface {
+
+namespace {
+
+constexpr double kSampleRate = 1000.0;  // one sample per control cycle
+
+struct Column {
+  const char* name;
+  uint32_t width;
+};
+
+// Order of the values in a sample, as filled by StateRecorder::record().
+constexpr Column kColumns[] = {
+    {"sequence", 1},
+    {"ros_time", 1},
+    {"time", 1},
+    {"q", 7},
+    {"q_d", 7},
+    {"dq", 7},
+    {"dq_d", 7},
+    {"ddq_d", 7},
+    {"theta", 7},
+    {"dtheta", 7},
+    {"tau_J", 7},
+    {"tau_J_d", 7},
+    {"dtau_J", 7},
+    {"tau_ext_hat_filtered", 7},
+    {"O_T_EE", 16},
+    {"O_T_EE_d", 16},
+    {"O_F_ext_hat_K", 6},
+    {"K_F_ext_hat_K", 6},
+    {"control_command_success_rate", 1},
+    {"robot_mode", 1},
+    {"current_errors", 1},
+    {"last_motion_errors", 1},
+};
+constexpr size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+constexpr size_t kCurrentErrorsColumn = 20;
+
+constexpr size_t columnOffset(size_t column) {
+  size_t offset = 0;
+  for (size_t i = 0; i < column; ++i) {
+    offset += kColumns[i].width;
+  }
+  return offset;
+}
+
+constexpr bool sameName(const char* a, const char* b) {
+  return *a == *b && (*a == '\0' || sameName(a + 1, b + 1));
+}
+
+static_assert(columnOffset(kColumnCount) == StateRecorder::kSampleWidth,
+              "The state recorder columns do not fill a sample");
+static_assert(sameName(kColumns[kCurrentErrorsColumn].name, "current_errors"),
+              "kCurrentErrorsColumn does not point to current_errors");
+
+template <size_t N>
+double* put(double* out, const std::array<double, N>& values) {
+  return std::copy(values.begin(), values.end(), out);
+}
+
+size_t nextPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // anonymous namespace
+
+StateRecorder::StateRecorder()
+    : enabled_(false),
+      flight_mode_(false),
+      chunk_samples_(0),
+      ring_mask_(0),
+      ring_head_(0),
+      ring_tail_(0),
+      dropped_samples_(0),
+      sequence_(0),
+      file_(nullptr),
+      chunk_count_(0),
+      file_samples_(0),
+      history_samples_(0),
+      history_next_(0),
+      history_count_(0),
+      post_trigger_samples_(0),
+      dump_countdown_(-1),
+      had_errors_(false),
+      dump_requested_(false),
+      running_(false) {}
+
+StateRecorder::~StateRecorder() {
+  running_ = false;
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+  closeFile();
+}
+
+bool StateRecorder::init(ros::NodeHandle& node_handle, const std::string& arm_id,
+                         std::string& error) {
+  std::string mode;
+  int chunk_size;
+  int ring_capacity;
+  double flight_duration;
+  double flight_post_trigger;
+  node_handle.param<bool>("/robot_config/state_recorder/enabled", enabled_, false);
+  node_handle.param<std::string>("/robot_config/state_recorder/mode", mode, "flight");
+  node_handle.param<std::string>("/robot_config/state_recorder/directory", directory_, "/tmp");
+  node_handle.param<int>("/robot_config/state_recorder/chunk_size", chunk_size, 1000);
+  node_handle.param<int>("/robot_config/state_recorder/ring_capacity", ring_capacity, 4096);
+  node_handle.param<double>("/robot_config/state_recorder/flight_duration", flight_duration,
+                            10.0);
+  node_handle.param<double>("/robot_config/state_recorder/flight_post_trigger",
+                            flight_post_trigger, 1.0);
+  if (!enabled_) {
+    return true;
+  }
+
+  if (mode != "continuous" && mode != "flight") {
+    error = "Invalid state_recorder/mode " + mode + ", expected continuous or flight";
+    return false;
+  }
+  if (chunk_size <= 0 || ring_capacity <= 0) {
+    error = "state_recorder/chunk_size and state_recorder/ring_capacity must be positive";
+    return false;
+  }
+  flight_mode_ = mode == "flight";
+  state_prefix_ = franka_ros_controllers::armResourceName(node_handle, arm_id, "state");
+  flight_prefix_ = franka_ros_controllers::armResourceName(node_handle, arm_id, "flight");
+  chunk_samples_ = static_cast<size_t>(chunk_size);
+  size_t ring_samples = nextPowerOfTwo(static_cast<size_t>(ring_capacity));
+  ring_mask_ = ring_samples - 1;
+  ring_.assign(ring_samples * kSampleWidth, 0.0);
+  chunk_rows_.assign(chunk_samples_ * kSampleWidth, 0.0);
+  chunk_columns_.assign(chunk_samples_ * kSampleWidth, 0.0);
+
+  if (flight_mode_) {
+    if (flight_duration <= 0.0 || flight_post_trigger < 0.0 ||
+        flight_post_trigger >= flight_duration) {
+      error = "state_recorder/flight_duration must be positive and larger than "
+              "state_recorder/flight_post_trigger";
+      return false;
+    }
+    history_samples_ = static_cast<size_t>(flight_duration * kSampleRate);
+    post_trigger_samples_ = static_cast<size_t>(flight_post_trigger * kSampleRate);
+    history_.assign(history_samples_ * kSampleWidth, 0.0);
+    dump_service_ = node_handle.advertiseService("dump_state_recording",
+                                                 &StateRecorder::dumpCallback, this);
+    ROS_INFO_STREAM("StateRecorder: Keeping the last " << flight_duration
+                    << " s of robot state; dumps are written to " << directory_);
+  } else {
+    if (!openFile(state_prefix_, error)) {
+      return false;
+    }
+  }
+
+  running_ = true;
+  writer_thread_ = std::thread(&StateRecorder::writerLoop, this);
+  return true;
+}
+
+void StateRecorder::record(const ros::Time& time,
+                           const franka::RobotState& robot_state,
+                           uint8_t robot_mode,
+                           uint64_t current_errors,
+                           uint64_t last_motion_errors) {
+  uint64_t sequence = sequence_++;
+  uint64_t head = ring_head_.load(std::memory_order_relaxed);
+  if (head - ring_tail_.load(std::memory_order_acquire) > ring_mask_) {
+    dropped_samples_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  double* out = &ring_[(head & ring_mask_) * kSampleWidth];
+  *out++ = static_cast<double>(sequence);
+  *out++ = time.toSec();
+  *out++ = robot_state.time.toSec();
+  out = put(out, robot_state.q);
+  out = put(out, robot_state.q_d);
+  out = put(out, robot_state.dq);
+  out = put(out, robot_state.dq_d);
+  out = put(out, robot_state.ddq_d);
+  out = put(out, robot_state.theta);
+  out = put(out, robot_state.dtheta);
+  out = put(out, robot_state.tau_J);
+  out = put(out, robot_state.tau_J_d);
+  out = put(out, robot_state.dtau_J);
+  out = put(out, robot_state.tau_ext_hat_filtered);
+  out = put(out, robot_state.O_T_EE);
+  out = put(out, robot_state.O_T_EE_d);
+  out = put(out, robot_state.O_F_ext_hat_K);
+  out = put(out, robot_state.K_F_ext_hat_K);
+  *out++ = robot_state.control_command_success_rate;
+  *out++ = static_cast<double>(robot_mode);
+  // the masks have fewer than 53 bits, so they are exact as doubles
+  *out++ = static_cast<double>(current_errors);
+  *out++ = static_cast<double>(last_motion_errors);
+  ring_head_.store(head + 1, std::memory_order_release);
+}
+
+void StateRecorder::writerLoop() {
+  uint64_t reported_drops = 0;
+  while (running_) {
+    drain();
+    if (flight_mode_ && dump_requested_.exchange(false) && dump_countdown_ < 0) {
+      dumpHistory();
+    }
+    uint64_t drops = dropped_samples_.load(std::memory_order_relaxed);
+    if (drops != reported_drops) {
+      ROS_WARN_STREAM("StateRecorder: Dropped " << drops - reported_drops
+                      << " samples, the writer thread does not keep up");
+      reported_drops = drops;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  drain();
+}
+
+void StateRecorder::drain() {
+  uint64_t tail = ring_tail_.load(std::memory_order_relaxed);
+  uint64_t head = ring_head_.load(std::memory_order_acquire);
+  for (; tail != head; ++tail) {
+    const double* sample = &ring_[(tail & ring_mask_) * kSampleWidth];
+    if (flight_mode_) {
+      addToHistory(sample);
+    } else {
+      appendToChunk(sample);
+    }
+    ring_tail_.store(tail + 1, std::memory_order_release);
+  }
+}
+
+void StateRecorder::addToHistory(const double* sample) {
+  std::copy(sample, sample + kSampleWidth, &history_[history_next_ * kSampleWidth]);
+  history_next_ = (history_next_ + 1) % history_samples_;
+  history_count_ = std::min(history_count_ + 1, history_samples_);
+
+  bool has_errors = sample[columnOffset(kCurrentErrorsColumn)] != 0.0;
+  if (has_errors && !had_errors_ && dump_countdown_ < 0) {
+    ROS_WARN("StateRecorder: Robot reported an error, dumping the state history");
+    dump_countdown_ = static_cast<int64_t>(post_trigger_samples_);
+  }
+  had_errors_ = has_errors;
+  if (dump_countdown_ >= 0 && dump_countdown_-- == 0) {
+    dumpHistory();
+  }
+}
+
+void StateRecorder::dumpHistory() {
+  dump_countdown_ = -1;
+  std::string error;
+  if (!openFile(flight_prefix_, error)) {
+    ROS_ERROR_STREAM("StateRecorder: " << error);
+    return;
+  }
+  size_t first = (history_next_ + history_samples_ - history_count_) % history_samples_;
+  for (size_t i = 0; i < history_count_; ++i) {
+    appendToChunk(&history_[((first + i) % history_samples_) * kSampleWidth]);
+  }
+  closeFile();
+}
+
+bool StateRecorder::openFile(const std::string& prefix, std::string& error) {
+  ros::WallTime now = ros::WallTime::now();
+  std::time_t seconds = static_cast<std::time_t>(now.sec);
+  std::tm local_time;
+  localtime_r(&seconds, &local_time);
+  char stamp[32];
+  size_t length = std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local_time);
+  std::snprintf(stamp + length, sizeof(stamp) - length, "_%03u", now.nsec / 1000000);
+  path_ = directory_ + "/" + prefix + "_" + stamp + ".bin";
+
+  file_ = std::fopen(path_.c_str(), "wb");
+  if (file_ == nullptr) {
+    error = "Could not create " + path_ + ": " + std::strerror(errno);
+    return false;
+  }
+  RecordingFileHeader header{};
+  std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+  header.version = kRecordingVersion;
+  header.column_count = kColumnCount;
+  header.chunk_samples = static_cast<uint32_t>(chunk_samples_);
+  header.flight = flight_mode_ ? 1 : 0;
+  header.start_time = now.toSec();
+  bool ok = std::fwrite(&header, sizeof(header), 1, file_) == 1;
+  for (const Column& column : kColumns) {
+    RecordingColumnHeader column_header{};
+    std::strncpy(column_header.name, column.name, sizeof(column_header.name) - 1);
+    column_header.width = column.width;
+    ok = ok && std::fwrite(&column_header, sizeof(column_header), 1, file_) == 1;
+  }
+  if (!ok) {
+    error = "Could not write to " + path_;
+    std::fclose(file_);
+    file_ = nullptr;
+    return false;
+  }
+  chunk_count_ = 0;
+  file_samples_ = 0;
+  ROS_INFO_STREAM("StateRecorder: Recording robot state to " << path_);
+  return true;
+}
+
+void StateRecorder::closeFile() {
+  if (file_ == nullptr) {
+    return;
+  }
+  writeChunk();
+  std::fclose(file_);
+  file_ = nullptr;
+  ROS_INFO_STREAM("StateRecorder: Wrote " << file_samples_ << " samples to " << path_);
+}
+
+void StateRecorder::appendToChunk(const double* sample) {
+  std::copy(sample, sample + kSampleWidth, &chunk_rows_[chunk_count_ * kSampleWidth]);
+  if (++chunk_count_ == chunk_samples_) {
+    writeChunk();
+  }
+}
+
+void StateRecorder::writeChunk() {
+  if (chunk_count_ == 0 || file_ == nullptr) {
+    return;
+  }
+  double* out = chunk_columns_.data();
+  for (size_t column = 0; column < kColumnCount; ++column) {
+    size_t offset = columnOffset(column);
+    size_t width = kColumns[column].width;
+    for (size_t i = 0; i < chunk_count_; ++i) {
+      const double* value = &chunk_rows_[i * kSampleWidth + offset];
+      out = std::copy(value, value + width, out);
+    }
+  }
+  RecordingChunkHeader header{};
+  std::memcpy(header.tag, kRecordingChunkTag, sizeof(header.tag));
+  header.sample_count = static_cast<uint32_t>(chunk_count_);
+  header.first_sample = file_samples_;
+  // Readers ignore a last chunk that was only partly written, e.g. after a crash.
+  if (std::fwrite(&header, sizeof(header), 1, file_) != 1 ||
+      std::fwrite(chunk_columns_.data(), sizeof(double), chunk_count_ * kSampleWidth, file_) !=
+          chunk_count_ * kSampleWidth ||
+      std::fflush(file_) != 0) {
+    ROS_ERROR_STREAM_THROTTLE(1.0, "StateRecorder: Could not write to " << path_);
+  }
+  file_samples_ += chunk_count_;
+  chunk_count_ = 0;
+}
+
+bool StateRecorder::dumpCallback(std_srvs::Trigger::Request& /* request */,
+                                 std_srvs::Trigger::Response& response) {
+  dump_requested_ = true;
+  response.success = true;
+  response.message = "Dumping the state history to " + directory_;
+  return true;
+}
+
+}  // namespace franka_interface
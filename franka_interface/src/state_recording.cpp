@@ -0,0 +1,127 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_interface/state_recording.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "state_recording_format.h"
+
+namespace franka_interface {
+
+bool StateRecording::open(const std::string& path, std::string& error) {
+  samples_ = 0;
+  columns_.clear();
+  data_.clear();
+
+  FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    error = "Could not open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  std::vector<char> bytes;
+  char buffer[1 << 16];
+  size_t read;
+  while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    bytes.insert(bytes.end(), buffer, buffer + read);
+  }
+  std::fclose(file);
+
+  RecordingFileHeader header;
+  if (bytes.size() < sizeof(header)) {
+    error = path + " is not a robot state recording";
+    return false;
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (std::memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0) {
+    error = path + " is not a robot state recording";
+    return false;
+  }
+  if (header.version != kRecordingVersion) {
+    error = "Unsupported recording version " + std::to_string(header.version);
+    return false;
+  }
+  flight_ = header.flight != 0;
+
+  size_t offset = sizeof(header);
+  size_t sample_width = 0;
+  for (uint32_t i = 0; i < header.column_count; ++i) {
+    RecordingColumnHeader column_header;
+    if (offset + sizeof(column_header) > bytes.size()) {
+      error = path + " ends within the column headers";
+      return false;
+    }
+    std::memcpy(&column_header, &bytes[offset], sizeof(column_header));
+    offset += sizeof(column_header);
+    column_header.name[sizeof(column_header.name) - 1] = '\0';
+    columns_.emplace_back(column_header.name, column_header.width);
+    data_[column_header.name];
+    sample_width += column_header.width;
+  }
+
+  while (offset + sizeof(RecordingChunkHeader) <= bytes.size()) {
+    RecordingChunkHeader chunk;
+    std::memcpy(&chunk, &bytes[offset], sizeof(chunk));
+    size_t begin = offset + sizeof(chunk);
+    size_t end = begin + static_cast<size_t>(chunk.sample_count) * sample_width * sizeof(double);
+    if (std::memcmp(chunk.tag, kRecordingChunkTag, sizeof(chunk.tag)) != 0 ||
+        end > bytes.size()) {
+      break;
+    }
+    for (const auto& column : columns_) {
+      std::vector<double>& values = data_[column.first];
+      size_t count = chunk.sample_count * column.second;
+      values.resize(values.size() + count);
+      std::memcpy(&values[values.size() - count], &bytes[begin], count * sizeof(double));
+      begin += count * sizeof(double);
+    }
+    samples_ += chunk.sample_count;
+    offset = end;
+  }
+  return true;
+}
+
+std::vector<std::string> StateRecording::names() const {
+  std::vector<std::string> names;
+  for (const auto& column : columns_) {
+    names.push_back(column.first);
+  }
+  return names;
+}
+
+const double* StateRecording::column(const std::string& name, size_t& width) const {
+  for (const auto& column : columns_) {
+    if (column.first == name) {
+      width = column.second;
+      return data_.at(name).data();
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace franka_interface
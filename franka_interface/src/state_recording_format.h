@@ -0,0 +1,42 @@
+// state_recording_format.h: blocks of the binary robot state recording files, written by
+// StateRecorder and read by StateRecording (and franka_interface.state_recording in Python).
+
+#pragma once
+
+#include <cstdint>
+
+namespace franka_interface {
+
+constexpr char kRecordingMagic[8] = {'F', 'R', 'A', 'N', 'K', 'R', 'E', 'C'};
+constexpr char kRecordingChunkTag[4] = {'C', 'H', 'N', 'K'};
+constexpr uint32_t kRecordingVersion = 1;
+
+// File layout; every block is a multiple of 8 bytes so that all values are aligned when the
+// file is memory-mapped.
+struct RecordingFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t column_count;
+  uint32_t chunk_samples;
+  uint32_t flight;
+  double start_time;  // wall-clock time at which the file was created
+  uint8_t reserved[32];
+};
+static_assert(sizeof(RecordingFileHeader) == 64, "Unexpected recording file header size");
+
+struct RecordingColumnHeader {
+  char name[40];
+  uint32_t width;
+  uint32_t reserved;
+};
+static_assert(sizeof(RecordingColumnHeader) == 48, "Unexpected recording column header size");
+
+// Followed by, for each column, sample_count * width doubles (sample-major within a column).
+struct RecordingChunkHeader {
+  char tag[4];
+  uint32_t sample_count;
+  uint64_t first_sample;  // index of the first sample of the chunk in the file
+};
+static_assert(sizeof(RecordingChunkHeader) == 16, "Unexpected recording chunk header size");
+
+}  // namespace franka_interface
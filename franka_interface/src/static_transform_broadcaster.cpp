@@ -0,0 +1,64 @@
+/***************************************************************************
+
+*
+* @package: franka_interface
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_interface/static_transform_broadcaster.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace franka_interface {
+
+StaticTransformBroadcaster& StaticTransformBroadcaster::get(ros::NodeHandle& node_handle) {
+  // unique_ptr: the constructor stays private
+  static std::mutex mutex;
+  static std::unique_ptr<StaticTransformBroadcaster> broadcaster;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!broadcaster) {
+    broadcaster.reset(new StaticTransformBroadcaster(node_handle));
+  }
+  return *broadcaster;
+}
+
+StaticTransformBroadcaster::StaticTransformBroadcaster(ros::NodeHandle& node_handle)
+    : publisher_(node_handle, "/tf_static", 1, true) {}
+
+size_t StaticTransformBroadcaster::setFrame(const geometry_msgs::TransformStamped& transform) {
+  publisher_.lock();
+  std::vector<geometry_msgs::TransformStamped>& frames = publisher_.msg_.transforms;
+  size_t index = 0;
+  while (index < frames.size() && frames[index].child_frame_id != transform.child_frame_id) {
+    ++index;
+  }
+  if (index == frames.size()) {
+    frames.push_back(transform);
+  } else {
+    frames[index] = transform;
+  }
+  publisher_.unlockAndPublish();
+  return index;
+}
+
+}  // namespace franka_interface
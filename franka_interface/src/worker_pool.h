@@ -0,0 +1,107 @@
+// worker_pool.h: fixed set of threads that split a range of work items with the calling
+// thread. Used by BatchKinematics; the threads sleep on a condition variable between calls.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace franka_interface {
+
+class WorkerPool {
+ public:
+  using Task = std::function<void(size_t begin, size_t end)>;
+
+  // threads includes the caller of run(), so threads - 1 workers are started.
+  explicit WorkerPool(size_t threads) {
+    for (size_t i = 1; i < threads; ++i) {
+      workers_.emplace_back(&WorkerPool::work, this);
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  size_t size() const { return workers_.size() + 1; }
+
+  // Calls task on consecutive pieces of [0, count) of at most grain items and returns once
+  // all of them are done. Not reentrant.
+  void run(size_t count, size_t grain, const Task& task) {
+    if (workers_.empty() || count <= grain) {
+      task(0, count);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      count_ = count;
+      grain_ = grain;
+      next_ = 0;
+      active_ = workers_.size();
+      generation_++;
+    }
+    wake_.notify_all();
+    process();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return active_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const Task* task_{nullptr};
+  size_t count_{0};
+  size_t grain_{1};
+  std::atomic<size_t> next_{0};
+  size_t active_{0};
+  uint64_t generation_{0};
+  bool stop_{false};
+
+  void process() {
+    for (size_t begin = next_.fetch_add(grain_); begin < count_;
+         begin = next_.fetch_add(grain_)) {
+      (*task_)(begin, std::min(begin + grain_, count_));
+    }
+  }
+
+  void work() {
+    uint64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || generation_ != generation; });
+        if (stop_) {
+          return;
+        }
+        generation = generation_;
+      }
+      process();
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--active_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+};
+
+}  // namespace franka_interface
@@ -0,0 +1,55 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace franka_ros_controllers {
+namespace benchmark {
+
+/**
+ * Counts heap allocations (malloc, calloc, realloc, memalign and friends, and therefore
+ * operator new) made by the calling thread while an instance is alive.
+ *
+ * Linking allocation_counter.cpp into an executable interposes the glibc allocator for the
+ * whole process; allocations made by other threads (e.g. realtime publisher threads) are not
+ * counted. Counters do not nest.
+ */
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter();
+  ~ScopedAllocationCounter();
+
+  ScopedAllocationCounter(const ScopedAllocationCounter&) = delete;
+  ScopedAllocationCounter& operator=(const ScopedAllocationCounter&) = delete;
+
+  /// Allocations made by this thread since construction.
+  uint64_t count() const;
+};
+
+}  // namespace benchmark
+}  // namespace franka_ros_controllers
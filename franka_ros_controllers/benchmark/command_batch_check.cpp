@@ -0,0 +1,115 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+// Replacement behaviour of JointCommandBatchQueue, without a robot.
+//
+// A model predictive controller sends a full horizon every cycle and every batch replaces the
+// previous one, so full-size batches must be accepted back to back, also when several arrive between
+// control cycles. The check plays such a sequence against the queue together with the reads of
+// the control loop and fails if a batch is refused or the loop reads a waypoint of a superseded
+// batch. Returns non-zero on failure.
+
+#include <cstdio>
+#include <string>
+
+#include <franka_core_msgs/JointCommand.h>
+#include <franka_core_msgs/JointCommandBatch.h>
+#include <ros/time.h>
+
+#include <franka_ros_controllers/command_batch.h>
+
+namespace {
+
+using franka_ros_controllers::JointCommandBatchQueue;
+using franka_ros_controllers::JointWaypoint;
+
+// A full position batch starting at start whose waypoints all carry the batch number, 1 ms apart.
+franka_core_msgs::JointCommandBatch makeBatch(double start, int number) {
+  franka_core_msgs::JointCommandBatch msg;
+  msg.header.stamp = ros::Time(start);
+  msg.mode = franka_core_msgs::JointCommand::POSITION_MODE;
+  for (int i = 0; i < 7; ++i) {
+    msg.names.push_back("panda_joint" + std::to_string(i + 1));
+  }
+  for (size_t k = 0; k < JointCommandBatchQueue::kCapacity; ++k) {
+    msg.time_from_start.push_back(0.001 * k);
+    msg.position.insert(msg.position.end(), 7, static_cast<double>(number));
+  }
+  return msg;
+}
+
+bool write(JointCommandBatchQueue& queue, const franka_core_msgs::JointCommandBatch& msg,
+           int number) {
+  std::string error;
+  if (!queue.writeFromNonRT(msg, [](const JointWaypoint&) { return true; }, error)) {
+    std::printf("batch %d rejected: %s\n", number, error.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool readsBatch(JointCommandBatchQueue& queue, double now, int number) {
+  JointWaypoint waypoint{};
+  if (!queue.readFromRT(ros::Time(now), waypoint)) {
+    std::printf("no waypoint of batch %d due at %.3f s\n", number, now);
+    return false;
+  }
+  if (waypoint.position[0] != number) {
+    std::printf("read a waypoint of batch %.0f instead of batch %d\n", waypoint.position[0],
+                number);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  constexpr int kRounds = 1000;
+  JointCommandBatchQueue queue;
+
+  double now = 1.0;
+  int number = 0;
+  bool passed = true;
+  for (int round = 0; round < kRounds && passed; ++round) {
+    // three replacing batches between two control cycles: the loop only sees the last one
+    for (int i = 0; i < 3 && passed; ++i) {
+      ++number;
+      passed = write(queue, makeBatch(now, number), number);
+    }
+    passed = passed && readsBatch(queue, now, number);
+    now += 0.001;
+    // and one per cycle, next to the one the loop has started on
+    ++number;
+    passed = passed && write(queue, makeBatch(now, number), number) &&
+             readsBatch(queue, now, number);
+    now += 0.001;
+  }
+
+  std::printf("%d replacing batches of %zu waypoints: %s\n", number,
+              JointCommandBatchQueue::kCapacity, passed ? "passed" : "FAILED");
+  return passed ? 0 : 1;
+}
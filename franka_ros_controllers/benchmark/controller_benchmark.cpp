@@ -0,0 +1,301 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+// Per-tick cost of the controllers' update() paths.
+//
+// Each controller is initialised against BenchmarkRobotHW, a RobotHW that exposes the franka_hw
+// state/model/command interfaces over a single robot state, and update() is then called back to
+// back with a 1 ms period. The latency distribution and the number of heap allocations made by
+// update() are reported per controller.
+//
+// libfranka can only evaluate the dynamics model after loading it from a robot, so the node
+// connects to ~robot_ip once, reads one state and loads the model. No motion is commanded and
+// franka_control must not be running at the same time. Controller parameters are read from
+// ~controller_namespace exactly as when spawned by the controller manager; see
+// launch/controller_benchmark.launch.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <franka/exception.h>
+#include <franka/model.h>
+#include <franka/robot.h>
+#include <franka/robot_state.h>
+#include <franka_hw/franka_cartesian_command_interface.h>
+#include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <hardware_interface/robot_hw.h>
+#include <ros/ros.h>
+
+#include <franka_ros_controllers/cartesian_impedance_controller.h>
+#include <franka_ros_controllers/effort_joint_impedance_controller.h>
+#include <franka_ros_controllers/force_controller.h>
+#include <franka_ros_controllers/joint_impedance_controller.h>
+#include <franka_ros_controllers/ntorque_controller.h>
+#include <franka_ros_controllers/velocity_joint_velocity_controller.h>
+
+#include "allocation_counter.h"
+
+namespace {
+
+using franka_ros_controllers::benchmark::ScopedAllocationCounter;
+
+class BenchmarkRobotHW : public hardware_interface::RobotHW {
+ public:
+  BenchmarkRobotHW(const std::string& arm_id,
+                   const std::vector<std::string>& joint_names,
+                   franka::Model& model,
+                   const franka::RobotState& robot_state)
+      : robot_state_(robot_state), initial_state_(robot_state) {
+    for (size_t i = 0; i < joint_names.size(); ++i) {
+      hardware_interface::JointStateHandle joint_state_handle(
+          joint_names[i], &robot_state_.q[i], &robot_state_.dq[i], &robot_state_.tau_J[i]);
+      joint_state_interface_.registerHandle(joint_state_handle);
+      effort_joint_interface_.registerHandle(
+          hardware_interface::JointHandle(joint_state_handle, &effort_command_[i]));
+      velocity_joint_interface_.registerHandle(
+          hardware_interface::JointHandle(joint_state_handle, &velocity_command_[i]));
+    }
+
+    franka_hw::FrankaStateHandle franka_state_handle(arm_id + "_robot", robot_state_);
+    franka_state_interface_.registerHandle(franka_state_handle);
+    franka_pose_cartesian_interface_.registerHandle(franka_hw::FrankaCartesianPoseHandle(
+        franka_state_handle, pose_command_, elbow_command_));
+    franka_model_interface_.registerHandle(
+        franka_hw::FrankaModelHandle(arm_id + "_model", model, robot_state_));
+
+    registerInterface(&joint_state_interface_);
+    registerInterface(&effort_joint_interface_);
+    registerInterface(&velocity_joint_interface_);
+    registerInterface(&franka_state_interface_);
+    registerInterface(&franka_pose_cartesian_interface_);
+    registerInterface(&franka_model_interface_);
+  }
+
+  /// Puts the robot state back to the one read from the robot, so that every controller starts
+  /// from the same conditions.
+  void reset() {
+    robot_state_ = initial_state_;
+    effort_command_.fill(0.0);
+    velocity_command_.fill(0.0);
+  }
+
+  /// Advances the robot state time as a read from the robot would, so that cached model
+  /// quantities are evaluated again on every update.
+  void tick() { robot_state_.time = robot_state_.time + franka::Duration(1); }
+
+ private:
+  franka::RobotState robot_state_;
+  const franka::RobotState initial_state_;
+
+  std::array<double, 7> effort_command_{};
+  std::array<double, 7> velocity_command_{};
+  std::array<double, 16> pose_command_{};
+  std::array<double, 2> elbow_command_{};
+
+  hardware_interface::JointStateInterface joint_state_interface_;
+  hardware_interface::EffortJointInterface effort_joint_interface_;
+  hardware_interface::VelocityJointInterface velocity_joint_interface_;
+  franka_hw::FrankaStateInterface franka_state_interface_;
+  franka_hw::FrankaPoseCartesianInterface franka_pose_cartesian_interface_;
+  franka_hw::FrankaModelInterface franka_model_interface_;
+};
+
+struct Result {
+  std::string name;
+  bool initialised{false};
+  double first_us{0.0};  // starting() and the first update(), as in the first cycle after a switch
+  double p50_us{0.0};
+  double p99_us{0.0};
+  double p999_us{0.0};
+  double max_us{0.0};
+  double allocations_per_call{0.0};
+};
+
+double percentile(std::vector<double>& samples, double fraction) {
+  auto nth = samples.begin() + static_cast<std::ptrdiff_t>(fraction * (samples.size() - 1));
+  std::nth_element(samples.begin(), nth, samples.end());
+  return *nth;
+}
+
+template <class Controller>
+Result run(const std::string& name,
+           const std::string& controller_namespace,
+           BenchmarkRobotHW& robot_hw,
+           int warmup_iterations,
+           int iterations) {
+  Result result;
+  result.name = name;
+  robot_hw.reset();
+
+  Controller controller;
+  ros::NodeHandle controller_nh(controller_namespace + "/" + name);
+  if (!controller.init(&robot_hw, controller_nh)) {
+    ROS_ERROR_STREAM("controller_benchmark: Could not initialise " << name << ", skipping.");
+    return result;
+  }
+  result.initialised = true;
+
+  const ros::Duration period(0.001);
+  ros::Time time = ros::Time::now();
+  {
+    robot_hw.tick();
+    auto start = std::chrono::steady_clock::now();
+    controller.starting(time);
+    controller.update(time, period);
+    auto stop = std::chrono::steady_clock::now();
+    result.first_us = std::chrono::duration<double, std::micro>(stop - start).count();
+  }
+  for (int i = 0; i < warmup_iterations; ++i) {
+    time += period;
+    robot_hw.tick();
+    controller.update(time, period);
+  }
+
+  std::vector<double> samples(iterations);
+  uint64_t allocations = 0;
+  {
+    ScopedAllocationCounter allocation_counter;
+    for (int i = 0; i < iterations; ++i) {
+      time += period;
+      robot_hw.tick();
+      auto start = std::chrono::steady_clock::now();
+      controller.update(time, period);
+      auto stop = std::chrono::steady_clock::now();
+      samples[i] = std::chrono::duration<double, std::micro>(stop - start).count();
+    }
+    allocations = allocation_counter.count();
+  }
+  controller.stopping(time);
+
+  result.allocations_per_call = static_cast<double>(allocations) / iterations;
+  result.max_us = *std::max_element(samples.begin(), samples.end());
+  result.p999_us = percentile(samples, 0.999);
+  result.p99_us = percentile(samples, 0.99);
+  result.p50_us = percentile(samples, 0.5);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "controller_benchmark");
+  ros::NodeHandle private_nh("~");
+
+  std::string robot_ip;
+  if (!private_nh.getParam("robot_ip", robot_ip)) {
+    ROS_ERROR("controller_benchmark: Could not find parameter ~robot_ip, aborting!");
+    return 1;
+  }
+  std::string arm_id;
+  if (!private_nh.getParam("/robot_config/arm_id", arm_id)) {
+    ROS_ERROR("controller_benchmark: Could not read parameter /robot_config/arm_id, aborting!");
+    return 1;
+  }
+  std::vector<std::string> joint_names;
+  if (!private_nh.getParam("/robot_config/joint_names", joint_names) || joint_names.size() != 7) {
+    ROS_ERROR("controller_benchmark: Invalid or no /robot_config/joint_names, aborting!");
+    return 1;
+  }
+
+  std::string controller_namespace;
+  int iterations, warmup_iterations;
+  double max_p999_us, max_allocations_per_call;
+  private_nh.param<std::string>("controller_namespace", controller_namespace,
+                                "/franka_ros_interface");
+  private_nh.param<int>("iterations", iterations, 1000000);
+  private_nh.param<int>("warmup_iterations", warmup_iterations, 10000);
+  // Regression gate: a negative value disables the check.
+  private_nh.param<double>("max_p99_9_us", max_p999_us, -1.0);
+  private_nh.param<double>("max_allocations_per_call", max_allocations_per_call, -1.0);
+  if (iterations <= 0 || warmup_iterations < 0) {
+    ROS_ERROR("controller_benchmark: ~iterations must be positive, aborting!");
+    return 1;
+  }
+
+  std::unique_ptr<franka::Robot> robot;
+  std::unique_ptr<franka::Model> model;
+  franka::RobotState robot_state;
+  try {
+    robot.reset(new franka::Robot(robot_ip));
+    robot_state = robot->readOnce();
+    model.reset(new franka::Model(robot->loadModel()));
+  } catch (const franka::Exception& ex) {
+    ROS_ERROR_STREAM("controller_benchmark: Could not load the model from " << robot_ip << ": "
+                                                                             << ex.what());
+    return 1;
+  }
+
+  BenchmarkRobotHW robot_hw(arm_id, joint_names, *model, robot_state);
+
+  using namespace franka_ros_controllers;  // NOLINT (google-build-using-namespace)
+  std::vector<Result> results;
+  results.push_back(run<EffortJointImpedanceController>("effort_joint_impedance_controller",
+                                                        controller_namespace, robot_hw,
+                                                        warmup_iterations, iterations));
+  results.push_back(run<CartesianImpedanceController>("cartesian_impedance_controller",
+                                                      controller_namespace, robot_hw,
+                                                      warmup_iterations, iterations));
+  results.push_back(run<ForceController>("force_controller", controller_namespace, robot_hw,
+                                         warmup_iterations, iterations));
+  results.push_back(run<NTorqueController>("ntorque_controller", controller_namespace, robot_hw,
+                                           warmup_iterations, iterations));
+  results.push_back(run<JointImpedanceController>("joint_impedance_controller",
+                                                  controller_namespace, robot_hw,
+                                                  warmup_iterations, iterations));
+  results.push_back(run<VelocityJointVelocityController>("velocity_joint_velocity_controller",
+                                                         controller_namespace, robot_hw,
+                                                         warmup_iterations, iterations));
+
+  bool passed = true;
+  std::printf("\n%d update() calls per controller after %d warm-up calls\n\n", iterations,
+              warmup_iterations);
+  std::printf("%-36s %10s %10s %10s %10s %10s %12s\n", "controller", "first [us]", "p50 [us]",
+              "p99 [us]", "p99.9 [us]", "max [us]", "allocs/call");
+  for (const Result& r : results) {
+    if (!r.initialised) {
+      std::printf("%-36s %10s\n", r.name.c_str(), "init failed");
+      passed = false;
+      continue;
+    }
+    const bool too_slow = max_p999_us >= 0.0 && r.p999_us > max_p999_us;
+    const bool allocates =
+        max_allocations_per_call >= 0.0 && r.allocations_per_call > max_allocations_per_call;
+    std::printf("%-36s %10.2f %10.2f %10.2f %10.2f %10.2f %12.3f%s\n", r.name.c_str(),
+                r.first_us, r.p50_us, r.p99_us, r.p999_us, r.max_us, r.allocations_per_call,
+                too_slow || allocates ? "  FAILED" : "");
+    passed = passed && !too_slow && !allocates;
+  }
+  return passed ? 0 : 1;
+}
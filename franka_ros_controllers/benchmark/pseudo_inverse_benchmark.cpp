@@ -0,0 +1,134 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+
+// Microbenchmark for the pseudo-inverse variants in pseudo_inversion.h.
+//
+// Times one call of each method on the 7x6 Jacobian transpose used by the Cartesian impedance
+// controller, for well-conditioned and near-singular inputs, and reports the largest elementwise
+// deviation from the SVD reference. The adaptive method is compared to the undamped SVD on
+// well-conditioned inputs and to the fully damped SVD near singularities.
+//
+// Usage: pseudo_inverse_benchmark [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <franka_ros_controllers/pseudo_inversion.h>
+
+namespace {
+
+using JacobianTranspose = Eigen::Matrix<double, 7, 6>;
+using JacobianTransposePinv = Eigen::Matrix<double, 6, 7>;
+
+struct Result {
+  double median_ns;
+  double max_ns;
+  double max_deviation;
+};
+
+// Scales the smallest singular value down to `smallest` so the matrix sits next to a singularity.
+JacobianTranspose nearSingular(const JacobianTranspose& M, double smallest) {
+  Eigen::JacobiSVD<JacobianTranspose> svd(M, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Eigen::Matrix<double, 6, 1> sigma = svd.singularValues();
+  sigma(5) = smallest;
+  return svd.matrixU().leftCols<6>() * sigma.asDiagonal() * svd.matrixV().transpose();
+}
+
+Result run(const std::vector<JacobianTranspose>& inputs, const PseudoInverseParams& params,
+           double reference_damping, int iterations) {
+  std::vector<double> samples;
+  samples.reserve(iterations);
+  JacobianTransposePinv pinv, reference;
+  double max_deviation = 0.0;
+  volatile double sink = 0.0;
+
+  for (int i = 0; i < iterations; ++i) {
+    const JacobianTranspose& M = inputs[i % inputs.size()];
+    auto start = std::chrono::steady_clock::now();
+    pseudoInverse(M, pinv, params);
+    auto stop = std::chrono::steady_clock::now();
+    sink = sink + pinv(0, 0);
+    samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+
+    if (i < static_cast<int>(inputs.size())) {
+      pseudoInverseSvd(M, reference, reference_damping);
+      max_deviation = std::max(max_deviation, (pinv - reference).cwiseAbs().maxCoeff());
+    }
+  }
+
+  std::sort(samples.begin(), samples.end());
+  return {samples[samples.size() / 2], samples.back(), max_deviation};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+  std::srand(42);
+
+  std::vector<JacobianTranspose> regular, singular;
+  for (int i = 0; i < 64; ++i) {
+    // Keep the well-conditioned set clear of the adaptive threshold.
+    JacobianTranspose M = JacobianTranspose::Random();
+    while (Eigen::JacobiSVD<JacobianTranspose>(M).singularValues()(5) < 0.2) {
+      M = JacobianTranspose::Random();
+    }
+    regular.push_back(M);
+    singular.push_back(nearSingular(M, 1e-4));
+  }
+
+  struct Case {
+    const char* name;
+    PseudoInverseParams params;
+  };
+  const Case cases[] = {
+      {"svd (undamped)", {PseudoInverseMethod::kSvd, 0.0, 0.1}},
+      {"svd (damped)", {PseudoInverseMethod::kSvd, 0.2, 0.1}},
+      {"dls", {PseudoInverseMethod::kDampedLeastSquares, 0.2, 0.1}},
+      {"adaptive", {PseudoInverseMethod::kAdaptiveDamping, 0.2, 0.1}},
+  };
+
+  std::printf("%d iterations per case, 7x6 inputs\n\n", iterations);
+  std::printf("%-16s %-14s %12s %12s %16s\n", "method", "input", "median [ns]", "max [ns]",
+              "max |dev| vs svd");
+  for (const Case& c : cases) {
+    const std::vector<JacobianTranspose>* inputs[] = {&regular, &singular};
+    const char* labels[] = {"regular", "near-singular"};
+    for (int k = 0; k < 2; ++k) {
+      const bool undamped_reference =
+          c.params.method == PseudoInverseMethod::kAdaptiveDamping && inputs[k] == &regular;
+      Result r = run(*inputs[k], c.params, undamped_reference ? 0.0 : c.params.damping, iterations);
+      std::printf("%-16s %-14s %12.0f %12.0f %16.3e\n", c.name, labels[k], r.median_ns, r.max_ns,
+                  r.max_deviation);
+    }
+  }
+  return 0;
+}
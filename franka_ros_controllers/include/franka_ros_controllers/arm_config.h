@@ -0,0 +1,121 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <franka_core_msgs/JointLimits.h>
+#include <ros/node_handle.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Reads the arm a controller runs on: its own arm_id parameter, or /robot_config/arm_id if it
+ * has none. In a multi-arm control node every controller has to set its arm_id.
+ *
+ * @return false if neither parameter is set.
+ */
+bool readArmId(const ros::NodeHandle& node_handle, std::string& arm_id);
+
+/**
+ * True if arm_id is one of the arms of a multi-arm control node
+ * (/robot_config/multi_arm/arm_ids, from the RobotConfig snapshot).
+ */
+bool isMultiArm(const ros::NodeHandle& node_handle, const std::string& arm_id);
+
+/**
+ * Name of a topic or parameter namespace of a controller on arm_id, so that the controllers of
+ * several arms do not share them: "/<arm_id>" + name for an arm of a multi-arm node, name
+ * unchanged otherwise. name must be absolute, e.g.
+ * "/franka_ros_interface/motion_controller/arm/joint_commands".
+ */
+std::string armTopic(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                     const std::string& name);
+
+/**
+ * Name of a resource outside ROS, e.g. a shared-memory segment or a file name prefix, of arm_id,
+ * so that the arms of a multi-arm node do not share it: name + "_<arm_id>" for an arm of a
+ * multi-arm node, name unchanged otherwise.
+ */
+std::string armResourceName(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                            const std::string& name);
+
+/**
+ * Full name of the robot configuration parameter name (e.g. "joint_names" or
+ * "joint_config/joint_velocity_limit") for arm_id: /robot_config/multi_arm/<arm_id>/<name> if
+ * that parameter exists, /robot_config/<name> otherwise.
+ */
+std::string armConfigParam(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                           const std::string& name);
+
+/**
+ * Read-only snapshot of the robot configuration (/robot_config) shared by all controllers of a
+ * process. It is fetched from the parameter server with a single call, by the control node at
+ * startup or else by the first controller that needs it, so that loading controllers does not
+ * repeat the same parameter lookups and joint limit parsing. Changes to /robot_config take
+ * effect once the control node restarts.
+ */
+class RobotConfig {
+ public:
+  /**
+   * Fetches /robot_config, replacing the shared snapshot.
+   *
+   * @return false (keeping the previous snapshot) if /robot_config is not on the server.
+   */
+  static bool load(const ros::NodeHandle& node_handle);
+
+  /// The shared snapshot, loaded on first use; empty if /robot_config is not available.
+  static std::shared_ptr<const RobotConfig> get(const ros::NodeHandle& node_handle);
+
+  /// True if arm_id is one of multi_arm/arm_ids.
+  bool isMultiArm(const std::string& arm_id) const;
+
+  /**
+   * Joint names of arm_id with their joint_config limits in the same order, each taken from
+   * multi_arm/<arm_id>/ if present there (see armConfigParam()). A limit that is missing or
+   * incomplete for these joints is left empty.
+   */
+  const franka_core_msgs::JointLimits& jointLimits(const std::string& arm_id) const;
+
+  /// neutral_pose of arm_id in the order of its joint names; empty if missing or incomplete.
+  const std::vector<double>& neutralPose(const std::string& arm_id) const;
+
+ private:
+  struct ArmConfig {
+    franka_core_msgs::JointLimits joint_limits;
+    std::vector<double> neutral_pose;
+  };
+  const ArmConfig& arm(const std::string& arm_id) const;
+
+  std::vector<std::string> arm_ids_;
+  ArmConfig config_;  // of an arm without its own configuration
+  std::map<std::string, ArmConfig> arm_configs_;
+};
+
+}  // namespace franka_ros_controllers
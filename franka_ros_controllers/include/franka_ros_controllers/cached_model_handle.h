@@ -0,0 +1,139 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include <franka/model.h>
+#include <franka/robot_state.h>
+#include <franka_hw/franka_model_interface.h>
+#include <hardware_interface/robot_hw.h>
+
+#include <franka_ros_controllers/model_approximation.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Drop-in replacement for franka_hw::FrankaModelHandle that evaluates each model quantity at
+ * most once per robot state.
+ *
+ * All controllers of an arm (and the state controller) share one instance through acquire(),
+ * so within a control tick the first caller pays for e.g. the end-effector Jacobian and the
+ * others get the cached result. Entries are invalidated when the time stamp of the robot state
+ * changes, i.e. on every read from the robot. Quantities are returned by reference and stay
+ * valid until the next call for the same quantity in a later tick.
+ *
+ * If the RobotHW provides a ModelApproximationInterface model for the arm, that model is
+ * evaluated instead of the libfranka one.
+ *
+ * Not thread-safe: only call from the control loop thread.
+ */
+class CachedFrankaModelHandle {
+ public:
+  /**
+   * Shared cache for the model of arm_id in robot_hw, created on first use and kept for the
+   * life of the process. robot_hw must provide the FrankaStateInterface handle of the arm and
+   * either a ModelApproximationInterface model or the FrankaModelInterface handle of the arm.
+   * Not real-time safe.
+   *
+   * @throw hardware_interface::HardwareInterfaceException if a handle is missing.
+   */
+  static CachedFrankaModelHandle* acquire(hardware_interface::RobotHW* robot_hw,
+                                          const std::string& arm_id);
+
+  CachedFrankaModelHandle(const CachedFrankaModelHandle&) = delete;
+  CachedFrankaModelHandle& operator=(const CachedFrankaModelHandle&) = delete;
+
+  std::string getName() const { return name_; }
+
+  const std::array<double, 49>& getMass();
+  const std::array<double, 7>& getCoriolis();
+  const std::array<double, 7>& getGravity();
+  const std::array<double, 16>& getPose(franka::Frame frame);
+  const std::array<double, 42>& getBodyJacobian(franka::Frame frame);
+  const std::array<double, 42>& getZeroJacobian(franka::Frame frame);
+
+  /**
+   * Uncached quantities for an explicit robot state, e.g. for the warm-up cycles of a
+   * controller (see controller_warmup.h). They leave the cache alone and can be called from
+   * any thread.
+   */
+  std::array<double, 7> getCoriolis(const franka::RobotState& state) const;
+  std::array<double, 7> getGravity(const franka::RobotState& state) const;
+  std::array<double, 16> getPose(franka::Frame frame, const franka::RobotState& state) const;
+  std::array<double, 42> getZeroJacobian(franka::Frame frame,
+                                         const franka::RobotState& state) const;
+
+ private:
+  CachedFrankaModelHandle(const franka_hw::FrankaModelHandle& handle,
+                          const franka::RobotState& state)
+      : name_(handle.getName()),
+        handle_(new franka_hw::FrankaModelHandle(handle)),
+        state_(&state) {}
+  CachedFrankaModelHandle(const std::string& name,
+                          const ModelApproximation& approximation,
+                          const franka::RobotState& state)
+      : name_(name), approximation_(&approximation), state_(&state) {}
+
+  static constexpr size_t kFrameCount{static_cast<size_t>(franka::Frame::kStiffness) + 1};
+  static constexpr uint64_t kNever{std::numeric_limits<uint64_t>::max()};
+
+  template <size_t N>
+  struct Cached {
+    std::array<double, N> value{};
+    uint64_t stamp{kNever};  // robot state time (ms) the value was computed for
+  };
+
+  /// Marks entry as computed for the current state; false if it already was.
+  template <size_t N>
+  bool refresh(Cached<N>& entry) const {
+    const uint64_t now = state_->time.toMSec();
+    if (entry.stamp == now) {
+      return false;
+    }
+    entry.stamp = now;
+    return true;
+  }
+
+  std::string name_;
+  std::unique_ptr<const franka_hw::FrankaModelHandle> handle_;  // null if approximated
+  const ModelApproximation* approximation_{nullptr};
+  const franka::RobotState* state_;
+
+  Cached<49> mass_;
+  Cached<7> coriolis_;
+  Cached<7> gravity_;
+  std::array<Cached<16>, kFrameCount> pose_;
+  std::array<Cached<42>, kFrameCount> body_jacobian_;
+  std::array<Cached<42>, kFrameCount> zero_jacobian_;
+};
+
+}  // namespace franka_ros_controllers
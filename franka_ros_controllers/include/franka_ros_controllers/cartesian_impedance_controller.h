@@ -2,7 +2,9 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
+#include <array>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -19,6 +21,17 @@
 #include <franka_hw/franka_model_interface.h>
 #include <franka_hw/franka_state_interface.h>
 #include <franka_core_msgs/CartImpedanceStiffness.h>
+#include <franka_core_msgs/CartImpedanceTrajectory.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/pseudo_inversion.h>
+#include <franka_ros_controllers/cached_model_handle.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/controller_warmup.h>
+#include <franka_ros_controllers/gain_schedule.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
+#include <franka_ros_controllers/trajectory_buffer.h>
 
 namespace franka_ros_controllers {
 
@@ -29,37 +42,85 @@ class CartesianImpedanceController : public controller_interface::MultiInterface
  public:
   bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
   void starting(const ros::Time&) override;
-  void update(const ros::Time&, const ros::Duration& period) override;
+  void update(const ros::Time& time, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  Eigen::Matrix<double, 7, 1> saturateTorqueRate(
-      const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-      const Eigen::Matrix<double, 7, 1>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
   std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  CachedFrankaModelHandle* model_handle_{nullptr};  // shared with the other controllers
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
-  double filter_params_{0.005};
-  double nullspace_stiffness_{20.0};
-  double nullspace_stiffness_target_{20.0};
+  double filter_params_{0.005};  // first-order filter of the equilibrium pose
   const double delta_tau_max_{1.0};
   std::vector<double> stiffness_gains_;
-  Eigen::Matrix<double, 6, 6> cartesian_stiffness_;
-  Eigen::Matrix<double, 6, 6> cartesian_stiffness_target_;
-  Eigen::Matrix<double, 6, 6> cartesian_damping_;
-  Eigen::Matrix<double, 6, 6> cartesian_damping_target_;
   Eigen::Matrix<double, 7, 1> q_d_nullspace_;
   Eigen::Vector3d position_d_;
   Eigen::Quaterniond orientation_d_;
   Eigen::Vector3d position_d_target_;
   Eigen::Quaterniond orientation_d_target_;
+  PseudoInverseParams pseudo_inverse_params_;
+
+  struct PoseSetpoint {
+    Eigen::Vector3d position;
+    Eigen::Quaterniond orientation;
+  };
+  struct CartesianGains {
+    Eigen::Matrix<double, 6, 6> stiffness;
+    Eigen::Matrix<double, 6, 6> damping;
+    double nullspace_stiffness;
+    double nullspace_damping;
+
+    friend CartesianGains interpolate(const CartesianGains& from,
+                                      const CartesianGains& to,
+                                      double s) {
+      return CartesianGains{interpolate(from.stiffness, to.stiffness, s),
+                            interpolate(from.damping, to.damping, s),
+                            interpolate(from.nullspace_stiffness, to.nullspace_stiffness, s),
+                            interpolate(from.nullspace_damping, to.nullspace_damping, s)};
+    }
+  };
+  SetpointChannel<PoseSetpoint> pose_channel_;
+  GainSchedule<CartesianGains> gain_schedule_;
+  // used for stiffness messages with PROFILE_DEFAULT
+  GainTransition default_gain_transition_{TransitionProfile::kExponential, 1.0};
+
+  struct PoseTrajectoryPoint {
+    std::array<double, 3> position;
+    std::array<double, 4> orientation;  // x, y, z, w
+    double duration;  // seconds after the previous point
+    double start;     // header stamp of a new trajectory in seconds, 0 to start on arrival
+  };
+  static constexpr size_t kTrajectoryCapacity{1024};  // points per message
+  // room for a new trajectory next to the one being tracked
+  TrajectoryBuffer<PoseTrajectoryPoint, 2 * kTrajectoryCapacity> trajectory_;
+  // between consecutive points of a trajectory message, in m/s and rad/s
+  double max_translational_velocity_{1.7};
+  double max_rotational_velocity_{2.5};
+  std::mutex trajectory_chunk_mutex_;
+  std::vector<PoseTrajectoryPoint> trajectory_chunk_;
+  // control loop side
+  Eigen::Vector3d segment_start_position_;
+  Eigen::Quaterniond segment_start_orientation_;
+  double segment_start_time_{0.0};
+  bool trajectory_active_{false};
+  bool trajectory_idle_{false};
+  void updateTrajectory(const ros::Time& time);
+  ControllerTiming::Histogram* update_timing_{nullptr};
+
+  /// Commanded torque for robot_state towards the current equilibrium; also run by the
+  /// warm-up in init(), so it must not change the controller.
+  Eigen::Matrix<double, 7, 1> computeTorque(const franka::RobotState& robot_state,
+                                            const std::array<double, 7>& coriolis,
+                                            const std::array<double, 42>& jacobian,
+                                            const CartesianGains& gains) const;
 
   // Equilibrium pose subscriber
   ros::Subscriber sub_equilibrium_pose_;
   void equilibriumPoseCallback(const geometry_msgs::PoseStampedConstPtr& msg);
 
+  // Equilibrium pose trajectory subscriber
+  ros::Subscriber sub_equilibrium_pose_trajectory_;
+  void equilibriumPoseTrajectoryCallback(const franka_core_msgs::CartImpedanceTrajectory& msg);
+
   // Stiffness subscriber 
   ros::Subscriber stiffness_params_;
   void stiffnessParamCallback(const franka_core_msgs::CartImpedanceStiffness& msg);
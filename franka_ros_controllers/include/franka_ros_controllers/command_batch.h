@@ -0,0 +1,188 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <franka_core_msgs/JointCommand.h>
+#include <franka_core_msgs/JointCommandBatch.h>
+#include <ros/time.h>
+
+#include <franka_ros_controllers/trajectory_buffer.h>
+
+namespace franka_ros_controllers {
+
+/// One waypoint of a franka_core_msgs::JointCommandBatch, unpacked for the control loop.
+struct JointWaypoint {
+  std::array<double, 7> position;
+  std::array<double, 7> velocity;
+  std::array<double, 7> effort;
+  double time;  // ROS time in seconds at which the waypoint becomes active
+};
+
+/**
+ * Feeds the waypoints of JointCommandBatch messages to a joint controller.
+ *
+ * The command callback unpacks a batch with writeFromNonRT(), which replaces whatever is still
+ * queued from the previous batch; full-size batches are accepted back to back. update() calls
+ * readFromRT() every cycle and gets the latest waypoint that has become due, without blocking or
+ * allocating; the controller then treats it like a single JointCommand.
+ */
+class JointCommandBatchQueue {
+ public:
+  static constexpr size_t kCapacity{1024};
+
+  JointCommandBatchQueue() { chunk_.reserve(kCapacity); }
+
+  /**
+   * Checks and queues a batch of the given mode. Must not be called from the real-time thread.
+   *
+   * @param[in] valid Called for every waypoint, e.g. to check joint limits; returning false
+   * rejects the batch.
+   * @param[out] error Reason for rejecting the batch.
+   * @return false if the batch is malformed, rejected or does not fit.
+   */
+  template <typename Validator>
+  bool writeFromNonRT(const franka_core_msgs::JointCommandBatch& msg, Validator valid,
+                      std::string& error) {
+    const size_t count = msg.time_from_start.size();
+    if (msg.names.size() != 7) {
+      error = "batch must have 7 joint names";
+      return false;
+    }
+    if (count > kCapacity) {
+      error = "batch has more than " + std::to_string(kCapacity) + " waypoints";
+      return false;
+    }
+    if (!fieldFits(msg.position, count, requiresPosition(msg.mode)) ||
+        !fieldFits(msg.velocity, count, requiresVelocity(msg.mode)) ||
+        !fieldFits(msg.effort, count, msg.mode == franka_core_msgs::JointCommand::TORQUE_MODE)) {
+      error = "batch fields required for the mode must hold 7 values per waypoint";
+      return false;
+    }
+
+    const double start = msg.header.stamp.isZero() ? ros::Time::now().toSec()
+                                                   : msg.header.stamp.toSec();
+    std::lock_guard<std::mutex> lock(chunk_mutex_);
+    chunk_.clear();
+    for (size_t k = 0; k < count; ++k) {
+      if (k > 0 && msg.time_from_start[k] < msg.time_from_start[k - 1]) {
+        error = "batch time_from_start must not decrease";
+        return false;
+      }
+      JointWaypoint waypoint{};
+      unpack(msg.position, k, waypoint.position);
+      unpack(msg.velocity, k, waypoint.velocity);
+      unpack(msg.effort, k, waypoint.effort);
+      waypoint.time = start + msg.time_from_start[k];
+      if (!valid(waypoint)) {
+        error = "waypoint " + std::to_string(k) + " is beyond the allowed limits";
+        return false;
+      }
+      chunk_.push_back(waypoint);
+    }
+    if (msg.mode == franka_core_msgs::JointCommand::POSITION_MODE && msg.velocity.empty()) {
+      // feed-forward velocities for controllers that interpolate the horizon
+      estimateVelocities(chunk_);
+    }
+    if (!queue_.writeFromNonRT(chunk_.data(), chunk_.size(), true)) {
+      error = "batch queue is full";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Gets the latest waypoint due at time, skipping any older ones it supersedes. Real-time
+   * safe.
+   *
+   * @return false if no new waypoint has become due since the previous call.
+   */
+  bool readFromRT(const ros::Time& time, JointWaypoint& waypoint) {
+    queue_.takeRestartFromRT();
+    const double now = time.toSec();
+    bool found = false;
+    for (const JointWaypoint* next = queue_.frontFromRT(); next != nullptr && next->time <= now;
+         next = queue_.frontFromRT()) {
+      waypoint = *next;
+      found = true;
+      queue_.popFromRT();
+    }
+    return found;
+  }
+
+  /**
+   * The next waypoint that is not due yet, or nullptr at the end of the queued horizon, e.g. to
+   * interpolate towards it from the one returned by readFromRT(). Valid until the next
+   * readFromRT() or clearFromRT() call. Real-time safe.
+   */
+  const JointWaypoint* peekFromRT() const { return queue_.frontFromRT(); }
+
+  /// Drops the queued waypoints, e.g. when the controller starts. Real-time safe.
+  void clearFromRT() { queue_.clearFromRT(); }
+
+ private:
+  static bool requiresPosition(int mode) {
+    return mode == franka_core_msgs::JointCommand::POSITION_MODE ||
+           mode == franka_core_msgs::JointCommand::IMPEDANCE_MODE;
+  }
+  static bool requiresVelocity(int mode) {
+    return mode == franka_core_msgs::JointCommand::VELOCITY_MODE ||
+           mode == franka_core_msgs::JointCommand::IMPEDANCE_MODE;
+  }
+  static bool fieldFits(const std::vector<double>& field, size_t count, bool required) {
+    return field.size() == count * 7 || (!required && field.empty());
+  }
+  // Central differences of the positions (one-sided at the ends of the batch).
+  static void estimateVelocities(std::vector<JointWaypoint>& waypoints) {
+    for (size_t k = 0; k < waypoints.size(); ++k) {
+      const JointWaypoint& before = waypoints[k > 0 ? k - 1 : k];
+      const JointWaypoint& after = waypoints[k + 1 < waypoints.size() ? k + 1 : k];
+      const double dt = after.time - before.time;
+      for (size_t i = 0; i < 7; ++i) {
+        waypoints[k].velocity[i] = dt > 0.0 ? (after.position[i] - before.position[i]) / dt : 0.0;
+      }
+    }
+  }
+  static void unpack(const std::vector<double>& field, size_t k, std::array<double, 7>& values) {
+    if (!field.empty()) {
+      std::copy_n(field.begin() + k * 7, 7, values.begin());
+    }
+  }
+
+  // Twice the largest batch: until its next readFromRT() the loop may still read the batch it has
+  // started on, so a replacing batch is written next to it.
+  TrajectoryBuffer<JointWaypoint, 2 * kCapacity> queue_;
+  std::mutex chunk_mutex_;
+  std::vector<JointWaypoint> chunk_;
+};
+
+}  // namespace franka_ros_controllers
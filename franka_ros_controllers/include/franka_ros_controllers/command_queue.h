@@ -0,0 +1,47 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <ros/callback_queue.h>
+#include <ros/node_handle.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Makes the controllers subscribe to their command topics (joint commands, target poses,
+ * wrenches and torques) on the given queue instead of the global one, so that the control
+ * node can serve them from dedicated spinner threads. Gains, stiffness and dynamic_reconfigure
+ * callbacks stay on the global queue. Must be called before controllers are loaded; nullptr
+ * restores the default.
+ */
+void setCommandCallbackQueue(ros::CallbackQueue* queue);
+
+/**
+ * Copy of node_handle whose subscriptions use the command callback queue, if one was set.
+ */
+ros::NodeHandle commandNodeHandle(const ros::NodeHandle& node_handle);
+
+}  // namespace franka_ros_controllers
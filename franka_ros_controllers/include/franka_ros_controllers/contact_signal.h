@@ -0,0 +1,81 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <semaphore.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Wakes a non-real-time thread when the contact state of an arm changes.
+ *
+ * custom_franka_state_controller raises the signal from the control loop as soon as its
+ * contact predicates change, and the motion controller interface waits for it to react to a
+ * contact (e.g. by switching to a controller that holds the arm) without going through a ROS
+ * topic. Raising only stores two atomics and posts a semaphore, so it is real-time safe.
+ *
+ * One waiter per arm.
+ */
+class ContactSignal {
+ public:
+  /**
+   * Signal of arm_id, created on first use and kept for the life of the process. Not
+   * real-time safe.
+   */
+  static ContactSignal& forArm(const std::string& arm_id);
+
+  ~ContactSignal();
+  ContactSignal(const ContactSignal&) = delete;
+  ContactSignal& operator=(const ContactSignal&) = delete;
+
+  /**
+   * Control loop: publishes the new set of active predicates
+   * (franka_core_msgs::ContactEvent::SOURCE_* bits) and wakes the waiter. Real-time safe.
+   */
+  void raise(uint8_t sources);
+
+  /**
+   * Waits up to timeout seconds for a change raised since the last call.
+   *
+   * @param[out] sources Predicates active now.
+   * @param[out] onsets Number of changes from no contact to contact so far.
+   * @return False on timeout.
+   */
+  bool wait(double timeout, uint8_t& sources, uint64_t& onsets);
+
+ private:
+  ContactSignal();
+
+  sem_t semaphore_;
+  std::atomic<uint8_t> sources_{0};
+  std::atomic<uint64_t> onsets_{0};
+};
+
+}  // namespace franka_ros_controllers
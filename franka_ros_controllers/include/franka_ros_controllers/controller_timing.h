@@ -0,0 +1,109 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <franka_ros_controllers/cycle_histogram.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Process-wide registry of update() durations per controller, for breaking the control loop
+ * cost down by controller.
+ *
+ * The control node enables it before any controller is loaded; controllers then acquire a
+ * histogram by name in init() and time their update() with a ScopedUpdateTimer. When
+ * disabled, acquire() returns nullptr and the timer costs a single branch.
+ */
+class ControllerTiming {
+ public:
+  /// update() durations in microseconds, 1 us bins up to 2 ms.
+  using Histogram = CycleHistogram<2000>;
+
+  static ControllerTiming& instance();
+
+  void setEnabled(bool enabled) { enabled_.store(enabled); }
+  bool enabled() const { return enabled_.load(); }
+
+  /**
+   * Histogram for the named controller, created on first use and kept for the life of the
+   * process so that reloading a controller continues the same series. Not real-time safe.
+   *
+   * @return nullptr when timing is disabled.
+   */
+  Histogram* acquire(const std::string& controller_name);
+
+  /**
+   * Calls visitor for every registered controller. Not real-time safe.
+   */
+  void forEach(const std::function<void(const std::string&, const Histogram&)>& visitor) const;
+
+ private:
+  ControllerTiming() = default;
+
+  struct Entry {
+    explicit Entry(const std::string& name) : name(name), histogram(1.0) {}
+    std::string name;
+    Histogram histogram;
+  };
+
+  std::atomic<bool> enabled_{false};
+  mutable std::mutex mutex_;
+  std::deque<Entry> entries_;  // deque: entries never move once created
+};
+
+/**
+ * Records the lifetime of the enclosing scope into a controller's histogram, if any.
+ */
+class ScopedUpdateTimer {
+ public:
+  explicit ScopedUpdateTimer(ControllerTiming::Histogram* histogram) : histogram_(histogram) {
+    if (histogram_ != nullptr) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~ScopedUpdateTimer() {
+    if (histogram_ != nullptr) {
+      histogram_->record(std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - start_)
+                             .count());
+    }
+  }
+  ScopedUpdateTimer(const ScopedUpdateTimer&) = delete;
+  ScopedUpdateTimer& operator=(const ScopedUpdateTimer&) = delete;
+
+ private:
+  ControllerTiming::Histogram* histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace franka_ros_controllers
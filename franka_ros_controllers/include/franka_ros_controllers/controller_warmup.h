@@ -0,0 +1,68 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <franka/robot_state.h>
+#include <ros/node_handle.h>
+
+#include <franka_ros_controllers/cached_model_handle.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Warm-up of a controller's update path from init(), so that the first control cycle after
+ * switching to the controller does not run code for the first time in the process (lazy symbol
+ * binding in the controller plugin and in libfranka's model library, first use of Eigen's
+ * decompositions, cold instruction caches).
+ *
+ * Other controllers may be running while one is initialised, so a warm-up cycle must compute
+ * on a synthetic state only: hardware handles and the cache of CachedFrankaModelHandle are off
+ * limits, and the model is evaluated through its explicit-state overloads instead.
+ */
+
+/**
+ * Robot state at rest at the neutral pose of arm_id (neutral_pose in robot_config.yaml, else
+ * the middle of the joint position limits), with identity end-effector and stiffness frames,
+ * no load, and O_T_EE and the gravity torques from model.
+ *
+ * @return False if the arm has neither a neutral pose nor joint position limits.
+ */
+bool warmUpState(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                 const CachedFrankaModelHandle& model, franka::RobotState& state);
+
+/**
+ * Runs cycle ~warm_up_cycles times (default 100, 0 to disable) and reports the duration of the
+ * first and the last cycle.
+ *
+ * @return False (after reporting the error) if ~warm_up_cycles is negative.
+ */
+bool warmUp(const ros::NodeHandle& node_handle, const std::string& controller_name,
+            const std::function<void()>& cycle);
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,140 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace franka_ros_controllers {
+
+/**
+ * Lock-free histogram of real-time loop measurements (durations, jitter, rates).
+ *
+ * A single real-time writer calls record() without locking or allocating; any number of
+ * non-RT readers take snapshots with read() and turn the difference of two snapshots into
+ * windowed statistics. Values are sorted into Buckets linear bins of bucket_width, plus one
+ * overflow bin; percentiles are therefore reported as the upper edge of their bin.
+ */
+template <size_t Buckets>
+class CycleHistogram {
+ public:
+  struct Snapshot {
+    std::array<uint64_t, Buckets + 1> counts{};
+    uint64_t total{0};
+    double sum{0.0};
+    double max{0.0};  // largest value ever recorded, not only inside the window
+  };
+
+  explicit CycleHistogram(double bucket_width) : bucket_width_(bucket_width) {}
+  CycleHistogram(const CycleHistogram&) = delete;
+  CycleHistogram& operator=(const CycleHistogram&) = delete;
+
+  /**
+   * Adds a sample. Real-time safe; must only be called from one thread at a time.
+   */
+  void record(double value) {
+    size_t bucket = Buckets;
+    if (value < bucket_width_ * Buckets) {
+      bucket = value > 0.0 ? static_cast<size_t>(value / bucket_width_) : 0;
+    }
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+    total_.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   * Copies the current counters. Concurrent record() calls may leave the bins one sample
+   * apart from the total; statistics are computed from the bins.
+   */
+  void read(Snapshot& snapshot) const {
+    snapshot.total = total_.load(std::memory_order_acquire);
+    for (size_t i = 0; i <= Buckets; ++i) {
+      snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.sum = sum_.load(std::memory_order_relaxed);
+    snapshot.max = max_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Samples recorded between two snapshots of the same histogram.
+   */
+  static void difference(const Snapshot& now, const Snapshot& before, Snapshot& window) {
+    window.total = 0;
+    for (size_t i = 0; i <= Buckets; ++i) {
+      window.counts[i] = now.counts[i] - before.counts[i];
+      window.total += window.counts[i];
+    }
+    window.sum = now.sum - before.sum;
+    window.max = now.max;
+  }
+
+  /**
+   * Upper edge of the bin holding the given fraction (0..1] of the samples, or the maximum
+   * when it falls into the overflow bin. Returns 0 for an empty snapshot.
+   */
+  double percentile(const Snapshot& snapshot, double fraction) const {
+    uint64_t total = 0;
+    for (uint64_t count : snapshot.counts) {
+      total += count;
+    }
+    if (total == 0) {
+      return 0.0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * total + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < Buckets; ++i) {
+      seen += snapshot.counts[i];
+      if (seen >= rank) {
+        return std::min(bucket_width_ * (i + 1), snapshot.max);
+      }
+    }
+    return snapshot.max;
+  }
+
+  /**
+   * Largest value inside the window, to bin resolution.
+   */
+  double windowMax(const Snapshot& snapshot) const {
+    return percentile(snapshot, 1.0);
+  }
+
+  double bucketWidth() const { return bucket_width_; }
+
+ private:
+  const double bucket_width_;
+  std::array<std::atomic<uint64_t>, Buckets + 1> counts_{};
+  std::atomic<uint64_t> total_{0};
+  std::atomic<double> sum_{0.0};
+  std::atomic<double> max_{0.0};
+};
+
+}  // namespace franka_ros_controllers
@@ -37,7 +37,6 @@
 #include <franka_core_msgs/JointLimits.h>
 
 #include <franka_hw/trigger_rate.h>
-#include <realtime_tools/realtime_publisher.h>
 
 #include <controller_interface/multi_interface_controller.h>
 #include <hardware_interface/joint_command_interface.h>
@@ -45,8 +44,19 @@
 #include <hardware_interface/robot_hw.h>
 #include <ros/node_handle.h>
 #include <ros/time.h>
+#include <ros/timer.h>
 
 #include <franka_hw/franka_model_interface.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/command_batch.h>
+#include <franka_ros_controllers/cached_model_handle.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/gain_schedule.h>
+#include <franka_ros_controllers/joint_controller_state_publisher.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
+#include <franka_ros_controllers/shm_transport.h>
 
 
 namespace franka_ros_controllers {
@@ -61,21 +71,12 @@ class EffortJointImpedanceController : public controller_interface::MultiInterfa
   void update(const ros::Time&, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  std::array<double, 7> saturateTorqueRate(
-      const std::array<double, 7>& tau_d_calculated,
-      const std::array<double, 7>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  CachedFrankaModelHandle* model_handle_{nullptr};  // shared with the other controllers
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
   static constexpr double kDeltaTauMax{1.0};
 
-  double filter_params_{0.005};
-  std::vector<double> k_gains_;
-  std::vector<double> k_gains_target_;
-  std::vector<double> d_gains_;
-  std::vector<double> d_gains_target_;
+  GainSchedule<JointGains> gain_schedule_;  // set through dynamic_reconfigure
   double coriolis_factor_{1.0};
   std::array<double, 7> pos_d_;
   std::array<double, 7> initial_pos_;
@@ -84,6 +85,21 @@ class EffortJointImpedanceController : public controller_interface::MultiInterfa
   std::array<double, 7> dq_d_;
   std::array<double, 7> dq_filtered_;
 
+  struct JointSetpoint {
+    std::array<double, 7> position;
+    std::array<double, 7> velocity;
+    bool hold;  // invalid command received: hold the last measured position
+  };
+  SetpointChannel<JointSetpoint> setpoint_channel_;
+  ControllerTiming::Histogram* update_timing_{nullptr};
+
+  // Optional same-host command source, polled in update() (see shm_transport.h)
+  shm::Transport shm_transport_;
+  shm::CommandSample shm_command_{};
+  double shm_command_timeout_{0.2};  // /controllers_config/command_timeout
+  shm::CommandEvents shm_events_;
+  ros::Timer shm_report_timer_;
+  void reportShmEvents(const ros::TimerEvent&);
 
   franka_hw::FrankaStateInterface* franka_state_interface_{};
   std::unique_ptr<franka_hw::FrankaStateHandle> franka_state_handle_{};
@@ -92,20 +108,24 @@ class EffortJointImpedanceController : public controller_interface::MultiInterfa
   std::array<double, 7> last_tau_d_{};
 
   ros::Subscriber desired_joints_subscriber_;
+  ros::Subscriber command_batch_subscriber_;
+  JointCommandBatchQueue command_batch_;
   std::unique_ptr< dynamic_reconfigure::Server<franka_ros_controllers::joint_controller_paramsConfig> > dynamic_server_controller_config_;
   ros::NodeHandle dynamic_reconfigure_controller_gains_node_;
 
   franka_core_msgs::JointLimits joint_limits_;
 
-  franka_hw::TriggerRate trigger_publish_;
-  realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> publisher_controller_states_;
+  JointControllerStatePublisher controller_state_publisher_;
 
-  bool checkPositionLimits(std::vector<double> positions);
-  bool checkVelocityLimits(std::vector<double> positions);
+  template <typename Container>
+  bool checkPositionLimits(const Container& positions);
+  template <typename Container>
+  bool checkVelocityLimits(const Container& velocities);
 
   void controllerConfigCallback(franka_ros_controllers::joint_controller_paramsConfig& config,
                                uint32_t level);
   void jointCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg);
+  void jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg);
 };
 
 }  // namespace franka_ros_controllers
\ No newline at end of file
@@ -36,7 +36,14 @@
 #include <franka_core_msgs/JointLimits.h>
 
 #include <franka_hw/trigger_rate.h>
-#include <realtime_tools/realtime_publisher.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/command_batch.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/gain_schedule.h>
+#include <franka_ros_controllers/joint_controller_state_publisher.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
 
 #include <controller_interface/multi_interface_controller.h>
 #include <hardware_interface/joint_command_interface.h>
@@ -57,20 +64,11 @@ class EffortJointPositionController : public controller_interface::MultiInterfac
   void update(const ros::Time&, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  std::array<double, 7> saturateTorqueRate(
-      const std::array<double, 7>& tau_d_calculated,
-      const std::array<double, 7>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
   static constexpr double kDeltaTauMax{1.0};
 
-  double filter_params_{0.005};
-  std::vector<double> k_gains_;
-  std::vector<double> k_gains_target_;
-  std::vector<double> d_gains_;
-  std::vector<double> d_gains_target_;
+  GainSchedule<JointGains> gain_schedule_;  // set through dynamic_reconfigure
   double coriolis_factor_{1.0};
   std::array<double, 7> pos_d_;
   std::array<double, 7> initial_pos_;
@@ -78,6 +76,13 @@ class EffortJointPositionController : public controller_interface::MultiInterfac
   std::array<double, 7> pos_d_target_;
   std::array<double, 7> d_error_;
   std::array<double, 7> p_error_last_;
+
+  struct JointSetpoint {
+    std::array<double, 7> position;
+    bool hold;  // invalid command received: hold the last measured position
+  };
+  SetpointChannel<JointSetpoint> setpoint_channel_;
+  ControllerTiming::Histogram* update_timing_{nullptr};
   
   franka_hw::FrankaStateInterface* franka_state_interface_{};
   std::unique_ptr<franka_hw::FrankaStateHandle> franka_state_handle_{};
@@ -85,19 +90,22 @@ class EffortJointPositionController : public controller_interface::MultiInterfac
   franka_hw::TriggerRate rate_trigger_{1.0};
   
   ros::Subscriber desired_joints_subscriber_;
+  ros::Subscriber command_batch_subscriber_;
+  JointCommandBatchQueue command_batch_;
   std::unique_ptr< dynamic_reconfigure::Server<franka_ros_controllers::joint_controller_paramsConfig> > dynamic_server_controller_config_;
   ros::NodeHandle dynamic_reconfigure_controller_gains_node_;
 
   franka_core_msgs::JointLimits joint_limits_;
 
-  franka_hw::TriggerRate trigger_publish_;
-  realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> publisher_controller_states_;
+  JointControllerStatePublisher controller_state_publisher_;
 
-  bool checkPositionLimits(std::vector<double> positions);
+  template <typename Container>
+  bool checkPositionLimits(const Container& positions);
 
   void controllerConfigCallback(franka_ros_controllers::joint_controller_paramsConfig& config,
                                uint32_t level);
   void jointCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg);
+  void jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg);
 };
 
 }  // namespace franka_ros_controllers
\ No newline at end of file
@@ -35,21 +35,32 @@
 #include <franka_core_msgs/JointLimits.h>
 
 #include <franka_hw/trigger_rate.h>
-#include <realtime_tools/realtime_publisher.h>
 
 #include <controller_interface/multi_interface_controller.h>
 #include <hardware_interface/joint_command_interface.h>
 #include <hardware_interface/robot_hw.h>
 #include <ros/node_handle.h>
 #include <ros/time.h>
+#include <ros/timer.h>
 #include <mutex>
 
 #include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/command_batch.h>
+#include <franka_ros_controllers/cached_model_handle.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/joint_controller_state_publisher.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
+#include <franka_ros_controllers/shm_transport.h>
 
 namespace franka_ros_controllers {
 
 class EffortJointTorqueController : public controller_interface::MultiInterfaceController<
                                             franka_hw::FrankaModelInterface,
+                                            franka_hw::FrankaStateInterface,
                                             hardware_interface::EffortJointInterface> {
  public:
   bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
@@ -57,12 +68,7 @@ class EffortJointTorqueController : public controller_interface::MultiInterfaceC
   void update(const ros::Time&, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  static std::array<double, 7> saturateTorqueRate(
-      const std::array<double, 7>& tau_d_calculated,
-      const std::array<double, 7>& prev_tau);  // NOLINT (readability-identifier-naming)
-
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  CachedFrankaModelHandle* model_handle_{nullptr};  // shared with the other controllers
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
   static constexpr double kDeltaTauMax{1.0};
@@ -71,20 +77,38 @@ class EffortJointTorqueController : public controller_interface::MultiInterfaceC
   std::array<double, 7> jnt_cmd_{};
   std::array<double, 7> prev_jnt_cmd_{};
 
+  struct TorqueSetpoint {
+    std::array<double, 7> effort;
+    bool hold;  // invalid command received: hold the last commanded torque
+  };
+  SetpointChannel<TorqueSetpoint> setpoint_channel_;
+  ControllerTiming::Histogram* update_timing_{nullptr};
+
+  // Optional same-host command source, polled in update() (see shm_transport.h)
+  shm::Transport shm_transport_;
+  shm::CommandSample shm_command_{};
+  double shm_command_timeout_{0.2};  // /controllers_config/command_timeout
+  shm::CommandEvents shm_events_;
+  ros::Timer shm_report_timer_;
+  void reportShmEvents(const ros::TimerEvent&);
+
 
   franka_hw::TriggerRate rate_trigger_{1.0};
   std::array<double, 7> last_tau_d_{};
 
   ros::Subscriber desired_joints_subscriber_;
+  ros::Subscriber command_batch_subscriber_;
+  JointCommandBatchQueue command_batch_;
 
   franka_core_msgs::JointLimits joint_limits_;
 
-  franka_hw::TriggerRate trigger_publish_;
-  realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> publisher_controller_states_;
+  JointControllerStatePublisher controller_state_publisher_;
 
-  bool checkTorqueLimits(std::vector<double> torques);
+  template <typename Container>
+  bool checkTorqueLimits(const Container& torques);
 
   void jointCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg);
+  void jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg);
 };
 
 }  // namespace franka_ros_controllers
\ No newline at end of file
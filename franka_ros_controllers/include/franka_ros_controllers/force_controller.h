@@ -18,6 +18,13 @@
 #include <Eigen/Core>
 
 #include <franka_ros_controllers/desired_mass_paramConfig.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/cached_model_handle.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/gain_schedule.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
 
 namespace franka_ros_controllers {
 
@@ -31,24 +38,28 @@ class ForceController : public controller_interface::MultiInterfaceController<
   void update(const ros::Time&, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  Eigen::Matrix<double, 7, 1> saturateTorqueRate(
-      const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-      const Eigen::Matrix<double, 7, 1>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  CachedFrankaModelHandle* model_handle_{nullptr};  // shared with the other controllers
   std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
-  //double desired_mass_{0.0};
-  //double target_mass_{0.0};
-  Eigen::Matrix<double, 6, 1> desired_mass_;
-  Eigen::Matrix<double, 6, 1> target_mass_;
+  struct ForceParameters {
+    Eigen::Matrix<double, 6, 1> wrench;  // desired wrench
+    double k_p;
+    double k_i;
+
+    friend ForceParameters interpolate(const ForceParameters& from,
+                                       const ForceParameters& to,
+                                       double s) {
+      return ForceParameters{interpolate(from.wrench, to.wrench, s),
+                             interpolate(from.k_p, to.k_p, s), interpolate(from.k_i, to.k_i, s)};
+    }
+  };
+  GainSchedule<ForceParameters> schedule_;
+  GainTransition gain_transition_{TransitionProfile::kExponential, 5.0};
+  ControllerTiming::Histogram* update_timing_{nullptr};
+  // PI gains of the force error, fixed after init()
   double k_p_{0.0};
   double k_i_{0.0};
-  double target_k_p_{0.0};
-  double target_k_i_{0.0};
-  double filter_gain_{0.001};
   Eigen::Matrix<double, 7, 1> tau_ext_initial_;
   Eigen::Matrix<double, 7, 1> tau_error_;
   static constexpr double kDeltaTauMax{1.0};
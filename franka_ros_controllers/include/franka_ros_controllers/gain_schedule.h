@@ -0,0 +1,245 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <ros/node_handle.h>
+
+#include <franka_ros_controllers/setpoint_channel.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Shape of a parameter transition of GainSchedule over its duration.
+ */
+enum class TransitionProfile : uint8_t {
+  kStep,         // the target applies at once
+  kLinear,       // constant rate of change
+  kMinimumJerk,  // quintic, with zero rate of change and acceleration at both ends
+  kExponential,  // first-order approach (time constant duration / 5), ending at the duration
+};
+
+// Parses "step", "linear", "min_jerk" or "exponential"; returns false (leaving profile
+// untouched) otherwise.
+bool transitionProfileFromString(const std::string& name, TransitionProfile& profile);
+
+/**
+ * Transition applied when a controller receives new parameters without an explicit one.
+ */
+struct GainTransition {
+  TransitionProfile profile{TransitionProfile::kExponential};
+  double duration{1.0};  // seconds
+};
+
+/**
+ * Reads ~gain_transition/profile and ~gain_transition/duration, keeping the values already in
+ * transition for missing entries.
+ *
+ * @return False (after reporting the error) if either value is invalid.
+ */
+bool readGainTransition(const ros::NodeHandle& node_handle,
+                        const std::string& controller_name,
+                        GainTransition& transition);
+
+/**
+ * Transition requested through the transition_profile and transition_time fields of the
+ * franka_core_msgs stiffness messages (PROFILE_DEFAULT selects default_transition).
+ *
+ * @return False if profile is not one of the PROFILE_* constants.
+ */
+bool transitionFromMessage(uint8_t profile,
+                           double time,
+                           const GainTransition& default_transition,
+                           GainTransition& transition);
+
+/**
+ * Fraction of a transition of the given profile that is completed after elapsed of duration
+ * seconds, in [0, 1]. Real-time safe.
+ */
+inline double transitionFraction(TransitionProfile profile, double elapsed, double duration) {
+  if (profile == TransitionProfile::kStep || duration <= 0.0 || elapsed >= duration) {
+    return 1.0;
+  }
+  const double u = elapsed <= 0.0 ? 0.0 : elapsed / duration;
+  switch (profile) {
+    case TransitionProfile::kLinear:
+      return u;
+    case TransitionProfile::kMinimumJerk:
+      return u * u * u * (10.0 + u * (-15.0 + u * 6.0));
+    case TransitionProfile::kExponential: {
+      constexpr double kRate = 5.0;
+      return (1.0 - std::exp(-kRate * u)) / (1.0 - std::exp(-kRate));
+    }
+    default:
+      return 1.0;
+  }
+}
+
+// Interpolation between two parameter sets at fraction s, used by GainSchedule. Parameter
+// structs add an overload (e.g. as a friend) built from these.
+
+inline double interpolate(double from, double to, double s) { return from + s * (to - from); }
+
+template <size_t N>
+std::array<double, N> interpolate(const std::array<double, N>& from,
+                                  const std::array<double, N>& to,
+                                  double s) {
+  std::array<double, N> result;
+  for (size_t i = 0; i < N; ++i) {
+    result[i] = from[i] + s * (to[i] - from[i]);
+  }
+  return result;
+}
+
+template <int Rows, int Cols>
+Eigen::Matrix<double, Rows, Cols> interpolate(const Eigen::Matrix<double, Rows, Cols>& from,
+                                              const Eigen::Matrix<double, Rows, Cols>& to,
+                                              double s) {
+  static_assert(Rows != Eigen::Dynamic && Cols != Eigen::Dynamic,
+                "parameters are interpolated in the control loop and must be fixed-size");
+  return from + s * (to - from);
+}
+
+// Spherical linear interpolation along the shorter arc.
+inline Eigen::Quaterniond interpolate(const Eigen::Quaterniond& from,
+                                      const Eigen::Quaterniond& to,
+                                      double s) {
+  return from.slerp(s, to);
+}
+
+/**
+ * Stiffness and damping of the seven joints of a joint-space controller.
+ */
+struct JointGains {
+  std::array<double, 7> k{};
+  std::array<double, 7> d{};
+};
+
+inline JointGains interpolate(const JointGains& from, const JointGains& to, double s) {
+  return JointGains{interpolate(from.k, to.k, s), interpolate(from.d, to.d, s)};
+}
+
+/**
+ * Real-time safe scheduling of controller parameters (gains, stiffness, ...).
+ *
+ * Non-RT threads (dynamic_reconfigure, subscriber callbacks) request a new parameter set
+ * together with the profile and duration of the transition to it; the request is handed over
+ * through a SetpointChannel, so the control loop never observes a half-written set. The
+ * control loop calls updateFromRT() once per cycle, which blends from the parameters in effect
+ * when the request arrived to the requested ones, reaching them exactly after the requested
+ * duration. A request arriving during a transition starts the next transition from wherever
+ * the current one got to.
+ *
+ * Derived quantities (e.g. critical damping from a stiffness) belong in Params and are
+ * computed by the requester, so the control loop only interpolates. Params must be copyable
+ * without allocating and have an interpolate(from, to, s) overload found by name lookup.
+ */
+template <typename Params>
+class GainSchedule {
+ public:
+  /**
+   * Sets the parameters at once and discards pending requests. Must not be called
+   * concurrently with updateFromRT(), e.g. only from init() or starting().
+   */
+  void reset(const Params& params) {
+    requests_.clearFromRT();
+    start_ = params;
+    target_ = params;
+    current_ = params;
+    active_ = false;
+  }
+
+  /**
+   * Requests a transition to new parameters. Must not be called from the real-time thread.
+   *
+   * @param[in] target Parameters to reach.
+   * @param[in] transition Profile and duration of the transition.
+   */
+  void requestFromNonRT(const Params& target, const GainTransition& transition) {
+    requests_.writeFromNonRT(Request{target, transition});
+  }
+
+  /**
+   * Advances the schedule by one control cycle.
+   *
+   * @param[in] period Time since the previous call in seconds.
+   * @return Parameters to use in this cycle.
+   */
+  const Params& updateFromRT(double period) {
+    Request request;
+    if (requests_.readFromRT(request)) {
+      start_ = current_;
+      target_ = request.target;
+      transition_ = request.transition;
+      elapsed_ = 0.0;
+      active_ = true;
+    } else if (active_) {
+      elapsed_ += period;
+    }
+    if (active_) {
+      const double s = transitionFraction(transition_.profile, elapsed_, transition_.duration);
+      if (s >= 1.0) {
+        current_ = target_;
+        active_ = false;
+      } else {
+        current_ = interpolate(start_, target_, s);
+      }
+    }
+    return current_;
+  }
+
+  /** @return Parameters returned by the last updateFromRT(). */
+  const Params& current() const { return current_; }
+
+  /** @return Parameters the running (or last) transition leads to. */
+  const Params& target() const { return target_; }
+
+  /** @return True while a transition is in progress. */
+  bool transitioning() const { return active_; }
+
+ private:
+  struct Request {
+    Params target;
+    GainTransition transition;
+  };
+
+  SetpointChannel<Request> requests_;
+  Params start_{};
+  Params target_{};
+  Params current_{};
+  GainTransition transition_{};
+  double elapsed_{0.0};
+  bool active_{false};
+};
+
+}  // namespace franka_ros_controllers
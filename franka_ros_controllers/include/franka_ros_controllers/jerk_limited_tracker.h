@@ -0,0 +1,91 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <array>
+#include <string>
+
+#include <franka_core_msgs/JointLimits.h>
+#include <ros/node_handle.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Follows a joint-space reference (position, velocity and acceleration feed-forward) within
+ * per-joint velocity, acceleration and jerk limits, re-planning the next step from its own
+ * state every cycle. The position error is turned into a velocity correction that is linear
+ * near the reference and a square-root (constant deceleration) law further away, so the
+ * joints brake in time instead of overshooting; the velocity error gives the acceleration, and
+ * the jerk needed to reach it within the cycle is clamped. The acceleration is also kept low
+ * enough to ramp down within the jerk limit before the velocity limit is reached. A reference
+ * within the limits is followed by its feed-forward terms without lag, while jumps (e.g. a new
+ * horizon that does not start where the previous one was) are smoothed. Real-time safe after
+ * init().
+ */
+class JerkLimitedTracker {
+ public:
+  /**
+   * Reads ~horizon_tracking/bandwidth and ~horizon_tracking/limit_scale and takes the joint
+   * velocity, acceleration and jerk limits from limits (see RobotConfig::jointLimits()).
+   *
+   * @return False (after reporting the error) if a value is missing or invalid.
+   */
+  bool init(const ros::NodeHandle& node_handle,
+            const franka_core_msgs::JointLimits& limits,
+            const std::string& controller_name);
+
+  /// Restarts from the given state with zero acceleration.
+  void reset(const std::array<double, 7>& position, const std::array<double, 7>& velocity);
+
+  /// Advances the state by period towards a position reference.
+  void updatePosition(const std::array<double, 7>& position,
+                      const std::array<double, 7>& velocity,
+                      const std::array<double, 7>& acceleration,
+                      double period);
+
+  /// Advances the state by period towards a velocity reference; the position is integrated.
+  void updateVelocity(const std::array<double, 7>& velocity,
+                      const std::array<double, 7>& acceleration,
+                      double period);
+
+  const std::array<double, 7>& position() const { return position_; }
+  const std::array<double, 7>& velocity() const { return velocity_; }
+  const std::array<double, 7>& acceleration() const { return acceleration_; }
+
+ private:
+  void step(size_t joint, double acceleration, double period);
+
+  double bandwidth_{30.0};  // rad/s, of the linear region
+  std::array<double, 7> velocity_limit_{};
+  std::array<double, 7> acceleration_limit_{};
+  std::array<double, 7> jerk_limit_{};
+
+  std::array<double, 7> position_{};
+  std::array<double, 7> velocity_{};
+  std::array<double, 7> acceleration_{};
+};
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,96 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <franka_core_msgs/JointControllerStates.h>
+#include <franka_core_msgs/JointControllerStatesBatch.h>
+#include <ros/node_handle.h>
+#include <ros/publisher.h>
+#include <ros/time.h>
+
+#include <franka_ros_controllers/telemetry.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * State of a joint-space controller in one control cycle; fields a controller does not set
+ * stay zero.
+ */
+struct JointControllerSample {
+  ros::Time stamp;
+  double time_step{0.0};
+  std::array<double, 7> set_point{};
+  std::array<double, 7> process_value{};
+  std::array<double, 7> process_value_dot{};
+  std::array<double, 7> error{};
+  std::array<double, 7> command{};
+  std::array<double, 7> p{};
+  std::array<double, 7> d{};
+};
+
+/**
+ * Publishes the state of a joint-space controller from the telemetry thread.
+ *
+ * The controller fills one preallocated JointControllerSample per cycle. The telemetry thread
+ * publishes them as franka_core_msgs/JointControllerStates on <topic> at publish_rate, and
+ * every cycle, in batches of /robot_config/controller_telemetry/batch_size cycles, as
+ * franka_core_msgs/JointControllerStatesBatch on <topic>_batch while it has subscribers.
+ * Cycles lost because the queue (/robot_config/controller_telemetry/queue_capacity) was full
+ * are counted in the batch messages and logged.
+ */
+class JointControllerStatePublisher {
+ public:
+  void init(ros::NodeHandle& node_handle, const std::string& topic,
+            const std::string& controller_name, const std::vector<std::string>& joint_names,
+            double publish_rate);
+
+  /**
+   * Slot for this cycle's state, or nullptr if the sample has to be dropped. Pass it on with
+   * commit(). Real-time safe.
+   */
+  JointControllerSample* claim() { return channel_.claim(); }
+  void commit() { channel_.commit(); }
+
+ private:
+  void publish(const std::vector<JointControllerSample>& batch, uint64_t dropped);
+
+  ros::Publisher publisher_;
+  ros::Publisher batch_publisher_;
+  franka_core_msgs::JointControllerStates msg_;
+  franka_core_msgs::JointControllerStatesBatch batch_msg_;
+  ros::Duration publish_period_;
+  ros::Time last_publish_;
+  uint64_t dropped_{0};
+  // last: stops draining before the publishers and messages go away
+  TelemetryChannel<JointControllerSample> channel_;
+};
+
+}  // namespace franka_ros_controllers
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -11,37 +12,43 @@
 #include <controller_interface/multi_interface_controller.h>
 #include <hardware_interface/joint_command_interface.h>
 #include <hardware_interface/robot_hw.h>
-#include <realtime_tools/realtime_publisher.h>
 #include <ros/node_handle.h>
 #include <ros/time.h>
 
 #include <franka_ros_controllers/JointTorqueComparison.h>
 #include <franka_hw/franka_cartesian_command_interface.h>
 #include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
 #include <franka_hw/trigger_rate.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/cached_model_handle.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/gain_schedule.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
+#include <franka_ros_controllers/telemetry.h>
+#include <franka_ros_controllers/trajectory_buffer.h>
 
 #include <franka_core_msgs/JICmd.h>
 #include <franka_core_msgs/JointImpedanceStiffness.h>
+#include <franka_core_msgs/JointImpedanceTrajectory.h>
 
 namespace franka_ros_controllers {
 
 class JointImpedanceController : public controller_interface::MultiInterfaceController<
                                             franka_hw::FrankaModelInterface,
                                             hardware_interface::EffortJointInterface,
-                                            franka_hw::FrankaPoseCartesianInterface> {
+                                            franka_hw::FrankaPoseCartesianInterface,
+                                            franka_hw::FrankaStateInterface> {
  public:
   bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
   void starting(const ros::Time&) override;
-  void update(const ros::Time&, const ros::Duration& period) override;
+  void update(const ros::Time& time, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  std::array<double, 7> saturateTorqueRate(
-      const std::array<double, 7>& tau_d_calculated,
-      const std::array<double, 7>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
   std::unique_ptr<franka_hw::FrankaCartesianPoseHandle> cartesian_pose_handle_;
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  CachedFrankaModelHandle* model_handle_{nullptr};  // shared with the other controllers
   std::vector<hardware_interface::JointHandle> joint_handles_;
   franka_core_msgs::JointLimits joint_limits_;
 
@@ -52,8 +59,9 @@ class JointImpedanceController : public controller_interface::MultiInterfaceCont
   double angle_{0.0};
   double vel_current_{0.0};
 
-  std::vector<double> k_gains_;
-  std::vector<double> d_gains_;
+  GainSchedule<JointGains> gain_schedule_;
+  // used for stiffness messages with PROFILE_DEFAULT
+  GainTransition default_gain_transition_{TransitionProfile::kStep, 0.0};
   double coriolis_factor_{1.0};
   std::array<double, 7> dq_filtered_;
   std::array<double, 16> initial_pose_;
@@ -65,16 +73,54 @@ class JointImpedanceController : public controller_interface::MultiInterfaceCont
   std::array<double, 7> dq_d_;
   //std::array<double, 7> dq_filtered_;
 
+  struct JointSetpoint {
+    std::array<double, 7> position;
+    std::array<double, 7> velocity;
+  };
+  SetpointChannel<JointSetpoint> setpoint_channel_;
+
+  struct JointTrajectoryPoint {
+    std::array<double, 7> position;
+    std::array<double, 7> velocity;
+    std::array<double, 7> acceleration;
+    double duration;  // seconds after the previous point
+    double start;     // header stamp of a new trajectory in seconds, 0 to start on arrival
+    bool quintic;
+  };
+  static constexpr size_t kTrajectoryCapacity{1024};  // points per message
+  // room for a new trajectory next to the one being tracked
+  TrajectoryBuffer<JointTrajectoryPoint, 2 * kTrajectoryCapacity> trajectory_;
+  std::mutex trajectory_chunk_mutex_;
+  std::vector<JointTrajectoryPoint> trajectory_chunk_;
+  // control loop side
+  JointTrajectoryPoint segment_start_{};
+  double segment_start_time_{0.0};
+  bool trajectory_active_{false};
+  bool trajectory_idle_{false};
+  ControllerTiming::Histogram* update_timing_{nullptr};
+
   franka_hw::TriggerRate rate_trigger_{1.0};
   std::array<double, 7> last_tau_d_{};
-  realtime_tools::RealtimePublisher<JointTorqueComparison> torques_publisher_;
+  struct TorqueComparisonSample {
+    std::array<double, 7> tau_error;
+    std::array<double, 7> tau_commanded;
+    std::array<double, 7> tau_measured;
+    double root_mean_square_error;
+  };
+  ros::Publisher torques_publisher_;
+  JointTorqueComparison torques_msg_;  // telemetry thread only
+  // after the publisher, so that it stops draining first
+  TelemetryChannel<TorqueComparisonSample> torques_channel_;
 
   ros::Subscriber desired_joints_subscriber_;
   ros::Subscriber stiffness_params_;
+  ros::Subscriber trajectory_subscriber_;
   bool checkPositionLimits(std::vector<double> positions);
   bool checkVelocityLimits(std::vector<double> positions);
   void jointCmdCallback(const franka_core_msgs::JICmd& msg);
   void stiffnessParamCallback(const franka_core_msgs::JointImpedanceStiffness& msg);
+  void trajectoryCallback(const franka_core_msgs::JointImpedanceTrajectory& msg);
+  void updateTrajectory(const ros::Time& time);
 
 };
 
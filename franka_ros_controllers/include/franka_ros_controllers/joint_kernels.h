@@ -0,0 +1,137 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace franka_ros_controllers {
+
+/**
+ * Fixed-size 7-DOF kernels shared by the joint-space control loops. They are written as
+ * coefficient-wise Eigen expressions on fixed-size vectors (min/max instead of branches), so
+ * the compiler unrolls and vectorises them. std::array, C arrays and std::vector are viewed
+ * in place through Eigen::Map with mapJoints(); nothing is copied or allocated.
+ */
+using JointVector = Eigen::Matrix<double, 7, 1>;
+
+inline Eigen::Map<JointVector> mapJoints(std::array<double, 7>& values) {
+  return Eigen::Map<JointVector>(values.data());
+}
+
+inline Eigen::Map<const JointVector> mapJoints(const std::array<double, 7>& values) {
+  return Eigen::Map<const JointVector>(values.data());
+}
+
+inline Eigen::Map<const JointVector> mapJoints(const double (&values)[7]) {
+  return Eigen::Map<const JointVector>(values);
+}
+
+/** The vector must have (at least) 7 elements. */
+inline Eigen::Map<const JointVector> mapJoints(const std::vector<double>& values) {
+  return Eigen::Map<const JointVector>(values.data());
+}
+
+/**
+ * PD law with Coriolis compensation:
+ * coriolis_factor * coriolis + k * (q_d - q) + d * (dq_d - dq), per joint.
+ */
+template <typename QD, typename Q, typename DQD, typename DQ, typename K, typename D, typename C>
+JointVector pdCoriolisTorque(const Eigen::MatrixBase<QD>& q_d,
+                             const Eigen::MatrixBase<Q>& q,
+                             const Eigen::MatrixBase<DQD>& dq_d,
+                             const Eigen::MatrixBase<DQ>& dq,
+                             const Eigen::MatrixBase<K>& k,
+                             const Eigen::MatrixBase<D>& d,
+                             const Eigen::MatrixBase<C>& coriolis,
+                             double coriolis_factor) {
+  return coriolis_factor * coriolis + k.cwiseProduct(q_d - q) + d.cwiseProduct(dq_d - dq);
+}
+
+/** PD law on a given error and error rate: k * error + d * error_dot, per joint. */
+template <typename E, typename ED, typename K, typename D>
+JointVector pdTorque(const Eigen::MatrixBase<E>& error,
+                     const Eigen::MatrixBase<ED>& error_dot,
+                     const Eigen::MatrixBase<K>& k,
+                     const Eigen::MatrixBase<D>& d) {
+  return k.cwiseProduct(error) + d.cwiseProduct(error_dot);
+}
+
+/**
+ * Exponential moving average: filtered = (1 - alpha) * filtered + alpha * sample. alpha = 1
+ * passes the sample through.
+ */
+template <typename F, typename S>
+void exponentialFilter(const Eigen::MatrixBase<F>& filtered,
+                       const Eigen::MatrixBase<S>& sample,
+                       double alpha) {
+  // the usual Eigen idiom for writing through an expression (Map) passed by const reference
+  Eigen::MatrixBase<F>& out = const_cast<Eigen::MatrixBase<F>&>(filtered);
+  out = (1.0 - alpha) * out + alpha * sample;
+}
+
+/**
+ * Limits the change of the commanded torque from tau_last (the last commanded or desired
+ * torque) to delta_tau_max per joint and cycle.
+ */
+template <typename T, typename L>
+JointVector saturateTorqueRate(const Eigen::MatrixBase<T>& tau_d,
+                               const Eigen::MatrixBase<L>& tau_last,
+                               double delta_tau_max) {
+  return tau_last + (tau_d - tau_last).array().min(delta_tau_max).max(-delta_tau_max).matrix();
+}
+
+inline std::array<double, 7> saturateTorqueRate(const std::array<double, 7>& tau_d,
+                                                const std::array<double, 7>& tau_last,
+                                                double delta_tau_max) {
+  std::array<double, 7> tau_saturated;
+  mapJoints(tau_saturated) = saturateTorqueRate(mapJoints(tau_d), mapJoints(tau_last), delta_tau_max);
+  return tau_saturated;
+}
+
+/** True if lower <= values <= upper for every joint (false for NaN). */
+template <typename V, typename L, typename U>
+bool withinLimits(const Eigen::MatrixBase<V>& values,
+                  const Eigen::MatrixBase<L>& lower,
+                  const Eigen::MatrixBase<U>& upper) {
+  return ((values.array() >= lower.array()) && (values.array() <= upper.array())).all();
+}
+
+/** True if |values| <= limit for every joint (false for NaN). */
+template <typename V, typename L>
+bool withinMagnitude(const Eigen::MatrixBase<V>& values, const Eigen::MatrixBase<L>& limit) {
+  return (values.array().abs() <= limit.array()).all();
+}
+
+/** True if |values| < limit for every joint (false for NaN). */
+template <typename V, typename L>
+bool belowMagnitude(const Eigen::MatrixBase<V>& values, const Eigen::MatrixBase<L>& limit) {
+  return (values.array().abs() < limit.array()).all();
+}
+
+}  // namespace franka_ros_controllers
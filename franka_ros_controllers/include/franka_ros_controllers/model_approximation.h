@@ -0,0 +1,81 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <array>
+#include <map>
+#include <string>
+
+#include <franka/model.h>
+#include <franka/robot_state.h>
+#include <hardware_interface/hardware_interface.h>
+
+namespace franka_ros_controllers {
+
+/**
+ * Model quantities for an explicit robot state, standing in for the libfranka model where no
+ * robot is available to load it from (e.g. when replaying a recording offline, see
+ * franka_interface/replay_robot_hw.h). Arrays are column-major, as in franka::Model.
+ */
+class ModelApproximation {
+ public:
+  virtual ~ModelApproximation() = default;
+
+  virtual std::array<double, 49> mass(const franka::RobotState& state) const = 0;
+  virtual std::array<double, 7> coriolis(const franka::RobotState& state) const = 0;
+  virtual std::array<double, 7> gravity(const franka::RobotState& state) const = 0;
+  virtual std::array<double, 16> pose(franka::Frame frame,
+                                      const franka::RobotState& state) const = 0;
+  virtual std::array<double, 42> bodyJacobian(franka::Frame frame,
+                                              const franka::RobotState& state) const = 0;
+  virtual std::array<double, 42> zeroJacobian(franka::Frame frame,
+                                              const franka::RobotState& state) const = 0;
+};
+
+/**
+ * Hardware interface through which a RobotHW provides a ModelApproximation per arm. When it is
+ * registered, CachedFrankaModelHandle evaluates the approximation instead of the
+ * franka_hw::FrankaModelInterface handle, which then only has to be registered (empty) for the
+ * controllers' interface checks.
+ */
+class ModelApproximationInterface : public hardware_interface::HardwareInterface {
+ public:
+  /** model has to outlive the interface. */
+  void registerModel(const std::string& arm_id, const ModelApproximation& model) {
+    models_[arm_id] = &model;
+  }
+
+  /** @return The approximation of arm_id, or nullptr if there is none. */
+  const ModelApproximation* getModel(const std::string& arm_id) const {
+    auto model = models_.find(arm_id);
+    return model == models_.end() ? nullptr : model->second;
+  }
+
+ private:
+  std::map<std::string, const ModelApproximation*> models_;
+};
+
+}  // namespace franka_ros_controllers
@@ -20,6 +20,12 @@
 
 #include <franka_ros_controllers/desired_mass_paramConfig.h>
 #include <franka_core_msgs/TorqueCmd.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/cached_model_handle.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
 
 namespace franka_ros_controllers {
 
@@ -33,19 +39,17 @@ class NTorqueController : public controller_interface::MultiInterfaceController<
   void update(const ros::Time&, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  Eigen::Matrix<double, 7, 1> saturateTorqueRate(
-      const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-      const Eigen::Matrix<double, 7, 1>& tau_J_d);  // NOLINT (readability-identifier-naming)
   bool checkTorqueLimits(std::vector<double> torques);
 
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  CachedFrankaModelHandle* model_handle_{nullptr};  // shared with the other controllers
   std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
   std::vector<hardware_interface::JointHandle> joint_handles_;
   franka_core_msgs::JointLimits joint_limits_;
 
   Eigen::Matrix<double, 7, 1> desired_torque_;
   Eigen::Matrix<double, 7, 1> target_torque_;
+  SetpointChannel<Eigen::Matrix<double, 7, 1>> torque_channel_;
+  ControllerTiming::Histogram* update_timing_{nullptr};
   double k_p_{0.0};
   double k_i_{0.0};
   double target_k_p_{0.0};
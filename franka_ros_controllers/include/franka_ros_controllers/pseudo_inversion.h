@@ -0,0 +1,171 @@
+// Author: Enrico Corvaglia
+// https://github.com/CentroEPiaggio/kuka-lwr/blob/master/lwr_controllers/include/utils/pseudo_inversion.h
+// File provided under public domain
+// pseudo_inverse() computes the pseudo inverse of matrix M_ using SVD decomposition (can choose
+// between damped and not)
+// returns the pseudo inverted matrix M_pinv_
+
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <Eigen/LU>
+#include <Eigen/SVD>
+
+inline void pseudoInverse(const Eigen::MatrixXd& M_, Eigen::MatrixXd& M_pinv_, bool damped = true) {
+  double lambda_ = damped ? 0.2 : 0.0;
+
+  Eigen::JacobiSVD<Eigen::MatrixXd> svd(M_, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Eigen::JacobiSVD<Eigen::MatrixXd>::SingularValuesType sing_vals_ = svd.singularValues();
+  Eigen::MatrixXd S_ = M_;  // copying the dimensions of M_, its content is not needed.
+  S_.setZero();
+
+  for (int i = 0; i < sing_vals_.size(); i++)
+    S_(i, i) = (sing_vals_(i)) / (sing_vals_(i) * sing_vals_(i) + lambda_ * lambda_);
+
+  M_pinv_ = Eigen::MatrixXd(svd.matrixV() * S_.transpose() * svd.matrixU().transpose());
+}
+
+// Fixed-size variants for the real-time loop: all temporaries live on the stack, so none of
+// them allocates (e.g. Rows = 7, Cols = 6 for the transposed Jacobian). All three compute the
+// damped pseudo inverse V * diag(s / (s^2 + lambda^2)) * U^T and differ in cost and in how the
+// damping is chosen.
+enum class PseudoInverseMethod {
+  kSvd,                 // Jacobi SVD with constant damping; the reference, and the slowest
+  kDampedLeastSquares,  // LDLT solve of the damped Gram matrix; needs damping > 0
+  kAdaptiveDamping,     // damping faded in only when the smallest singular value gets small
+};
+
+struct PseudoInverseParams {
+  PseudoInverseMethod method{PseudoInverseMethod::kSvd};
+  double damping{0.2};             // lambda; maximum damping for kAdaptiveDamping
+  double singular_threshold{0.1};  // kAdaptiveDamping: singular value below which damping starts
+};
+
+// Parses "svd", "dls" or "adaptive"; returns false (leaving method untouched) otherwise.
+inline bool pseudoInverseMethodFromString(const std::string& name, PseudoInverseMethod& method) {
+  if (name == "svd") {
+    method = PseudoInverseMethod::kSvd;
+  } else if (name == "dls") {
+    method = PseudoInverseMethod::kDampedLeastSquares;
+  } else if (name == "adaptive") {
+    method = PseudoInverseMethod::kAdaptiveDamping;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+template <int Rows, int Cols>
+inline void pseudoInverseSvd(const Eigen::Matrix<double, Rows, Cols>& M_,
+                             Eigen::Matrix<double, Cols, Rows>& M_pinv_,
+                             double lambda_) {
+  static_assert(Rows != Eigen::Dynamic && Cols != Eigen::Dynamic,
+                "use the Eigen::MatrixXd overload for dynamic-size matrices");
+  constexpr int kRank = Rows < Cols ? Rows : Cols;
+
+  Eigen::JacobiSVD<Eigen::Matrix<double, Rows, Cols>> svd(M_, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Eigen::Matrix<double, kRank, 1> sing_vals_ = svd.singularValues();
+  Eigen::Matrix<double, kRank, 1> damped_inverse_ =
+      sing_vals_.cwiseQuotient((sing_vals_.cwiseProduct(sing_vals_).array() + lambda_ * lambda_).matrix());
+
+  M_pinv_.noalias() = svd.matrixV().template leftCols<kRank>() * damped_inverse_.asDiagonal() *
+                      svd.matrixU().template leftCols<kRank>().transpose();
+}
+
+// Solves (M^T M + lambda^2 I) X = M^T (or the transposed problem for wide matrices) on the
+// small Gram matrix, which is 6x6 for a Panda Jacobian.
+template <int Rows, int Cols>
+inline void pseudoInverseDls(const Eigen::Matrix<double, Rows, Cols>& M_,
+                             Eigen::Matrix<double, Cols, Rows>& M_pinv_,
+                             double lambda_) {
+  static_assert(Rows != Eigen::Dynamic && Cols != Eigen::Dynamic,
+                "use the Eigen::MatrixXd overload for dynamic-size matrices");
+  if (Rows >= Cols) {
+    Eigen::Matrix<double, Cols, Cols> gram_;
+    gram_.noalias() = M_.transpose() * M_;
+    gram_.diagonal().array() += lambda_ * lambda_;
+    M_pinv_ = gram_.ldlt().solve(M_.transpose());
+  } else {
+    Eigen::Matrix<double, Rows, Rows> gram_;
+    gram_.noalias() = M_ * M_.transpose();
+    gram_.diagonal().array() += lambda_ * lambda_;
+    M_pinv_ = gram_.ldlt().solve(M_).transpose();
+  }
+}
+
+// Damped least squares with singular-value-adaptive damping: lambda^2 = (1 - (s_min / eps)^2) *
+// lambda_max^2 below the threshold eps and zero above it, so tracking stays exact away from
+// singularities. The singular values come from an eigen decomposition of the Gram matrix.
+template <int Rows, int Cols>
+inline void pseudoInverseAdaptive(const Eigen::Matrix<double, Rows, Cols>& M_,
+                                  Eigen::Matrix<double, Cols, Rows>& M_pinv_,
+                                  double lambda_max_,
+                                  double singular_threshold_) {
+  static_assert(Rows != Eigen::Dynamic && Cols != Eigen::Dynamic,
+                "use the Eigen::MatrixXd overload for dynamic-size matrices");
+  constexpr int kRank = Rows < Cols ? Rows : Cols;
+  using Gram = Eigen::Matrix<double, kRank, kRank>;
+
+  Gram gram_;
+  if (Rows >= Cols) {
+    gram_.noalias() = M_.transpose().template topRows<kRank>() * M_.template leftCols<kRank>();
+  } else {
+    gram_.noalias() = M_.template topRows<kRank>() * M_.transpose().template leftCols<kRank>();
+  }
+  Eigen::SelfAdjointEigenSolver<Gram> eigen_solver_(gram_);
+  // eigenvalues are the squared singular values, in increasing order
+  Eigen::Matrix<double, kRank, 1> sing_vals_sq_ = eigen_solver_.eigenvalues().cwiseMax(0.0);
+
+  double lambda_sq_ = 0.0;
+  double sing_val_min_ = std::sqrt(sing_vals_sq_(0));
+  if (sing_val_min_ < singular_threshold_) {
+    double ratio_ = sing_val_min_ / singular_threshold_;
+    lambda_sq_ = (1.0 - ratio_ * ratio_) * lambda_max_ * lambda_max_;
+  }
+
+  Eigen::Matrix<double, kRank, 1> damped_inverse_;
+  for (int i = 0; i < kRank; i++) {
+    double denominator_ = sing_vals_sq_(i) + lambda_sq_;
+    damped_inverse_(i) = denominator_ > 0.0 ? 1.0 / denominator_ : 0.0;
+  }
+  Gram gram_inverse_;
+  gram_inverse_.noalias() = eigen_solver_.eigenvectors() * damped_inverse_.asDiagonal() *
+                            eigen_solver_.eigenvectors().transpose();
+  if (Rows >= Cols) {
+    M_pinv_.template topRows<kRank>().noalias() =
+        gram_inverse_ * M_.transpose().template topRows<kRank>();
+  } else {
+    M_pinv_.template leftCols<kRank>().noalias() =
+        M_.transpose().template leftCols<kRank>() * gram_inverse_;
+  }
+}
+
+template <int Rows, int Cols>
+inline void pseudoInverse(const Eigen::Matrix<double, Rows, Cols>& M_,
+                          Eigen::Matrix<double, Cols, Rows>& M_pinv_,
+                          const PseudoInverseParams& params_) {
+  switch (params_.method) {
+    case PseudoInverseMethod::kDampedLeastSquares:
+      pseudoInverseDls(M_, M_pinv_, params_.damping);
+      break;
+    case PseudoInverseMethod::kAdaptiveDamping:
+      pseudoInverseAdaptive(M_, M_pinv_, params_.damping, params_.singular_threshold);
+      break;
+    case PseudoInverseMethod::kSvd:
+    default:
+      pseudoInverseSvd(M_, M_pinv_, params_.damping);
+      break;
+  }
+}
+
+template <int Rows, int Cols>
+inline void pseudoInverse(const Eigen::Matrix<double, Rows, Cols>& M_,
+                          Eigen::Matrix<double, Cols, Rows>& M_pinv_,
+                          bool damped = true) {
+  pseudoInverseSvd(M_, M_pinv_, damped ? 0.2 : 0.0);
+}
@@ -0,0 +1,159 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace franka_ros_controllers {
+
+/**
+ * Wait-free hand-off of command setpoints from ROS callback threads to the real-time
+ * control loop, implemented as a triple buffer.
+ *
+ * Writers (ROS subscriber or service callbacks) publish complete setpoints with
+ * writeFromNonRT(); concurrent writers are serialised among themselves and never block the
+ * reader. The control loop takes a consistent snapshot of the most recent setpoint with
+ * readFromRT() without locking or allocating, so a 7-DOF target can never be observed
+ * half-written. A setpoint that gets overwritten before the control loop consumed it is
+ * counted as dropped.
+ *
+ * T must be copyable without allocating (std::array, fixed-size Eigen types, PODs).
+ */
+template <typename T>
+class SetpointChannel {
+ public:
+  SetpointChannel() = default;
+  SetpointChannel(const SetpointChannel&) = delete;
+  SetpointChannel& operator=(const SetpointChannel&) = delete;
+
+  /**
+   * Publishes a new setpoint. Must not be called from the real-time thread.
+   *
+   * @param[in] value Complete setpoint to hand over to the control loop.
+   */
+  void writeFromNonRT(const T& value) {
+    while (writer_lock_.test_and_set(std::memory_order_acquire)) {
+    }
+    Slot& slot = slots_[write_index_];
+    slot.value = value;
+    slot.stamp = Clock::now();
+    uint8_t previous = state_.exchange(write_index_ | kFreshBit, std::memory_order_acq_rel);
+    write_index_ = previous & kIndexMask;
+    if ((previous & kFreshBit) != 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    writer_lock_.clear(std::memory_order_release);
+  }
+
+  /**
+   * Records a command that was discarded by the writer, e.g. because it failed validation.
+   */
+  void rejectFromNonRT() { rejected_.fetch_add(1, std::memory_order_relaxed); }
+
+  /**
+   * Takes the most recent setpoint if one was published since the last call.
+   *
+   * @param[out] value Receives the setpoint; left untouched if there is nothing new.
+   * @return True if a new setpoint was copied into value.
+   */
+  bool readFromRT(T& value) {
+    if (!acquireFromRT()) {
+      return false;
+    }
+    value = slots_[read_index_].value;
+    return true;
+  }
+
+  /**
+   * Discards any pending setpoint, e.g. when the controller is (re)started and should hold
+   * its current state instead of jumping to a command sent while it was inactive.
+   */
+  void clearFromRT() {
+    if (acquireFromRT()) {
+      consumed_stamp_ = TimePoint();
+    }
+  }
+
+  /**
+   * @return Seconds since the setpoint last returned by readFromRT() was written, or infinity
+   * if no setpoint has been consumed since the last clearFromRT().
+   */
+  double ageFromRT() const {
+    if (consumed_stamp_ == TimePoint()) {
+      return std::numeric_limits<double>::infinity();
+    }
+    return std::chrono::duration<double>(Clock::now() - consumed_stamp_).count();
+  }
+
+  /** @return Number of setpoints published with writeFromNonRT(). */
+  uint64_t writeCount() const { return writes_.load(std::memory_order_relaxed); }
+
+  /** @return Number of setpoints overwritten before the control loop consumed them. */
+  uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /** @return Number of commands discarded by the writer with rejectFromNonRT(). */
+  uint64_t rejectedCount() const { return rejected_.load(std::memory_order_relaxed); }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  struct Slot {
+    T value{};
+    TimePoint stamp{};
+  };
+
+  static constexpr uint8_t kIndexMask{0x3};
+  static constexpr uint8_t kFreshBit{0x4};
+
+  bool acquireFromRT() {
+    if ((state_.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+      return false;
+    }
+    uint8_t previous = state_.exchange(read_index_, std::memory_order_acq_rel);
+    read_index_ = previous & kIndexMask;
+    consumed_stamp_ = slots_[read_index_].stamp;
+    return true;
+  }
+
+  Slot slots_[3];
+  // Index of the slot shared between writer and reader, plus a flag marking it unread.
+  std::atomic<uint8_t> state_{1};
+  uint8_t write_index_{0};  // owned by the writers
+  uint8_t read_index_{2};   // owned by the real-time reader
+  TimePoint consumed_stamp_{};
+
+  std::atomic_flag writer_lock_ = ATOMIC_FLAG_INIT;
+  std::atomic<uint64_t> writes_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> rejected_{0};
+};
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,367 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace franka_ros_controllers {
+namespace shm {
+
+/**
+ * Fixed-layout shared-memory transport for robot state and joint commands, for clients
+ * running in another process on the same host.
+ *
+ * The segment (/dev/shm/<name>, see armResourceName() for the name of each arm of a multi-arm
+ * node) is created by CustomFrankaStateController and contains:
+ *  - a header with a magic number, layout version and the offsets below,
+ *  - a ring of kStateRingSize StateSample slots written every control cycle,
+ *  - a single CommandSample slot written by one external client and polled by the effort
+ *    controllers from update().
+ *
+ * Every slot is guarded by a sequence lock: the writer makes the slot's counter odd, writes
+ * the payload and makes it even again. Readers copy the payload and retry (or, on the
+ * real-time side, give up until the next cycle) if the counter was odd or changed meanwhile.
+ * No side ever blocks the other. All payload fields are little-endian doubles or 64 bit
+ * integers so the layout can be read without ROS, e.g. by franka_interface.shm_client.
+ *
+ * The command slot's sequence lock doubles as a write counter: the robot side notes the
+ * control loop time whenever it changes, and pollCommand() reports a client that stopped
+ * writing for longer than the command timeout, like the topic watchdog of the motion
+ * controller interface does for JointCommand messages.
+ */
+
+constexpr uint32_t kMagic{0x4d485346};  // "FSHM"
+constexpr uint32_t kVersion{1};
+constexpr uint32_t kStateRingSize{16};
+
+/** Snapshot of the franka::RobotState fields needed by external control loops. */
+struct StateSample {
+  uint64_t sequence;  // control cycle counter of the state controller
+  uint64_t robot_mode;  // franka_core_msgs::RobotState::ROBOT_MODE_*
+  double time;  // franka::RobotState::time [s]
+  double q[7];
+  double dq[7];
+  double q_d[7];
+  double dq_d[7];
+  double tau_J[7];
+  double tau_J_d[7];
+  double dtau_J[7];
+  double tau_ext_hat_filtered[7];
+  double O_T_EE[16];  // column-major
+  double O_F_ext_hat_K[6];
+  double K_F_ext_hat_K[6];
+};
+
+/** Joint command, interpreted like franka_core_msgs::JointCommand. */
+struct CommandSample {
+  uint64_t sequence;  // client-side counter, for bookkeeping only
+  uint64_t mode;  // franka_core_msgs::JointCommand::*_MODE
+  double position[7];
+  double velocity[7];
+  double effort[7];
+};
+
+struct alignas(64) StateSlot {
+  std::atomic<uint64_t> lock;
+  StateSample sample;
+};
+
+struct alignas(64) CommandSlot {
+  std::atomic<uint64_t> lock;
+  CommandSample sample;
+};
+
+struct Segment {
+  std::atomic<uint32_t> magic;  // written last by the creator
+  uint32_t version;
+  uint32_t size;
+  uint32_t state_ring_size;
+  uint32_t state_offset;
+  uint32_t state_stride;
+  uint32_t command_offset;
+  uint32_t reserved;
+  alignas(64) std::atomic<uint64_t> state_head;  // number of samples written so far
+  StateSlot states[kStateRingSize];
+  CommandSlot command;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared-memory transport needs lock-free atomics");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "Shared-memory transport needs plain 64 bit atomics");
+
+/** Result of Transport::pollCommand(). */
+enum class CommandStatus {
+  kNone,      // no new command this cycle
+  kNew,       // a new command was copied
+  kTimedOut,  // the client stopped writing; reported once per stall
+};
+
+/**
+ * Command events of the robot side, counted by the control loop and reported from a
+ * non-real-time thread, so that update() does not log.
+ */
+class CommandEvents {
+ public:
+  /// Control loop side. Real-time safe.
+  void countRejected() { rejected_.fetch_add(1, std::memory_order_relaxed); }
+  void countTimeout() { timeouts_.fetch_add(1, std::memory_order_relaxed); }
+
+  /// Reporting side (a single thread): events since the previous call.
+  void takeNew(uint64_t& rejected, uint64_t& timeouts) {
+    const uint64_t rejected_total = rejected_.load(std::memory_order_relaxed);
+    const uint64_t timeouts_total = timeouts_.load(std::memory_order_relaxed);
+    rejected = rejected_total - reported_rejected_;
+    timeouts = timeouts_total - reported_timeouts_;
+    reported_rejected_ = rejected_total;
+    reported_timeouts_ = timeouts_total;
+  }
+
+ private:
+  std::atomic<uint64_t> rejected_{0};
+  std::atomic<uint64_t> timeouts_{0};
+  uint64_t reported_rejected_{0};
+  uint64_t reported_timeouts_{0};
+};
+
+/**
+ * Handle to a mapped transport segment. The same class serves the robot side (state writer,
+ * command reader) and C++ clients (state reader, command writer).
+ */
+class Transport {
+ public:
+  Transport() = default;
+  Transport(const Transport&) = delete;
+  Transport& operator=(const Transport&) = delete;
+  ~Transport() { close(); }
+
+  /**
+   * Maps the segment, creating and initialising it if requested and not present yet.
+   *
+   * @param[in] name Segment name without leading slash, e.g. "franka_ros_interface".
+   * @param[in] create True on the robot side, false for clients.
+   * @param[out] error Reason for failure, if any.
+   * @return True if the segment is mapped and has a compatible layout.
+   */
+  bool open(const std::string& name, bool create, std::string& error) {
+    close();
+    std::string path = "/" + name;
+    int fd = ::shm_open(path.c_str(), create ? (O_RDWR | O_CREAT) : O_RDWR, 0666);
+    if (fd < 0) {
+      error = "shm_open(" + path + "): " + std::strerror(errno);
+      return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+      error = "fstat(" + path + "): " + std::strerror(errno);
+      ::close(fd);
+      return false;
+    }
+    bool fresh = info.st_size == 0;
+    if (fresh && !create) {
+      error = path + " has not been initialised by the robot side yet";
+      ::close(fd);
+      return false;
+    }
+    if (fresh && ::ftruncate(fd, sizeof(Segment)) != 0) {
+      error = "ftruncate(" + path + "): " + std::strerror(errno);
+      ::close(fd);
+      return false;
+    }
+    if (!fresh && static_cast<size_t>(info.st_size) != sizeof(Segment)) {
+      error = path + " has an incompatible size; remove it and restart the robot side";
+      ::close(fd);
+      return false;
+    }
+    void* address = ::mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+      error = "mmap(" + path + "): " + std::strerror(errno);
+      return false;
+    }
+    segment_ = static_cast<Segment*>(address);
+    if (create) {
+      ::mlock(address, sizeof(Segment));  // best effort; keeps page faults out of the RT loop
+      if (fresh) {
+        initialise();
+      }
+    }
+    if (segment_->magic.load(std::memory_order_acquire) != kMagic ||
+        segment_->version != kVersion || segment_->size != sizeof(Segment)) {
+      error = path + " has an incompatible layout; remove it and restart the robot side";
+      close();
+      return false;
+    }
+    syncCommand();
+    return true;
+  }
+
+  void close() {
+    if (segment_ != nullptr) {
+      ::munmap(segment_, sizeof(Segment));
+      segment_ = nullptr;
+    }
+  }
+
+  bool isOpen() const { return segment_ != nullptr; }
+
+  /** Robot side: appends a state sample to the ring. Wait-free, single writer. */
+  void writeState(const StateSample& sample) {
+    uint64_t head = segment_->state_head.load(std::memory_order_relaxed);
+    StateSlot& slot = segment_->states[head % kStateRingSize];
+    writeLocked(slot.lock, slot.sample, sample);
+    segment_->state_head.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * Client side: copies the most recent state sample.
+   *
+   * @return False if no sample has been written yet or the writer kept overtaking the read.
+   */
+  bool readLatestState(StateSample& sample) const {
+    for (int attempt = 0; attempt < 8; ++attempt) {
+      uint64_t head = segment_->state_head.load(std::memory_order_acquire);
+      if (head == 0) {
+        return false;
+      }
+      StateSlot& slot = segment_->states[(head - 1) % kStateRingSize];
+      if (readLocked(slot.lock, slot.sample, sample)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** @return Number of state samples written since the segment was created. */
+  uint64_t stateCount() const { return segment_->state_head.load(std::memory_order_acquire); }
+
+  /** Client side: publishes a command. Only one client may write commands at a time. */
+  void writeCommand(const CommandSample& sample) {
+    writeLocked(segment_->command.lock, segment_->command.sample, sample);
+  }
+
+  /**
+   * Robot side: takes the command slot if it was written since the last successful call.
+   * Makes a single attempt so it can be called from update(); a command that is being
+   * written right now is picked up on the next cycle.
+   *
+   * @return True if a new command was copied into sample.
+   */
+  bool readCommand(CommandSample& sample) {
+    uint64_t lock = segment_->command.lock.load(std::memory_order_acquire);
+    if (lock == last_command_lock_ || (lock & 1) != 0) {
+      return false;
+    }
+    if (!readLocked(segment_->command.lock, segment_->command.sample, sample)) {
+      return false;
+    }
+    last_command_lock_ = lock;
+    return true;
+  }
+
+  /**
+   * Robot side: readCommand() with a watchdog. Once a command of mode has been taken, the
+   * client has to write a new one at least every timeout seconds; when it does not, kTimedOut
+   * is returned once and the caller should fall back to a safe command (e.g. hold position or
+   * zero torque) until the next new command arrives. Commands of other modes are skipped and
+   * do not count as new. Real-time safe.
+   *
+   * @param[in] now Control loop time [s].
+   * @param[in] timeout Longest time [s] between two new commands.
+   * @param[in] mode franka_core_msgs::JointCommand::*_MODE the caller executes.
+   * @param[out] sample The new command, for kNew.
+   */
+  CommandStatus pollCommand(double now, double timeout, uint64_t mode, CommandSample& sample) {
+    if (readCommand(sample) && sample.mode == mode) {
+      last_command_time_ = now;
+      command_active_ = true;
+      return CommandStatus::kNew;
+    }
+    if (command_active_ && now - last_command_time_ > timeout) {
+      command_active_ = false;
+      return CommandStatus::kTimedOut;
+    }
+    return CommandStatus::kNone;
+  }
+
+  /**
+   * Robot side: marks the current command as consumed, e.g. in starting(), so that a
+   * controller does not act on a command written while it was inactive.
+   */
+  void syncCommand() {
+    uint64_t lock = segment_->command.lock.load(std::memory_order_acquire);
+    last_command_lock_ = lock & ~uint64_t{1};
+    command_active_ = false;
+  }
+
+ private:
+  void initialise() {
+    segment_->version = kVersion;
+    segment_->size = sizeof(Segment);
+    segment_->state_ring_size = kStateRingSize;
+    segment_->state_offset = offsetof(Segment, states);
+    segment_->state_stride = sizeof(StateSlot);
+    segment_->command_offset = offsetof(Segment, command);
+    segment_->magic.store(kMagic, std::memory_order_release);
+  }
+
+  template <typename Sample>
+  static void writeLocked(std::atomic<uint64_t>& lock, Sample& target, const Sample& value) {
+    uint64_t sequence = lock.load(std::memory_order_relaxed);
+    lock.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&target, &value, sizeof(Sample));
+    lock.store(sequence + 2, std::memory_order_release);
+  }
+
+  template <typename Sample>
+  static bool readLocked(const std::atomic<uint64_t>& lock, const Sample& source, Sample& value) {
+    uint64_t before = lock.load(std::memory_order_acquire);
+    if ((before & 1) != 0) {
+      return false;
+    }
+    std::memcpy(&value, &source, sizeof(Sample));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return lock.load(std::memory_order_relaxed) == before;
+  }
+
+  Segment* segment_{nullptr};
+  uint64_t last_command_lock_{0};
+  double last_command_time_{0.0};  // control loop time of the last new command
+  bool command_active_{false};     // a command was taken and has not timed out yet
+};
+
+}  // namespace shm
+}  // namespace franka_ros_controllers
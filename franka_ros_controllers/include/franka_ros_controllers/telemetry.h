@@ -0,0 +1,234 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace franka_ros_controllers {
+
+/**
+ * Single-producer single-consumer queue of preallocated, fixed-size slots.
+ *
+ * The control loop fills a slot in place with claim() and hands it over with commit(); a
+ * sample that finds the queue full is counted as dropped instead of blocking or allocating.
+ * The consumer drains the slots in order with front() and pop().
+ *
+ * Sample must be default-constructible and copyable without allocating.
+ */
+template <typename Sample>
+class SampleQueue {
+ public:
+  SampleQueue() = default;
+  SampleQueue(const SampleQueue&) = delete;
+  SampleQueue& operator=(const SampleQueue&) = delete;
+
+  /**
+   * Allocates capacity slots and empties the queue. Not thread-safe, not real-time safe.
+   */
+  void reset(size_t capacity) {
+    slots_.assign(capacity + 1, Sample{});
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * Producer: the next free slot, to be filled and then passed on with commit().
+   *
+   * @return nullptr (and the sample is counted as dropped) if the queue is full.
+   */
+  Sample* claim() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (slots_.empty() || next(head) == tail_.load(std::memory_order_acquire)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &slots_[head];
+  }
+
+  /** Producer: makes the slot returned by the last successful claim() available. */
+  void commit() {
+    head_.store(next(head_.load(std::memory_order_relaxed)), std::memory_order_release);
+  }
+
+  /** Consumer: the oldest committed sample, or nullptr if there is none. */
+  const Sample* front() const {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &slots_[tail];
+  }
+
+  /** Consumer: releases the sample returned by front(). */
+  void pop() { tail_.store(next(tail_.load(std::memory_order_relaxed)), std::memory_order_release); }
+
+  /** @return Number of samples dropped because the queue was full. */
+  uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  size_t next(size_t index) const { return index + 1 == slots_.size() ? 0 : index + 1; }
+
+  std::vector<Sample> slots_;  // one slot stays free to tell a full queue from an empty one
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+/**
+ * Something the telemetry thread drains periodically; see TelemetryChannel.
+ */
+class TelemetrySource {
+ public:
+  virtual ~TelemetrySource() = default;
+
+  /** Called on the telemetry thread only. */
+  virtual void drain() = 0;
+};
+
+/**
+ * The one non-real-time thread that turns the samples queued by all controllers into ROS
+ * messages, so that publishing costs the control loop no more than filling a slot.
+ *
+ * Started when the first source is added; it inherits the CPU affinity of that thread (the
+ * controller manager's), which custom_franka_control_node keeps off the control CPUs.
+ */
+class TelemetryThread {
+ public:
+  static TelemetryThread& instance();
+
+  TelemetryThread(const TelemetryThread&) = delete;
+  TelemetryThread& operator=(const TelemetryThread&) = delete;
+
+  void add(TelemetrySource* source);
+
+  /** Returns once source is no longer being drained. */
+  void remove(TelemetrySource* source);
+
+ private:
+  TelemetryThread() = default;
+  ~TelemetryThread();
+
+  void run();
+
+  std::mutex mutex_;
+  std::vector<TelemetrySource*> sources_;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+};
+
+/**
+ * Hand-off of per-cycle controller samples to the telemetry thread, which passes them on in
+ * batches, e.g. to publish the state of every control cycle in a few messages per second.
+ */
+template <typename Sample>
+class TelemetryChannel : public TelemetrySource {
+ public:
+  /**
+   * Receives up to batch_size consecutive samples (fewer once the producer pauses) and the
+   * number of samples dropped just before them. Called on the telemetry thread.
+   */
+  using Handler = std::function<void(const std::vector<Sample>& batch, uint64_t dropped)>;
+
+  TelemetryChannel() = default;
+  ~TelemetryChannel() override { stop(); }
+
+  /**
+   * Preallocates the queue and the batch and registers with the telemetry thread. Not
+   * real-time safe.
+   */
+  void start(size_t capacity, size_t batch_size, Handler handler) {
+    stop();
+    queue_.reset(capacity);
+    batch_size_ = batch_size > 0 ? batch_size : 1;
+    batch_.clear();
+    batch_.reserve(batch_size_);
+    reported_dropped_ = 0;
+    handler_ = std::move(handler);
+    TelemetryThread::instance().add(this);
+    started_ = true;
+  }
+
+  /** Unregisters from the telemetry thread; samples still queued are discarded. */
+  void stop() {
+    if (started_) {
+      TelemetryThread::instance().remove(this);
+      started_ = false;
+    }
+  }
+
+  /**
+   * Control loop: slot for this cycle's sample, to be passed on with commit(), or nullptr if
+   * the telemetry thread fell behind (the sample is counted as dropped). Real-time safe.
+   */
+  Sample* claim() { return started_ ? queue_.claim() : nullptr; }
+
+  /** Control loop: hands over the sample returned by the last successful claim(). */
+  void commit() { queue_.commit(); }
+
+  /** @return Number of samples dropped because the queue was full. */
+  uint64_t droppedCount() const { return queue_.droppedCount(); }
+
+ private:
+  void drain() override {
+    bool received = false;
+    while (const Sample* sample = queue_.front()) {
+      batch_.push_back(*sample);
+      queue_.pop();
+      received = true;
+      if (batch_.size() == batch_size_) {
+        flush();
+      }
+    }
+    // the producer paused, e.g. the controller was stopped: do not hold back the last samples
+    if (!received && !batch_.empty()) {
+      flush();
+    }
+  }
+
+  void flush() {
+    const uint64_t dropped = queue_.droppedCount();
+    handler_(batch_, dropped - reported_dropped_);
+    reported_dropped_ = dropped;
+    batch_.clear();
+  }
+
+  SampleQueue<Sample> queue_;
+  size_t batch_size_{1};
+  std::vector<Sample> batch_;  // telemetry thread only
+  uint64_t reported_dropped_{0};
+  Handler handler_;
+  bool started_{false};
+};
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,158 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace franka_ros_controllers {
+
+/**
+ * Preallocated queue of trajectory points handed from ROS callbacks to the real-time loop.
+ *
+ * Writers append whole chunks with writeFromNonRT(), optionally replacing the queued
+ * trajectory; concurrent writers are serialised among themselves and never block the reader.
+ * The control loop consumes points in order with frontFromRT()/popFromRT() and learns about new
+ * points and a replacement through takeRestartFromRT(), without blocking or allocating. A chunk
+ * is either queued completely or not at all, so the loop never sees half a trajectory.
+ *
+ * A replacing chunk reuses the slots of points the loop has not seen yet, so any number of
+ * replacements can arrive between two takeRestartFromRT() calls. The points the loop has seen
+ * stay in place until then, though: to always accept a replacement of n points next to a
+ * trajectory of n points, Capacity must be 2n.
+ *
+ * Point must be copyable without allocating.
+ */
+template <typename Point, size_t Capacity>
+class TrajectoryBuffer {
+ public:
+  TrajectoryBuffer() = default;
+  TrajectoryBuffer(const TrajectoryBuffer&) = delete;
+  TrajectoryBuffer& operator=(const TrajectoryBuffer&) = delete;
+
+  static constexpr size_t capacity() { return Capacity; }
+
+  /**
+   * Queues count points. Must not be called from the real-time thread.
+   *
+   * @param[in] replace Drop the queued points and make these the start of a new trajectory.
+   * @return false, leaving the queue untouched, if the points do not fit.
+   */
+  bool writeFromNonRT(const Point* points, size_t count, bool replace) {
+    while (lock_.test_and_set(std::memory_order_acquire)) {
+    }
+    // Slots from tail_ up to available_ may still be read by the loop, even if a restart will
+    // skip them. The points after available_ have not been seen by the loop, which cannot look
+    // while the lock is held, and a replacement supersedes them.
+    const uint64_t head = replace ? available_ : head_.load(std::memory_order_relaxed);
+    const uint64_t used = head - tail_.load(std::memory_order_acquire);
+    const bool fits = count <= Capacity - used;
+    if (fits) {
+      for (size_t i = 0; i < count; ++i) {
+        slots_[(head + i) % Capacity] = points[i];
+      }
+      if (replace) {
+        restart_at_.store(head, std::memory_order_relaxed);
+        restarts_.fetch_add(1, std::memory_order_release);
+      }
+      // Published last: a reader that sees the new points also sees the restart.
+      head_.store(head + count, std::memory_order_release);
+    } else {
+      rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+    lock_.clear(std::memory_order_release);
+    return fits;
+  }
+
+  /**
+   * Makes the points written so far visible and applies a pending replacement: drops the
+   * points queued before it. While a writer is busy, the previous view is kept until the next
+   * call. Real-time safe.
+   *
+   * @return true once for every replacement since the previous call.
+   */
+  bool takeRestartFromRT() {
+    if (lock_.test_and_set(std::memory_order_acquire)) {
+      return false;
+    }
+    available_ = head_.load(std::memory_order_relaxed);
+    const uint64_t restarts = restarts_.load(std::memory_order_relaxed);
+    const uint64_t restart_at = restart_at_.load(std::memory_order_relaxed);
+    lock_.clear(std::memory_order_release);
+    if (restarts == restarts_seen_) {
+      return false;
+    }
+    restarts_seen_ = restarts;
+    if (restart_at > tail_.load(std::memory_order_relaxed)) {
+      tail_.store(restart_at, std::memory_order_release);
+    }
+    return true;
+  }
+
+  /**
+   * Oldest queued point, or nullptr if the queue is empty. Points written after the last
+   * takeRestartFromRT() call are not visible yet. Real-time safe.
+   */
+  const Point* frontFromRT() const {
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    return tail < available_ ? &slots_[tail % Capacity] : nullptr;
+  }
+
+  /// Removes the point returned by frontFromRT(). Real-time safe.
+  void popFromRT() {
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail < available_) {
+      tail_.store(tail + 1, std::memory_order_release);
+    }
+  }
+
+  /// Drops everything queued so far, e.g. when a direct setpoint takes over. Real-time safe.
+  void clearFromRT() {
+    takeRestartFromRT();
+    tail_.store(available_, std::memory_order_release);
+  }
+
+  /// Number of chunks refused because the queue was full.
+  uint64_t rejectedCount() const { return rejected_.load(std::memory_order_relaxed); }
+
+ private:
+  std::array<Point, Capacity> slots_{};
+  std::atomic<uint64_t> head_{0};        // written by writers
+  std::atomic<uint64_t> tail_{0};        // written by the loop
+  std::atomic<uint64_t> restart_at_{0};  // first point of the latest replacement
+  std::atomic<uint64_t> restarts_{0};
+  std::atomic<uint64_t> rejected_{0};
+  // serialises the writers, and the loop's view of the queue against them
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+
+  // loop only, except that writers read available_ while holding lock_
+  uint64_t available_{0};  // head_ as of the last takeRestartFromRT()
+  uint64_t restarts_seen_{0};
+};
+
+}  // namespace franka_ros_controllers
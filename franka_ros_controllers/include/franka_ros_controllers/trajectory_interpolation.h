@@ -0,0 +1,106 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace franka_ros_controllers {
+
+/**
+ * Position, velocity and acceleration at time t of a segment of duration T that joins
+ * (p0, v0, a0) to (p1, v1, a1), per element. With quintic = false the accelerations are ignored
+ * and a cubic Hermite segment is used. t is clamped to [0, T]; T <= 0 gives the end state.
+ * Real-time safe.
+ */
+template <size_t N>
+void interpolateSegment(const std::array<double, N>& p0,
+                        const std::array<double, N>& v0,
+                        const std::array<double, N>& a0,
+                        const std::array<double, N>& p1,
+                        const std::array<double, N>& v1,
+                        const std::array<double, N>& a1,
+                        double T,
+                        double t,
+                        bool quintic,
+                        std::array<double, N>& position,
+                        std::array<double, N>& velocity,
+                        std::array<double, N>& acceleration) {
+  if (T <= 0.0) {
+    position = p1;
+    velocity = v1;
+    acceleration = quintic ? a1 : std::array<double, N>{};
+    return;
+  }
+  t = std::max(0.0, std::min(t, T));
+  const double T2 = T * T;
+  const double T3 = T2 * T;
+  for (size_t i = 0; i < N; ++i) {
+    const double dp = p1[i] - p0[i];
+    if (!quintic) {
+      const double c2 = (3.0 * dp - (2.0 * v0[i] + v1[i]) * T) / T2;
+      const double c3 = (-2.0 * dp + (v0[i] + v1[i]) * T) / T3;
+      position[i] = p0[i] + t * (v0[i] + t * (c2 + t * c3));
+      velocity[i] = v0[i] + t * (2.0 * c2 + t * 3.0 * c3);
+      acceleration[i] = 2.0 * c2 + 6.0 * c3 * t;
+    } else {
+      const double T4 = T3 * T;
+      const double T5 = T4 * T;
+      const double c2 = 0.5 * a0[i];
+      const double c3 = (20.0 * dp - (8.0 * v1[i] + 12.0 * v0[i]) * T -
+                         (3.0 * a0[i] - a1[i]) * T2) / (2.0 * T3);
+      const double c4 = (-30.0 * dp + (14.0 * v1[i] + 16.0 * v0[i]) * T +
+                         (3.0 * a0[i] - 2.0 * a1[i]) * T2) / (2.0 * T4);
+      const double c5 = (12.0 * dp - 6.0 * (v1[i] + v0[i]) * T -
+                         (a0[i] - a1[i]) * T2) / (2.0 * T5);
+      position[i] = p0[i] + t * (v0[i] + t * (c2 + t * (c3 + t * (c4 + t * c5))));
+      velocity[i] = v0[i] + t * (2.0 * c2 + t * (3.0 * c3 + t * (4.0 * c4 + t * 5.0 * c5)));
+      acceleration[i] = 2.0 * c2 + t * (6.0 * c3 + t * (12.0 * c4 + t * 20.0 * c5));
+    }
+  }
+}
+
+/**
+ * Position and velocity only of the segment described above. Real-time safe.
+ */
+template <size_t N>
+void interpolateSegment(const std::array<double, N>& p0,
+                        const std::array<double, N>& v0,
+                        const std::array<double, N>& a0,
+                        const std::array<double, N>& p1,
+                        const std::array<double, N>& v1,
+                        const std::array<double, N>& a1,
+                        double T,
+                        double t,
+                        bool quintic,
+                        std::array<double, N>& position,
+                        std::array<double, N>& velocity) {
+  std::array<double, N> acceleration;
+  interpolateSegment(p0, v0, a0, p1, v1, a1, T, t, quintic, position, velocity, acceleration);
+}
+
+}  // namespace franka_ros_controllers
@@ -36,8 +36,14 @@
 #include <franka_core_msgs/JointLimits.h>
 
 #include <mutex>
-#include <franka_hw/trigger_rate.h>
-#include <realtime_tools/realtime_publisher.h>
+#include <franka_ros_controllers/arm_config.h>
+#include <franka_ros_controllers/command_batch.h>
+#include <franka_ros_controllers/command_queue.h>
+#include <franka_ros_controllers/controller_timing.h>
+#include <franka_ros_controllers/jerk_limited_tracker.h>
+#include <franka_ros_controllers/joint_controller_state_publisher.h>
+#include <franka_ros_controllers/joint_kernels.h>
+#include <franka_ros_controllers/setpoint_channel.h>
 
 #include <controller_interface/multi_interface_controller.h>
 #include <franka_hw/franka_state_interface.h>
@@ -65,8 +71,23 @@ class VelocityJointVelocityController : public controller_interface::MultiInterf
   std::array<double, 7> vel_d_target_{};
   std::array<double, 7> vel_d_;
 
+  struct JointSetpoint {
+    std::array<double, 7> velocity;
+    bool hold;  // invalid command received: hold the last measured velocity
+  };
+  SetpointChannel<JointSetpoint> setpoint_channel_;
+  ControllerTiming::Histogram* update_timing_{nullptr};
+
     // joint_cmd subscriber
   ros::Subscriber desired_joints_subscriber_;
+  ros::Subscriber command_batch_subscriber_;
+  JointCommandBatchQueue command_batch_;
+
+  // batches are a look-ahead horizon: interpolated between their waypoints and followed within
+  // the acceleration and jerk limits, instead of filtering every waypoint like a single command
+  JerkLimitedTracker horizon_tracker_;
+  JointWaypoint horizon_waypoint_{};  // latest waypoint of the horizon that has become due
+  bool horizon_active_{false};
 
   double filter_joint_vel_{0.3};
   double target_filter_joint_vel_{0.3};
@@ -80,15 +101,18 @@ class VelocityJointVelocityController : public controller_interface::MultiInterf
   std::unique_ptr< dynamic_reconfigure::Server<franka_ros_controllers::joint_controller_paramsConfig> > dynamic_server_joint_controller_params_;
   ros::NodeHandle dynamic_reconfigure_joint_controller_params_node_;
 
-  franka_hw::TriggerRate trigger_publish_;
-  realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> publisher_controller_states_;
+  JointControllerStatePublisher controller_state_publisher_;
+
+  void trackHorizon(const ros::Time& time, double period);
 
-  bool checkVelocityLimits(std::vector<double> velocities);
+  template <typename Container>
+  bool checkVelocityLimits(const Container& velocities);
 
 
   void jointControllerParamCallback(franka_ros_controllers::joint_controller_paramsConfig& config,
                                uint32_t level);
   void jointVelCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg);
+  void jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg);
 };
 
 }  // namespace franka_ros_controllers
@@ -0,0 +1,213 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/arm_config.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include <ros/console.h>
+#include <xmlrpcpp/XmlRpcValue.h>
+
+namespace franka_ros_controllers {
+
+bool readArmId(const ros::NodeHandle& node_handle, std::string& arm_id) {
+  return node_handle.getParam("arm_id", arm_id) ||
+         node_handle.getParam("/robot_config/arm_id", arm_id);
+}
+
+bool isMultiArm(const ros::NodeHandle& node_handle, const std::string& arm_id) {
+  return RobotConfig::get(node_handle)->isMultiArm(arm_id);
+}
+
+std::string armTopic(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                     const std::string& name) {
+  return isMultiArm(node_handle, arm_id) ? "/" + arm_id + name : name;
+}
+
+std::string armResourceName(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                            const std::string& name) {
+  return isMultiArm(node_handle, arm_id) ? name + "_" + arm_id : name;
+}
+
+std::string armConfigParam(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                           const std::string& name) {
+  const std::string arm_param = "/robot_config/multi_arm/" + arm_id + "/" + name;
+  if (node_handle.hasParam(arm_param)) {
+    return arm_param;
+  }
+  return "/robot_config/" + name;
+}
+
+namespace {
+
+std::mutex robot_config_mutex;
+std::shared_ptr<const RobotConfig> robot_config;
+
+// Member at a "/"-separated path below value, or nullptr.
+XmlRpc::XmlRpcValue* findMember(XmlRpc::XmlRpcValue& value, const std::string& path) {
+  XmlRpc::XmlRpcValue* member = &value;
+  size_t begin = 0;
+  while (begin <= path.size()) {
+    const size_t end = std::min(path.find('/', begin), path.size());
+    const std::string name = path.substr(begin, end - begin);
+    if (member->getType() != XmlRpc::XmlRpcValue::TypeStruct || !member->hasMember(name)) {
+      return nullptr;
+    }
+    member = &(*member)[name];
+    begin = end + 1;
+  }
+  return member;
+}
+
+bool toDouble(XmlRpc::XmlRpcValue& value, double& number) {
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble) {
+    number = static_cast<double>(value);
+  } else if (value.getType() == XmlRpc::XmlRpcValue::TypeInt) {
+    number = static_cast<int>(value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void readStrings(XmlRpc::XmlRpcValue* value, std::vector<std::string>& strings) {
+  strings.clear();
+  if (value == nullptr || value->getType() != XmlRpc::XmlRpcValue::TypeArray) {
+    return;
+  }
+  for (int i = 0; i < value->size(); ++i) {
+    if ((*value)[i].getType() != XmlRpc::XmlRpcValue::TypeString) {
+      strings.clear();
+      return;
+    }
+    strings.push_back(static_cast<std::string>((*value)[i]));
+  }
+}
+
+// Values of a map by joint name (e.g. joint_config/joint_velocity_limit), in the order of
+// joint_names; left empty unless every joint has a number.
+void readJointValues(XmlRpc::XmlRpcValue* value, const std::vector<std::string>& joint_names,
+                     std::vector<double>& values) {
+  values.clear();
+  if (value == nullptr || value->getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+    return;
+  }
+  for (const std::string& joint_name : joint_names) {
+    double number;
+    if (!value->hasMember(joint_name) || !toDouble((*value)[joint_name], number)) {
+      values.clear();
+      return;
+    }
+    values.push_back(number);
+  }
+}
+
+// Like armConfigParam(): the parameter of the arm if it has its own, the global one otherwise.
+XmlRpc::XmlRpcValue* findArmMember(XmlRpc::XmlRpcValue& root, XmlRpc::XmlRpcValue* arm,
+                                   const std::string& path) {
+  XmlRpc::XmlRpcValue* member = arm != nullptr ? findMember(*arm, path) : nullptr;
+  return member != nullptr ? member : findMember(root, path);
+}
+
+franka_core_msgs::JointLimits readJointLimits(XmlRpc::XmlRpcValue& root,
+                                              XmlRpc::XmlRpcValue* arm) {
+  franka_core_msgs::JointLimits limits;
+  readStrings(findArmMember(root, arm, "joint_names"), limits.joint_names);
+  readJointValues(findArmMember(root, arm, "joint_config/joint_position_limit/lower"),
+                  limits.joint_names, limits.position_lower);
+  readJointValues(findArmMember(root, arm, "joint_config/joint_position_limit/upper"),
+                  limits.joint_names, limits.position_upper);
+  readJointValues(findArmMember(root, arm, "joint_config/joint_velocity_limit"),
+                  limits.joint_names, limits.velocity);
+  readJointValues(findArmMember(root, arm, "joint_config/joint_acceleration_limit"),
+                  limits.joint_names, limits.accel);
+  readJointValues(findArmMember(root, arm, "joint_config/joint_jerk_limit"),
+                  limits.joint_names, limits.jerk);
+  readJointValues(findArmMember(root, arm, "joint_config/joint_effort_limit"),
+                  limits.joint_names, limits.effort);
+  return limits;
+}
+
+}  // namespace
+
+bool RobotConfig::load(const ros::NodeHandle& node_handle) {
+  XmlRpc::XmlRpcValue root;
+  if (!node_handle.getParam("/robot_config", root) ||
+      root.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+    return false;
+  }
+  std::shared_ptr<RobotConfig> config(new RobotConfig);
+  readStrings(findMember(root, "multi_arm/arm_ids"), config->arm_ids_);
+  const auto read_arm = [&root](XmlRpc::XmlRpcValue* arm, ArmConfig& arm_config) {
+    arm_config.joint_limits = readJointLimits(root, arm);
+    readJointValues(findArmMember(root, arm, "neutral_pose"),
+                    arm_config.joint_limits.joint_names, arm_config.neutral_pose);
+  };
+  read_arm(nullptr, config->config_);
+  for (const std::string& arm_id : config->arm_ids_) {
+    read_arm(findMember(root, "multi_arm/" + arm_id), config->arm_configs_[arm_id]);
+  }
+
+  std::lock_guard<std::mutex> lock(robot_config_mutex);
+  robot_config = config;
+  return true;
+}
+
+std::shared_ptr<const RobotConfig> RobotConfig::get(const ros::NodeHandle& node_handle) {
+  {
+    std::lock_guard<std::mutex> lock(robot_config_mutex);
+    if (robot_config) {
+      return robot_config;
+    }
+  }
+  if (!load(node_handle)) {
+    // not cached, so that a later call picks up /robot_config once it is there
+    ROS_WARN_ONCE("No /robot_config on the parameter server");
+    return std::make_shared<const RobotConfig>();
+  }
+  std::lock_guard<std::mutex> lock(robot_config_mutex);
+  return robot_config;
+}
+
+bool RobotConfig::isMultiArm(const std::string& arm_id) const {
+  return std::find(arm_ids_.begin(), arm_ids_.end(), arm_id) != arm_ids_.end();
+}
+
+const franka_core_msgs::JointLimits& RobotConfig::jointLimits(const std::string& arm_id) const {
+  return arm(arm_id).joint_limits;
+}
+
+const std::vector<double>& RobotConfig::neutralPose(const std::string& arm_id) const {
+  return arm(arm_id).neutral_pose;
+}
+
+const RobotConfig::ArmConfig& RobotConfig::arm(const std::string& arm_id) const {
+  auto arm_config = arm_configs_.find(arm_id);
+  return arm_config != arm_configs_.end() ? arm_config->second : config_;
+}
+
+}  // namespace franka_ros_controllers
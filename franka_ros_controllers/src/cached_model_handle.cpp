@@ -0,0 +1,150 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/cached_model_handle.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include <franka_hw/franka_state_interface.h>
+#include <hardware_interface/hardware_interface.h>
+
+namespace franka_ros_controllers {
+
+CachedFrankaModelHandle* CachedFrankaModelHandle::acquire(hardware_interface::RobotHW* robot_hw,
+                                                          const std::string& arm_id) {
+  auto* state_interface = robot_hw->get<franka_hw::FrankaStateInterface>();
+  auto* approximation_interface = robot_hw->get<ModelApproximationInterface>();
+  const ModelApproximation* approximation =
+      approximation_interface == nullptr ? nullptr : approximation_interface->getModel(arm_id);
+  auto* model_interface = robot_hw->get<franka_hw::FrankaModelInterface>();
+  if (state_interface == nullptr || (approximation == nullptr && model_interface == nullptr)) {
+    throw hardware_interface::HardwareInterfaceException(
+        "Model and state interfaces are required for the model of " + arm_id);
+  }
+  const franka::RobotState& state = state_interface->getHandle(arm_id + "_robot").getRobotState();
+  const std::string name = approximation == nullptr
+                               ? model_interface->getHandle(arm_id + "_model").getName()
+                               : arm_id + "_model";
+
+  // unique_ptr: entries never move once created, and the constructor stays private
+  static std::mutex mutex;
+  static std::deque<std::unique_ptr<CachedFrankaModelHandle>> entries;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const auto& entry : entries) {
+    if (entry->getName() == name && entry->state_ == &state &&
+        entry->approximation_ == approximation) {
+      return entry.get();
+    }
+  }
+  if (approximation == nullptr) {
+    entries.emplace_back(
+        new CachedFrankaModelHandle(model_interface->getHandle(arm_id + "_model"), state));
+  } else {
+    entries.emplace_back(new CachedFrankaModelHandle(name, *approximation, state));
+  }
+  return entries.back().get();
+}
+
+const std::array<double, 49>& CachedFrankaModelHandle::getMass() {
+  if (refresh(mass_)) {
+    mass_.value = handle_ ? handle_->getMass() : approximation_->mass(*state_);
+  }
+  return mass_.value;
+}
+
+const std::array<double, 7>& CachedFrankaModelHandle::getCoriolis() {
+  if (refresh(coriolis_)) {
+    coriolis_.value = handle_ ? handle_->getCoriolis() : approximation_->coriolis(*state_);
+  }
+  return coriolis_.value;
+}
+
+const std::array<double, 7>& CachedFrankaModelHandle::getGravity() {
+  if (refresh(gravity_)) {
+    gravity_.value = handle_ ? handle_->getGravity() : approximation_->gravity(*state_);
+  }
+  return gravity_.value;
+}
+
+const std::array<double, 16>& CachedFrankaModelHandle::getPose(franka::Frame frame) {
+  Cached<16>& entry = pose_[static_cast<size_t>(frame)];
+  if (refresh(entry)) {
+    entry.value = handle_ ? handle_->getPose(frame) : approximation_->pose(frame, *state_);
+  }
+  return entry.value;
+}
+
+const std::array<double, 42>& CachedFrankaModelHandle::getBodyJacobian(franka::Frame frame) {
+  Cached<42>& entry = body_jacobian_[static_cast<size_t>(frame)];
+  if (refresh(entry)) {
+    entry.value = handle_ ? handle_->getBodyJacobian(frame)
+                        : approximation_->bodyJacobian(frame, *state_);
+  }
+  return entry.value;
+}
+
+const std::array<double, 42>& CachedFrankaModelHandle::getZeroJacobian(franka::Frame frame) {
+  Cached<42>& entry = zero_jacobian_[static_cast<size_t>(frame)];
+  if (refresh(entry)) {
+    entry.value = handle_ ? handle_->getZeroJacobian(frame)
+                        : approximation_->zeroJacobian(frame, *state_);
+  }
+  return entry.value;
+}
+
+std::array<double, 7> CachedFrankaModelHandle::getCoriolis(
+    const franka::RobotState& state) const {
+  if (!handle_) {
+    return approximation_->coriolis(state);
+  }
+  return handle_->getCoriolis(state.q, state.dq, state.I_total, state.m_total, state.F_x_Ctotal);
+}
+
+std::array<double, 7> CachedFrankaModelHandle::getGravity(const franka::RobotState& state) const {
+  if (!handle_) {
+    return approximation_->gravity(state);
+  }
+  return handle_->getGravity(state.q, state.m_total, state.F_x_Ctotal);
+}
+
+std::array<double, 16> CachedFrankaModelHandle::getPose(franka::Frame frame,
+                                                        const franka::RobotState& state) const {
+  if (!handle_) {
+    return approximation_->pose(frame, state);
+  }
+  return handle_->getPose(frame, state.q, state.F_T_EE, state.EE_T_K);
+}
+
+std::array<double, 42> CachedFrankaModelHandle::getZeroJacobian(
+    franka::Frame frame, const franka::RobotState& state) const {
+  if (!handle_) {
+    return approximation_->zeroJacobian(frame, state);
+  }
+  return handle_->getZeroJacobian(frame, state.q, state.F_T_EE, state.EE_T_K);
+}
+
+}  // namespace franka_ros_controllers
@@ -2,6 +2,7 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <franka_ros_controllers/cartesian_impedance_controller.h>
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
@@ -10,27 +11,45 @@
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
 
-#include "pseudo_inversion.h"
+#include "realtime_allocation_guard.h"
 
 namespace franka_ros_controllers {
 
 bool CartesianImpedanceController::init(hardware_interface::RobotHW* robot_hw,
                                         ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
+  std::string arm_id;
+  if (!readArmId(node_handle, arm_id)) {
+    ROS_ERROR_STREAM("CartesianImpedanceController: Could not read parameter arm_id");
+    return false;
+  }
   std::vector<double> cartesian_stiffness_vector;
   std::vector<double> cartesian_damping_vector;
 
-  sub_equilibrium_pose_ = node_handle.subscribe(
-      "/equilibrium_pose", 20, &CartesianImpedanceController::equilibriumPoseCallback, this,
+  // read before subscribing, the trajectory callback checks against them
+  node_handle.param<double>("trajectory_velocity_limits/translational",
+                            max_translational_velocity_, 1.7);
+  node_handle.param<double>("trajectory_velocity_limits/rotational",
+                            max_rotational_velocity_, 2.5);
+  if (!(max_translational_velocity_ > 0.0) || !(max_rotational_velocity_ > 0.0)) {
+    ROS_ERROR(
+        "CartesianImpedanceController: Invalid trajectory_velocity_limits, aborting controller "
+        "init!");
+    return false;
+  }
+
+  sub_equilibrium_pose_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/equilibrium_pose"), 20, &CartesianImpedanceController::equilibriumPoseCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  trajectory_chunk_.reserve(kTrajectoryCapacity);
+  sub_equilibrium_pose_trajectory_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/equilibrium_pose_trajectory"), 20,
+      &CartesianImpedanceController::equilibriumPoseTrajectoryCallback, this,
       ros::TransportHints().reliable().tcpNoDelay());
   stiffness_params_ = node_handle.subscribe(
-      "/impedance_stiffness", 20, &CartesianImpedanceController::stiffnessParamCallback, this,
+      armTopic(node_handle, arm_id, "/impedance_stiffness"), 20, &CartesianImpedanceController::stiffnessParamCallback, this,
       ros::TransportHints().reliable().tcpNoDelay());
  
-  std::string arm_id;
-  if (!node_handle.getParam("arm_id", arm_id)) {
-    ROS_ERROR_STREAM("CartesianImpedanceController: Could not read parameter arm_id");
-    return false;
-  }
   std::vector<std::string> joint_names;
   if (!node_handle.getParam("joint_names", joint_names) || joint_names.size() != 7) {
     ROS_ERROR(
@@ -45,6 +64,28 @@ bool CartesianImpedanceController::init(hardware_interface::RobotHW* robot_hw,
     return false;
   }
 
+  std::string pseudo_inverse_method;
+  node_handle.param<std::string>("pseudo_inverse_method", pseudo_inverse_method, "svd");
+  if (!pseudoInverseMethodFromString(pseudo_inverse_method, pseudo_inverse_params_.method)) {
+    ROS_ERROR_STREAM("CartesianImpedanceController: Unknown pseudo_inverse_method '"
+                     << pseudo_inverse_method << "' (expected svd, dls or adaptive), aborting "
+                     "controller init!");
+    return false;
+  }
+  node_handle.param<double>("pseudo_inverse_damping", pseudo_inverse_params_.damping, 0.2);
+  node_handle.param<double>("pseudo_inverse_singular_threshold",
+                            pseudo_inverse_params_.singular_threshold, 0.1);
+  if (pseudo_inverse_params_.damping < 0.0 ||
+      (pseudo_inverse_params_.method == PseudoInverseMethod::kDampedLeastSquares &&
+       pseudo_inverse_params_.damping <= 0.0) ||
+      (pseudo_inverse_params_.method == PseudoInverseMethod::kAdaptiveDamping &&
+       pseudo_inverse_params_.singular_threshold <= 0.0)) {
+    ROS_ERROR(
+        "CartesianImpedanceController: Invalid pseudo_inverse_damping or "
+        "pseudo_inverse_singular_threshold, aborting controller init!");
+    return false;
+  }
+
   auto* model_interface = robot_hw->get<franka_hw::FrankaModelInterface>();
   if (model_interface == nullptr) {
     ROS_ERROR_STREAM(
@@ -52,8 +93,7 @@ bool CartesianImpedanceController::init(hardware_interface::RobotHW* robot_hw,
     return false;
   }
   try {
-    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
-        model_interface->getHandle(arm_id + "_model"));
+    model_handle_ = CachedFrankaModelHandle::acquire(robot_hw, arm_id);
   } catch (hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM(
         "CartesianImpedanceController: Exception getting model handle from interface: "
@@ -93,23 +133,55 @@ bool CartesianImpedanceController::init(hardware_interface::RobotHW* robot_hw,
     }
   }
 
-  cartesian_stiffness_target_.setIdentity();
-  cartesian_damping_target_.setIdentity();
-  nullspace_stiffness_target_ = 0;
+  if (!readGainTransition(node_handle, "CartesianImpedanceController", default_gain_transition_)) {
+    return false;
+  }
+  // ramp up from zero Cartesian stiffness (and the nullspace stiffness down to zero) once
+  // the controller runs
+  CartesianGains gains;
+  gains.stiffness.setZero();
+  gains.damping.setZero();
+  gains.nullspace_stiffness = 20.0;
+  gains.nullspace_damping = 2.0 * sqrt(gains.nullspace_stiffness);
+  gain_schedule_.reset(gains);
+  gains.stiffness.setIdentity();
+  gains.damping.setIdentity();
   for (size_t i = 0; i < 6; ++i) { 
-    cartesian_stiffness_target_(i,i) = stiffness_gains_[i];
-    cartesian_damping_target_(i,i) = 2.0 * sqrt(stiffness_gains_[i]);
+    gains.stiffness(i,i) = stiffness_gains_[i];
+    gains.damping(i,i) = 2.0 * sqrt(stiffness_gains_[i]);
+  }
+  gains.nullspace_stiffness = 0.0;
+  gains.nullspace_damping = 0.0;
+  gain_schedule_.requestFromNonRT(gains, default_gain_transition_);
+
+  // run the control law near the neutral pose, so that the first update() after a switch to
+  // this controller is not the first time it runs
+  franka::RobotState warm_up_state;
+  if (warmUpState(node_handle, arm_id, *model_handle_, warm_up_state)) {
+    Eigen::Affine3d warm_up_transform(Eigen::Matrix4d::Map(warm_up_state.O_T_EE.data()));
+    // off the equilibrium, as while tracking (starting() resets the equilibrium)
+    position_d_ = warm_up_transform.translation() + Eigen::Vector3d::Constant(0.01);
+    orientation_d_ = Eigen::Quaterniond(warm_up_transform.linear()) *
+                     Eigen::AngleAxisd(0.05, Eigen::Vector3d::UnitZ());
+    q_d_nullspace_ = Eigen::Matrix<double, 7, 1>::Map(warm_up_state.q.data());
+    Eigen::Matrix<double, 7, 1> tau_d;
+    if (!warmUp(node_handle, "CartesianImpedanceController", [&]() {
+          tau_d = computeTorque(
+              warm_up_state, model_handle_->getCoriolis(warm_up_state),
+              model_handle_->getZeroJacobian(franka::Frame::kEndEffector, warm_up_state), gains);
+        })) {
+      return false;
+    }
+  } else {
+    ROS_WARN("CartesianImpedanceController: No neutral_pose or joint position limits, skipping "
+             "warm-up");
   }
-  
 
   position_d_.setZero();
   orientation_d_.coeffs() << 0.0, 0.0, 0.0, 1.0;
   position_d_target_.setZero();
   orientation_d_target_.coeffs() << 0.0, 0.0, 0.0, 1.0;
 
-  cartesian_stiffness_.setZero();
-  cartesian_damping_.setZero();
-
   return true;
 }
 
@@ -134,22 +206,58 @@ void CartesianImpedanceController::starting(const ros::Time& /*time*/) {
 
   // set nullspace equilibrium configuration to initial q
   q_d_nullspace_ = q_initial;
+  pose_channel_.clearFromRT();
+  trajectory_.clearFromRT();
+  trajectory_active_ = false;
 }
 
-void CartesianImpedanceController::update(const ros::Time& /*time*/,
-                                                 const ros::Duration& /*period*/) {
+void CartesianImpedanceController::update(const ros::Time& time,
+                                                 const ros::Duration& period) {
+  ScopedUpdateTimer update_timer(update_timing_);
+  RealtimeAllocationGuard allocation_guard;
+
   // get state variables
   franka::RobotState robot_state = state_handle_->getRobotState();
-  std::array<double, 7> coriolis_array = model_handle_->getCoriolis();
-  std::array<double, 42> jacobian_array =
+  const std::array<double, 7>& coriolis = model_handle_->getCoriolis();
+  const std::array<double, 42>& jacobian =
       model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
 
+  // take new targets published through the topic callbacks
+  PoseSetpoint pose_setpoint;
+  if (pose_channel_.readFromRT(pose_setpoint)) {
+    position_d_target_ = pose_setpoint.position;
+    if (orientation_d_target_.coeffs().dot(pose_setpoint.orientation.coeffs()) < 0.0) {
+      pose_setpoint.orientation.coeffs() << -pose_setpoint.orientation.coeffs();
+    }
+    orientation_d_target_ = pose_setpoint.orientation;
+    // a direct setpoint cancels any streamed trajectory
+    trajectory_.clearFromRT();
+    trajectory_active_ = false;
+  }
+  updateTrajectory(time);
+  const CartesianGains& gains = gain_schedule_.updateFromRT(period.toSec());
+
+  const Eigen::Matrix<double, 7, 1> tau_d = computeTorque(robot_state, coriolis, jacobian, gains);
+  for (size_t i = 0; i < 7; ++i) {
+    joint_handles_[i].setCommand(tau_d(i));
+  }
+
+  // move the equilibrium pose towards the target by filtering; the gains follow gain_schedule_
+  position_d_ = interpolate(position_d_, position_d_target_, filter_params_);
+  orientation_d_ = interpolate(orientation_d_, orientation_d_target_, filter_params_);
+}
+
+Eigen::Matrix<double, 7, 1> CartesianImpedanceController::computeTorque(
+    const franka::RobotState& robot_state,
+    const std::array<double, 7>& coriolis_array,
+    const std::array<double, 42>& jacobian_array,
+    const CartesianGains& gains) const {
   // convert to Eigen
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> coriolis(coriolis_array.data());
-  Eigen::Map<Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> q(robot_state.q.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> dq(robot_state.dq.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> tau_J_d(  // NOLINT (readability-identifier-naming)
+  Eigen::Map<const Eigen::Matrix<double, 7, 1>> coriolis(coriolis_array.data());
+  Eigen::Map<const Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
+  Eigen::Map<const Eigen::Matrix<double, 7, 1>> q(robot_state.q.data());
+  Eigen::Map<const Eigen::Matrix<double, 7, 1>> dq(robot_state.dq.data());
+  Eigen::Map<const Eigen::Matrix<double, 7, 1>> tau_J_d(  // NOLINT (readability-identifier-naming)
       robot_state.tau_J_d.data());
   Eigen::Affine3d transform(Eigen::Matrix4d::Map(robot_state.O_T_EE.data()));
   Eigen::Vector3d position(transform.translation());
@@ -172,83 +280,176 @@ void CartesianImpedanceController::update(const ros::Time& /*time*/,
   error.tail(3) << error_quaternion_angle_axis.axis() * error_quaternion_angle_axis.angle();
 
   // compute control
-  // allocate variables
-  Eigen::VectorXd tau_task(7), tau_nullspace(7), tau_d(7);
+  // fixed-size variables, so that the control loop never allocates
+  Eigen::Matrix<double, 7, 1> tau_task, tau_nullspace, tau_d;
 
   // pseudoinverse for nullspace handling
   // kinematic pseuoinverse
-  Eigen::MatrixXd jacobian_transpose_pinv;
-  pseudoInverse(jacobian.transpose(), jacobian_transpose_pinv);
+  const Eigen::Matrix<double, 7, 6> jacobian_transpose = jacobian.transpose();
+  Eigen::Matrix<double, 6, 7> jacobian_transpose_pinv;
+  pseudoInverse(jacobian_transpose, jacobian_transpose_pinv, pseudo_inverse_params_);
 
   // Cartesian PD control with damping ratio = 1
-  tau_task << jacobian.transpose() *
-                  (-cartesian_stiffness_ * error - cartesian_damping_ * (jacobian * dq));
+  tau_task << jacobian_transpose *
+                  (-gains.stiffness * error - gains.damping * (jacobian * dq));
   // nullspace PD control with damping ratio = 1
-  tau_nullspace << (Eigen::MatrixXd::Identity(7, 7) -
-                    jacobian.transpose() * jacobian_transpose_pinv) *
-                       (nullspace_stiffness_ * (q_d_nullspace_ - q) -
-                        (2.0 * sqrt(nullspace_stiffness_)) * dq);
+  tau_nullspace << (Eigen::Matrix<double, 7, 7>::Identity() -
+                    jacobian_transpose * jacobian_transpose_pinv) *
+                       (gains.nullspace_stiffness * (q_d_nullspace_ - q) -
+                        gains.nullspace_damping * dq);
   // Desired torque
   tau_d << tau_task + tau_nullspace + coriolis;
   // Saturate torque rate to avoid discontinuities
-  tau_d << saturateTorqueRate(tau_d, tau_J_d);
-  for (size_t i = 0; i < 7; ++i) {
-    joint_handles_[i].setCommand(tau_d(i));
-  }
-
-  // update parameters changed online either through dynamic reconfigure or through the interactive
-  // target by filtering
-  cartesian_stiffness_ = filter_params_ * cartesian_stiffness_target_ + (1.0 - filter_params_) * cartesian_stiffness_;
-  cartesian_damping_ = filter_params_ * cartesian_damping_target_ + (1.0 - filter_params_) * cartesian_damping_;
-  nullspace_stiffness_ = filter_params_ * nullspace_stiffness_target_ + (1.0 - filter_params_) * nullspace_stiffness_;
-  position_d_ = filter_params_ * position_d_target_ + (1.0 - filter_params_) * position_d_;
-  Eigen::AngleAxisd aa_orientation_d(orientation_d_);
-  Eigen::AngleAxisd aa_orientation_d_target(orientation_d_target_);
-  aa_orientation_d.axis() = filter_params_ * aa_orientation_d_target.axis() + (1.0 - filter_params_) * aa_orientation_d.axis();
-  aa_orientation_d.angle() = filter_params_ * aa_orientation_d_target.angle() + (1.0 - filter_params_) * aa_orientation_d.angle();
-  orientation_d_ = Eigen::Quaterniond(aa_orientation_d);
+  tau_d << saturateTorqueRate(tau_d, tau_J_d, delta_tau_max_);
+  return tau_d;
 }
 
-Eigen::Matrix<double, 7, 1> CartesianImpedanceController::saturateTorqueRate(
-    const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-    const Eigen::Matrix<double, 7, 1>& tau_J_d) {  // NOLINT (readability-identifier-naming)
-  Eigen::Matrix<double, 7, 1> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - tau_J_d[i];
-    tau_d_saturated[i] = tau_J_d[i] + std::max(std::min(difference, delta_tau_max_), -delta_tau_max_);
+void CartesianImpedanceController::updateTrajectory(const ros::Time& time) {
+  const double now = time.toSec();
+  const bool restart = trajectory_.takeRestartFromRT();
+  const PoseTrajectoryPoint* next = trajectory_.frontFromRT();
+  if (restart || (!trajectory_active_ && next != nullptr)) {
+    // a new trajectory starts from wherever the current target is
+    segment_start_position_ = position_d_target_;
+    segment_start_orientation_ = orientation_d_target_;
+    // a stamp in the past must not skip the first segments (or jump to a later point)
+    segment_start_time_ = (restart && next != nullptr) ? std::max(next->start, now) : now;
+    trajectory_active_ = true;
+    trajectory_idle_ = false;
+  }
+  if (!trajectory_active_) {
+    return;
+  }
+  if (next != nullptr && trajectory_idle_) {
+    // points appended after the queue ran dry are timed from now
+    segment_start_time_ = now;
+    trajectory_idle_ = false;
+  }
+
+  while (next != nullptr && segment_start_time_ + next->duration <= now) {
+    segment_start_position_ = Eigen::Vector3d::Map(next->position.data());
+    segment_start_orientation_.coeffs() = Eigen::Vector4d::Map(next->orientation.data());
+    segment_start_time_ += next->duration;
+    trajectory_.popFromRT();
+    next = trajectory_.frontFromRT();
+  }
+  if (next == nullptr) {
+    // hold the last point until more are appended
+    position_d_target_ = segment_start_position_;
+    orientation_d_target_ = segment_start_orientation_;
+    trajectory_idle_ = true;
+    return;
+  }
+  // linear in position, SLERP (along the shorter arc) in orientation
+  const double s = std::max(0.0, std::min((now - segment_start_time_) / next->duration, 1.0));
+  Eigen::Quaterniond orientation_next;
+  orientation_next.coeffs() = Eigen::Vector4d::Map(next->orientation.data());
+  position_d_target_ = (1.0 - s) * segment_start_position_ +
+                       s * Eigen::Vector3d::Map(next->position.data());
+  orientation_d_target_ = segment_start_orientation_.slerp(s, orientation_next);
+  if (orientation_d_.coeffs().dot(orientation_d_target_.coeffs()) < 0.0) {
+    orientation_d_target_.coeffs() << -orientation_d_target_.coeffs();
   }
-  return tau_d_saturated;
 }
 
 void CartesianImpedanceController::stiffnessParamCallback(
      const franka_core_msgs::CartImpedanceStiffness& msg) {
 
-  cartesian_stiffness_target_.setIdentity();
-  cartesian_damping_target_.setIdentity(); // Damping ratio = 1
+  GainTransition transition;
+  if (!transitionFromMessage(msg.transition_profile, msg.transition_time,
+                             default_gain_transition_, transition)) {
+    ROS_ERROR_STREAM("CartesianImpedanceController: Invalid transition_profile or transition_time");
+    return;
+  }
+  CartesianGains gains;
+  gains.stiffness.setIdentity();
+  gains.damping.setIdentity(); // Damping ratio = 1
   //nullspace_stiffness_target_ = config.nullspace_stiffness; TODO
+  gains.nullspace_stiffness = 0.0;
+  gains.nullspace_damping = 0.0;
 
-  cartesian_stiffness_target_(0,0) = msg.x;
-  cartesian_stiffness_target_(1,1) = msg.y;
-  cartesian_stiffness_target_(2,2) = msg.z;
-  cartesian_stiffness_target_(3,3) = msg.xrot;
-  cartesian_stiffness_target_(4,4) = msg.yrot;
-  cartesian_stiffness_target_(5,5) = msg.zrot;
-  cartesian_damping_target_(0,0) = 2.0 * sqrt(msg.x);
-  cartesian_damping_target_(1,1) = 2.0 * sqrt(msg.y);
-  cartesian_damping_target_(2,2) = 2.0 * sqrt(msg.z);
-  cartesian_damping_target_(3,3) = 2.0 * sqrt(msg.xrot);
-  cartesian_damping_target_(4,4) = 2.0 * sqrt(msg.yrot);
-  cartesian_damping_target_(5,5) = 2.0 * sqrt(msg.zrot);
+  gains.stiffness(0,0) = msg.x;
+  gains.stiffness(1,1) = msg.y;
+  gains.stiffness(2,2) = msg.z;
+  gains.stiffness(3,3) = msg.xrot;
+  gains.stiffness(4,4) = msg.yrot;
+  gains.stiffness(5,5) = msg.zrot;
+  gains.damping(0,0) = 2.0 * sqrt(msg.x);
+  gains.damping(1,1) = 2.0 * sqrt(msg.y);
+  gains.damping(2,2) = 2.0 * sqrt(msg.z);
+  gains.damping(3,3) = 2.0 * sqrt(msg.xrot);
+  gains.damping(4,4) = 2.0 * sqrt(msg.yrot);
+  gains.damping(5,5) = 2.0 * sqrt(msg.zrot);
+  gain_schedule_.requestFromNonRT(gains, transition);
 }
 
 void CartesianImpedanceController::equilibriumPoseCallback(
     const geometry_msgs::PoseStampedConstPtr& msg) {
-  position_d_target_ << msg->pose.position.x, msg->pose.position.y, msg->pose.position.z;
-  Eigen::Quaterniond last_orientation_d_target(orientation_d_target_);
-  orientation_d_target_.coeffs() << msg->pose.orientation.x, msg->pose.orientation.y,
+  // the sign of the quaternion is aligned with the previous target once it reaches the
+  // control loop
+  PoseSetpoint setpoint;
+  setpoint.position << msg->pose.position.x, msg->pose.position.y, msg->pose.position.z;
+  setpoint.orientation.coeffs() << msg->pose.orientation.x, msg->pose.orientation.y,
       msg->pose.orientation.z, msg->pose.orientation.w;
-  if (last_orientation_d_target.coeffs().dot(orientation_d_target_.coeffs()) < 0.0) {
-    orientation_d_target_.coeffs() << -orientation_d_target_.coeffs();
+  pose_channel_.writeFromNonRT(setpoint);
+}
+
+void CartesianImpedanceController::equilibriumPoseTrajectoryCallback(
+    const franka_core_msgs::CartImpedanceTrajectory& msg) {
+  if (msg.points.size() > kTrajectoryCapacity) {
+    ROS_ERROR_STREAM("CartesianImpedanceController: Trajectory has " << msg.points.size()
+                     << " points, at most " << kTrajectoryCapacity << " can be queued");
+    return;
+  }
+  std::lock_guard<std::mutex> lock(trajectory_chunk_mutex_);
+  trajectory_chunk_.clear();
+  // the first point is timed from the trajectory start, or from the last queued point when
+  // appending
+  double previous_time = 0.0;
+  for (const auto& p : msg.points) {
+    const double time = p.time_from_start.toSec();
+    if (time < previous_time) {
+      ROS_ERROR_STREAM(
+          "CartesianImpedanceController: Trajectory time_from_start must not decrease");
+      return;
+    }
+    Eigen::Quaterniond orientation(p.pose.orientation.w, p.pose.orientation.x,
+                                   p.pose.orientation.y, p.pose.orientation.z);
+    if (orientation.norm() < 1e-6) {
+      ROS_ERROR_STREAM("CartesianImpedanceController: Trajectory contains an invalid orientation");
+      return;
+    }
+    orientation.normalize();
+    const double duration = time - previous_time;
+    if (!trajectory_chunk_.empty()) {
+      // the first point starts from the target the controller has when it arrives
+      const PoseTrajectoryPoint& previous = trajectory_chunk_.back();
+      Eigen::Quaterniond previous_orientation;
+      previous_orientation.coeffs() = Eigen::Vector4d::Map(previous.orientation.data());
+      const double distance =
+          (Eigen::Vector3d(p.pose.position.x, p.pose.position.y, p.pose.position.z) -
+           Eigen::Vector3d::Map(previous.position.data()))
+              .norm();
+      if (distance > max_translational_velocity_ * duration ||
+          orientation.angularDistance(previous_orientation) > max_rotational_velocity_ * duration) {
+        ROS_ERROR_STREAM("CartesianImpedanceController: Trajectory point "
+                         << trajectory_chunk_.size()
+                         << " is beyond the trajectory velocity limits, rejecting the trajectory");
+        return;
+      }
+    }
+    PoseTrajectoryPoint point{};
+    point.position = {p.pose.position.x, p.pose.position.y, p.pose.position.z};
+    point.orientation = {orientation.x(), orientation.y(), orientation.z(), orientation.w()};
+    point.duration = duration;
+    point.start = msg.header.stamp.toSec();
+    trajectory_chunk_.push_back(point);
+    previous_time = time;
+  }
+  if (!trajectory_.writeFromNonRT(trajectory_chunk_.data(), trajectory_chunk_.size(),
+                                  !msg.append)) {
+    ROS_ERROR_STREAM("CartesianImpedanceController: Trajectory buffer is full, dropping "
+                     << msg.points.size() << " points");
   }
 }
 
@@ -0,0 +1,51 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/command_queue.h>
+
+#include <atomic>
+
+namespace franka_ros_controllers {
+
+namespace {
+
+std::atomic<ros::CallbackQueue*> command_queue{nullptr};
+
+}  // anonymous namespace
+
+void setCommandCallbackQueue(ros::CallbackQueue* queue) {
+  command_queue.store(queue);
+}
+
+ros::NodeHandle commandNodeHandle(const ros::NodeHandle& node_handle) {
+  ros::NodeHandle command_node_handle(node_handle);
+  ros::CallbackQueue* queue = command_queue.load();
+  if (queue != nullptr) {
+    command_node_handle.setCallbackQueue(queue);
+  }
+  return command_node_handle;
+}
+
+}  // namespace franka_ros_controllers
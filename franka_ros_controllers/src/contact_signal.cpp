@@ -0,0 +1,90 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/contact_signal.h>
+
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace franka_ros_controllers {
+
+ContactSignal& ContactSignal::forArm(const std::string& arm_id) {
+  // unique_ptr: entries never move once created, and the constructor stays private
+  static std::mutex mutex;
+  static std::deque<std::pair<std::string, std::unique_ptr<ContactSignal>>> entries;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const auto& entry : entries) {
+    if (entry.first == arm_id) {
+      return *entry.second;
+    }
+  }
+  entries.emplace_back(arm_id, std::unique_ptr<ContactSignal>(new ContactSignal()));
+  return *entries.back().second;
+}
+
+ContactSignal::ContactSignal() { sem_init(&semaphore_, 0, 0); }
+
+ContactSignal::~ContactSignal() { sem_destroy(&semaphore_); }
+
+void ContactSignal::raise(uint8_t sources) {
+  const uint8_t previous = sources_.exchange(sources, std::memory_order_acq_rel);
+  if (previous == 0 && sources != 0) {
+    onsets_.fetch_add(1, std::memory_order_acq_rel);
+  }
+  // several changes before the waiter runs are reported once, with the latest state
+  int pending = 0;
+  if (sem_getvalue(&semaphore_, &pending) == 0 && pending > 0) {
+    return;
+  }
+  sem_post(&semaphore_);
+}
+
+bool ContactSignal::wait(double timeout, uint8_t& sources, uint64_t& onsets) {
+  timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  double seconds = 0.0;
+  const double fraction = std::modf(timeout, &seconds);
+  deadline.tv_sec += static_cast<time_t>(seconds);
+  deadline.tv_nsec += static_cast<long>(fraction * 1e9);
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  while (sem_timedwait(&semaphore_, &deadline) != 0) {
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+  sources = sources_.load(std::memory_order_acquire);
+  onsets = onsets_.load(std::memory_order_acquire);
+  return true;
+}
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,57 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/controller_timing.h>
+
+namespace franka_ros_controllers {
+
+ControllerTiming& ControllerTiming::instance() {
+  static ControllerTiming timing;
+  return timing;
+}
+
+ControllerTiming::Histogram* ControllerTiming::acquire(const std::string& controller_name) {
+  if (!enabled()) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Entry& entry : entries_) {
+    if (entry.name == controller_name) {
+      return &entry.histogram;
+    }
+  }
+  entries_.emplace_back(controller_name);
+  return &entries_.back().histogram;
+}
+
+void ControllerTiming::forEach(
+    const std::function<void(const std::string&, const Histogram&)>& visitor) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const Entry& entry : entries_) {
+    visitor(entry.name, entry.histogram);
+  }
+}
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,94 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/controller_warmup.h>
+
+#include <chrono>
+#include <vector>
+
+#include <ros/console.h>
+
+#include <franka_ros_controllers/arm_config.h>
+
+namespace franka_ros_controllers {
+
+bool warmUpState(const ros::NodeHandle& node_handle, const std::string& arm_id,
+                 const CachedFrankaModelHandle& model, franka::RobotState& state) {
+  const std::shared_ptr<const RobotConfig> config = RobotConfig::get(node_handle);
+  const std::vector<double>& neutral_pose = config->neutralPose(arm_id);
+  const franka_core_msgs::JointLimits& limits = config->jointLimits(arm_id);
+  if (neutral_pose.size() == state.q.size()) {
+    std::copy(neutral_pose.begin(), neutral_pose.end(), state.q.begin());
+  } else if (limits.position_lower.size() == state.q.size() &&
+             limits.position_upper.size() == state.q.size()) {
+    for (size_t i = 0; i < state.q.size(); ++i) {
+      state.q[i] = 0.5 * (limits.position_lower[i] + limits.position_upper[i]);
+    }
+  } else {
+    return false;
+  }
+  state.q_d = state.q;
+  state.dq.fill(0.0);
+  state.dq_d.fill(0.0);
+  state.F_T_EE = {{1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0}};
+  state.EE_T_K = state.F_T_EE;
+  state.m_total = 0.0;
+  state.I_total.fill(0.0);
+  state.F_x_Ctotal.fill(0.0);
+  state.O_T_EE = model.getPose(franka::Frame::kEndEffector, state);
+  state.O_T_EE_d = state.O_T_EE;
+  // holding still: the measured and commanded torques only compensate gravity
+  state.tau_J = model.getGravity(state);
+  state.tau_J_d = state.tau_J;
+  return true;
+}
+
+bool warmUp(const ros::NodeHandle& node_handle, const std::string& controller_name,
+            const std::function<void()>& cycle) {
+  int cycles(100);
+  node_handle.getParam("warm_up_cycles", cycles);
+  if (cycles < 0) {
+    ROS_ERROR_STREAM(controller_name << ": Invalid warm_up_cycles " << cycles
+                     << ", aborting controller init!");
+    return false;
+  }
+  double first_us(0.0), last_us(0.0);
+  for (int i = 0; i < cycles; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    cycle();
+    last_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+                  .count();
+    if (i == 0) {
+      first_us = last_us;
+    }
+  }
+  if (cycles > 0) {
+    ROS_INFO("%s: %d warm-up cycles, first %.1f us, last %.1f us", controller_name.c_str(),
+             cycles, first_us, last_us);
+  }
+  return true;
+}
+
+}  // namespace franka_ros_controllers
@@ -38,8 +38,9 @@ namespace franka_ros_controllers {
 
 bool EffortJointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
                                            ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
   std::string arm_id;
-  if (!node_handle.getParam("/robot_config/arm_id", arm_id)) {
+  if (!readArmId(node_handle, arm_id)) {
     ROS_ERROR("EffortJointImpedanceController: Could not read parameter arm_id");
     return false;
   }
@@ -49,93 +50,48 @@ bool EffortJointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
     ROS_ERROR("EffortJointImpedanceController: Could not get Franka state interface from hardware");
     return false;
   }
-  if (!node_handle.getParam("/robot_config/joint_names", joint_limits_.joint_names) || joint_limits_.joint_names.size() != 7) {
+  joint_limits_ = RobotConfig::get(node_handle)->jointLimits(arm_id);
+  if (joint_limits_.joint_names.size() != 7) {
     ROS_ERROR(
         "EffortJointImpedanceController: Invalid or no joint_names parameters provided, aborting "
         "controller init!");
     return false;
   }
 
-  if (!node_handle.getParam("k_gains", k_gains_) || k_gains_.size() != 7) {
+  std::vector<double> k_gains;
+  if (!node_handle.getParam("k_gains", k_gains) || k_gains.size() != 7) {
     ROS_ERROR(
         "EffortJointImpedanceController:  Invalid or no k_gain parameters provided, aborting "
         "controller init!");
     return false;
   }
 
-  if (!node_handle.getParam("d_gains", d_gains_) || d_gains_.size() != 7) {
+  std::vector<double> d_gains;
+  if (!node_handle.getParam("d_gains", d_gains) || d_gains.size() != 7) {
     ROS_ERROR(
         "EffortJointImpedanceController:  Invalid or no d_gain parameters provided, aborting "
         "controller init!");
     return false;
   }
 
-  k_gains_target_.clear();
-  d_gains_target_.clear();
-
-  // k_gains_target_.resize(k_gains_.size());
-  // d_gains_target_.resize(d_gains_.size());
-
-  std::map<std::string, double> pos_limit_lower_map;
-  std::map<std::string, double> pos_limit_upper_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/lower", pos_limit_lower_map) ) {
-  ROS_ERROR(
-      "EffortJointImpedanceController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/upper", pos_limit_upper_map) ) {
-  ROS_ERROR(
-      "EffortJointImpedanceController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-
-
-  std::map<std::string, double> velocity_limit_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_velocity_limit", velocity_limit_map))
-  {
-    ROS_ERROR("EffortJointImpedanceController: Failed to find joint velocity limits on the param server. Aborting controller init");
+  JointGains initial_gains;
+  std::copy(k_gains.begin(), k_gains.end(), initial_gains.k.begin());
+  std::copy(d_gains.begin(), d_gains.end(), initial_gains.d.begin());
+
+  if (joint_limits_.position_lower.size() != 7 ||
+      joint_limits_.position_upper.size() != 7 ||
+      joint_limits_.velocity.size() != 7) {
+    ROS_ERROR(
+        "EffortJointImpedanceController: Joint limits parameters not provided, aborting "
+        "controller init!");
     return false;
   }
 
-  for (size_t i = 0; i < joint_limits_.joint_names.size(); ++i){
-    if (pos_limit_lower_map.find(joint_limits_.joint_names[i]) != pos_limit_lower_map.end())
-      {
-        joint_limits_.position_lower.push_back(pos_limit_lower_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("EffortJointImpedanceController: Unable to find lower position limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-    if (pos_limit_upper_map.find(joint_limits_.joint_names[i]) != pos_limit_upper_map.end())
-      {
-        joint_limits_.position_upper.push_back(pos_limit_upper_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("EffortJointImpedanceController: Unable to find upper position limit  values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-    if (velocity_limit_map.find(joint_limits_.joint_names[i]) != velocity_limit_map.end())
-      {
-        joint_limits_.velocity.push_back(velocity_limit_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("EffortJointImpedanceController: Unable to find velocity limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-    // ROS_INFO_STREAM("K: "<<k_gains_target_[i]);
-  }  
-
   double controller_state_publish_rate(30.0);
   if (!node_handle.getParam("controller_state_publish_rate", controller_state_publish_rate)) {
     ROS_INFO_STREAM("EffortJointImpedanceController: Did not find controller_state_publish_rate. Using default "
                     << controller_state_publish_rate << " [Hz].");
   }
-  trigger_publish_ = franka_hw::TriggerRate(controller_state_publish_rate);
 
   if (!node_handle.getParam("coriolis_factor", coriolis_factor_)) {
     ROS_INFO_STREAM("EffortJointImpedanceController: coriolis_factor not found. Defaulting to "
@@ -149,8 +105,7 @@ bool EffortJointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
     return false;
   }
   try {
-    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
-        model_interface->getHandle(arm_id + "_model"));
+    model_handle_ = CachedFrankaModelHandle::acquire(robot_hw, arm_id);
   } catch (hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM(
         "EffortJointImpedanceController: Exception getting model handle from interface: "
@@ -181,14 +136,11 @@ bool EffortJointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
           "EffortJointImpedanceController: Exception getting joint handles: " << ex.what());
       return false;
     }
-
-    k_gains_target_.push_back(k_gains_[i]);
-    d_gains_target_.push_back(d_gains_[i]);
   }
 
 
   dynamic_reconfigure_controller_gains_node_ =
-      ros::NodeHandle("/franka_ros_interface/effort_joint_impedance_controller/arm/controller_parameters_config");
+      ros::NodeHandle(armTopic(node_handle, arm_id, "/franka_ros_interface/effort_joint_impedance_controller/arm/controller_parameters_config"));
 
   dynamic_server_controller_config_ = std::make_unique<
       dynamic_reconfigure::Server<franka_ros_controllers::joint_controller_paramsConfig>>(
@@ -197,27 +149,40 @@ bool EffortJointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
   dynamic_server_controller_config_->setCallback(
       boost::bind(&EffortJointImpedanceController::controllerConfigCallback, this, _1, _2));
 
-  desired_joints_subscriber_ = node_handle.subscribe(
-      "/franka_ros_interface/motion_controller/arm/joint_commands", 20, &EffortJointImpedanceController::jointCmdCallback, this,
-      ros::TransportHints().reliable().tcpNoDelay());
+  bool shm_enabled = false;
+  node_handle.param<bool>("/robot_config/shm_transport/enabled", shm_enabled, false);
+  if (shm_enabled) {
+    std::string shm_name;
+    std::string shm_error;
+    node_handle.param<std::string>("/robot_config/shm_transport/name", shm_name,
+                                   "franka_ros_interface");
+    shm_name = armResourceName(node_handle, arm_id, shm_name);
+    if (!shm_transport_.open(shm_name, true, shm_error)) {
+      ROS_ERROR_STREAM("EffortJointImpedanceController: Could not open shared-memory transport: " << shm_error);
+      return false;
+    }
+    // same limit as the watchdog of the topic path
+    node_handle.param<double>("/controllers_config/command_timeout", shm_command_timeout_, 0.2);
+    shm_report_timer_ = node_handle.createTimer(
+        ros::Duration(1.0), &EffortJointImpedanceController::reportShmEvents, this);
+  }
 
-  publisher_controller_states_.init(node_handle, "/franka_ros_interface/motion_controller/arm/joint_controller_states", 1);
+  desired_joints_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_commands"), 20, &EffortJointImpedanceController::jointCmdCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  command_batch_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_command_batch"), 20, &EffortJointImpedanceController::jointCmdBatchCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
 
-  {
-    std::lock_guard<realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> > lock(
-        publisher_controller_states_);
-    publisher_controller_states_.msg_.controller_name = "effort_joint_impedance_controller";
-    publisher_controller_states_.msg_.names.resize(joint_limits_.joint_names.size());
-    publisher_controller_states_.msg_.joint_controller_states.resize(joint_limits_.joint_names.size());
-
-  }
+  controller_state_publisher_.init(
+      node_handle, armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_controller_states"),
+      "effort_joint_impedance_controller", joint_limits_.joint_names, controller_state_publish_rate);
 
   std::fill(dq_filtered_.begin(), dq_filtered_.end(), 0);
 
-  for (size_t i = 0; i < 7; ++i) { // this has to be done again; apparently when the dyn callback is initialised everything is set to zeros again!?
-    k_gains_target_[i] = k_gains_[i];
-    d_gains_target_[i] = d_gains_[i];
-  }
+  // setCallback() above already requested the gains of the dynamic_reconfigure defaults;
+  // start from the configured ones instead
+  gain_schedule_.reset(initial_gains);
 
   return true;
 }
@@ -227,123 +192,152 @@ void EffortJointImpedanceController::starting(const ros::Time& /*time*/) {
 
   for (size_t i = 0; i < 7; ++i) {
     initial_pos_[i] = robot_state.q[i];
-    std::cout << "---- Joint Number: " << i  << std::endl;
-    std::cout << "Joint Pos: " << initial_pos_[i]  << std::endl;
-    std::cout << "K_des: " << k_gains_target_[i]  << std::endl;
-    std::cout << "D_des: " << d_gains_target_[i]  << std::endl;
-    std::cout << std::endl;
+    ROS_DEBUG_STREAM("EffortJointImpedanceController: joint " << i << ": pos "
+                     << initial_pos_[i] << ", k " << gain_schedule_.target().k[i] << ", d "
+                     << gain_schedule_.target().d[i]);
   }
   prev_pos_ = initial_pos_;
   pos_d_target_ = initial_pos_;
 
   std::fill(dq_filtered_.begin(), dq_filtered_.end(), 0);
   dq_d_ = dq_filtered_;
+  setpoint_channel_.clearFromRT();
+  command_batch_.clearFromRT();
+  if (shm_transport_.isOpen()) {
+    shm_transport_.syncCommand();
+  }
 }
 
 void EffortJointImpedanceController::update(const ros::Time& time,
                                              const ros::Duration& period) {
+  ScopedUpdateTimer update_timer(update_timing_);
   franka::RobotState robot_state = franka_state_handle_->getRobotState();
   std::array<double, 7> coriolis = model_handle_->getCoriolis();
 
-  double alpha = 0.99;
-  for (size_t i = 0; i < 7; i++) {
-    dq_filtered_[i] = (1 - alpha) * dq_filtered_[i] + alpha * robot_state.dq[i];
+  JointSetpoint setpoint;
+  if (setpoint_channel_.readFromRT(setpoint)) {
+    // a single command overrides the queued waypoints
+    command_batch_.clearFromRT();
+    if (setpoint.hold) {
+      pos_d_target_ = prev_pos_;
+    } else {
+      pos_d_target_ = setpoint.position;
+      dq_d_ = setpoint.velocity;
+    }
   }
-
-  std::array<double, 7> tau_d_calculated{};
-  for (size_t i = 0; i < 7; ++i) {
-    tau_d_calculated[i] = coriolis_factor_ * coriolis[i] +
-                          k_gains_[i] * (pos_d_target_[i] - robot_state.q[i]) +
-                          d_gains_[i] * (dq_d_[i] - dq_filtered_[i]);
+  JointWaypoint waypoint;
+  if (command_batch_.readFromRT(time, waypoint)) {
+    pos_d_target_ = waypoint.position;
+    dq_d_ = waypoint.velocity;
+  }
+  shm::CommandStatus shm_status =
+      shm_transport_.isOpen()
+          ? shm_transport_.pollCommand(time.toSec(), shm_command_timeout_,
+                                       franka_core_msgs::JointCommand::IMPEDANCE_MODE,
+                                       shm_command_)
+          : shm::CommandStatus::kNone;
+  if (shm_status == shm::CommandStatus::kNew) {
+    if (checkPositionLimits(shm_command_.position) ||
+        checkVelocityLimits(shm_command_.velocity)) {
+      shm_events_.countRejected();
+      pos_d_target_ = prev_pos_;
+    } else {
+      std::copy_n(shm_command_.position, 7, pos_d_target_.begin());
+      std::copy_n(shm_command_.velocity, 7, dq_d_.begin());
+    }
+  } else if (shm_status == shm::CommandStatus::kTimedOut) {
+    // the client stalled or died: hold the current position instead of chasing its last target
+    shm_events_.countTimeout();
+    pos_d_target_ = prev_pos_;
+    std::fill(dq_d_.begin(), dq_d_.end(), 0.0);
   }
 
-  // Maximum torque difference with a sampling rate of 1 kHz. The maximum torque rate is
-  // 1000 * (1 / sampling_time).
-  std::array<double, 7> tau_d_saturated = saturateTorqueRate(tau_d_calculated, robot_state.tau_J_d);
-
-  if (trigger_publish_() && publisher_controller_states_.trylock()) {
-      for (size_t i = 0; i < 7; ++i){
+  const JointGains& gains = gain_schedule_.updateFromRT(period.toSec());
 
-        publisher_controller_states_.msg_.joint_controller_states[i].set_point = pos_d_target_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].process_value = robot_state.q[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].process_value_dot = robot_state.dq[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].error = pos_d_target_[i] - robot_state.q[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].time_step = period.toSec();
-        publisher_controller_states_.msg_.joint_controller_states[i].command = tau_d_calculated[i];
+  double alpha = 0.99;
+  exponentialFilter(mapJoints(dq_filtered_), mapJoints(robot_state.dq), alpha);
 
-        publisher_controller_states_.msg_.joint_controller_states[i].p = k_gains_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].d = d_gains_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].header.stamp = time;
-      }
+  std::array<double, 7> tau_d_calculated;
+  mapJoints(tau_d_calculated) = pdCoriolisTorque(
+      mapJoints(pos_d_target_), mapJoints(robot_state.q), mapJoints(dq_d_), mapJoints(dq_filtered_),
+      mapJoints(gains.k), mapJoints(gains.d), mapJoints(coriolis), coriolis_factor_);
 
-      publisher_controller_states_.unlockAndPublish();
+  // Maximum torque difference with a sampling rate of 1 kHz. The maximum torque rate is
+  // 1000 * (1 / sampling_time).
+  std::array<double, 7> tau_d_saturated =
+      saturateTorqueRate(tau_d_calculated, robot_state.tau_J_d, kDeltaTauMax);
+
+  if (JointControllerSample* sample = controller_state_publisher_.claim()) {
+    sample->stamp = time;
+    sample->time_step = period.toSec();
+    for (size_t i = 0; i < 7; ++i) {
+      sample->set_point[i] = pos_d_target_[i];
+      sample->process_value[i] = robot_state.q[i];
+      sample->process_value_dot[i] = robot_state.dq[i];
+      sample->error[i] = pos_d_target_[i] - robot_state.q[i];
+      sample->command[i] = tau_d_calculated[i];
+      sample->p[i] = gains.k[i];
+      sample->d[i] = gains.d[i];
     }
+    controller_state_publisher_.commit();
+  }
 
   for (size_t i = 0; i < 7; ++i) {
     joint_handles_[i].setCommand(tau_d_saturated[i]);
 
     prev_pos_[i] = robot_state.q[i];
-
-    k_gains_[i] = filter_params_ * k_gains_target_[i] + (1.0 - filter_params_) * k_gains_[i];
-    d_gains_[i] = filter_params_ * d_gains_target_[i] + (1.0 - filter_params_) * d_gains_[i];
-
-
   }
 
 }
 
-bool EffortJointImpedanceController::checkPositionLimits(std::vector<double> positions)
+template <typename Container>
+bool EffortJointImpedanceController::checkPositionLimits(const Container& positions)
 {
-  for (size_t i = 0;  i < 7; ++i){
-    if (!((positions[i] <= joint_limits_.position_upper[i]) && (positions[i] >= joint_limits_.position_lower[i]))){
-      return true;
-    }
-  }
-
-  return false;
+  return !withinLimits(mapJoints(positions), mapJoints(joint_limits_.position_lower),
+                       mapJoints(joint_limits_.position_upper));
 }
 
-bool EffortJointImpedanceController::checkVelocityLimits(std::vector<double> velocities)
+template <typename Container>
+bool EffortJointImpedanceController::checkVelocityLimits(const Container& velocities)
 {
-  // bool retval = true;
-  for (size_t i = 0;  i < 7; ++i){
-    if (!(abs(velocities[i]) <= joint_limits_.velocity[i])){
-      return true;
-    }
-  }
-
-  return false;
+  return !withinMagnitude(mapJoints(velocities), mapJoints(joint_limits_.velocity));
 }
 
-std::array<double, 7> EffortJointImpedanceController::saturateTorqueRate(
-  const std::array<double, 7>& tau_d_calculated,
-    const std::array<double, 7>& tau_J_d) {  // NOLINT (readability-identifier-naming)
-  std::array<double, 7> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - tau_J_d[i];
-    tau_d_saturated[i] = tau_J_d[i] + std::max(std::min(difference, kDeltaTauMax), -kDeltaTauMax);
+void EffortJointImpedanceController::reportShmEvents(const ros::TimerEvent&) {
+  uint64_t rejected, timeouts;
+  shm_events_.takeNew(rejected, timeouts);
+  if (rejected > 0) {
+    ROS_ERROR_STREAM("EffortJointImpedanceController: Rejected " << rejected
+                     << " shared-memory commands beyond the position or velocity limits.");
+  }
+  if (timeouts > 0) {
+    ROS_WARN_STREAM("EffortJointImpedanceController: No shared-memory command for "
+                    << shm_command_timeout_ << " s, holding position.");
   }
-  return tau_d_saturated;
 }
 
 void EffortJointImpedanceController::jointCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg) {
 
   if (msg->mode == franka_core_msgs::JointCommand::IMPEDANCE_MODE){
+    JointSetpoint setpoint{};
     if (msg->position.size() != 7) {
       ROS_ERROR_STREAM(
           "EffortJointImpedanceController: Published Commands are not of size 7");
-      pos_d_target_ = prev_pos_;
+      setpoint.hold = true;
+      setpoint_channel_.rejectFromNonRT();
     }
     else if (checkPositionLimits(msg->position) || checkVelocityLimits(msg->velocity)) {
          ROS_ERROR_STREAM(
             "EffortJointImpedanceController: Commanded positions or velicities are beyond allowed position limits.");
-        pos_d_target_ = prev_pos_;
+        setpoint.hold = true;
+        setpoint_channel_.rejectFromNonRT();
 
     }
     else {
-      std::copy_n(msg->position.begin(), 7, pos_d_target_.begin());
-      std::copy_n(msg->velocity.begin(), 7, dq_d_.begin()); // if velocity is not there, the controller fails!!
+      std::copy_n(msg->position.begin(), 7, setpoint.position.begin());
+      std::copy_n(msg->velocity.begin(), 7, setpoint.velocity.begin()); // if velocity is not there, the controller fails!!
     }
+    setpoint_channel_.writeFromNonRT(setpoint);
   }
   // else ROS_ERROR_STREAM("EffortJointImpedanceController: Published Command msg are not of JointCommand::IMPEDANCE_MODE! Dropping message");
 }
@@ -352,22 +346,47 @@ void EffortJointImpedanceController::controllerConfigCallback(
     franka_ros_controllers::joint_controller_paramsConfig& config,
     uint32_t /*level*/) {
     ROS_DEBUG_STREAM("EffortJointImpedanceController: Updating Config");
-    k_gains_target_[0] = config.groups.controller_gains.j1_k;
-    k_gains_target_[1] = config.groups.controller_gains.j2_k;
-    k_gains_target_[2] = config.groups.controller_gains.j3_k;
-    k_gains_target_[3] = config.groups.controller_gains.j4_k;
-    k_gains_target_[4] = config.groups.controller_gains.j5_k;
-    k_gains_target_[5] = config.groups.controller_gains.j6_k;
-    k_gains_target_[6] = config.groups.controller_gains.j7_k;
-
-    d_gains_target_[0] = config.groups.controller_gains.j1_d;
-    d_gains_target_[1] = config.groups.controller_gains.j2_d;
-    d_gains_target_[2] = config.groups.controller_gains.j3_d;
-    d_gains_target_[3] = config.groups.controller_gains.j4_d;
-    d_gains_target_[4] = config.groups.controller_gains.j5_d;
-    d_gains_target_[5] = config.groups.controller_gains.j6_d;
-    d_gains_target_[6] = config.groups.controller_gains.j7_d;
+    JointGains gains;
+    gains.k[0] = config.groups.controller_gains.j1_k;
+    gains.k[1] = config.groups.controller_gains.j2_k;
+    gains.k[2] = config.groups.controller_gains.j3_k;
+    gains.k[3] = config.groups.controller_gains.j4_k;
+    gains.k[4] = config.groups.controller_gains.j5_k;
+    gains.k[5] = config.groups.controller_gains.j6_k;
+    gains.k[6] = config.groups.controller_gains.j7_k;
+
+    gains.d[0] = config.groups.controller_gains.j1_d;
+    gains.d[1] = config.groups.controller_gains.j2_d;
+    gains.d[2] = config.groups.controller_gains.j3_d;
+    gains.d[3] = config.groups.controller_gains.j4_d;
+    gains.d[4] = config.groups.controller_gains.j5_d;
+    gains.d[5] = config.groups.controller_gains.j6_d;
+    gains.d[6] = config.groups.controller_gains.j7_d;
+
+    GainTransition transition;
+    transition.profile = static_cast<TransitionProfile>(config.groups.gain_transition.gain_transition_profile);
+    transition.duration = config.groups.gain_transition.gain_transition_time;
+    gain_schedule_.requestFromNonRT(gains, transition);
+
+}
 
+void EffortJointImpedanceController::jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg) {
+  if (msg->mode != franka_core_msgs::JointCommand::IMPEDANCE_MODE) {
+    return;
+  }
+  std::string error;
+  if (!command_batch_.writeFromNonRT(*msg,
+                                     [this](const JointWaypoint& waypoint) {
+                                       return !(checkPositionLimits(waypoint.position) ||
+                                                checkVelocityLimits(waypoint.velocity));
+                                     },
+                                     error)) {
+    ROS_ERROR_STREAM("EffortJointImpedanceController: Rejected command batch: " << error);
+    JointSetpoint setpoint{};
+    setpoint.hold = true;
+    setpoint_channel_.rejectFromNonRT();
+    setpoint_channel_.writeFromNonRT(setpoint);
+  }
 }
 
 }  // namespace franka_ros_controllers
@@ -38,8 +38,9 @@ namespace franka_ros_controllers {
 
 bool EffortJointPositionController::init(hardware_interface::RobotHW* robot_hw,
                                            ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
   std::string arm_id;
-  if (!node_handle.getParam("/robot_config/arm_id", arm_id)) {
+  if (!readArmId(node_handle, arm_id)) {
     ROS_ERROR("EffortJointPositionController: Could not read parameter arm_id");
     return false;
   }
@@ -49,73 +50,47 @@ bool EffortJointPositionController::init(hardware_interface::RobotHW* robot_hw,
     ROS_ERROR("EffortJointPositionController: Could not get Franka state interface from hardware");
     return false;
   }
-  if (!node_handle.getParam("/robot_config/joint_names", joint_limits_.joint_names) || joint_limits_.joint_names.size() != 7) {
+  joint_limits_ = RobotConfig::get(node_handle)->jointLimits(arm_id);
+  if (joint_limits_.joint_names.size() != 7) {
     ROS_ERROR(
         "EffortJointPositionController: Invalid or no joint_names parameters provided, aborting "
         "controller init!");
     return false;
   }
 
-  if (!node_handle.getParam("k_gains", k_gains_) || k_gains_.size() != 7) {
+  std::vector<double> k_gains;
+  if (!node_handle.getParam("k_gains", k_gains) || k_gains.size() != 7) {
     ROS_ERROR(
         "EffortJointPositionController:  Invalid or no k_gain parameters provided, aborting "
         "controller init!");
     return false;
   }
 
-  if (!node_handle.getParam("d_gains", d_gains_) || d_gains_.size() != 7) {
+  std::vector<double> d_gains;
+  if (!node_handle.getParam("d_gains", d_gains) || d_gains.size() != 7) {
     ROS_ERROR(
         "EffortJointPositionController:  Invalid or no d_gain parameters provided, aborting "
         "controller init!");
     return false;
   }
 
-  k_gains_target_.clear();
-  d_gains_target_.clear();
-
-
-  std::map<std::string, double> pos_limit_lower_map;
-  std::map<std::string, double> pos_limit_upper_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/lower", pos_limit_lower_map) ) {
-  ROS_ERROR(
-      "EffortJointPositionController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/upper", pos_limit_upper_map) ) {
-  ROS_ERROR(
-      "EffortJointPositionController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-
-  for (size_t i = 0; i < joint_limits_.joint_names.size(); ++i){
-    if (pos_limit_lower_map.find(joint_limits_.joint_names[i]) != pos_limit_lower_map.end())
-      {
-        joint_limits_.position_lower.push_back(pos_limit_lower_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("EffortJointPositionController: Unable to find lower position limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-    if (pos_limit_upper_map.find(joint_limits_.joint_names[i]) != pos_limit_upper_map.end())
-      {
-        joint_limits_.position_upper.push_back(pos_limit_upper_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("EffortJointPositionController: Unable to find upper position limit  values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-  }  
+  JointGains initial_gains;
+  std::copy(k_gains.begin(), k_gains.end(), initial_gains.k.begin());
+  std::copy(d_gains.begin(), d_gains.end(), initial_gains.d.begin());
+
+  if (joint_limits_.position_lower.size() != 7 ||
+      joint_limits_.position_upper.size() != 7) {
+    ROS_ERROR(
+        "EffortJointPositionController: Joint limits parameters not provided, aborting "
+        "controller init!");
+    return false;
+  }
 
   double controller_state_publish_rate(30.0);
   if (!node_handle.getParam("controller_state_publish_rate", controller_state_publish_rate)) {
     ROS_INFO_STREAM("EffortJointPositionController: Did not find controller_state_publish_rate. Using default "
                     << controller_state_publish_rate << " [Hz].");
   }
-  trigger_publish_ = franka_hw::TriggerRate(controller_state_publish_rate);
 
 
   try {
@@ -141,12 +116,10 @@ bool EffortJointPositionController::init(hardware_interface::RobotHW* robot_hw,
           "EffortJointPositionController: Exception getting joint handles: " << ex.what());
       return false;
     }
-    k_gains_target_.push_back(k_gains_[i]);
-    d_gains_target_.push_back(d_gains_[i]);
   }
 
   dynamic_reconfigure_controller_gains_node_ =
-      ros::NodeHandle("/franka_ros_interface/effort_joint_position_controller/arm/controller_parameters_config");
+      ros::NodeHandle(armTopic(node_handle, arm_id, "/franka_ros_interface/effort_joint_position_controller/arm/controller_parameters_config"));
 
   dynamic_server_controller_config_ = std::make_unique<
       dynamic_reconfigure::Server<franka_ros_controllers::joint_controller_paramsConfig>>(
@@ -155,25 +128,20 @@ bool EffortJointPositionController::init(hardware_interface::RobotHW* robot_hw,
   dynamic_server_controller_config_->setCallback(
       boost::bind(&EffortJointPositionController::controllerConfigCallback, this, _1, _2));
 
-  desired_joints_subscriber_ = node_handle.subscribe(
-      "/franka_ros_interface/motion_controller/arm/joint_commands", 20, &EffortJointPositionController::jointCmdCallback, this,
+  desired_joints_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_commands"), 20, &EffortJointPositionController::jointCmdCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  command_batch_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_command_batch"), 20, &EffortJointPositionController::jointCmdBatchCallback, this,
       ros::TransportHints().reliable().tcpNoDelay());
 
-  publisher_controller_states_.init(node_handle, "/franka_ros_interface/motion_controller/arm/joint_controller_states", 1);
-
-  {
-    std::lock_guard<realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> > lock(
-        publisher_controller_states_);
-    publisher_controller_states_.msg_.controller_name = "effort_joint_position_controller";
-    publisher_controller_states_.msg_.names.resize(joint_limits_.joint_names.size());
-    publisher_controller_states_.msg_.joint_controller_states.resize(joint_limits_.joint_names.size());
+  controller_state_publisher_.init(
+      node_handle, armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_controller_states"),
+      "effort_joint_position_controller", joint_limits_.joint_names, controller_state_publish_rate);
 
-  }
-
-  for (size_t i = 0; i < 7; ++i) { // this has to be done again; apparently when the dyn callback is initialised everything is set to zeros again!?
-    k_gains_target_[i] = k_gains_[i];
-    d_gains_target_[i] = d_gains_[i];
-  }
+  // setCallback() above already requested the gains of the dynamic_reconfigure defaults;
+  // start from the configured ones instead
+  gain_schedule_.reset(initial_gains);
 
   return true;
 }
@@ -188,117 +156,102 @@ void EffortJointPositionController::starting(const ros::Time& /*time*/) {
 
   std::fill(p_error_last_.begin(), p_error_last_.end(), 0);
   d_error_ = p_error_last_;
+  setpoint_channel_.clearFromRT();
+  command_batch_.clearFromRT();
 }
 
 void EffortJointPositionController::update(const ros::Time& time,
                                              const ros::Duration& period) {
+  ScopedUpdateTimer update_timer(update_timing_);
   franka::RobotState robot_state = franka_state_handle_->getRobotState();
 
-  std::array<double, 7> error = p_error_last_;
-  std::array<double, 7> error_dot = d_error_;
-
-  for (size_t i = 0; i < 7; i++) {
-
-    error[i] = (pos_d_target_[i] - robot_state.q[i]);
-
-    if (period.toSec() > 0.0)
-    {
-      error_dot[i] = (error[i] - p_error_last_[i]) / period.toSec();
+  JointSetpoint setpoint;
+  if (setpoint_channel_.readFromRT(setpoint)) {
+    // a single command overrides the queued waypoints
+    command_batch_.clearFromRT();
+    if (setpoint.hold) {
+      pos_d_target_ = prev_pos_;
+      std::fill(p_error_last_.begin(), p_error_last_.end(), 0);
+      d_error_ = p_error_last_;
+    } else {
+      pos_d_target_ = setpoint.position;
     }
-
+  }
+  JointWaypoint waypoint;
+  if (command_batch_.readFromRT(time, waypoint)) {
+    pos_d_target_ = waypoint.position;
   }
 
-  d_error_ = error_dot;
+  std::array<double, 7> error;
+  mapJoints(error) = mapJoints(pos_d_target_) - mapJoints(robot_state.q);
+  if (period.toSec() > 0.0) {
+    mapJoints(d_error_) = (mapJoints(error) - mapJoints(p_error_last_)) / period.toSec();
+  }
 
   // Compute torque command using PD control law
-  std::array<double, 7> tau_d_calculated{};
-  for (size_t i = 0; i < 7; ++i) {
-
-    tau_d_calculated[i] = k_gains_[i] * error[i]  + 
-                          d_gains_[i] * d_error_[i];
-
-  }
+  const JointGains& gains = gain_schedule_.updateFromRT(period.toSec());
+  std::array<double, 7> tau_d_calculated;
+  mapJoints(tau_d_calculated) =
+      pdTorque(mapJoints(error), mapJoints(d_error_), mapJoints(gains.k), mapJoints(gains.d));
 
   p_error_last_ = error;
 
   // Maximum torque difference with a sampling rate of 1 kHz. The maximum torque rate is
   // 1000 * (1 / sampling_time).
-  std::array<double, 7> tau_d_saturated = saturateTorqueRate(tau_d_calculated, robot_state.tau_J_d);
-
-  if (trigger_publish_() && publisher_controller_states_.trylock()) {
-      for (size_t i = 0; i < 7; ++i){
-
-        publisher_controller_states_.msg_.joint_controller_states[i].set_point = pos_d_target_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].process_value = robot_state.q[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].process_value_dot = d_error_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].error = error[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].time_step = period.toSec();
-        publisher_controller_states_.msg_.joint_controller_states[i].command = tau_d_calculated[i];
-
-        publisher_controller_states_.msg_.joint_controller_states[i].p = k_gains_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].d = d_gains_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].header.stamp = time;
-
-      }
-
-      publisher_controller_states_.unlockAndPublish();
-
+  std::array<double, 7> tau_d_saturated =
+      saturateTorqueRate(tau_d_calculated, robot_state.tau_J_d, kDeltaTauMax);
+
+  if (JointControllerSample* sample = controller_state_publisher_.claim()) {
+    sample->stamp = time;
+    sample->time_step = period.toSec();
+    for (size_t i = 0; i < 7; ++i) {
+      sample->set_point[i] = pos_d_target_[i];
+      sample->process_value[i] = robot_state.q[i];
+      sample->process_value_dot[i] = d_error_[i];
+      sample->error[i] = error[i];
+      sample->command[i] = tau_d_calculated[i];
+      sample->p[i] = gains.k[i];
+      sample->d[i] = gains.d[i];
     }
+    controller_state_publisher_.commit();
+  }
 
   for (size_t i = 0; i < 7; ++i) {
     joint_handles_[i].setCommand(tau_d_saturated[i]);
 
     prev_pos_[i] = robot_state.q[i];
-
-    k_gains_[i] = filter_params_ * k_gains_target_[i] + (1.0 - filter_params_) * k_gains_[i];
-    d_gains_[i] = filter_params_ * d_gains_target_[i] + (1.0 - filter_params_) * d_gains_[i];
   }
 
 }
 
-bool EffortJointPositionController::checkPositionLimits(std::vector<double> positions)
+template <typename Container>
+bool EffortJointPositionController::checkPositionLimits(const Container& positions)
 {
-  for (size_t i = 0;  i < 7; ++i){
-    if (!((positions[i] <= joint_limits_.position_upper[i]) && (positions[i] >= joint_limits_.position_lower[i]))){
-      return true;
-    }
-  }
-
-  return false;
-}
-
-std::array<double, 7> EffortJointPositionController::saturateTorqueRate(
-  const std::array<double, 7>& tau_d_calculated,
-    const std::array<double, 7>& tau_J_d) {  // NOLINT (readability-identifier-naming)
-  std::array<double, 7> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - tau_J_d[i];
-    tau_d_saturated[i] = tau_J_d[i] + std::max(std::min(difference, kDeltaTauMax), -kDeltaTauMax);
-  }
-  return tau_d_saturated;
+  return !withinLimits(mapJoints(positions), mapJoints(joint_limits_.position_lower),
+                       mapJoints(joint_limits_.position_upper));
 }
 
 void EffortJointPositionController::jointCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg) {
 
   if (msg->mode == franka_core_msgs::JointCommand::POSITION_MODE){
+    JointSetpoint setpoint{};
     if (msg->position.size() != 7) {
       ROS_ERROR_STREAM(
           "EffortJointPositionController: Published Commands are not of size 7");
-      pos_d_target_ = prev_pos_;
-      std::fill(p_error_last_.begin(), p_error_last_.end(), 0);
-      d_error_ = p_error_last_;
+      setpoint.hold = true;
+      setpoint_channel_.rejectFromNonRT();
     }
     else if (checkPositionLimits(msg->position)) {
          ROS_ERROR_STREAM(
             "PositionJointPositionController: Commanded positions are beyond allowed position limits.");
-        pos_d_target_ = prev_pos_;
-        std::fill(p_error_last_.begin(), p_error_last_.end(), 0);
-        d_error_ = p_error_last_;
+        setpoint.hold = true;
+        setpoint_channel_.rejectFromNonRT();
     }
     else {
-      std::copy_n(msg->position.begin(), 7, pos_d_target_.begin());
+      std::copy_n(msg->position.begin(), 7, setpoint.position.begin());
 
     }
+    setpoint_channel_.writeFromNonRT(setpoint);
   }
   // else ROS_ERROR_STREAM("EffortJointPositionController: Published Command msg are not of JointCommand::POSITION_MODE! Dropping message");
 }
@@ -307,22 +260,46 @@ void EffortJointPositionController::controllerConfigCallback(
     franka_ros_controllers::joint_controller_paramsConfig& config,
     uint32_t /*level*/) {
 
-    k_gains_target_[0] = config.j1_k;
-    k_gains_target_[1] = config.j2_k;
-    k_gains_target_[2] = config.j3_k;
-    k_gains_target_[3] = config.j4_k;
-    k_gains_target_[4] = config.j5_k;
-    k_gains_target_[5] = config.j6_k;
-    k_gains_target_[6] = config.j7_k;
-
-    d_gains_target_[0] = config.j1_d;
-    d_gains_target_[1] = config.j2_d;
-    d_gains_target_[2] = config.j3_d;
-    d_gains_target_[3] = config.j4_d;
-    d_gains_target_[4] = config.j5_d;
-    d_gains_target_[5] = config.j6_d;
-    d_gains_target_[6] = config.j7_d;
+    JointGains gains;
+    gains.k[0] = config.j1_k;
+    gains.k[1] = config.j2_k;
+    gains.k[2] = config.j3_k;
+    gains.k[3] = config.j4_k;
+    gains.k[4] = config.j5_k;
+    gains.k[5] = config.j6_k;
+    gains.k[6] = config.j7_k;
+
+    gains.d[0] = config.j1_d;
+    gains.d[1] = config.j2_d;
+    gains.d[2] = config.j3_d;
+    gains.d[3] = config.j4_d;
+    gains.d[4] = config.j5_d;
+    gains.d[5] = config.j6_d;
+    gains.d[6] = config.j7_d;
+
+    GainTransition transition;
+    transition.profile = static_cast<TransitionProfile>(config.gain_transition_profile);
+    transition.duration = config.gain_transition_time;
+    gain_schedule_.requestFromNonRT(gains, transition);
+
+}
 
+void EffortJointPositionController::jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg) {
+  if (msg->mode != franka_core_msgs::JointCommand::POSITION_MODE) {
+    return;
+  }
+  std::string error;
+  if (!command_batch_.writeFromNonRT(*msg,
+                                     [this](const JointWaypoint& waypoint) {
+                                       return !checkPositionLimits(waypoint.position);
+                                     },
+                                     error)) {
+    ROS_ERROR_STREAM("EffortJointPositionController: Rejected command batch: " << error);
+    JointSetpoint setpoint{};
+    setpoint.hold = true;
+    setpoint_channel_.rejectFromNonRT();
+    setpoint_channel_.writeFromNonRT(setpoint);
+  }
 }
 
 }  // namespace franka_ros_controllers
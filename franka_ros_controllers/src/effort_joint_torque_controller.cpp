@@ -36,12 +36,14 @@ namespace franka_ros_controllers {
 
 bool EffortJointTorqueController::init(hardware_interface::RobotHW* robot_hw,
                                            ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
   std::string arm_id;
-  if (!node_handle.getParam("/robot_config/arm_id", arm_id)) {
+  if (!readArmId(node_handle, arm_id)) {
     ROS_ERROR("EffortJointTorqueController: Could not read parameter arm_id");
     return false;
   }
-  if (!node_handle.getParam("/robot_config/joint_names", joint_limits_.joint_names) || joint_limits_.joint_names.size() != 7) {
+  joint_limits_ = RobotConfig::get(node_handle)->jointLimits(arm_id);
+  if (joint_limits_.joint_names.size() != 7) {
     ROS_ERROR(
         "EffortJointTorqueController: Invalid or no joint_names parameters provided, aborting "
         "controller init!");
@@ -62,31 +64,18 @@ bool EffortJointTorqueController::init(hardware_interface::RobotHW* robot_hw,
     ROS_INFO_STREAM("EffortJointTorqueController: Coriolis compensation enabled!");
   }
 
-  std::map<std::string, double> torque_limit_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_effort_limit", torque_limit_map))
-  {
-    ROS_ERROR("EffortJointTorqueController: Failed to find joint effort limits on the param server. Aborting controller init");
+  if (joint_limits_.effort.size() != 7) {
+    ROS_ERROR(
+        "EffortJointTorqueController: Joint limits parameters not provided, aborting "
+        "controller init!");
     return false;
   }
 
-  for (size_t i = 0; i < joint_limits_.joint_names.size(); ++i){
-    if (torque_limit_map.find(joint_limits_.joint_names[i]) != torque_limit_map.end())
-      {
-        joint_limits_.effort.push_back(torque_limit_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("EffortJointTorqueController: Unable to find torque limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-  }  
-
   double controller_state_publish_rate(30.0);
   if (!node_handle.getParam("controller_state_publish_rate", controller_state_publish_rate)) {
     ROS_INFO_STREAM("EffortJointTorqueController: Did not find controller_state_publish_rate. Using default "
                     << controller_state_publish_rate << " [Hz].");
   }
-  trigger_publish_ = franka_hw::TriggerRate(controller_state_publish_rate);
 
   auto* model_interface = robot_hw->get<franka_hw::FrankaModelInterface>();
   if (model_interface == nullptr) {
@@ -95,8 +84,7 @@ bool EffortJointTorqueController::init(hardware_interface::RobotHW* robot_hw,
     return false;
   }
   try {
-    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
-        model_interface->getHandle(arm_id + "_model"));
+    model_handle_ = CachedFrankaModelHandle::acquire(robot_hw, arm_id);
   } catch (hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM(
         "EffortJointTorqueController: Exception getting model handle from interface: "
@@ -119,20 +107,35 @@ bool EffortJointTorqueController::init(hardware_interface::RobotHW* robot_hw,
       return false;
     }
   }
-  desired_joints_subscriber_ = node_handle.subscribe(
-      "/franka_ros_interface/motion_controller/arm/joint_commands", 20, &EffortJointTorqueController::jointCmdCallback, this,
-      ros::TransportHints().reliable().tcpNoDelay());
-  publisher_controller_states_.init(node_handle, "/franka_ros_interface/motion_controller/arm/joint_controller_states", 1);
-
-  {
-    std::lock_guard<realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> > lock(
-        publisher_controller_states_);
-    publisher_controller_states_.msg_.controller_name = "effort_joint_torque_controller";
-    publisher_controller_states_.msg_.names.resize(joint_limits_.joint_names.size());
-    publisher_controller_states_.msg_.joint_controller_states.resize(joint_limits_.joint_names.size());
 
+  bool shm_enabled = false;
+  node_handle.param<bool>("/robot_config/shm_transport/enabled", shm_enabled, false);
+  if (shm_enabled) {
+    std::string shm_name;
+    std::string shm_error;
+    node_handle.param<std::string>("/robot_config/shm_transport/name", shm_name,
+                                   "franka_ros_interface");
+    shm_name = armResourceName(node_handle, arm_id, shm_name);
+    if (!shm_transport_.open(shm_name, true, shm_error)) {
+      ROS_ERROR_STREAM("EffortJointTorqueController: Could not open shared-memory transport: " << shm_error);
+      return false;
+    }
+    // same limit as the watchdog of the topic path
+    node_handle.param<double>("/controllers_config/command_timeout", shm_command_timeout_, 0.2);
+    shm_report_timer_ = node_handle.createTimer(
+        ros::Duration(1.0), &EffortJointTorqueController::reportShmEvents, this);
   }
 
+  desired_joints_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_commands"), 20, &EffortJointTorqueController::jointCmdCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  command_batch_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_command_batch"), 20, &EffortJointTorqueController::jointCmdBatchCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  controller_state_publisher_.init(
+      node_handle, armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_controller_states"),
+      "effort_joint_torque_controller", joint_limits_.joint_names, controller_state_publish_rate);
+
   return true;
 }
 
@@ -140,37 +143,65 @@ void EffortJointTorqueController::starting(const ros::Time& /*time*/) {
 
   std::fill(jnt_cmd_.begin(), jnt_cmd_.end(), 0);
   prev_jnt_cmd_ = jnt_cmd_;
+  setpoint_channel_.clearFromRT();
+  command_batch_.clearFromRT();
+  if (shm_transport_.isOpen()) {
+    shm_transport_.syncCommand();
+  }
   ROS_WARN_STREAM("EffortJointTorqueController: Using raw torque controller! Be extremely careful and send smooth commands.");
 }
 
 void EffortJointTorqueController::update(const ros::Time& time,
                                              const ros::Duration& period) {
-  
+  ScopedUpdateTimer update_timer(update_timing_);
+  TorqueSetpoint setpoint;
+  if (setpoint_channel_.readFromRT(setpoint)) {
+    // a single command overrides the queued waypoints
+    command_batch_.clearFromRT();
+    jnt_cmd_ = setpoint.hold ? prev_jnt_cmd_ : setpoint.effort;
+  }
+  JointWaypoint waypoint;
+  if (command_batch_.readFromRT(time, waypoint)) {
+    jnt_cmd_ = waypoint.effort;
+  }
+  shm::CommandStatus shm_status =
+      shm_transport_.isOpen()
+          ? shm_transport_.pollCommand(time.toSec(), shm_command_timeout_,
+                                       franka_core_msgs::JointCommand::TORQUE_MODE,
+                                       shm_command_)
+          : shm::CommandStatus::kNone;
+  if (shm_status == shm::CommandStatus::kNew) {
+    if (checkTorqueLimits(shm_command_.effort)) {
+      shm_events_.countRejected();
+      jnt_cmd_ = prev_jnt_cmd_;
+    } else {
+      std::copy_n(shm_command_.effort, 7, jnt_cmd_.begin());
+    }
+  } else if (shm_status == shm::CommandStatus::kTimedOut) {
+    // the client stalled or died: ramp down to zero torque instead of keeping its last command
+    shm_events_.countTimeout();
+    std::fill(jnt_cmd_.begin(), jnt_cmd_.end(), 0.0);
+  }
+
   std::array<double, 7> coriolis = model_handle_->getCoriolis();
 
-  std::array<double, 7> compensated_cmd{};
-  for (size_t i = 0; i < 7; ++i) {
-    compensated_cmd[i] = coriolis_factor_ * coriolis[i] + jnt_cmd_[i];
-  }
+  std::array<double, 7> compensated_cmd;
+  mapJoints(compensated_cmd) = coriolis_factor_ * mapJoints(coriolis) + mapJoints(jnt_cmd_);
   // Maximum torque difference with a sampling rate of 1 kHz. The maximum torque rate is
   // 1000 * (1 / sampling_time).
-  std::array<double, 7> tau_d_saturated = saturateTorqueRate(compensated_cmd, prev_jnt_cmd_);
-
-  if (trigger_publish_() && publisher_controller_states_.trylock()) {
-      for (size_t i = 0; i < 7; ++i){
-
-        publisher_controller_states_.msg_.joint_controller_states[i].set_point = jnt_cmd_[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].process_value = compensated_cmd[i];
-        publisher_controller_states_.msg_.joint_controller_states[i].time_step = period.toSec();
-        publisher_controller_states_.msg_.joint_controller_states[i].command = tau_d_saturated[i];
-
-        publisher_controller_states_.msg_.joint_controller_states[i].header.stamp = time;
-
-      }
-
-      publisher_controller_states_.unlockAndPublish();
-
+  std::array<double, 7> tau_d_saturated =
+      saturateTorqueRate(compensated_cmd, prev_jnt_cmd_, kDeltaTauMax);
+
+  if (JointControllerSample* sample = controller_state_publisher_.claim()) {
+    sample->stamp = time;
+    sample->time_step = period.toSec();
+    for (size_t i = 0; i < 7; ++i) {
+      sample->set_point[i] = jnt_cmd_[i];
+      sample->process_value[i] = compensated_cmd[i];
+      sample->command[i] = tau_d_saturated[i];
     }
+    controller_state_publisher_.commit();
+  }
 
   for (size_t i = 0; i < 7; ++i) {
     joint_handles_[i].setCommand(tau_d_saturated[i]);
@@ -181,50 +212,68 @@ void EffortJointTorqueController::update(const ros::Time& time,
 
 }
 
-bool EffortJointTorqueController::checkTorqueLimits(std::vector<double> torques)
+template <typename Container>
+bool EffortJointTorqueController::checkTorqueLimits(const Container& torques)
 {
-  for (size_t i = 0;  i < 7; ++i){
-    if (!(abs(torques[i]) < joint_limits_.effort[i])){
-      return true;
-    }
-  }
-
-  return false;
+  return !belowMagnitude(mapJoints(torques), mapJoints(joint_limits_.effort));
 }
 
-std::array<double, 7> EffortJointTorqueController::saturateTorqueRate(
-    const std::array<double, 7>& tau_d_calculated, const std::array<double, 7>& prev_tau) {  // NOLINT (readability-identifier-naming)
-  std::array<double, 7> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - prev_tau[i];
-    tau_d_saturated[i] = prev_tau[i] + std::max(std::min(difference, kDeltaTauMax), -kDeltaTauMax);
+void EffortJointTorqueController::reportShmEvents(const ros::TimerEvent&) {
+  uint64_t rejected, timeouts;
+  shm_events_.takeNew(rejected, timeouts);
+  if (rejected > 0) {
+    ROS_ERROR_STREAM("EffortJointTorqueController: Rejected " << rejected
+                     << " shared-memory commands beyond the torque limits.");
+  }
+  if (timeouts > 0) {
+    ROS_WARN_STREAM("EffortJointTorqueController: No shared-memory command for "
+                    << shm_command_timeout_ << " s, commanding zero torque.");
   }
-  return tau_d_saturated;
 }
 
 void EffortJointTorqueController::jointCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg) {
 
   if (msg->mode == franka_core_msgs::JointCommand::TORQUE_MODE){
+    TorqueSetpoint setpoint{};
     if (msg->effort.size() != 7) {
       ROS_ERROR_STREAM(
           "EffortJointTorqueController: Published Commands are not of size 7");
-      std::fill(jnt_cmd_.begin(), jnt_cmd_.end(), 0);
-      jnt_cmd_= prev_jnt_cmd_;
+      setpoint.hold = true;
+      setpoint_channel_.rejectFromNonRT();
     }
     else if (checkTorqueLimits(msg->effort)) {
          ROS_ERROR_STREAM(
             "EffortJointTorqueController: Commanded torques are beyond allowed torque limits.");
-        std::fill(jnt_cmd_.begin(), jnt_cmd_.end(), 0);
-        jnt_cmd_= prev_jnt_cmd_;
+        setpoint.hold = true;
+        setpoint_channel_.rejectFromNonRT();
     }
     else {
-      std::copy_n(msg->effort.begin(), 7, jnt_cmd_.begin());
+      std::copy_n(msg->effort.begin(), 7, setpoint.effort.begin());
 
     }
+    setpoint_channel_.writeFromNonRT(setpoint);
   }
   // else ROS_ERROR_STREAM("EffortJointTorqueController: Published Command msg are not of JointCommand::TORQUE_MODE! Dropping message");
 }
 
+void EffortJointTorqueController::jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg) {
+  if (msg->mode != franka_core_msgs::JointCommand::TORQUE_MODE) {
+    return;
+  }
+  std::string error;
+  if (!command_batch_.writeFromNonRT(*msg,
+                                     [this](const JointWaypoint& waypoint) {
+                                       return !checkTorqueLimits(waypoint.effort);
+                                     },
+                                     error)) {
+    ROS_ERROR_STREAM("EffortJointTorqueController: Rejected command batch: " << error);
+    TorqueSetpoint setpoint{};
+    setpoint.hold = true;
+    setpoint_channel_.rejectFromNonRT();
+    setpoint_channel_.writeFromNonRT(setpoint);
+  }
+}
+
 }  // namespace franka_ros_controllers
 
 PLUGINLIB_EXPORT_CLASS(franka_ros_controllers::EffortJointTorqueController,
@@ -15,20 +15,21 @@ namespace franka_ros_controllers {
 
 bool ForceController::init(hardware_interface::RobotHW* robot_hw,
                                   ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
   std::vector<std::string> joint_names;
   std::string arm_id;
+  if (!readArmId(node_handle, arm_id)) {
+    ROS_ERROR("ForceController: Could not read parameter arm_id");
+    return false;
+  }
 
-  force_params_ = node_handle.subscribe(
-    "/wrench_target", 20, &ForceController::forceParamCallback, this,
+  force_params_ = commandNodeHandle(node_handle).subscribe(
+    armTopic(node_handle, arm_id, "/wrench_target"), 20, &ForceController::forceParamCallback, this,
     ros::TransportHints().reliable().tcpNoDelay());
 
   ROS_WARN(
       "ForceController: Make sure your robot's endeffector is in contact "
       "with a horizontal surface before starting the controller!");
-  if (!node_handle.getParam("arm_id", arm_id)) {
-    ROS_ERROR("ForceController: Could not read parameter arm_id");
-    return false;
-  }
   if (!node_handle.getParam("joint_names", joint_names) || joint_names.size() != 7) {
     ROS_ERROR(
         "ForceController: Invalid or no joint_names parameters provided, aborting "
@@ -42,8 +43,7 @@ bool ForceController::init(hardware_interface::RobotHW* robot_hw,
     return false;
   }
   try {
-    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
-        model_interface->getHandle(arm_id + "_model"));
+    model_handle_ = CachedFrankaModelHandle::acquire(robot_hw, arm_id);
   } catch (hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM(
         "ForceController: Exception getting model handle from interface: " << ex.what());
@@ -78,10 +78,15 @@ bool ForceController::init(hardware_interface::RobotHW* robot_hw,
     }
   }
 
+  if (!readGainTransition(node_handle, "ForceController", gain_transition_)) {
+    return false;
+  }
   // Initialize
-  //target_mass_ = 0.0;
-  target_mass_.setZero();
-  desired_mass_.setZero();
+  ForceParameters parameters;
+  parameters.wrench.setZero();
+  parameters.k_p = k_p_;
+  parameters.k_i = k_i_;
+  schedule_.reset(parameters);
   return true;
 }
 
@@ -93,9 +98,12 @@ void ForceController::starting(const ros::Time& /*time*/) {
   // Bias correction for the current external torque
   tau_ext_initial_ = tau_measured - gravity;
   tau_error_.setZero();
+  // discard wrenches sent while the controller was stopped
+  schedule_.reset(schedule_.current());
 }
 
 void ForceController::update(const ros::Time& /*time*/, const ros::Duration& period) {
+  ScopedUpdateTimer update_timer(update_timing_);
   franka::RobotState robot_state = state_handle_->getRobotState();
   std::array<double, 42> jacobian_array =
       model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
@@ -106,50 +114,39 @@ void ForceController::update(const ros::Time& /*time*/, const ros::Duration& per
       robot_state.tau_J_d.data());
   Eigen::Map<Eigen::Matrix<double, 7, 1>> gravity(gravity_array.data());
 
+  const ForceParameters& parameters = schedule_.updateFromRT(period.toSec());
+
   Eigen::VectorXd tau_d(7), desired_force_torque(6), tau_cmd(7), tau_ext(7);
   desired_force_torque.setZero();
-  for (size_t i = 0; i < 7; ++i) {
-      desired_force_torque(i) = desired_mass_(i); // * -9.81;
+  for (size_t i = 0; i < 6; ++i) {
+      desired_force_torque(i) = parameters.wrench(i); // * -9.81;
   }
   //desired_force_torque(2) = desired_mass_(2) * -9.81;
   tau_ext = tau_measured - gravity - tau_ext_initial_;
   tau_d << jacobian.transpose() * desired_force_torque;
   tau_error_ = tau_error_ + period.toSec() * (tau_d - tau_ext);
   // FF + PI control (PI gains are initially all 0)
-  tau_cmd = tau_d + k_p_ * (tau_d - tau_ext) + k_i_ * tau_error_;
-  tau_cmd << saturateTorqueRate(tau_cmd, tau_J_d);
+  tau_cmd = tau_d + parameters.k_p * (tau_d - tau_ext) + parameters.k_i * tau_error_;
+  tau_cmd << saturateTorqueRate(tau_cmd, tau_J_d, kDeltaTauMax);
 
   for (size_t i = 0; i < 7; ++i) {
     joint_handles_[i].setCommand(tau_cmd(i));
   }
-
-  // Update signals changed online through dynamic reconfigure
-  desired_mass_ = filter_gain_ * target_mass_ + (1 - filter_gain_) * desired_mass_;
-  k_p_ = filter_gain_ * target_k_p_ + (1 - filter_gain_) * k_p_;
-  k_i_ = filter_gain_ * target_k_i_ + (1 - filter_gain_) * k_i_;
 }
 
 void ForceController::forceParamCallback(
      const geometry_msgs::Wrench& msg) {
 
-  target_mass_(0) = msg.force.x;
-  target_mass_(1) = msg.force.y;
-  target_mass_(2) = msg.force.z;
-  target_mass_(3) = msg.torque.x;
-  target_mass_(4) = msg.torque.y;
-  target_mass_(5) = msg.torque.z;
-}
-
-
-Eigen::Matrix<double, 7, 1> ForceController::saturateTorqueRate(
-    const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-    const Eigen::Matrix<double, 7, 1>& tau_J_d) {  // NOLINT (readability-identifier-naming)
-  Eigen::Matrix<double, 7, 1> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - tau_J_d[i];
-    tau_d_saturated[i] = tau_J_d[i] + std::max(std::min(difference, kDeltaTauMax), -kDeltaTauMax);
-  }
-  return tau_d_saturated;
+  ForceParameters parameters;
+  parameters.wrench(0) = msg.force.x;
+  parameters.wrench(1) = msg.force.y;
+  parameters.wrench(2) = msg.force.z;
+  parameters.wrench(3) = msg.torque.x;
+  parameters.wrench(4) = msg.torque.y;
+  parameters.wrench(5) = msg.torque.z;
+  parameters.k_p = k_p_;
+  parameters.k_i = k_i_;
+  schedule_.requestFromNonRT(parameters, gain_transition_);
 }
 
 }  // namespace franka_ros_controllers
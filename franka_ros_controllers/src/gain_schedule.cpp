@@ -0,0 +1,100 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/gain_schedule.h>
+
+#include <franka_core_msgs/CartImpedanceStiffness.h>
+#include <ros/console.h>
+
+namespace franka_ros_controllers {
+
+bool transitionProfileFromString(const std::string& name, TransitionProfile& profile) {
+  if (name == "step") {
+    profile = TransitionProfile::kStep;
+  } else if (name == "linear") {
+    profile = TransitionProfile::kLinear;
+  } else if (name == "min_jerk") {
+    profile = TransitionProfile::kMinimumJerk;
+  } else if (name == "exponential") {
+    profile = TransitionProfile::kExponential;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool readGainTransition(const ros::NodeHandle& node_handle,
+                        const std::string& controller_name,
+                        GainTransition& transition) {
+  std::string profile;
+  if (node_handle.getParam("gain_transition/profile", profile) &&
+      !transitionProfileFromString(profile, transition.profile)) {
+    ROS_ERROR_STREAM(controller_name << ": Unknown gain_transition/profile '" << profile
+                     << "' (expected step, linear, min_jerk or exponential), aborting "
+                     "controller init!");
+    return false;
+  }
+  node_handle.getParam("gain_transition/duration", transition.duration);
+  if (!(transition.duration >= 0.0)) {
+    ROS_ERROR_STREAM(controller_name << ": gain_transition/duration must not be negative, "
+                     "aborting controller init!");
+    return false;
+  }
+  return true;
+}
+
+bool transitionFromMessage(uint8_t profile,
+                           double time,
+                           const GainTransition& default_transition,
+                           GainTransition& transition) {
+  // JointImpedanceStiffness defines the same constants
+  using Message = franka_core_msgs::CartImpedanceStiffness;
+  if (profile != Message::PROFILE_DEFAULT && !(time >= 0.0)) {
+    return false;
+  }
+  switch (profile) {
+    case Message::PROFILE_DEFAULT:
+      transition = default_transition;
+      return true;
+    case Message::PROFILE_STEP:
+      transition.profile = TransitionProfile::kStep;
+      break;
+    case Message::PROFILE_LINEAR:
+      transition.profile = TransitionProfile::kLinear;
+      break;
+    case Message::PROFILE_MIN_JERK:
+      transition.profile = TransitionProfile::kMinimumJerk;
+      break;
+    case Message::PROFILE_EXPONENTIAL:
+      transition.profile = TransitionProfile::kExponential;
+      break;
+    default:
+      return false;
+  }
+  transition.duration = time;
+  return true;
+}
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,149 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/jerk_limited_tracker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <ros/console.h>
+
+namespace franka_ros_controllers {
+
+namespace {
+
+bool readJointLimit(const std::vector<double>& values,
+                    const std::string& name,
+                    double scale,
+                    const std::string& controller_name,
+                    std::array<double, 7>& limits) {
+  if (values.size() != limits.size()) {
+    ROS_ERROR_STREAM(controller_name << ": Joint limits parameter joint_config/" << name
+                     << " not provided, aborting controller init!");
+    return false;
+  }
+  for (size_t i = 0; i < limits.size(); ++i) {
+    if (!(values[i] > 0.0)) {
+      ROS_ERROR_STREAM(controller_name << ": Invalid joint_config/" << name << " for joint "
+                       << i + 1 << ", aborting controller init!");
+      return false;
+    }
+    limits[i] = scale * values[i];
+  }
+  return true;
+}
+
+double clamp(double value, double limit) { return std::max(-limit, std::min(value, limit)); }
+
+// Largest acceleration from which the velocity, after this cycle and a ramp down to zero at the
+// jerk limit, grows by at most margin: a * period + a^2 / (2 * jerk) <= margin.
+double brakingBound(double margin, double jerk, double period) {
+  if (margin <= 0.0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return jerk * (std::sqrt(period * period + 2.0 * margin / jerk) - period);
+}
+
+}  // namespace
+
+bool JerkLimitedTracker::init(const ros::NodeHandle& node_handle,
+                              const franka_core_msgs::JointLimits& limits,
+                              const std::string& controller_name) {
+  double limit_scale(0.9);
+  node_handle.getParam("horizon_tracking/bandwidth", bandwidth_);
+  node_handle.getParam("horizon_tracking/limit_scale", limit_scale);
+  if (!(bandwidth_ > 0.0) || !(limit_scale > 0.0 && limit_scale <= 1.0)) {
+    ROS_ERROR_STREAM(controller_name << ": horizon_tracking/bandwidth must be positive and "
+                     "horizon_tracking/limit_scale in (0, 1], aborting controller init!");
+    return false;
+  }
+  return readJointLimit(limits.velocity, "joint_velocity_limit", limit_scale, controller_name,
+                        velocity_limit_) &&
+         readJointLimit(limits.accel, "joint_acceleration_limit", limit_scale, controller_name,
+                        acceleration_limit_) &&
+         readJointLimit(limits.jerk, "joint_jerk_limit", limit_scale, controller_name,
+                        jerk_limit_);
+}
+
+void JerkLimitedTracker::reset(const std::array<double, 7>& position,
+                               const std::array<double, 7>& velocity) {
+  position_ = position;
+  velocity_ = velocity;
+  acceleration_.fill(0.0);
+}
+
+void JerkLimitedTracker::updatePosition(const std::array<double, 7>& position,
+                                        const std::array<double, 7>& velocity,
+                                        const std::array<double, 7>& acceleration,
+                                        double period) {
+  // critically damped at bandwidth_ in the linear region
+  const double position_gain = 0.5 * bandwidth_;
+  const double velocity_gain = 2.0 * bandwidth_;
+  for (size_t i = 0; i < 7; ++i) {
+    // braking with half the acceleration limit leaves room for the jerk-limited ramp down
+    const double braking = 0.5 * acceleration_limit_[i];
+    const double linear_region = braking / (position_gain * position_gain);
+    const double error = position[i] - position_[i];
+    const double correction =
+        std::fabs(error) <= linear_region
+            ? position_gain * error
+            : std::copysign(std::sqrt(2.0 * braking * (std::fabs(error) - 0.5 * linear_region)),
+                            error);
+    step(i, acceleration[i] + velocity_gain * (velocity[i] + correction - velocity_[i]), period);
+  }
+}
+
+void JerkLimitedTracker::updateVelocity(const std::array<double, 7>& velocity,
+                                        const std::array<double, 7>& acceleration,
+                                        double period) {
+  for (size_t i = 0; i < 7; ++i) {
+    step(i, acceleration[i] + bandwidth_ * (velocity[i] - velocity_[i]), period);
+  }
+}
+
+void JerkLimitedTracker::step(size_t joint, double acceleration, double period) {
+  if (!(period > 0.0)) {
+    return;
+  }
+  // start braking while the acceleration can still be ramped down within the jerk limit before
+  // the velocity limit is reached
+  const double upper = std::min(
+      acceleration_limit_[joint],
+      brakingBound(velocity_limit_[joint] - velocity_[joint], jerk_limit_[joint], period));
+  const double lower = std::max(
+      -acceleration_limit_[joint],
+      -brakingBound(velocity_limit_[joint] + velocity_[joint], jerk_limit_[joint], period));
+  const double target = std::max(lower, std::min(acceleration, upper));
+  const double jerk = clamp((target - acceleration_[joint]) / period, jerk_limit_[joint]);
+  acceleration_[joint] += jerk * period;
+  // the jerk limit takes precedence; only a state reset above the velocity limit reaches this
+  velocity_[joint] =
+      clamp(velocity_[joint] + acceleration_[joint] * period, velocity_limit_[joint]);
+  position_[joint] += velocity_[joint] * period;
+}
+
+}  // namespace franka_ros_controllers
@@ -0,0 +1,130 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/joint_controller_state_publisher.h>
+
+#include <ros/ros.h>
+
+namespace franka_ros_controllers {
+
+void JointControllerStatePublisher::init(ros::NodeHandle& node_handle, const std::string& topic,
+                                         const std::string& controller_name,
+                                         const std::vector<std::string>& joint_names,
+                                         double publish_rate) {
+  int queue_capacity;
+  int batch_size;
+  node_handle.param<int>("/robot_config/controller_telemetry/queue_capacity", queue_capacity, 256);
+  node_handle.param<int>("/robot_config/controller_telemetry/batch_size", batch_size, 20);
+  if (queue_capacity < 1 || batch_size < 1) {
+    ROS_WARN("JointControllerStatePublisher: Invalid controller_telemetry parameters, using "
+             "defaults");
+    queue_capacity = 256;
+    batch_size = 20;
+  }
+
+  const size_t joint_count = joint_names.size();
+  msg_.controller_name = controller_name;
+  msg_.names = joint_names;
+  msg_.joint_controller_states.resize(joint_count);
+  batch_msg_.controller_name = controller_name;
+  batch_msg_.names = joint_names;
+  batch_msg_.stamps.reserve(batch_size);
+  batch_msg_.time_step.reserve(batch_size);
+  for (auto* field : {&batch_msg_.set_point, &batch_msg_.process_value,
+                      &batch_msg_.process_value_dot, &batch_msg_.error, &batch_msg_.command,
+                      &batch_msg_.p, &batch_msg_.d}) {
+    field->reserve(batch_size * joint_count);
+  }
+  publish_period_ = ros::Duration(publish_rate > 0.0 ? 1.0 / publish_rate : 0.0);
+  last_publish_ = ros::Time();
+  dropped_ = 0;
+
+  publisher_ = node_handle.advertise<franka_core_msgs::JointControllerStates>(topic, 1);
+  batch_publisher_ =
+      node_handle.advertise<franka_core_msgs::JointControllerStatesBatch>(topic + "_batch", 10);
+  channel_.start(queue_capacity, batch_size,
+                 [this](const std::vector<JointControllerSample>& batch, uint64_t dropped) {
+                   publish(batch, dropped);
+                 });
+}
+
+void JointControllerStatePublisher::publish(const std::vector<JointControllerSample>& batch,
+                                            uint64_t dropped) {
+  if (dropped > 0) {
+    ROS_WARN_THROTTLE(1.0, "%s: dropped %lu controller state samples, the telemetry queue was full",
+                      msg_.controller_name.c_str(), static_cast<unsigned long>(dropped));
+  }
+  dropped_ += dropped;
+  const size_t joint_count = msg_.names.size();
+
+  const JointControllerSample& last = batch.back();
+  if (last.stamp < last_publish_ || last.stamp - last_publish_ >= publish_period_) {
+    for (size_t i = 0; i < joint_count; ++i) {
+      auto& state = msg_.joint_controller_states[i];
+      state.header.stamp = last.stamp;
+      state.set_point = last.set_point[i];
+      state.process_value = last.process_value[i];
+      state.process_value_dot = last.process_value_dot[i];
+      state.error = last.error[i];
+      state.time_step = last.time_step;
+      state.command = last.command[i];
+      state.p = last.p[i];
+      state.d = last.d[i];
+    }
+    msg_.header.stamp = last.stamp;
+    publisher_.publish(msg_);
+    last_publish_ = last.stamp;
+  }
+
+  if (batch_publisher_.getNumSubscribers() == 0) {
+    return;
+  }
+  batch_msg_.header.stamp = last.stamp;
+  batch_msg_.dropped = dropped_;
+  dropped_ = 0;
+  batch_msg_.stamps.clear();
+  batch_msg_.time_step.clear();
+  for (auto* field : {&batch_msg_.set_point, &batch_msg_.process_value,
+                      &batch_msg_.process_value_dot, &batch_msg_.error, &batch_msg_.command,
+                      &batch_msg_.p, &batch_msg_.d}) {
+    field->clear();
+  }
+  for (const JointControllerSample& sample : batch) {
+    batch_msg_.stamps.push_back(sample.stamp);
+    batch_msg_.time_step.push_back(sample.time_step);
+    for (size_t i = 0; i < joint_count; ++i) {
+      batch_msg_.set_point.push_back(sample.set_point[i]);
+      batch_msg_.process_value.push_back(sample.process_value[i]);
+      batch_msg_.process_value_dot.push_back(sample.process_value_dot[i]);
+      batch_msg_.error.push_back(sample.error[i]);
+      batch_msg_.command.push_back(sample.command[i]);
+      batch_msg_.p.push_back(sample.p[i]);
+      batch_msg_.d.push_back(sample.d[i]);
+    }
+  }
+  batch_publisher_.publish(batch_msg_);
+}
+
+}  // namespace franka_ros_controllers
@@ -2,6 +2,7 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <franka_ros_controllers/joint_impedance_controller.h>
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
@@ -10,13 +11,15 @@
 #include <ros/ros.h>
 
 #include <franka/robot_state.h>
+#include <franka_ros_controllers/trajectory_interpolation.h>
 
 namespace franka_ros_controllers {
 
 bool JointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
                                            ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
   std::string arm_id;
-  if (!node_handle.getParam("arm_id", arm_id)) {
+  if (!readArmId(node_handle, arm_id)) {
     ROS_ERROR("JointImpedanceController: Could not read parameter arm_id");
     return false;
   }
@@ -46,52 +49,36 @@ bool JointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
     return false;
   }
 
-  std::map<std::string, double> pos_limit_lower_map;
-  std::map<std::string, double> pos_limit_upper_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/lower", pos_limit_lower_map) ) {
-  ROS_ERROR("PositionJointPositionController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/upper", pos_limit_upper_map) ) {
-  ROS_ERROR("PositionJointPositionController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-  for (size_t i = 0; i < joint_limits_.joint_names.size(); ++i){
-    if (pos_limit_lower_map.find(joint_limits_.joint_names[i]) != pos_limit_lower_map.end())
-      {
-        joint_limits_.position_lower.push_back(pos_limit_lower_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("PositionJointPositionController: Unable to find lower position limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-    if (pos_limit_upper_map.find(joint_limits_.joint_names[i]) != pos_limit_upper_map.end())
-      {
-        joint_limits_.position_upper.push_back(pos_limit_upper_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("PositionJointPositionController: Unable to find upper position limit  values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-  } 
-
-  if (!node_handle.getParam("k_gains", k_gains_) || k_gains_.size() != 7) {
+  joint_limits_ = RobotConfig::get(node_handle)->jointLimits(arm_id);
+  if (joint_limits_.velocity.size() != 7) {
+    ROS_ERROR(
+        "JointImpedanceController: Joint limits parameters not provided, aborting "
+        "controller init!");
+    return false;
+  }
+
+  std::vector<double> k_gains;
+  if (!node_handle.getParam("k_gains", k_gains) || k_gains.size() != 7) {
     ROS_ERROR(
         "JointImpedanceController:  Invalid or no k_gain parameters provided, aborting "
         "controller init!");
     return false;
   }
 
-  if (!node_handle.getParam("d_gains", d_gains_) || d_gains_.size() != 7) {
+  std::vector<double> d_gains;
+  if (!node_handle.getParam("d_gains", d_gains) || d_gains.size() != 7) {
     ROS_ERROR(
         "JointImpedanceController:  Invalid or no d_gain parameters provided, aborting "
         "controller init!");
     return false;
   }
+  JointGains initial_gains;
+  std::copy(k_gains.begin(), k_gains.end(), initial_gains.k.begin());
+  std::copy(d_gains.begin(), d_gains.end(), initial_gains.d.begin());
+  gain_schedule_.reset(initial_gains);
+  if (!readGainTransition(node_handle, "JointImpedanceController", default_gain_transition_)) {
+    return false;
+  }
 
   double publish_rate(30.0);
   if (!node_handle.getParam("publish_rate", publish_rate)) {
@@ -112,8 +99,7 @@ bool JointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
     return false;
   }
   try {
-    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
-        model_interface->getHandle(arm_id + "_model"));
+    model_handle_ = CachedFrankaModelHandle::acquire(robot_hw, arm_id);
   } catch (hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM(
         "JointImpedanceController: Exception getting model handle from interface: "
@@ -152,13 +138,34 @@ bool JointImpedanceController::init(hardware_interface::RobotHW* robot_hw,
       return false;
     }
   }
-  torques_publisher_.init(node_handle, "torque_comparison", 1);
+  torques_publisher_ = node_handle.advertise<JointTorqueComparison>("torque_comparison", 1);
+  // samples are only queued at publish_rate, a few slots suffice
+  torques_channel_.start(16, 1, [this](const std::vector<TorqueComparisonSample>& batch,
+                                       uint64_t dropped) {
+    if (dropped > 0) {
+      ROS_WARN_THROTTLE(1.0, "JointImpedanceController: dropped %lu torque comparison samples",
+                        static_cast<unsigned long>(dropped));
+    }
+    for (const TorqueComparisonSample& sample : batch) {
+      std::copy(sample.tau_error.begin(), sample.tau_error.end(), torques_msg_.tau_error.begin());
+      std::copy(sample.tau_commanded.begin(), sample.tau_commanded.end(),
+                torques_msg_.tau_commanded.begin());
+      std::copy(sample.tau_measured.begin(), sample.tau_measured.end(),
+                torques_msg_.tau_measured.begin());
+      torques_msg_.root_mean_square_error = sample.root_mean_square_error;
+      torques_publisher_.publish(torques_msg_);
+    }
+  });
 
-  desired_joints_subscriber_ = node_handle.subscribe(
-      "/joint_impedance_position_velocity", 20, &JointImpedanceController::jointCmdCallback, this,
+  desired_joints_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/joint_impedance_position_velocity"), 20, &JointImpedanceController::jointCmdCallback, this,
       ros::TransportHints().reliable().tcpNoDelay());
   stiffness_params_ = node_handle.subscribe(
-      "/joint_impedance_stiffness", 20, &JointImpedanceController::stiffnessParamCallback, this,
+      armTopic(node_handle, arm_id, "/joint_impedance_stiffness"), 20, &JointImpedanceController::stiffnessParamCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  trajectory_chunk_.reserve(kTrajectoryCapacity);
+  trajectory_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/joint_impedance_trajectory"), 20, &JointImpedanceController::trajectoryCallback, this,
       ros::TransportHints().reliable().tcpNoDelay());
 
   std::fill(dq_filtered_.begin(), dq_filtered_.end(), 0);
@@ -179,10 +186,14 @@ void JointImpedanceController::starting(const ros::Time& /*time*/) {
 
   std::fill(dq_filtered_.begin(), dq_filtered_.end(), 0);
   dq_d_ = dq_filtered_;
+  setpoint_channel_.clearFromRT();
+  trajectory_.clearFromRT();
+  trajectory_active_ = false;
 }
 
-void JointImpedanceController::update(const ros::Time& /*time*/,
+void JointImpedanceController::update(const ros::Time& time,
                                              const ros::Duration& period) {
+  ScopedUpdateTimer update_timer(update_timing_);
   /*if (vel_current_ < vel_max_) {
     vel_current_ += period.toSec() * std::fabs(vel_max_ / acceleration_time_);
   }
@@ -205,46 +216,47 @@ void JointImpedanceController::update(const ros::Time& /*time*/,
   std::array<double, 7> coriolis = model_handle_->getCoriolis();
   std::array<double, 7> gravity = model_handle_->getGravity();
 
-  double alpha = 0.99;
-  for (size_t i = 0; i < 7; i++) {
-    dq_filtered_[i] = (1 - alpha) * dq_filtered_[i] + alpha * robot_state.dq[i];
+  JointSetpoint setpoint;
+  if (setpoint_channel_.readFromRT(setpoint)) {
+    // a direct setpoint cancels any streamed trajectory
+    trajectory_.clearFromRT();
+    trajectory_active_ = false;
+    pos_d_target_ = setpoint.position;
+    dq_d_ = setpoint.velocity;
   }
+  updateTrajectory(time);
+  const JointGains& gains = gain_schedule_.updateFromRT(period.toSec());
+
+  double alpha = 0.99;
+  exponentialFilter(mapJoints(dq_filtered_), mapJoints(robot_state.dq), alpha);
 
   std::array<double, 7> tau_d_calculated;
-  for (size_t i = 0; i < 7; ++i) {
-    //tau_d_calculated[i] = coriolis_factor_ * coriolis[i] +
-    //                      k_gains_[i] * (robot_state.q_d[i] - robot_state.q[i]) +
-    //                      d_gains_[i] * (robot_state.dq_d[i] - dq_filtered_[i]);
-    tau_d_calculated[i] = coriolis_factor_ * coriolis[i] +
-                          k_gains_[i] * (pos_d_target_[i] - robot_state.q[i]) +
-                          d_gains_[i] * (dq_d_[i] - dq_filtered_[i]);
-    
-  }
+  mapJoints(tau_d_calculated) = pdCoriolisTorque(
+      mapJoints(pos_d_target_), mapJoints(robot_state.q), mapJoints(dq_d_), mapJoints(dq_filtered_),
+      mapJoints(gains.k), mapJoints(gains.d), mapJoints(coriolis), coriolis_factor_);
 
   // Maximum torque difference with a sampling rate of 1 kHz. The maximum torque rate is
   // 1000 * (1 / sampling_time).
-  std::array<double, 7> tau_d_saturated = saturateTorqueRate(tau_d_calculated, robot_state.tau_J_d);
+  std::array<double, 7> tau_d_saturated =
+      saturateTorqueRate(tau_d_calculated, robot_state.tau_J_d, kDeltaTauMax);
 
   for (size_t i = 0; i < 7; ++i) {
     joint_handles_[i].setCommand(tau_d_saturated[i]);
     prev_pos_[i] = robot_state.q[i];
   }
 
-  if (rate_trigger_() && torques_publisher_.trylock()) {
+  TorqueComparisonSample* sample = rate_trigger_() ? torques_channel_.claim() : nullptr;
+  if (sample != nullptr) {
     std::array<double, 7> tau_j = robot_state.tau_J;
-    std::array<double, 7> tau_error;
     double error_rms(0.0);
     for (size_t i = 0; i < 7; ++i) {
-      tau_error[i] = last_tau_d_[i] - tau_j[i];
-      error_rms += std::sqrt(std::pow(tau_error[i], 2.0)) / 7.0;
-    }
-    torques_publisher_.msg_.root_mean_square_error = error_rms;
-    for (size_t i = 0; i < 7; ++i) {
-      torques_publisher_.msg_.tau_commanded[i] = last_tau_d_[i];
-      torques_publisher_.msg_.tau_error[i] = tau_error[i];
-      torques_publisher_.msg_.tau_measured[i] = tau_j[i];
+      sample->tau_error[i] = last_tau_d_[i] - tau_j[i];
+      error_rms += std::sqrt(std::pow(sample->tau_error[i], 2.0)) / 7.0;
     }
-    torques_publisher_.unlockAndPublish();
+    sample->root_mean_square_error = error_rms;
+    sample->tau_commanded = last_tau_d_;
+    sample->tau_measured = tau_j;
+    torques_channel_.commit();
   }
 
   for (size_t i = 0; i < 7; ++i) {
@@ -252,15 +264,47 @@ void JointImpedanceController::update(const ros::Time& /*time*/,
   }
 }
 
-std::array<double, 7> JointImpedanceController::saturateTorqueRate(
-    const std::array<double, 7>& tau_d_calculated,
-    const std::array<double, 7>& tau_J_d) {  // NOLINT (readability-identifier-naming)
-  std::array<double, 7> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - tau_J_d[i];
-    tau_d_saturated[i] = tau_J_d[i] + std::max(std::min(difference, kDeltaTauMax), -kDeltaTauMax);
+void JointImpedanceController::updateTrajectory(const ros::Time& time) {
+  const double now = time.toSec();
+  const bool restart = trajectory_.takeRestartFromRT();
+  const JointTrajectoryPoint* next = trajectory_.frontFromRT();
+  if (restart || (!trajectory_active_ && next != nullptr)) {
+    // a new trajectory starts from wherever the current target is
+    segment_start_.position = pos_d_target_;
+    segment_start_.velocity = dq_d_;
+    segment_start_.acceleration.fill(0.0);
+    segment_start_time_ = (restart && next != nullptr && next->start > 0.0) ? next->start : now;
+    trajectory_active_ = true;
+    trajectory_idle_ = false;
+  }
+  if (!trajectory_active_) {
+    return;
+  }
+  if (next != nullptr && trajectory_idle_) {
+    // points appended after the queue ran dry are timed from now
+    segment_start_time_ = now;
+    trajectory_idle_ = false;
+  }
+
+  while (next != nullptr && segment_start_time_ + next->duration <= now) {
+    segment_start_ = *next;
+    segment_start_time_ += next->duration;
+    trajectory_.popFromRT();
+    next = trajectory_.frontFromRT();
+  }
+  if (next == nullptr) {
+    // hold the last point until more are appended
+    segment_start_.velocity.fill(0.0);
+    segment_start_.acceleration.fill(0.0);
+    pos_d_target_ = segment_start_.position;
+    dq_d_.fill(0.0);
+    trajectory_idle_ = true;
+    return;
   }
-  return tau_d_saturated;
+  interpolateSegment(segment_start_.position, segment_start_.velocity,
+                     segment_start_.acceleration, next->position, next->velocity,
+                     next->acceleration, next->duration, now - segment_start_time_,
+                     next->quintic, pos_d_target_, dq_d_);
 }
 
 bool JointImpedanceController::checkPositionLimits(std::vector<double> positions) {
@@ -276,14 +320,7 @@ bool JointImpedanceController::checkPositionLimits(std::vector<double> positions
 }
 
 bool JointImpedanceController::checkVelocityLimits(std::vector<double> velocities) {
-  // bool retval = true;
-  for (size_t i = 0;  i < 7; ++i){
-    if (!(abs(velocities[i]) <= joint_limits_.velocity[i])){
-      return true;
-    }
-  }
-
-  return false;
+  return !withinMagnitude(mapJoints(velocities), mapJoints(joint_limits_.velocity));
 }
 
 void JointImpedanceController::jointCmdCallback(const franka_core_msgs::JICmd& msg) {
@@ -299,25 +336,95 @@ void JointImpedanceController::jointCmdCallback(const franka_core_msgs::JICmd& m
       std::copy_n(msg->velocity.begin(), 7, dq_d_.begin()); // if velocity is not there, the controller fails!!
     }*/
   //TODO want to add back in position and velocity limit checks
+  if (msg.position.size() != 7 || msg.velocity.size() != 7) {
+    ROS_ERROR_STREAM("JointImpedanceController: Published Commands are not of size 7");
+    setpoint_channel_.rejectFromNonRT();
+    return;
+  }
   checkPositionLimits(msg.position);
+  JointSetpoint setpoint;
   for (size_t i = 0;  i < 7; ++i){
-      pos_d_target_[i] = msg.position[i];
+      setpoint.position[i] = msg.position[i];
   }
   for (size_t i = 0;  i < 7; ++i){
-      dq_d_[i] = msg.velocity[i];
+      setpoint.velocity[i] = msg.velocity[i];
   }
+  setpoint_channel_.writeFromNonRT(setpoint);
 }
 
 void JointImpedanceController::stiffnessParamCallback(
      const franka_core_msgs::JointImpedanceStiffness& msg) {
 
+  if (msg.stiffness.size() != 7) {
+    ROS_ERROR_STREAM("JointImpedanceController: Published stiffness is not of size 7");
+    return;
+  }
+  GainTransition transition;
+  if (!transitionFromMessage(msg.transition_profile, msg.transition_time,
+                             default_gain_transition_, transition)) {
+    ROS_ERROR_STREAM("JointImpedanceController: Invalid transition_profile or transition_time");
+    return;
+  }
+  JointGains gains;
   for (size_t i = 0;  i < 7; ++i){
-      k_gains_[i] = msg.stiffness[i];
-      d_gains_[i] = 2.0 * sqrt(msg.stiffness[i]);
+      gains.k[i] = msg.stiffness[i];
+      gains.d[i] = 2.0 * sqrt(msg.stiffness[i]);
   }  
+  gain_schedule_.requestFromNonRT(gains, transition);
 
 }
 
+void JointImpedanceController::trajectoryCallback(
+    const franka_core_msgs::JointImpedanceTrajectory& msg) {
+  if (msg.points.size() > kTrajectoryCapacity) {
+    ROS_ERROR_STREAM("JointImpedanceController: Trajectory has " << msg.points.size()
+                     << " points, at most " << kTrajectoryCapacity << " can be queued");
+    return;
+  }
+  const bool quintic =
+      msg.interpolation == franka_core_msgs::JointImpedanceTrajectory::INTERPOLATION_QUINTIC;
+  std::lock_guard<std::mutex> lock(trajectory_chunk_mutex_);
+  trajectory_chunk_.clear();
+  // the first point is timed from the trajectory start, or from the last queued point when
+  // appending
+  double previous_time = 0.0;
+  for (const auto& p : msg.points) {
+    if (p.position.size() != 7 || (!p.velocity.empty() && p.velocity.size() != 7) ||
+        (!p.acceleration.empty() && p.acceleration.size() != 7)) {
+      ROS_ERROR_STREAM("JointImpedanceController: Trajectory points are not of size 7");
+      return;
+    }
+    if (!p.velocity.empty() && checkVelocityLimits(p.velocity)) {
+      ROS_ERROR_STREAM("JointImpedanceController: Trajectory point " << trajectory_chunk_.size()
+                       << " is beyond the joint velocity limits, rejecting the trajectory");
+      return;
+    }
+    const double time = p.time_from_start.toSec();
+    if (time < previous_time) {
+      ROS_ERROR_STREAM("JointImpedanceController: Trajectory time_from_start must not decrease");
+      return;
+    }
+    JointTrajectoryPoint point{};
+    std::copy_n(p.position.begin(), 7, point.position.begin());
+    if (!p.velocity.empty()) {
+      std::copy_n(p.velocity.begin(), 7, point.velocity.begin());
+    }
+    if (!p.acceleration.empty()) {
+      std::copy_n(p.acceleration.begin(), 7, point.acceleration.begin());
+    }
+    point.duration = time - previous_time;
+    point.start = msg.header.stamp.toSec();
+    point.quintic = quintic;
+    trajectory_chunk_.push_back(point);
+    previous_time = time;
+  }
+  if (!trajectory_.writeFromNonRT(trajectory_chunk_.data(), trajectory_chunk_.size(),
+                                  !msg.append)) {
+    ROS_ERROR_STREAM("JointImpedanceController: Trajectory buffer is full, dropping "
+                     << msg.points.size() << " points");
+  }
+}
+
 }  // namespace franka_ros_controllers
 
 PLUGINLIB_EXPORT_CLASS(franka_ros_controllers::JointImpedanceController,
@@ -15,20 +15,21 @@ namespace franka_ros_controllers {
 
 bool NTorqueController::init(hardware_interface::RobotHW* robot_hw,
                                   ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
   std::vector<std::string> joint_names;
   std::string arm_id;
+  if (!readArmId(node_handle, arm_id)) {
+    ROS_ERROR("TorqueController: Could not read parameter arm_id");
+    return false;
+  }
 
-  torque_params_ = node_handle.subscribe(
-    "/torque_target", 20, &NTorqueController::torqueParamCallback, this,
+  torque_params_ = commandNodeHandle(node_handle).subscribe(
+    armTopic(node_handle, arm_id, "/torque_target"), 20, &NTorqueController::torqueParamCallback, this,
     ros::TransportHints().reliable().tcpNoDelay());
 
   ROS_WARN(
       "TorqueController: Make sure your robot's endeffector is in contact "
       "with a horizontal surface before starting the controller!");
-  if (!node_handle.getParam("arm_id", arm_id)) {
-    ROS_ERROR("TorqueController: Could not read parameter arm_id");
-    return false;
-  }
   /*if (!node_handle.getParam("joint_names", joint_names) || joint_names.size() != 7) {
     ROS_ERROR(
         "TorqueController: Invalid or no joint_names parameters provided, aborting "
@@ -38,39 +39,27 @@ bool NTorqueController::init(hardware_interface::RobotHW* robot_hw,
 
 
 
-  if (!node_handle.getParam("/robot_config/joint_names", joint_limits_.joint_names) || joint_limits_.joint_names.size() != 7) {
+  joint_limits_ = RobotConfig::get(node_handle)->jointLimits(arm_id);
+  if (joint_limits_.joint_names.size() != 7) {
     ROS_ERROR(
         "TorqueController: Invalid or no joint_names parameters provided, aborting "
         "controller init!");
     return false;
   }
-
-
-  std::map<std::string, double> torque_limit_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_effort_limit", torque_limit_map))
-  {
-    ROS_ERROR("TorqueController: Failed to find joint effort limits on the param server. Aborting controller init");
+  if (joint_limits_.effort.size() != 7) {
+    ROS_ERROR(
+        "TorqueController: Joint limits parameters not provided, aborting "
+        "controller init!");
     return false;
   }
 
-
-  for (size_t i = 0; i < joint_limits_.joint_names.size(); ++i){
-    if (torque_limit_map.find(joint_limits_.joint_names[i]) != torque_limit_map.end()) {
-        joint_limits_.effort.push_back(torque_limit_map[joint_limits_.joint_names[i]]);
-    } else {
-        ROS_ERROR("TorqueController: Unable to find torque limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-  }
-
   auto* model_interface = robot_hw->get<franka_hw::FrankaModelInterface>();
   if (model_interface == nullptr) {
     ROS_ERROR_STREAM("TorqueController: Error getting model interface from hardware");
     return false;
   }
   try {
-    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
-        model_interface->getHandle(arm_id + "_model"));
+    model_handle_ = CachedFrankaModelHandle::acquire(robot_hw, arm_id);
   } catch (hardware_interface::HardwareInterfaceException& ex) {
     ROS_ERROR_STREAM(
         "TorqueController: Exception getting model handle from interface: " << ex.what());
@@ -121,9 +110,11 @@ void NTorqueController::starting(const ros::Time& /*time*/) {
   // Bias correction for the current external torque
   tau_ext_initial_ = tau_measured - gravity;
   tau_error_.setZero();
+  torque_channel_.clearFromRT();
 }
 
 void NTorqueController::update(const ros::Time& /*time*/, const ros::Duration& period) {
+  ScopedUpdateTimer update_timer(update_timing_);
   franka::RobotState robot_state = state_handle_->getRobotState();
   std::array<double, 42> jacobian_array =
       model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
@@ -134,16 +125,18 @@ void NTorqueController::update(const ros::Time& /*time*/, const ros::Duration& p
       robot_state.tau_J_d.data());
   Eigen::Map<Eigen::Matrix<double, 7, 1>> gravity(gravity_array.data());
 
+  torque_channel_.readFromRT(target_torque_);
+
   Eigen::VectorXd tau_cmd(7);
 
-  tau_cmd << saturateTorqueRate(desired_torque_, tau_J_d);
+  tau_cmd << saturateTorqueRate(desired_torque_, tau_J_d, kDeltaTauMax);
 
   for (size_t i = 0; i < 7; ++i) {
     joint_handles_[i].setCommand(tau_cmd(i));
   }
 
   // Update signals changed online through dynamic reconfigure
-  desired_torque_ = filter_gain_ * target_torque_ + (1 - filter_gain_) * desired_torque_;
+  exponentialFilter(desired_torque_, target_torque_, filter_gain_);
 }
 
 void NTorqueController::torqueParamCallback(
@@ -151,14 +144,18 @@ void NTorqueController::torqueParamCallback(
 
   if (msg->torque.size() != 7) {
       ROS_ERROR_STREAM("TorqueController: Published Commands are not of size 7");
+      torque_channel_.rejectFromNonRT();
   }
   else if (checkTorqueLimits(msg->torque)) {
       ROS_ERROR_STREAM("TorqueController: Commanded positions or velicities are beyond allowed position limits.");
+      torque_channel_.rejectFromNonRT();
   }
   else {
+      Eigen::Matrix<double, 7, 1> target_torque;
       for (size_t i = 0; i < 7; ++i) {
-          target_torque_(i) = msg->torque[i];
+          target_torque(i) = msg->torque[i];
       }
+      torque_channel_.writeFromNonRT(target_torque);
       //target_torque_ = msg->torque;
       //std::copy_n(msg->torque.begin(), 7, target_torque_);
   }
@@ -166,24 +163,7 @@ void NTorqueController::torqueParamCallback(
 
 bool NTorqueController::checkTorqueLimits(std::vector<double> torques)
 {
-  for (size_t i = 0;  i < 7; ++i){
-    if (!(abs(torques[i]) < joint_limits_.effort[i])){
-      return true;
-    }
-  }
-
-  return false;
-}
-
-Eigen::Matrix<double, 7, 1> NTorqueController::saturateTorqueRate(
-    const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-    const Eigen::Matrix<double, 7, 1>& tau_J_d) {  // NOLINT (readability-identifier-naming)
-  Eigen::Matrix<double, 7, 1> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - tau_J_d[i];
-    tau_d_saturated[i] = tau_J_d[i] + std::max(std::min(difference, kDeltaTauMax), -kDeltaTauMax);
-  }
-  return tau_d_saturated;
+  return !belowMagnitude(mapJoints(torques), mapJoints(joint_limits_.effort));
 }
 
 }  // namespace franka_ros_controllers
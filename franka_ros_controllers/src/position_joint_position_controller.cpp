@@ -33,14 +33,23 @@
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
 
+#include <franka_ros_controllers/trajectory_interpolation.h>
+
 
 namespace franka_ros_controllers {
 
 bool PositionJointPositionController::init(hardware_interface::RobotHW* robot_hardware,
                                           ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
+  // optional: only selects the arm's topics and joint names in a multi-arm node
+  std::string arm_id;
+  readArmId(node_handle, arm_id);
 
-  desired_joints_subscriber_ = node_handle.subscribe(
-      "/franka_ros_interface/motion_controller/arm/joint_commands", 20, &PositionJointPositionController::jointPosCmdCallback, this,
+  desired_joints_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_commands"), 20, &PositionJointPositionController::jointPosCmdCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  command_batch_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_command_batch"), 20, &PositionJointPositionController::jointCmdBatchCallback, this,
       ros::TransportHints().reliable().tcpNoDelay());
 
   position_joint_interface_ = robot_hardware->get<hardware_interface::PositionJointInterface>();
@@ -49,49 +58,24 @@ bool PositionJointPositionController::init(hardware_interface::RobotHW* robot_ha
         "PositionJointPositionController: Error getting position joint interface from hardware!");
     return false;
   }
-  if (!node_handle.getParam("/robot_config/joint_names", joint_limits_.joint_names)) {
-    ROS_ERROR("PositionJointPositionController: Could not parse joint names");
-  }
+  joint_limits_ = RobotConfig::get(node_handle)->jointLimits(arm_id);
   if (joint_limits_.joint_names.size() != 7) {
-    ROS_ERROR_STREAM("PositionJointPositionController: Wrong number of joint names, got "
-                     << joint_limits_.joint_names.size() << " instead of 7 names!");
+    ROS_ERROR(
+        "PositionJointPositionController: Invalid or no joint_names parameters provided, aborting "
+        "controller init!");
+    return false;
+  }
+  if (joint_limits_.position_lower.size() != 7 ||
+      joint_limits_.position_upper.size() != 7) {
+    ROS_ERROR(
+        "PositionJointPositionController: Joint limits parameters not provided, aborting "
+        "controller init!");
     return false;
   }
-  std::map<std::string, double> pos_limit_lower_map;
-  std::map<std::string, double> pos_limit_upper_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/lower", pos_limit_lower_map) ) {
-  ROS_ERROR(
-      "PositionJointPositionController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-  if (!node_handle.getParam("/robot_config/joint_config/joint_position_limit/upper", pos_limit_upper_map) ) {
-  ROS_ERROR(
-      "PositionJointPositionController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
 
-  for (size_t i = 0; i < joint_limits_.joint_names.size(); ++i){
-    if (pos_limit_lower_map.find(joint_limits_.joint_names[i]) != pos_limit_lower_map.end())
-      {
-        joint_limits_.position_lower.push_back(pos_limit_lower_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("PositionJointPositionController: Unable to find lower position limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-    if (pos_limit_upper_map.find(joint_limits_.joint_names[i]) != pos_limit_upper_map.end())
-      {
-        joint_limits_.position_upper.push_back(pos_limit_upper_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("PositionJointPositionController: Unable to find upper position limit  values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-  }  
+  if (!horizon_tracker_.init(node_handle, joint_limits_, "PositionJointPositionController")) {
+    return false;
+  }
 
   position_joint_handles_.resize(7);
   for (size_t i = 0; i < 7; ++i) {
@@ -109,10 +93,9 @@ bool PositionJointPositionController::init(hardware_interface::RobotHW* robot_ha
     ROS_INFO_STREAM("PositionJointPositionController: Did not find controller_state_publish_rate. Using default "
                     << controller_state_publish_rate << " [Hz].");
   }
-  trigger_publish_ = franka_hw::TriggerRate(controller_state_publish_rate);
 
   dynamic_reconfigure_joint_controller_params_node_ =
-      ros::NodeHandle("/franka_ros_interface/position_joint_position_controller/arm/controller_parameters_config");
+      ros::NodeHandle(armTopic(node_handle, arm_id, "/franka_ros_interface/position_joint_position_controller/arm/controller_parameters_config"));
 
   dynamic_server_joint_controller_params_ = std::make_unique<
       dynamic_reconfigure::Server<franka_ros_controllers::joint_controller_paramsConfig>>(
@@ -121,16 +104,9 @@ bool PositionJointPositionController::init(hardware_interface::RobotHW* robot_ha
   dynamic_server_joint_controller_params_->setCallback(
       boost::bind(&PositionJointPositionController::jointControllerParamCallback, this, _1, _2));
 
-  publisher_controller_states_.init(node_handle, "/franka_ros_interface/motion_controller/arm/joint_controller_states", 1);
-
-  {
-    std::lock_guard<realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> > lock(
-        publisher_controller_states_);
-    publisher_controller_states_.msg_.controller_name = "position_joint_position_controller";
-    publisher_controller_states_.msg_.names.resize(joint_limits_.joint_names.size());
-    publisher_controller_states_.msg_.joint_controller_states.resize(joint_limits_.joint_names.size());
-
-  }
+  controller_state_publisher_.init(
+      node_handle, armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_controller_states"),
+      "position_joint_position_controller", joint_limits_.joint_names, controller_state_publish_rate);
 
   return true;
 }
@@ -142,31 +118,62 @@ void PositionJointPositionController::starting(const ros::Time& /* time */) {
   pos_d_ = initial_pos_;
   prev_pos_ = initial_pos_;
   pos_d_target_ = initial_pos_;
+  dq_d_.fill(0.0);
+  horizon_active_ = false;
+  setpoint_channel_.clearFromRT();
+  command_batch_.clearFromRT();
 }
 
 void PositionJointPositionController::update(const ros::Time& time,
                                             const ros::Duration& period) {
-  for (size_t i = 0; i < 7; ++i) {
-    position_joint_handles_[i].setCommand(pos_d_[i]);
+  ScopedUpdateTimer update_timer(update_timing_);
+  JointSetpoint setpoint;
+  if (setpoint_channel_.readFromRT(setpoint)) {
+    // a single command overrides the queued waypoints
+    command_batch_.clearFromRT();
+    horizon_active_ = false;
+    if (setpoint.hold) {
+      pos_d_ = prev_pos_;
+      pos_d_target_ = prev_pos_;
+      dq_d_.fill(0.0);
+    } else {
+      pos_d_target_ = setpoint.position;
+    }
+  }
+  JointWaypoint waypoint;
+  if (command_batch_.readFromRT(time, waypoint)) {
+    if (!horizon_active_) {
+      // take over from wherever the filtered single commands have brought the joints
+      horizon_tracker_.reset(pos_d_, dq_d_);
+      horizon_active_ = true;
+    }
+    horizon_waypoint_ = waypoint;
   }
-  double filter_val = filter_joint_pos_ * filter_factor_;
+  if (horizon_active_) {
+    trackHorizon(time, period.toSec());
+  }
+
   for (size_t i = 0; i < 7; ++i) {
+    position_joint_handles_[i].setCommand(pos_d_[i]);
     prev_pos_[i] = position_joint_handles_[i].getPosition();
-    pos_d_[i] = filter_val * pos_d_target_[i] + (1.0 - filter_val) * pos_d_[i];
   }
-
-  if (trigger_publish_() && publisher_controller_states_.trylock()) {
-    for (size_t i = 0; i < 7; ++i){
-
-      publisher_controller_states_.msg_.joint_controller_states[i].set_point = pos_d_target_[i];
-      publisher_controller_states_.msg_.joint_controller_states[i].process_value = pos_d_[i];
-      publisher_controller_states_.msg_.joint_controller_states[i].time_step = period.toSec();
-
-      publisher_controller_states_.msg_.joint_controller_states[i].header.stamp = time;
-
+  if (!horizon_active_) {
+    double filter_val = filter_joint_pos_ * filter_factor_;
+    for (size_t i = 0; i < 7; ++i) {
+      const double pos_d = filter_val * pos_d_target_[i] + (1.0 - filter_val) * pos_d_[i];
+      dq_d_[i] = period.toSec() > 0.0 ? (pos_d - pos_d_[i]) / period.toSec() : 0.0;
+      pos_d_[i] = pos_d;
     }
+  }
 
-    publisher_controller_states_.unlockAndPublish();        
+  if (JointControllerSample* sample = controller_state_publisher_.claim()) {
+    sample->stamp = time;
+    sample->time_step = period.toSec();
+    for (size_t i = 0; i < 7; ++i) {
+      sample->set_point[i] = pos_d_target_[i];
+      sample->process_value[i] = pos_d_[i];
+    }
+    controller_state_publisher_.commit();
   }
 
   // update parameters changed online either through dynamic reconfigure or through the interactive
@@ -175,39 +182,54 @@ void PositionJointPositionController::update(const ros::Time& time,
 
 }
 
-bool PositionJointPositionController::checkPositionLimits(std::vector<double> positions)
-{
-  // bool retval = true;
-  for (size_t i = 0;  i < 7; ++i){
-    if (!((positions[i] <= joint_limits_.position_upper[i]) && (positions[i] >= joint_limits_.position_lower[i]))){
-      return true;
-    }
+void PositionJointPositionController::trackHorizon(const ros::Time& time, double period) {
+  std::array<double, 7> velocity{};
+  std::array<double, 7> acceleration{};
+  const JointWaypoint* next = command_batch_.peekFromRT();
+  if (next == nullptr) {
+    // end of the horizon: come to rest at its last waypoint
+    pos_d_target_ = horizon_waypoint_.position;
+  } else {
+    const std::array<double, 7> unused{};
+    interpolateSegment(horizon_waypoint_.position, horizon_waypoint_.velocity, unused,
+                       next->position, next->velocity, unused,
+                       next->time - horizon_waypoint_.time, time.toSec() - horizon_waypoint_.time,
+                       false, pos_d_target_, velocity, acceleration);
   }
+  horizon_tracker_.updatePosition(pos_d_target_, velocity, acceleration, period);
+  pos_d_ = horizon_tracker_.position();
+  dq_d_ = horizon_tracker_.velocity();
+}
 
-  return false;
+template <typename Container>
+bool PositionJointPositionController::checkPositionLimits(const Container& positions)
+{
+  return !withinLimits(mapJoints(positions), mapJoints(joint_limits_.position_lower),
+                       mapJoints(joint_limits_.position_upper));
 }
 
 void PositionJointPositionController::jointPosCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg) {
 
     if (msg->mode == franka_core_msgs::JointCommand::POSITION_MODE){
+      JointSetpoint setpoint{};
       if (msg->position.size() != 7) {
         ROS_ERROR_STREAM(
             "PositionJointPositionController: Published Commands are not of size 7");
-        pos_d_ = prev_pos_;
-        pos_d_target_ = prev_pos_;
+        setpoint.hold = true;
+        setpoint_channel_.rejectFromNonRT();
       }
       else if (checkPositionLimits(msg->position)) {
          ROS_ERROR_STREAM(
             "PositionJointPositionController: Commanded positions are beyond allowed position limits.");
-        pos_d_ = prev_pos_;
-        pos_d_target_ = prev_pos_;
+        setpoint.hold = true;
+        setpoint_channel_.rejectFromNonRT();
 
       }
       else
       {
-        std::copy_n(msg->position.begin(), 7, pos_d_target_.begin());
+        std::copy_n(msg->position.begin(), 7, setpoint.position.begin());
       }
-      
+      setpoint_channel_.writeFromNonRT(setpoint);
     }
     // else ROS_ERROR_STREAM("PositionJointPositionController: Published Command msg are not of JointCommand::POSITION_MODE! Dropping message");
 }
@@ -217,6 +239,24 @@ void PositionJointPositionController::jointControllerParamCallback(franka_ros_co
   target_filter_joint_pos_ = config.position_joint_delta_filter;
 }
 
+void PositionJointPositionController::jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg) {
+  if (msg->mode != franka_core_msgs::JointCommand::POSITION_MODE) {
+    return;
+  }
+  std::string error;
+  if (!command_batch_.writeFromNonRT(*msg,
+                                     [this](const JointWaypoint& waypoint) {
+                                       return !checkPositionLimits(waypoint.position);
+                                     },
+                                     error)) {
+    ROS_ERROR_STREAM("PositionJointPositionController: Rejected command batch: " << error);
+    JointSetpoint setpoint{};
+    setpoint.hold = true;
+    setpoint_channel_.rejectFromNonRT();
+    setpoint_channel_.writeFromNonRT(setpoint);
+  }
+}
+
 }  // namespace franka_ros_controllers
 
 PLUGINLIB_EXPORT_CLASS(franka_ros_controllers::PositionJointPositionController,
@@ -0,0 +1,34 @@
+// realtime_allocation_guard.h: scope guard that forbids Eigen heap allocations while it is
+// alive. Only active when the package is built with -DCHECK_RT_ALLOCATIONS=ON, which defines
+// EIGEN_RUNTIME_NO_MALLOC and keeps assertions enabled; any Eigen allocation inside the guarded
+// scope (typically a controller's update()) then aborts with an Eigen assertion naming the
+// offending allocation. In regular builds the guard compiles to nothing.
+// Note that Eigen keeps the flag process-wide, so this is a debugging aid for test runs: a
+// dynamic-size Eigen allocation on another thread inside the guarded window trips it as well.
+
+#pragma once
+
+#include <Eigen/Core>
+
+namespace franka_ros_controllers {
+
+class RealtimeAllocationGuard {
+ public:
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+  RealtimeAllocationGuard() : previously_allowed_(Eigen::internal::is_malloc_allowed()) {
+    Eigen::internal::set_is_malloc_allowed(false);
+  }
+  ~RealtimeAllocationGuard() { Eigen::internal::set_is_malloc_allowed(previously_allowed_); }
+#else
+  RealtimeAllocationGuard() = default;
+#endif
+  RealtimeAllocationGuard(const RealtimeAllocationGuard&) = delete;
+  RealtimeAllocationGuard& operator=(const RealtimeAllocationGuard&) = delete;
+
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+ private:
+  bool previously_allowed_;
+#endif
+};
+
+}  // namespace franka_ros_controllers
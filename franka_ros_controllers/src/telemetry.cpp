@@ -0,0 +1,76 @@
+/***************************************************************************
+
+*
+* @package: franka_ros_controllers
+* @metapackage: franka_ros_interface
+* @author: Saif Sidhik <sxs1412@bham.ac.uk>
+*
+
+**************************************************************************/
+
+/***************************************************************************
+* Copyright (c) 2019-2020, Saif Sidhik.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**************************************************************************/
+#include <franka_ros_controllers/telemetry.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace franka_ros_controllers {
+
+namespace {
+
+// Each drain hands a few samples per controller on; at 1 kHz a queue of 256 slots leaves
+// ample margin for a late wake-up.
+constexpr std::chrono::milliseconds kDrainPeriod{2};
+
+}  // anonymous namespace
+
+TelemetryThread& TelemetryThread::instance() {
+  static TelemetryThread thread;
+  return thread;
+}
+
+TelemetryThread::~TelemetryThread() {
+  stop_.store(true);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void TelemetryThread::add(TelemetrySource* source) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sources_.push_back(source);
+  if (!thread_.joinable()) {
+    thread_ = std::thread(&TelemetryThread::run, this);
+  }
+}
+
+void TelemetryThread::remove(TelemetrySource* source) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sources_.erase(std::remove(sources_.begin(), sources_.end(), source), sources_.end());
+}
+
+void TelemetryThread::run() {
+  while (!stop_.load()) {
+    std::this_thread::sleep_for(kDrainPeriod);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (TelemetrySource* source : sources_) {
+      source->drain();
+    }
+  }
+}
+
+}  // namespace franka_ros_controllers
@@ -25,6 +25,7 @@
 **************************************************************************/
 #include <franka_ros_controllers/velocity_joint_velocity_controller.h>
 
+#include <algorithm>
 #include <cmath>
 
 #include <controller_interface/controller_base.h>
@@ -38,9 +39,16 @@ namespace franka_ros_controllers {
 
 bool VelocityJointVelocityController::init(hardware_interface::RobotHW* robot_hardware,
                                           ros::NodeHandle& node_handle) {
+  update_timing_ = ControllerTiming::instance().acquire(node_handle.getNamespace());
+  // optional: only selects the arm's topics and joint names in a multi-arm node
+  std::string arm_id;
+  readArmId(node_handle, arm_id);
 
-  desired_joints_subscriber_ = node_handle.subscribe(
-      "/franka_ros_interface/motion_controller/arm/joint_commands", 20, &VelocityJointVelocityController::jointVelCmdCallback, this,
+  desired_joints_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_commands"), 20, &VelocityJointVelocityController::jointVelCmdCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+  command_batch_subscriber_ = commandNodeHandle(node_handle).subscribe(
+      armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_command_batch"), 20, &VelocityJointVelocityController::jointCmdBatchCallback, this,
       ros::TransportHints().reliable().tcpNoDelay());
 
   velocity_joint_interface_ = robot_hardware->get<hardware_interface::VelocityJointInterface>();
@@ -49,34 +57,23 @@ bool VelocityJointVelocityController::init(hardware_interface::RobotHW* robot_ha
         "VelocityJointVelocityController: Error getting velocity joint interface from hardware!");
     return false;
   }
-  if (!node_handle.getParam("/robot_config/joint_names", joint_limits_.joint_names)) {
-    ROS_ERROR("VelocityJointVelocityController: Could not parse joint names");
-  }
+  joint_limits_ = RobotConfig::get(node_handle)->jointLimits(arm_id);
   if (joint_limits_.joint_names.size() != 7) {
-    ROS_ERROR_STREAM("VelocityJointVelocityController: Wrong number of joint names, got "
-                     << joint_limits_.joint_names.size() << " instead of 7 names!");
+    ROS_ERROR(
+        "VelocityJointVelocityController: Invalid or no joint_names parameters provided, aborting "
+        "controller init!");
+    return false;
+  }
+  if (joint_limits_.velocity.size() != 7) {
+    ROS_ERROR(
+        "VelocityJointVelocityController: Joint limits parameters not provided, aborting "
+        "controller init!");
     return false;
   }
-  std::map<std::string, double> vel_limit_map;
-  if (!node_handle.getParam("/robot_config/joint_config/joint_velocity_limit", vel_limit_map) ) {
-  ROS_ERROR(
-      "VelocityJointVelocityController: Joint limits parameters not provided, aborting "
-      "controller init!");
-  return false;
-      }
-  
 
-  for (size_t i = 0; i < joint_limits_.joint_names.size(); ++i){
-    if (vel_limit_map.find(joint_limits_.joint_names[i]) != vel_limit_map.end())
-      {
-        joint_limits_.velocity.push_back(vel_limit_map[joint_limits_.joint_names[i]]);
-      }
-      else
-      {
-        ROS_ERROR("VelocityJointVelocityController: Unable to find lower velocity limit values for joint %s...",
-                       joint_limits_.joint_names[i].c_str());
-      }
-  }  
+  if (!horizon_tracker_.init(node_handle, joint_limits_, "VelocityJointVelocityController")) {
+    return false;
+  }
 
   velocity_joint_handles_.resize(7);
   for (size_t i = 0; i < 7; ++i) {
@@ -94,10 +91,9 @@ bool VelocityJointVelocityController::init(hardware_interface::RobotHW* robot_ha
     ROS_INFO_STREAM("VelocityJointVelocityController: Did not find controller_state_publish_rate. Using default "
                     << controller_state_publish_rate << " [Hz].");
   }
-  trigger_publish_ = franka_hw::TriggerRate(controller_state_publish_rate);
 
   dynamic_reconfigure_joint_controller_params_node_ =
-      ros::NodeHandle("/franka_ros_interface/velocity_joint_velocity_controller/arm/controller_parameters_config");
+      ros::NodeHandle(armTopic(node_handle, arm_id, "/franka_ros_interface/velocity_joint_velocity_controller/arm/controller_parameters_config"));
 
   dynamic_server_joint_controller_params_ = std::make_unique<
       dynamic_reconfigure::Server<franka_ros_controllers::joint_controller_paramsConfig>>(
@@ -106,16 +102,9 @@ bool VelocityJointVelocityController::init(hardware_interface::RobotHW* robot_ha
   dynamic_server_joint_controller_params_->setCallback(
       boost::bind(&VelocityJointVelocityController::jointControllerParamCallback, this, _1, _2));
 
-  publisher_controller_states_.init(node_handle, "/franka_ros_interface/motion_controller/arm/joint_controller_states", 1);
-
-  {
-    std::lock_guard<realtime_tools::RealtimePublisher<franka_core_msgs::JointControllerStates> > lock(
-        publisher_controller_states_);
-    publisher_controller_states_.msg_.controller_name = "velocity_joint_velocity_controller";
-    publisher_controller_states_.msg_.names.resize(joint_limits_.joint_names.size());
-    publisher_controller_states_.msg_.joint_controller_states.resize(joint_limits_.joint_names.size());
-
-  }
+  controller_state_publisher_.init(
+      node_handle, armTopic(node_handle, arm_id, "/franka_ros_interface/motion_controller/arm/joint_controller_states"),
+      "velocity_joint_velocity_controller", joint_limits_.joint_names, controller_state_publish_rate);
 
   return true;
 }
@@ -126,31 +115,58 @@ void VelocityJointVelocityController::starting(const ros::Time& /* time */) {
   }
   vel_d_ = initial_vel_;
   prev_d_ = vel_d_;
+  horizon_active_ = false;
+  setpoint_channel_.clearFromRT();
+  command_batch_.clearFromRT();
 }
 
 void VelocityJointVelocityController::update(const ros::Time& time,
                                             const ros::Duration& period) {
-  for (size_t i = 0; i < 7; ++i) {
-    velocity_joint_handles_[i].setCommand(vel_d_[i]);
+  ScopedUpdateTimer update_timer(update_timing_);
+  JointSetpoint setpoint;
+  if (setpoint_channel_.readFromRT(setpoint)) {
+    // a single command overrides the queued waypoints
+    command_batch_.clearFromRT();
+    horizon_active_ = false;
+    if (setpoint.hold) {
+      vel_d_ = prev_d_;
+      vel_d_target_ = prev_d_;
+    } else {
+      vel_d_target_ = setpoint.velocity;
+    }
+  }
+  JointWaypoint waypoint;
+  if (command_batch_.readFromRT(time, waypoint)) {
+    if (!horizon_active_) {
+      // take over from the velocity commanded so far (the position is not used)
+      horizon_tracker_.reset(std::array<double, 7>{}, vel_d_);
+      horizon_active_ = true;
+    }
+    horizon_waypoint_ = waypoint;
   }
-  double filter_val = filter_joint_vel_ * filter_factor_;
+  if (horizon_active_) {
+    trackHorizon(time, period.toSec());
+  }
+
   for (size_t i = 0; i < 7; ++i) {
+    velocity_joint_handles_[i].setCommand(vel_d_[i]);
     prev_d_[i] = velocity_joint_handles_[i].getVelocity();
-    vel_d_[i] = filter_val * vel_d_target_[i] + (1.0 - filter_val) * vel_d_[i];
   }
-
-  if (trigger_publish_() && publisher_controller_states_.trylock()) {
-    for (size_t i = 0; i < 7; ++i){
-
-      publisher_controller_states_.msg_.joint_controller_states[i].set_point = vel_d_target_[i];
-      publisher_controller_states_.msg_.joint_controller_states[i].process_value = vel_d_[i];
-      publisher_controller_states_.msg_.joint_controller_states[i].time_step = period.toSec();
-
-      publisher_controller_states_.msg_.joint_controller_states[i].header.stamp = time;
-
+  if (!horizon_active_) {
+    double filter_val = filter_joint_vel_ * filter_factor_;
+    for (size_t i = 0; i < 7; ++i) {
+      vel_d_[i] = filter_val * vel_d_target_[i] + (1.0 - filter_val) * vel_d_[i];
     }
+  }
 
-    publisher_controller_states_.unlockAndPublish();        
+  if (JointControllerSample* sample = controller_state_publisher_.claim()) {
+    sample->stamp = time;
+    sample->time_step = period.toSec();
+    for (size_t i = 0; i < 7; ++i) {
+      sample->set_point[i] = vel_d_target_[i];
+      sample->process_value[i] = vel_d_[i];
+    }
+    controller_state_publisher_.commit();
   }
 
   // update parameters changed online either through dynamic reconfigure or through the interactive
@@ -159,39 +175,53 @@ void VelocityJointVelocityController::update(const ros::Time& time,
 
 }
 
-bool VelocityJointVelocityController::checkVelocityLimits(std::vector<double> velocities)
-{
-  // bool retval = true;
-  for (size_t i = 0;  i < 7; ++i){
-    if (!(abs(velocities[i]) <= joint_limits_.velocity[i])){
-      return true;
+void VelocityJointVelocityController::trackHorizon(const ros::Time& time, double period) {
+  std::array<double, 7> acceleration{};
+  const JointWaypoint* next = command_batch_.peekFromRT();
+  const double duration = next != nullptr ? next->time - horizon_waypoint_.time : 0.0;
+  if (duration <= 0.0) {
+    // end of the horizon: keep its last velocity, like a single command
+    vel_d_target_ = horizon_waypoint_.velocity;
+  } else {
+    // linear between the waypoints
+    const double elapsed = std::max(0.0, std::min(time.toSec() - horizon_waypoint_.time, duration));
+    for (size_t i = 0; i < 7; ++i) {
+      acceleration[i] = (next->velocity[i] - horizon_waypoint_.velocity[i]) / duration;
+      vel_d_target_[i] = horizon_waypoint_.velocity[i] + elapsed * acceleration[i];
     }
   }
+  horizon_tracker_.updateVelocity(vel_d_target_, acceleration, period);
+  vel_d_ = horizon_tracker_.velocity();
+}
 
-  return false;
+template <typename Container>
+bool VelocityJointVelocityController::checkVelocityLimits(const Container& velocities)
+{
+  return !withinMagnitude(mapJoints(velocities), mapJoints(joint_limits_.velocity));
 }
 
 void VelocityJointVelocityController::jointVelCmdCallback(const franka_core_msgs::JointCommandConstPtr& msg) {
 
     if (msg->mode == franka_core_msgs::JointCommand::VELOCITY_MODE){
+      JointSetpoint setpoint{};
       if (msg->velocity.size() != 7) {
         ROS_ERROR_STREAM(
             "VelocityJointVelocityController: Published Commands are not of size 7");
-        vel_d_ = prev_d_;
-        vel_d_target_ = prev_d_;
+        setpoint.hold = true;
+        setpoint_channel_.rejectFromNonRT();
       }
       else if (checkVelocityLimits(msg->velocity)) {
          ROS_ERROR_STREAM(
             "VelocityJointVelocityController: Commanded velocities are beyond allowed velocity limits.");
-        vel_d_ = prev_d_;
-        vel_d_target_ = prev_d_;
+        setpoint.hold = true;
+        setpoint_channel_.rejectFromNonRT();
 
       }
       else
       {
-        std::copy_n(msg->velocity.begin(), 7, vel_d_target_.begin());
+        std::copy_n(msg->velocity.begin(), 7, setpoint.velocity.begin());
       }
-      
+      setpoint_channel_.writeFromNonRT(setpoint);
     }
     // else ROS_ERROR_STREAM("VelocityJointVelocityController: Published Command msg are not of JointCommand::Velocity! Dropping message");
 }
@@ -207,6 +237,24 @@ void VelocityJointVelocityController::stopping(const ros::Time& /*time*/) {
   // BUILT-IN STOPPING BEHAVIOR SLOW DOWN THE ROBOT.
 }
 
+void VelocityJointVelocityController::jointCmdBatchCallback(const franka_core_msgs::JointCommandBatchConstPtr& msg) {
+  if (msg->mode != franka_core_msgs::JointCommand::VELOCITY_MODE) {
+    return;
+  }
+  std::string error;
+  if (!command_batch_.writeFromNonRT(*msg,
+                                     [this](const JointWaypoint& waypoint) {
+                                       return !checkVelocityLimits(waypoint.velocity);
+                                     },
+                                     error)) {
+    ROS_ERROR_STREAM("VelocityJointVelocityController: Rejected command batch: " << error);
+    JointSetpoint setpoint{};
+    setpoint.hold = true;
+    setpoint_channel_.rejectFromNonRT();
+    setpoint_channel_.writeFromNonRT(setpoint);
+  }
+}
+
 }  // namespace franka_ros_controllers
 
 PLUGINLIB_EXPORT_CLASS(franka_ros_controllers::VelocityJointVelocityController,